@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <initializer_list>
 #include <memory>
 #include <optional>
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include <libcamera/base/class.h>
 #include <libcamera/base/flags.h>
@@ -21,6 +23,7 @@
 
 #include <libcamera/controls.h>
 #include <libcamera/geometry.h>
+#include <libcamera/memory_usage.h>
 #include <libcamera/orientation.h>
 #include <libcamera/request.h>
 #include <libcamera/stream.h>
@@ -124,6 +127,7 @@ public:
 
 	Signal<Request *, FrameBuffer *> bufferCompleted;
 	Signal<Request *> requestCompleted;
+	Signal<const std::vector<Request *> &> requestsCompleted;
 	Signal<> disconnected;
 
 	int acquire();
@@ -150,6 +154,14 @@ public:
 
 	int start(const ControlList *controls = nullptr);
 	int stop();
+	int switchConfiguration(CameraConfiguration *config);
+
+	MemoryUsage memoryUsage() const;
+	void setMemoryBudget(std::size_t budget);
+	std::size_t memoryBudget() const;
+
+	int setCompletionBatching(unsigned int maxRequests,
+				  std::chrono::microseconds maxLatency);
 
 private:
 	LIBCAMERA_DISABLE_COPY(Camera)
@@ -161,6 +173,9 @@ private:
 	friend class PipelineHandler;
 	void disconnect();
 	void requestComplete(Request *request);
+	void flushCompletedRequests();
+
+	int applyConfiguration(CameraConfiguration *config);
 
 	friend class FrameBufferAllocator;
 	int exportFrameBuffers(Stream *stream,
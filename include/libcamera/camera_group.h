@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Synchronised capture from multiple cameras
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <libcamera/base/class.h>
+#include <libcamera/base/signal.h>
+#include <libcamera/base/span.h>
+
+namespace libcamera {
+
+class Camera;
+class Request;
+
+class CameraGroup : public Extensible
+{
+	LIBCAMERA_DECLARE_PRIVATE()
+
+public:
+	CameraGroup(const std::vector<std::shared_ptr<Camera>> &cameras);
+	~CameraGroup();
+
+	const std::vector<std::shared_ptr<Camera>> &cameras() const;
+
+	void setSyncTolerance(std::chrono::microseconds tolerance);
+	void setMaxPendingRequests(unsigned int count);
+	void setPhaseAlignment(bool enable);
+
+	int start();
+	int stop();
+
+	int queueRequests(Span<Request *const> requests);
+
+	Signal<const std::vector<Request *> &> requestSetCompleted;
+	Signal<Request *> requestDropped;
+
+private:
+	LIBCAMERA_DISABLE_COPY_AND_MOVE(CameraGroup)
+};
+
+} /* namespace libcamera */
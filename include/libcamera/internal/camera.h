@@ -8,18 +8,24 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <list>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <libcamera/base/class.h>
+#include <libcamera/base/mutex.h>
+#include <libcamera/base/timer.h>
 
 #include <libcamera/camera.h>
+#include <libcamera/memory_usage.h>
 
 namespace libcamera {
 
 class CameraControlValidator;
+class FrameBuffer;
 class PipelineHandler;
 class Stream;
 
@@ -41,6 +47,18 @@ public:
 
 	const CameraControlValidator *validator() const { return validator_.get(); }
 
+	void addMemory(MemoryUsage::Purpose purpose, MemoryUsage::Type type,
+		       std::size_t size);
+	void removeMemory(MemoryUsage::Purpose purpose, MemoryUsage::Type type,
+			  std::size_t size);
+	void addBuffer(MemoryUsage::Purpose purpose, const FrameBuffer *buffer);
+	void addBuffers(MemoryUsage::Purpose purpose,
+			const std::vector<std::unique_ptr<FrameBuffer>> &buffers);
+	void removeBuffers(MemoryUsage::Purpose purpose,
+			   const std::vector<std::unique_ptr<FrameBuffer>> &buffers);
+	unsigned int budgetBufferCount(unsigned int count, unsigned int minCount,
+				       std::size_t bufferSize) const;
+
 private:
 	enum State {
 		CameraAvailable,
@@ -61,6 +79,8 @@ private:
 	void disconnect();
 	void setState(State state);
 
+	void flushCompletedRequests();
+
 	std::shared_ptr<PipelineHandler> pipe_;
 	std::string id_;
 	std::set<Stream *> streams_;
@@ -70,6 +90,15 @@ private:
 	std::atomic<State> state_;
 
 	std::unique_ptr<CameraControlValidator> validator_;
+
+	mutable Mutex memoryLock_;
+	MemoryUsage memoryUsage_ LIBCAMERA_TSA_GUARDED_BY(memoryLock_);
+	std::atomic<std::size_t> memoryBudget_;
+
+	unsigned int batchMaxRequests_;
+	std::chrono::microseconds batchMaxLatency_;
+	std::vector<Request *> completedRequests_;
+	std::unique_ptr<Timer> batchTimer_;
 };
 
 } /* namespace libcamera */
@@ -13,6 +13,7 @@
 
 #include <libcamera/base/class.h>
 #include <libcamera/base/log.h>
+#include <libcamera/base/mutex.h>
 
 #include <libcamera/control_ids.h>
 #include <libcamera/controls.h>
@@ -95,6 +96,9 @@ private:
 	int initProperties();
 	int discoverAncillaryDevices();
 	int applyTestPatternMode(controls::draft::TestPatternModeEnum mode);
+	void clearFormatCache();
+	V4L2SubdeviceFormat findFormat(const std::vector<unsigned int> &mbusCodes,
+				       const Size &size) const;
 
 	const MediaEntity *entity_;
 	std::unique_ptr<V4L2Subdevice> subdev_;
@@ -121,6 +125,18 @@ private:
 	ControlList properties_;
 
 	std::unique_ptr<CameraLens> focusLens_;
+
+	struct FormatCacheEntry {
+		std::vector<unsigned int> mbusCodes;
+		Size size;
+		V4L2SubdeviceFormat format;
+	};
+
+	static constexpr unsigned int kFormatCacheSize = 16;
+
+	mutable Mutex formatCacheMutex_;
+	mutable std::vector<FormatCacheEntry> formatCache_
+		LIBCAMERA_TSA_GUARDED_BY(formatCacheMutex_);
 };
 
 } /* namespace libcamera */
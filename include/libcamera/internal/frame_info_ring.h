@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Fixed-capacity ring of per-frame pipeline information
+ */
+
+#pragma once
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <libcamera/base/class.h>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+
+namespace libcamera {
+
+template<typename Info>
+class FrameInfoRing
+{
+public:
+	FrameInfoRing()
+		: size_(0)
+	{
+	}
+
+	void reset(unsigned int capacity)
+	{
+		slots_.clear();
+		slots_.resize(capacity ? capacity : 1);
+		requestIndex_.assign(slots_.size(), kInvalidSlot);
+		size_ = 0;
+	}
+
+	Info *create(unsigned int frame, Request *request)
+	{
+		if (size_ == slots_.size())
+			grow();
+
+		unsigned int index = insertSlot(frame, request);
+		return &slots_[index].info;
+	}
+
+	bool remove(unsigned int frame)
+	{
+		unsigned int index = findSlot(frame);
+		if (index == kInvalidSlot)
+			return false;
+
+		Slot &slot = slots_[index];
+		requestIndex_[findRequestIndex(slot.request)] = kInvalidSlot;
+		slot.info = {};
+		slot.request = nullptr;
+		slot.used = false;
+		size_--;
+
+		return true;
+	}
+
+	Info *find(unsigned int frame)
+	{
+		unsigned int index = findSlot(frame);
+		return index != kInvalidSlot ? &slots_[index].info : nullptr;
+	}
+
+	Info *find(const Request *request)
+	{
+		unsigned int index = findRequestIndex(request);
+		return index != kInvalidSlot ? &slots_[requestIndex_[index]].info : nullptr;
+	}
+
+	Info *find(const FrameBuffer *buffer)
+	{
+		const Request *request = buffer->request();
+		return request ? find(request) : nullptr;
+	}
+
+	template<typename Func>
+	void forEach(Func func)
+	{
+		for (Slot &slot : slots_) {
+			if (slot.used)
+				func(slot.info);
+		}
+	}
+
+	bool empty() const { return size_ == 0; }
+	unsigned int size() const { return size_; }
+	unsigned int capacity() const { return slots_.size(); }
+
+private:
+	LIBCAMERA_DISABLE_COPY_AND_MOVE(FrameInfoRing)
+
+	static constexpr unsigned int kInvalidSlot =
+		std::numeric_limits<unsigned int>::max();
+
+	struct Slot {
+		Info info{};
+		unsigned int frame = 0;
+		Request *request = nullptr;
+		bool used = false;
+	};
+
+	unsigned int insertSlot(unsigned int frame, Request *request)
+	{
+		const unsigned int capacity = slots_.size();
+		unsigned int index = frame % capacity;
+
+		while (slots_[index].used)
+			index = (index + 1) % capacity;
+
+		Slot &slot = slots_[index];
+		slot.frame = frame;
+		slot.request = request;
+		slot.used = true;
+		size_++;
+
+		unsigned int entry = request->sequence() % capacity;
+		while (requestIndex_[entry] != kInvalidSlot)
+			entry = (entry + 1) % capacity;
+		requestIndex_[entry] = index;
+
+		return index;
+	}
+
+	unsigned int findSlot(unsigned int frame) const
+	{
+		const unsigned int capacity = slots_.size();
+		if (!capacity)
+			return kInvalidSlot;
+
+		/*
+		 * Slots are freed without tombstones, keep probing past empty
+		 * slots. The frame is found in its home slot unless frames
+		 * in flight collide, which bounds the search to the ring
+		 * capacity.
+		 */
+		unsigned int index = frame % capacity;
+		for (unsigned int i = 0; i < capacity; ++i) {
+			const Slot &slot = slots_[index];
+			if (slot.used && slot.frame == frame)
+				return index;
+			index = (index + 1) % capacity;
+		}
+
+		return kInvalidSlot;
+	}
+
+	unsigned int findRequestIndex(const Request *request) const
+	{
+		const unsigned int capacity = requestIndex_.size();
+		if (!capacity)
+			return kInvalidSlot;
+
+		unsigned int entry = request->sequence() % capacity;
+		for (unsigned int i = 0; i < capacity; ++i) {
+			unsigned int index = requestIndex_[entry];
+			if (index != kInvalidSlot && slots_[index].request == request)
+				return entry;
+			entry = (entry + 1) % capacity;
+		}
+
+		return kInvalidSlot;
+	}
+
+	void grow()
+	{
+		std::vector<Slot> slots = std::move(slots_);
+
+		reset(slots.size() * 2);
+
+		for (Slot &slot : slots) {
+			unsigned int index = insertSlot(slot.frame, slot.request);
+			slots_[index].info = std::move(slot.info);
+		}
+	}
+
+	std::vector<Slot> slots_;
+	std::vector<unsigned int> requestIndex_;
+	unsigned int size_;
+};
+
+} /* namespace libcamera */
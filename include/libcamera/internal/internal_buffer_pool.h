@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Lazily allocated pool of internal pipeline buffers
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libcamera/base/class.h>
+#include <libcamera/base/signal.h>
+
+#include "libcamera/internal/dma_buf_allocator.h"
+
+namespace libcamera {
+
+class FrameBuffer;
+class V4L2VideoDevice;
+
+class InternalBufferPool
+{
+public:
+	InternalBufferPool(const std::string &name,
+			   DmaBufAllocator::DmaBufAllocatorFlags flags);
+	~InternalBufferPool();
+
+	int allocate(V4L2VideoDevice *video, unsigned int initialCount,
+		     unsigned int maxCount);
+	FrameBuffer *allocateBuffer();
+	void release();
+
+	bool contains(const FrameBuffer *buffer) const;
+
+	unsigned int maxCount() const { return maxCount_; }
+	const std::vector<std::unique_ptr<FrameBuffer>> &buffers() const { return buffers_; }
+
+	Signal<FrameBuffer *> bufferAllocated;
+
+private:
+	LIBCAMERA_DISABLE_COPY_AND_MOVE(InternalBufferPool)
+
+	std::string name_;
+	DmaBufAllocator dmaHeap_;
+
+	std::vector<unsigned int> planeSizes_;
+	unsigned int maxCount_;
+
+	std::vector<std::unique_ptr<FrameBuffer>> buffers_;
+};
+
+} /* namespace libcamera */
@@ -57,6 +57,7 @@ public:
 
 	virtual int start(Camera *camera, const ControlList *controls) = 0;
 	void stop(Camera *camera);
+	int reconfigure(Camera *camera, CameraConfiguration *config);
 	bool hasPendingRequests(const Camera *camera) const;
 
 	void registerRequest(Request *request);
@@ -76,6 +77,7 @@ protected:
 
 	virtual int queueRequestDevice(Camera *camera, Request *request) = 0;
 	virtual void stopDevice(Camera *camera) = 0;
+	virtual int reconfigureDevice(Camera *camera, CameraConfiguration *config);
 
 	virtual void releaseDevice(Camera *camera);
 
@@ -89,6 +91,7 @@ private:
 
 	void doQueueRequest(Request *request);
 	void doQueueRequests();
+	void cancelWaitingRequests(Camera *camera);
 
 	std::vector<std::shared_ptr<MediaDevice>> mediaDevices_;
 	std::vector<std::weak_ptr<Camera>> cameras_;
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * CPU post-processing stages
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <libcamera/base/class.h>
+#include <libcamera/base/log.h>
+#include <libcamera/base/semaphore.h>
+#include <libcamera/base/span.h>
+
+#include <libcamera/stream.h>
+
+namespace libcamera {
+
+class Thread;
+
+LOG_DECLARE_CATEGORY(PostProcessing)
+
+class PostProcessingStage
+{
+public:
+	virtual ~PostProcessingStage();
+
+	virtual int configure(const StreamConfiguration &inputCfg,
+			      const StreamConfiguration &outputCfg) = 0;
+	virtual void process(Span<const Span<uint8_t>> input,
+			     Span<const Span<uint8_t>> output) = 0;
+
+	static unsigned int planeStride(const StreamConfiguration &cfg,
+					unsigned int plane);
+};
+
+class ParallelStripes
+{
+public:
+	ParallelStripes(unsigned int count = 0);
+	~ParallelStripes();
+
+	unsigned int count() const { return count_; }
+
+	void run(const std::function<void(unsigned int)> &func);
+
+private:
+	LIBCAMERA_DISABLE_COPY_AND_MOVE(ParallelStripes)
+
+	class Worker;
+
+	unsigned int count_;
+
+	std::vector<std::unique_ptr<Thread>> threads_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+
+	const std::function<void(unsigned int)> *func_;
+	Semaphore done_;
+};
+
+} /* namespace libcamera */
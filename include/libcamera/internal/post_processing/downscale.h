@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Integer ratio downscaling post-processing stage
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+#include <libcamera/geometry.h>
+
+#include "libcamera/internal/post_processing.h"
+
+namespace libcamera {
+
+class DownscaleStage : public PostProcessingStage
+{
+public:
+	static bool isSupported(const PixelFormat &format);
+
+	int configure(const StreamConfiguration &inputCfg,
+		      const StreamConfiguration &outputCfg) override;
+	void process(Span<const Span<uint8_t>> input,
+		     Span<const Span<uint8_t>> output) override;
+
+private:
+	struct Plane {
+		unsigned int components;
+		unsigned int width;
+		unsigned int height;
+		unsigned int inputStride;
+		unsigned int outputStride;
+	};
+
+	void downscalePlane(const Plane &plane, const uint8_t *src, uint8_t *dst);
+
+	std::vector<Plane> planes_;
+	unsigned int factorX_;
+	unsigned int factorY_;
+
+	std::vector<uint16_t> rowSums_;
+};
+
+} /* namespace libcamera */
@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Semi-planar YUV scaling post-processing stage
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+#include <libcamera/geometry.h>
+
+#include "libcamera/internal/post_processing.h"
+
+namespace libcamera {
+
+class ScaleStage : public PostProcessingStage
+{
+public:
+	enum class Filter {
+		Bilinear,
+		Area,
+	};
+
+	ScaleStage(Filter filter = Filter::Bilinear, unsigned int stripes = 0);
+
+	static bool isSupported(const PixelFormat &format);
+
+	int configure(const StreamConfiguration &inputCfg,
+		      const StreamConfiguration &outputCfg) override;
+	void process(Span<const Span<uint8_t>> input,
+		     Span<const Span<uint8_t>> output) override;
+
+private:
+	struct Tap {
+		unsigned int first;
+		unsigned int count;
+		unsigned int weights;
+	};
+
+	struct Plane {
+		unsigned int components;
+		Size input;
+		Size output;
+		unsigned int inputStride;
+		unsigned int outputStride;
+
+		std::vector<Tap> xTaps;
+		std::vector<Tap> yTaps;
+		std::vector<uint16_t> weights;
+	};
+
+	void computeTaps(unsigned int input, unsigned int output,
+			 std::vector<Tap> &taps, std::vector<uint16_t> &weights);
+	void processStripe(unsigned int index);
+	template<unsigned int Components>
+	void filterLine(const Plane &plane, const uint32_t *line, uint8_t *dst);
+	void scalePlane(const Plane &plane, const uint8_t *src, uint8_t *dst,
+			unsigned int begin, unsigned int end, uint32_t *line);
+
+	Filter filter_;
+	ParallelStripes stripes_;
+
+	std::vector<Plane> planes_;
+	std::vector<std::vector<uint32_t>> lines_;
+
+	Span<const Span<uint8_t>> input_;
+	Span<const Span<uint8_t>> output_;
+};
+
+} /* namespace libcamera */
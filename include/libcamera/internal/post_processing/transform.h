@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Rotation and flipping post-processing stage
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+#include <libcamera/geometry.h>
+#include <libcamera/transform.h>
+
+#include "libcamera/internal/post_processing.h"
+
+namespace libcamera {
+
+class TransformStage : public PostProcessingStage
+{
+public:
+	TransformStage(Transform transform, unsigned int stripes = 0);
+
+	static bool isSupported(const PixelFormat &format);
+
+	int configure(const StreamConfiguration &inputCfg,
+		      const StreamConfiguration &outputCfg) override;
+	void process(Span<const Span<uint8_t>> input,
+		     Span<const Span<uint8_t>> output) override;
+
+private:
+	struct Plane {
+		unsigned int bytesPerPixel;
+		Size output;
+		unsigned int outputStride;
+
+		/* Offset and steps of the input pixels, in bytes. */
+		ptrdiff_t offset;
+		ptrdiff_t stepX;
+		ptrdiff_t stepY;
+	};
+
+	void processStripe(unsigned int index);
+	template<unsigned int N>
+	void transformPlane(const Plane &plane, const uint8_t *src, uint8_t *dst,
+			    unsigned int begin, unsigned int end);
+
+	Transform transform_;
+	ParallelStripes stripes_;
+
+	std::vector<Plane> planes_;
+
+	Span<const Span<uint8_t>> input_;
+	Span<const Span<uint8_t>> output_;
+};
+
+} /* namespace libcamera */
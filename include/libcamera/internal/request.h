@@ -8,11 +8,13 @@
 #pragma once
 
 #include <chrono>
-#include <map>
+#include <list>
 #include <memory>
+#include <vector>
 
 #include <libcamera/base/event_notifier.h>
 #include <libcamera/base/timer.h>
+#include <libcamera/base/unique_fd.h>
 
 #include <libcamera/request.h>
 
@@ -46,9 +48,16 @@ private:
 	friend class PipelineHandler;
 	friend std::ostream &operator<<(std::ostream &out, const Request &r);
 
+	struct FenceNotifier {
+		std::vector<FrameBuffer *> buffers;
+		UniqueFD mergedFence;
+		std::unique_ptr<EventNotifier> notifier;
+	};
+
 	void doCancelRequest();
 	void emitPrepareCompleted();
-	void notifierActivated(FrameBuffer *buffer);
+	void addFenceNotifier(std::vector<FrameBuffer *> buffers, UniqueFD mergedFence);
+	void notifierActivated(FenceNotifier *fence);
 	void timeout();
 
 	Camera *camera_;
@@ -57,7 +66,7 @@ private:
 	bool prepared_ = false;
 
 	std::unordered_set<FrameBuffer *> pending_;
-	std::map<FrameBuffer *, std::unique_ptr<EventNotifier>> notifiers_;
+	std::list<FenceNotifier> notifiers_;
 	std::unique_ptr<Timer> timer_;
 };
 
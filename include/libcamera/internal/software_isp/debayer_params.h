@@ -10,19 +10,23 @@
 
 #pragma once
 
-#include <array>
 #include <stdint.h>
 
 namespace libcamera {
 
 struct DebayerParams {
-	static constexpr unsigned int kRGBLookupSize = 256;
+	static constexpr unsigned int kGainOne = 256;
 
-	using ColorLookupTable = std::array<uint8_t, kRGBLookupSize>;
+	uint16_t blackLevel = 0;
+	uint16_t gainR = kGainOne;
+	uint16_t gainG = kGainOne;
+	uint16_t gainB = kGainOne;
+	float gamma = 0.5f;
 
-	ColorLookupTable red;
-	ColorLookupTable green;
-	ColorLookupTable blue;
+	uint8_t denoise = 0;
+	uint8_t sharpen = 0;
+	uint8_t temporal = 0;
+	uint8_t noiseLevel = 0;
 };
 
 } /* namespace libcamera */
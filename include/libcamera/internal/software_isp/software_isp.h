@@ -51,6 +51,8 @@ public:
 
 	bool isValid() const;
 
+	std::size_t sharedMemorySize() const;
+
 	std::vector<PixelFormat> formats(PixelFormat input);
 
 	SizeRange sizes(PixelFormat inputFormat, const Size &inputSize);
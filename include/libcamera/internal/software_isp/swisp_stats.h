@@ -44,6 +44,49 @@ struct SwIspStats {
 	 * \brief A histogram of luminance values
 	 */
 	Histogram yHistogram;
+	/**
+	 * \brief Number of zone columns in the AWB grid
+	 */
+	static constexpr unsigned int kAwbGridWidth = 16;
+	/**
+	 * \brief Number of zone rows in the AWB grid
+	 */
+	static constexpr unsigned int kAwbGridHeight = 12;
+	/**
+	 * \brief Colour sums of one zone of the AWB grid
+	 *
+	 * The sums are not scaled, they must be divided by sampleDivisor to
+	 * get 8-bit sample values.
+	 */
+	struct AwbZone {
+		/**
+		 * \brief Sum of the sampled red pixels in the zone
+		 */
+		uint32_t sumR;
+		/**
+		 * \brief Sum of the sampled green pixels in the zone
+		 */
+		uint32_t sumG;
+		/**
+		 * \brief Sum of the sampled blue pixels in the zone
+		 */
+		uint32_t sumB;
+		/**
+		 * \brief Number of samples in the zone
+		 */
+		uint32_t count;
+	};
+	/**
+	 * \brief Colour sums of the zones of the image, in raster order
+	 */
+	std::array<AwbZone, kAwbGridWidth * kAwbGridHeight> awbGrid;
+	/**
+	 * \brief Divisor scaling the sampled pixel values to 8 bits
+	 *
+	 * This applies to the sums of the AWB grid zones and to the sums of
+	 * the whole image.
+	 */
+	uint32_t sampleDivisor;
 };
 
 } /* namespace libcamera */
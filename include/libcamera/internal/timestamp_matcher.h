@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Timestamp-based matching of frames from multiple streams
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace libcamera {
+
+template<typename T>
+class TimestampMatcher
+{
+public:
+	TimestampMatcher(unsigned int count)
+		: queues_(count), tolerance_(2000000), maxPending_(4)
+	{
+	}
+
+	void setTolerance(int64_t tolerance) { tolerance_ = tolerance; }
+	int64_t tolerance() const { return tolerance_; }
+
+	void setMaxPending(unsigned int count) { maxPending_ = std::max(count, 1U); }
+	unsigned int maxPending() const { return maxPending_; }
+
+	void add(unsigned int index, int64_t timestamp, int64_t frameDuration,
+		 const T &item, std::vector<T> *dropped,
+		 std::vector<std::vector<T>> *sets)
+	{
+		Queue &queue = queues_[index];
+
+		if (frameDuration)
+			queue.frameDuration = frameDuration;
+		else if (queue.lastTimestamp && timestamp > queue.lastTimestamp)
+			queue.frameDuration = timestamp - queue.lastTimestamp;
+		queue.lastTimestamp = timestamp;
+
+		queue.pending.emplace_back(timestamp, item);
+
+		/* Bound the buffering by dropping the oldest item. */
+		while (queue.pending.size() > maxPending_) {
+			dropped->push_back(queue.pending.front().second);
+			queue.pending.pop_front();
+		}
+
+		match(dropped, sets);
+	}
+
+	void flush(std::vector<T> *dropped)
+	{
+		for (Queue &queue : queues_) {
+			for (const auto &[timestamp, item] : queue.pending)
+				dropped->push_back(item);
+
+			queue = {};
+		}
+	}
+
+	unsigned int pending(unsigned int index) const { return queues_[index].pending.size(); }
+	int64_t frameDuration(unsigned int index) const { return queues_[index].frameDuration; }
+	int64_t phaseError(unsigned int index) const { return queues_[index].phaseError; }
+
+private:
+	struct Queue {
+		std::deque<std::pair<int64_t, T>> pending;
+		int64_t lastTimestamp = 0;
+		int64_t frameDuration = 0;
+		int64_t phaseError = 0;
+	};
+
+	void match(std::vector<T> *dropped, std::vector<std::vector<T>> *sets)
+	{
+		while (true) {
+			int64_t latest = 0;
+
+			for (const Queue &queue : queues_) {
+				if (queue.pending.empty())
+					return;
+
+				latest = std::max(latest, queue.pending.front().first);
+			}
+
+			updatePhase();
+
+			bool matched = true;
+
+			for (Queue &queue : queues_) {
+				if (queue.pending.front().first >= latest - tolerance_)
+					continue;
+
+				dropped->push_back(queue.pending.front().second);
+				queue.pending.pop_front();
+				matched = false;
+			}
+
+			if (!matched)
+				continue;
+
+			std::vector<T> set;
+			set.reserve(queues_.size());
+
+			for (Queue &queue : queues_) {
+				set.push_back(queue.pending.front().second);
+				queue.pending.pop_front();
+			}
+
+			sets->push_back(std::move(set));
+		}
+	}
+
+	void updatePhase()
+	{
+		const Queue &reference = queues_[0];
+		const int64_t duration = reference.frameDuration;
+
+		if (!duration)
+			return;
+
+		const int64_t base = reference.pending.front().first;
+
+		for (Queue &queue : queues_) {
+			int64_t offset = (queue.pending.front().first - base) % duration;
+			if (offset >= duration / 2)
+				offset -= duration;
+			else if (offset < -duration / 2)
+				offset += duration;
+
+			queue.phaseError = offset;
+		}
+	}
+
+	std::vector<Queue> queues_;
+	int64_t tolerance_;
+	unsigned int maxPending_;
+};
+
+} /* namespace libcamera */
@@ -21,6 +21,7 @@
 
 #include <libcamera/base/class.h>
 #include <libcamera/base/log.h>
+#include <libcamera/base/mutex.h>
 #include <libcamera/base/signal.h>
 #include <libcamera/base/timer.h>
 #include <libcamera/base/unique_fd.h>
@@ -289,6 +290,27 @@ private:
 
 	Timer watchdog_;
 	utils::Duration watchdogDuration_;
+
+	struct TryFormatEntry {
+		V4L2DeviceFormat format;
+		V4L2DeviceFormat result;
+	};
+
+	static constexpr unsigned int kTryFormatCacheSize = 16;
+
+	Mutex tryFormatMutex_;
+	std::vector<TryFormatEntry> tryFormatCache_
+		LIBCAMERA_TSA_GUARDED_BY(tryFormatMutex_);
+
+	/*
+	 * The other queue of a memory-to-memory device, whose format affects
+	 * the results of tryFormat(), and the number of formats set on it when
+	 * the cache was last valid.
+	 */
+	friend class V4L2M2MDevice;
+	V4L2VideoDevice *m2mPeer_;
+	std::atomic<unsigned int> formatGeneration_;
+	unsigned int peerFormatGeneration_ LIBCAMERA_TSA_GUARDED_BY(tryFormatMutex_);
 };
 
 class V4L2M2MDevice
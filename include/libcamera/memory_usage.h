@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Memory usage accounting
+ */
+
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <stddef.h>
+#include <string>
+
+namespace libcamera {
+
+class MemoryUsage
+{
+public:
+	enum class Purpose {
+		Application,
+		Raw,
+		Statistics,
+		Parameters,
+		EmbeddedData,
+		Processing,
+	};
+
+	enum class Type {
+		DmaBuf,
+		SharedMemory,
+	};
+
+	MemoryUsage();
+
+	void add(Purpose purpose, Type type, std::size_t size);
+	void remove(Purpose purpose, Type type, std::size_t size);
+
+	std::size_t size(Purpose purpose, Type type) const;
+	std::size_t size(Purpose purpose) const;
+	std::size_t size(Type type) const;
+	std::size_t total() const;
+
+	std::string toString() const;
+
+private:
+	static constexpr unsigned int kNumPurposes =
+		static_cast<unsigned int>(Purpose::Processing) + 1;
+	static constexpr unsigned int kNumTypes =
+		static_cast<unsigned int>(Type::SharedMemory) + 1;
+
+	std::array<std::array<std::size_t, kNumTypes>, kNumPurposes> sizes_;
+};
+
+std::ostream &operator<<(std::ostream &out, MemoryUsage::Purpose purpose);
+std::ostream &operator<<(std::ostream &out, MemoryUsage::Type type);
+std::ostream &operator<<(std::ostream &out, const MemoryUsage &usage);
+
+} /* namespace libcamera */
@@ -10,18 +10,31 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <ctype.h>
+#include <errno.h>
+#include <fstream>
+#include <iomanip>
 #include <map>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <type_traits>
+#include <unistd.h>
 
 #include <hardware/camera3.h>
 
+#include <libcamera/base/file.h>
 #include <libcamera/base/log.h>
+#include <libcamera/base/utils.h>
 
+#include <libcamera/camera_manager.h>
 #include <libcamera/control_ids.h>
 #include <libcamera/controls.h>
 #include <libcamera/property_ids.h>
 
 #include "libcamera/internal/formats.h"
+#include "libcamera/internal/yaml_parser.h"
 
 using namespace libcamera;
 
@@ -220,6 +233,24 @@ std::vector<U> setMetadata(CameraMetadata *metadata, uint32_t tag,
 	return values;
 }
 
+/*
+ * Create the directory \a dir and all its missing parents.
+ */
+int createDirectories(const std::string &dir)
+{
+	std::string::size_type pos = 0;
+
+	while (pos != std::string::npos) {
+		pos = dir.find('/', pos + 1);
+
+		std::string path = dir.substr(0, pos);
+		if (mkdir(path.c_str(), 0755) && errno != EEXIST)
+			return -errno;
+	}
+
+	return 0;
+}
+
 } /* namespace */
 
 bool CameraCapabilities::validateManualSensorCapability()
@@ -414,10 +445,24 @@ int CameraCapabilities::initialize(std::shared_ptr<Camera> camera,
 		return ret;
 	}
 
-	ret = initializeStreamConfigurations();
-	if (ret) {
-		camera_->release();
-		return ret;
+	/*
+	 * Probing the stream configurations requires validating and
+	 * configuring the camera for every supported format and resolution,
+	 * which is slow. Use the results cached by a previous run if they are
+	 * still valid.
+	 */
+	std::string cachePath = cacheFilePath();
+	uint64_t key = cachePath.empty() ? 0 : cacheKey();
+
+	if (cachePath.empty() || loadStreamConfigurations(cachePath, key)) {
+		ret = initializeStreamConfigurations();
+		if (ret) {
+			camera_->release();
+			return ret;
+		}
+
+		if (!cachePath.empty())
+			saveStreamConfigurations(cachePath, key);
 	}
 
 	ret = initializeStaticMetadata();
@@ -655,6 +700,9 @@ int CameraCapabilities::initializeStreamConfigurations()
 			if (ret)
 				return ret;
 
+			configuredFormat_ = cfg.pixelFormat;
+			configuredSize_ = cfg.size;
+
 			const ControlInfoMap &controls = camera_->controls();
 			const auto frameDurations = controls.find(
 				&controls::FrameDurationLimits);
@@ -756,6 +804,235 @@ int CameraCapabilities::initializeStreamConfigurations()
 	return 0;
 }
 
+/*
+ * Return the path of the file caching the stream configurations of the camera,
+ * or an empty string if caching is disabled.
+ */
+std::string CameraCapabilities::cacheFilePath() const
+{
+	const char *dir = utils::secure_getenv("LIBCAMERA_HAL_CACHE_DIR");
+	if (!dir || !*dir)
+		return {};
+
+	/* Camera IDs are system paths, turn them into a file name. */
+	std::string name = camera_->id();
+	std::replace_if(name.begin(), name.end(),
+			[](char c) { return !isalnum(c) && c != '-' && c != '.'; },
+			'_');
+
+	return std::string(dir) + "/" + name + ".yaml";
+}
+
+/*
+ * Compute the key that identifies valid cached stream configurations. It
+ * covers the libcamera version and the camera capabilities reported by the
+ * pipeline handler without configuring the camera, which reflect the pipeline
+ * handler configuration.
+ */
+uint64_t CameraCapabilities::cacheKey() const
+{
+	std::stringstream ss;
+
+	ss << CameraManager::version() << ";" << camera_->id() << ";";
+
+	for (StreamRole role : { StreamRole::StillCapture, StreamRole::Raw }) {
+		std::unique_ptr<CameraConfiguration> config =
+			camera_->generateConfiguration({ role });
+		if (!config)
+			continue;
+
+		const StreamConfiguration &cfg = config->at(0);
+		ss << cfg.toString() << ";";
+
+		const StreamFormats &formats = cfg.formats();
+		for (const PixelFormat &format : formats.pixelformats()) {
+			ss << format << ":" << formats.range(format).toString();
+			for (const Size &size : formats.sizes(format))
+				ss << "," << size;
+			ss << ";";
+		}
+	}
+
+	for (const auto &[id, value] : camera_->properties())
+		ss << id << "=" << value.toString() << ";";
+
+	for (const auto &[id, info] : camera_->controls())
+		ss << id->name() << "=" << info.toString() << ";";
+
+	/* 64-bit FNV-1a hash. */
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (char c : ss.str()) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/*
+ * Load the stream configurations from the cache file at \a path, if it
+ * matches the cache \a key. The camera is then configured with the last
+ * configuration probed when the cache was created, both to check that the
+ * cache is still valid and to leave the camera in the same state for
+ * initializeStaticMetadata() as initializeStreamConfigurations() does.
+ *
+ * Return 0 on success, or a negative error code if the cache is missing or
+ * invalid, in which case the stream configurations must be probed.
+ */
+int CameraCapabilities::loadStreamConfigurations(const std::string &path,
+						 uint64_t key)
+{
+	File file(path);
+	if (!file.open(File::OpenModeFlag::ReadOnly))
+		return -ENOENT;
+
+	std::unique_ptr<YamlObject> root = YamlParser::parse(file);
+	if (!root)
+		return -EINVAL;
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << key;
+	if ((*root)["key"].get<std::string>() != ss.str()) {
+		LOG(HAL, Debug) << "Stale stream configurations cache " << path;
+		return -EINVAL;
+	}
+
+	std::map<int, PixelFormat> formatsMap;
+	for (const YamlObject &entry : (*root)["formats"].asList()) {
+		std::optional<int32_t> androidFormat = entry[0].get<int32_t>();
+		PixelFormat format = PixelFormat::fromString(entry[1].get<std::string>(""));
+		if (!androidFormat || !format.isValid())
+			return -EINVAL;
+
+		formatsMap[*androidFormat] = format;
+	}
+
+	std::vector<Camera3StreamConfiguration> streamConfigurations;
+	for (const YamlObject &entry : (*root)["stream-configurations"].asList()) {
+		std::optional<Size> resolution = entry[0].get<Size>();
+		std::optional<int32_t> androidFormat = entry[1].get<int32_t>();
+		std::optional<double> minFrameDuration = entry[2].get<double>();
+		std::optional<double> maxFrameDuration = entry[3].get<double>();
+		if (!resolution || !androidFormat || !minFrameDuration ||
+		    !maxFrameDuration)
+			return -EINVAL;
+
+		streamConfigurations.push_back({
+			*resolution, *androidFormat,
+			static_cast<int64_t>(*minFrameDuration),
+			static_cast<int64_t>(*maxFrameDuration),
+		});
+	}
+
+	std::optional<double> maxFrameDuration = (*root)["max-frame-duration"].get<double>();
+	std::optional<uint32_t> maxJpegBufferSize = (*root)["max-jpeg-buffer-size"].get<uint32_t>();
+	std::optional<bool> rawStreamAvailable = (*root)["raw-stream-available"].get<bool>();
+	PixelFormat configuredFormat =
+		PixelFormat::fromString((*root)["configured-format"].get<std::string>(""));
+	std::optional<Size> configuredSize = (*root)["configured-size"].get<Size>();
+
+	if (formatsMap.empty() || streamConfigurations.empty() ||
+	    !maxFrameDuration || !maxJpegBufferSize || !rawStreamAvailable ||
+	    !configuredFormat.isValid() || !configuredSize) {
+		LOG(HAL, Warning) << "Invalid stream configurations cache " << path;
+		return -EINVAL;
+	}
+
+	/* Revalidate the cache by applying the last probed configuration. */
+	std::unique_ptr<CameraConfiguration> cameraConfig =
+		camera_->generateConfiguration({ StreamRole::StillCapture });
+	if (!cameraConfig)
+		return -EINVAL;
+
+	StreamConfiguration &cfg = cameraConfig->at(0);
+	cfg.pixelFormat = configuredFormat;
+	cfg.size = *configuredSize;
+
+	if (cameraConfig->validate() == CameraConfiguration::Invalid ||
+	    cfg.pixelFormat != configuredFormat || cfg.size != *configuredSize ||
+	    camera_->configure(cameraConfig.get())) {
+		LOG(HAL, Warning)
+			<< "Cached stream configurations are not valid anymore";
+		return -EINVAL;
+	}
+
+	formatsMap_ = std::move(formatsMap);
+	streamConfigurations_ = std::move(streamConfigurations);
+	maxFrameDuration_ = *maxFrameDuration;
+	maxJpegBufferSize_ = *maxJpegBufferSize;
+	rawStreamAvailable_ = *rawStreamAvailable;
+	configuredFormat_ = configuredFormat;
+	configuredSize_ = *configuredSize;
+
+	LOG(HAL, Debug) << "Loaded stream configurations from " << path;
+
+	return 0;
+}
+
+/*
+ * Store the stream configurations in the cache file at \a path. Failures are
+ * not fatal, the configurations will be probed again next time.
+ */
+void CameraCapabilities::saveStreamConfigurations(const std::string &path,
+						  uint64_t key) const
+{
+	std::string dir = path.substr(0, path.rfind('/'));
+	int ret = createDirectories(dir);
+	if (ret) {
+		LOG(HAL, Info)
+			<< "Not caching stream configurations, can't create "
+			<< dir << ": " << strerror(-ret);
+		return;
+	}
+
+	/*
+	 * Write the cache to a temporary file first and rename it, to avoid
+	 * leaving a truncated cache behind if the HAL is interrupted.
+	 */
+	std::string tmpPath = path + ".tmp";
+	std::ofstream out(tmpPath, std::ios::trunc);
+	if (!out) {
+		LOG(HAL, Info)
+			<< "Not caching stream configurations, can't create "
+			<< tmpPath;
+		return;
+	}
+
+	out << "# Stream configurations cache, generated by libcamera "
+	    << CameraManager::version() << "\n";
+	out << "key: \"" << std::hex << std::setw(16) << std::setfill('0')
+	    << key << std::dec << "\"\n";
+	out << "raw-stream-available: " << (rawStreamAvailable_ ? "true" : "false") << "\n";
+	out << "max-frame-duration: " << maxFrameDuration_ << "\n";
+	out << "max-jpeg-buffer-size: " << maxJpegBufferSize_ << "\n";
+	out << "configured-format: \"" << configuredFormat_ << "\"\n";
+	out << "configured-size: [ " << configuredSize_.width << ", "
+	    << configuredSize_.height << " ]\n";
+
+	out << "formats:\n";
+	for (const auto &[androidFormat, format] : formatsMap_)
+		out << "  - [ " << androidFormat << ", \"" << format << "\" ]\n";
+
+	out << "stream-configurations:\n";
+	for (const Camera3StreamConfiguration &entry : streamConfigurations_)
+		out << "  - [ [ " << entry.resolution.width << ", "
+		    << entry.resolution.height << " ], "
+		    << entry.androidFormat << ", "
+		    << entry.minFrameDurationNsec << ", "
+		    << entry.maxFrameDurationNsec << " ]\n";
+
+	out.close();
+	if (!out || rename(tmpPath.c_str(), path.c_str())) {
+		LOG(HAL, Info)
+			<< "Not caching stream configurations, can't write "
+			<< path;
+		unlink(tmpPath.c_str());
+		return;
+	}
+
+	LOG(HAL, Debug) << "Stored stream configurations in " << path;
+}
+
 int CameraCapabilities::initializeStaticMetadata()
 {
 	staticMetadata_ = std::make_unique<CameraMetadata>(64, 1024);
@@ -10,6 +10,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <string>
 #include <vector>
 
 #include <libcamera/base/class.h>
@@ -64,6 +65,11 @@ private:
 	initializeRawResolutions(const libcamera::PixelFormat &pixelFormat);
 	int initializeStreamConfigurations();
 
+	std::string cacheFilePath() const;
+	uint64_t cacheKey() const;
+	int loadStreamConfigurations(const std::string &path, uint64_t key);
+	void saveStreamConfigurations(const std::string &path, uint64_t key) const;
+
 	int initializeStaticMetadata();
 
 	std::shared_ptr<libcamera::Camera> camera_;
@@ -77,6 +83,8 @@ private:
 
 	std::vector<Camera3StreamConfiguration> streamConfigurations_;
 	std::map<int, libcamera::PixelFormat> formatsMap_;
+	libcamera::PixelFormat configuredFormat_;
+	libcamera::Size configuredSize_;
 	std::unique_ptr<CameraMetadata> staticMetadata_;
 	unsigned int maxJpegBufferSize_;
 
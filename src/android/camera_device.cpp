@@ -11,6 +11,7 @@
 #include <fstream>
 #include <set>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
@@ -38,6 +39,31 @@ LOG_DECLARE_CATEGORY(HAL)
 
 namespace {
 
+/*
+ * Check if the file descriptors of the planes of \a buffer refer to the same
+ * files as the ones of \a handle.
+ */
+bool isSameBuffer(const FrameBuffer &buffer, const buffer_handle_t handle)
+{
+	const std::vector<FrameBuffer::Plane> &planes = buffer.planes();
+	if (planes.size() > static_cast<size_t>(handle->numFds))
+		return false;
+
+	for (size_t i = 0; i < planes.size(); ++i) {
+		struct stat cached, current;
+
+		if (fstat(planes[i].fd.get(), &cached) ||
+		    fstat(handle->data[i], &current))
+			return false;
+
+		if (cached.st_dev != current.st_dev ||
+		    cached.st_ino != current.st_ino)
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * \struct Camera3StreamConfig
  * \brief Data to store StreamConfiguration associated with camera3_stream(s)
@@ -439,6 +465,7 @@ void CameraDevice::stop()
 	{
 		MutexLocker descriptorsLock(descriptorsMutex_);
 		descriptors_ = {};
+		frameBufferCache_.clear();
 	}
 
 	streams_.clear();
@@ -580,9 +607,16 @@ int CameraDevice::configureStreams(camera3_stream_configuration_t *stream_list)
 		if (!format.isValid())
 			return -EINVAL;
 
-		/* \todo Support rotation. */
-		if (stream->rotation != CAMERA3_STREAM_ROTATION_0) {
-			LOG(HAL, Error) << "Rotation is not supported";
+		/*
+		 * Rotated streams are produced by rotating an internal NV12
+		 * stream in software.
+		 *
+		 * \todo Support rotation of other formats.
+		 */
+		if (stream->rotation != CAMERA3_STREAM_ROTATION_0 &&
+		    (stream->format == HAL_PIXEL_FORMAT_BLOB ||
+		     format != formats::NV12)) {
+			LOG(HAL, Error) << "Rotation is only supported for NV12 streams";
 			return -EINVAL;
 		}
 #if defined(OS_CHROMEOS)
@@ -605,9 +639,31 @@ int CameraDevice::configureStreams(camera3_stream_configuration_t *stream_list)
 		}
 
 		Camera3StreamConfig streamConfig;
+		streamConfig.config.pixelFormat = format;
+
+		if (stream->rotation != CAMERA3_STREAM_ROTATION_0) {
+			/*
+			 * The stream size is the size after rotation, capture
+			 * frames with the size before rotation.
+			 */
+			if (stream->rotation != CAMERA3_STREAM_ROTATION_180)
+				size = Size(size.height, size.width);
+
+			streamConfig.streams = { { stream, CameraStream::Type::Internal } };
+			streamConfig.config.size = size;
+
+			LOG(HAL, Info) << "Adding " << streamConfig.config.toString()
+				       << " for rotation support";
+
+			streamConfigs.push_back(std::move(streamConfig));
+
+			/* This stream will be produced by software. */
+			stream->usage |= GRALLOC_USAGE_SW_WRITE_OFTEN;
+			continue;
+		}
+
 		streamConfig.streams = { { stream, CameraStream::Type::Direct } };
 		streamConfig.config.size = size;
-		streamConfig.config.pixelFormat = format;
 		streamConfigs.push_back(std::move(streamConfig));
 
 		/* This stream will be produced by hardware. */
@@ -624,6 +680,10 @@ int CameraDevice::configureStreams(camera3_stream_configuration_t *stream_list)
 			Camera3StreamConfig &streamConfig = streamConfigs[i];
 			const auto &cfg = streamConfig.config;
 
+			/* Rotated streams can't be shared with the JPEG stream. */
+			if (streamConfig.streams[0].type != CameraStream::Type::Direct)
+				continue;
+
 			/*
 			 * \todo The PixelFormat must also be compatible with
 			 * the encoder.
@@ -741,6 +801,40 @@ int CameraDevice::configureStreams(camera3_stream_configuration_t *stream_list)
 	}
 
 	config_ = std::move(config);
+
+	/*
+	 * Preallocate request descriptors for the maximum number of requests
+	 * the framework can have in flight, as bounded by the number of
+	 * buffers of the streams. The pool grows on demand if needed.
+	 */
+	unsigned int maxRequests = 1;
+	for (const StreamConfiguration &cfg : *config_)
+		maxRequests = std::max(maxRequests, cfg.bufferCount);
+
+	/*
+	 * Size the cache of FrameBuffer instances wrapping the buffers of
+	 * direct streams to hold all the buffers the framework can allocate.
+	 */
+	unsigned int maxFrameBuffers = 0;
+	for (const CameraStream &cameraStream : streams_) {
+		if (cameraStream.type() == CameraStream::Type::Direct)
+			maxFrameBuffers += cameraStream.camera3Stream()->max_buffers;
+	}
+
+	{
+		MutexLocker descriptorsLock(descriptorsMutex_);
+
+		descriptorPool_.clear();
+		descriptorPool_.reserve(maxRequests);
+		for (unsigned int i = 0; i < maxRequests; ++i)
+			descriptorPool_.push_back(
+				std::make_unique<Camera3RequestDescriptor>(camera_.get()));
+
+		frameBufferCache_.clear();
+		frameBufferCache_.reserve(maxFrameBuffers + streams_.size());
+		maxCachedFrameBuffers_ = maxFrameBuffers;
+	}
+
 	return 0;
 }
 
@@ -770,6 +864,40 @@ CameraDevice::createFrameBuffer(const buffer_handle_t camera3buffer,
 	return std::make_unique<HALFrameBuffer>(planes, camera3buffer);
 }
 
+/*
+ * \brief Get a FrameBuffer wrapping a buffer of a direct stream
+ *
+ * The framework cycles through a small set of buffers for each stream. Reuse
+ * the FrameBuffer created for a previous request on the same buffer if there
+ * is one, and create a new one otherwise. As the framework may reuse a buffer
+ * handle for a different buffer, a cached FrameBuffer is only reused if its
+ * file descriptors still refer to the same dmabufs as the handle.
+ */
+std::unique_ptr<HALFrameBuffer>
+CameraDevice::getFrameBuffer(const buffer_handle_t camera3buffer,
+			     PixelFormat pixelFormat, const Size &size)
+{
+	std::unique_ptr<HALFrameBuffer> cached;
+
+	{
+		MutexLocker descriptorsLock(descriptorsMutex_);
+
+		auto it = std::find_if(frameBufferCache_.begin(), frameBufferCache_.end(),
+				       [camera3buffer](const auto &buffer) {
+					       return buffer->handle() == camera3buffer;
+				       });
+		if (it != frameBufferCache_.end()) {
+			cached = std::move(*it);
+			frameBufferCache_.erase(it);
+		}
+	}
+
+	if (cached && isSameBuffer(*cached, camera3buffer))
+		return cached;
+
+	return createFrameBuffer(camera3buffer, pixelFormat, size);
+}
+
 int CameraDevice::processControls(Camera3RequestDescriptor *descriptor)
 {
 	const CameraMetadata &settings = descriptor->settings_;
@@ -910,11 +1038,11 @@ int CameraDevice::processCaptureRequest(camera3_capture_request_t *camera3Reques
 
 	/*
 	 * Save the request descriptors for use at completion time.
-	 * The descriptor and the associated memory reserved here are freed
-	 * at request complete time.
+	 * The descriptor is taken from the pool, and returned to it with the
+	 * associated memory released at request complete time.
 	 */
-	auto descriptor = std::make_unique<Camera3RequestDescriptor>(camera_.get(),
-								     camera3Request);
+	std::unique_ptr<Camera3RequestDescriptor> descriptor =
+		acquireDescriptor(camera3Request);
 
 	/*
 	 * \todo The Android request model is incremental, settings passed in
@@ -923,7 +1051,7 @@ int CameraDevice::processCaptureRequest(camera3_capture_request_t *camera3Reques
 	 * it handled by the Android camera service ?
 	 */
 	if (camera3Request->settings)
-		lastSettings_ = camera3Request->settings;
+		lastSettings_.assign(camera3Request->settings);
 
 	descriptor->settings_ = lastSettings_;
 
@@ -971,9 +1099,9 @@ int CameraDevice::processCaptureRequest(camera3_capture_request_t *camera3Reques
 			 * lifetime management only.
 			 */
 			buffer.frameBuffer =
-				createFrameBuffer(*buffer.camera3Buffer,
-						  cameraStream->configuration().pixelFormat,
-						  cameraStream->configuration().size);
+				getFrameBuffer(*buffer.camera3Buffer,
+					       cameraStream->configuration().pixelFormat,
+					       cameraStream->configuration().size);
 			frameBuffer = buffer.frameBuffer.get();
 			acquireFence = std::move(buffer.fence);
 			LOG(HAL, Debug) << ss.str() << " (direct)";
@@ -1169,8 +1297,7 @@ void CameraDevice::requestComplete(Request *request)
 	 * Notify if the metadata generation has failed, but continue processing
 	 * buffers and return an empty metadata pack.
 	 */
-	descriptor->resultMetadata_ = getResultMetadata(*descriptor);
-	if (!descriptor->resultMetadata_) {
+	if (!getResultMetadata(*descriptor, &descriptor->resultMetadata_)) {
 		notifyError(descriptor->frameNumber_, nullptr, CAMERA3_MSG_ERROR_RESULT);
 
 		/*
@@ -1179,7 +1306,7 @@ void CameraDevice::requestComplete(Request *request)
 		 * \todo Check that the post-processor code handles this situation
 		 * correctly.
 		 */
-		descriptor->resultMetadata_ = std::make_unique<CameraMetadata>(0, 0);
+		descriptor->resultMetadata_.reset(0, 0);
 	}
 
 	/* Handle post-processing. */
@@ -1269,12 +1396,10 @@ void CameraDevice::sendCaptureResults()
 
 		captureResult.frame_number = descriptor->frameNumber_;
 
-		if (descriptor->resultMetadata_)
-			captureResult.result =
-				descriptor->resultMetadata_->getMetadata();
+		captureResult.result = descriptor->resultMetadata_.getMetadata();
 
-		std::vector<camera3_stream_buffer_t> resultBuffers;
-		resultBuffers.reserve(descriptor->buffers_.size());
+		std::vector<camera3_stream_buffer_t> &resultBuffers = resultBuffers_;
+		resultBuffers.clear();
 
 		for (auto &buffer : descriptor->buffers_) {
 			camera3_buffer_status status = CAMERA3_BUFFER_STATUS_ERROR;
@@ -1300,9 +1425,73 @@ void CameraDevice::sendCaptureResults()
 			captureResult.partial_result = 1;
 
 		callbacks_->process_capture_result(callbacks_, &captureResult);
+
+		releaseDescriptor(std::move(descriptor));
 	}
 }
 
+/**
+ * \brief Get a request descriptor to track a capture request
+ * \param[in] camera3Request The capture request placed by the framework
+ *
+ * Take a descriptor from the pool preallocated by configureStreams(), or
+ * allocate a new one if all descriptors are in use, and prepare it to track
+ * \a camera3Request.
+ *
+ * \return The request descriptor
+ */
+std::unique_ptr<Camera3RequestDescriptor>
+CameraDevice::acquireDescriptor(const camera3_capture_request_t *camera3Request)
+{
+	std::unique_ptr<Camera3RequestDescriptor> descriptor;
+
+	{
+		MutexLocker descriptorsLock(descriptorsMutex_);
+
+		if (!descriptorPool_.empty()) {
+			descriptor = std::move(descriptorPool_.back());
+			descriptorPool_.pop_back();
+		}
+	}
+
+	if (!descriptor) {
+		LOG(HAL, Debug) << "Request descriptor pool exhausted";
+		descriptor = std::make_unique<Camera3RequestDescriptor>(camera_.get());
+	}
+
+	descriptor->reuse(camera3Request);
+
+	return descriptor;
+}
+
+/**
+ * \brief Return a completed request descriptor to the pool
+ * \param[in] descriptor The request descriptor
+ *
+ * Release the resources associated with the capture request tracked by the
+ * \a descriptor, and store it for reuse by a later capture request.
+ */
+void CameraDevice::releaseDescriptor(std::unique_ptr<Camera3RequestDescriptor> descriptor)
+{
+	/*
+	 * Keep the FrameBuffer instances of direct streams for reuse by later
+	 * requests on the same buffers. The cache is ordered from the least to
+	 * the most recently used, drop the oldest entries beyond its capacity
+	 * once the descriptor has released its libcamera::Request.
+	 */
+	for (Camera3RequestDescriptor::StreamBuffer &buffer : descriptor->buffers_) {
+		if (buffer.frameBuffer)
+			frameBufferCache_.push_back(std::move(buffer.frameBuffer));
+	}
+
+	descriptor->clear();
+	descriptorPool_.push_back(std::move(descriptor));
+
+	if (frameBufferCache_.size() > maxCachedFrameBuffers_)
+		frameBufferCache_.erase(frameBufferCache_.begin(),
+					frameBufferCache_.end() - maxCachedFrameBuffers_);
+}
+
 void CameraDevice::setBufferStatus(Camera3RequestDescriptor::StreamBuffer &streamBuffer,
 				   Camera3RequestDescriptor::Status status)
 {
@@ -1386,10 +1575,11 @@ void CameraDevice::notifyError(uint32_t frameNumber, camera3_stream_t *stream,
 }
 
 /*
- * Produce a set of fixed result metadata.
+ * Produce a set of fixed result metadata in \a resultMetadata, reusing its
+ * storage from previous requests.
  */
-std::unique_ptr<CameraMetadata>
-CameraDevice::getResultMetadata(const Camera3RequestDescriptor &descriptor) const
+bool CameraDevice::getResultMetadata(const Camera3RequestDescriptor &descriptor,
+				     CameraMetadata *resultMetadata) const
 {
 	const ControlList &metadata = descriptor.request_->metadata();
 	const CameraMetadata &settings = descriptor.settings_;
@@ -1412,11 +1602,9 @@ CameraDevice::getResultMetadata(const Camera3RequestDescriptor &descriptor) cons
 	 * ANDROID_JPEG_THUMBNAIL_SIZE (int32 x 2) = 8 bytes
 	 * Total bytes for JPEG metadata: 82
 	 */
-	std::unique_ptr<CameraMetadata> resultMetadata =
-		std::make_unique<CameraMetadata>(88, 166);
-	if (!resultMetadata->isValid()) {
+	if (!resultMetadata->reset(88, 166)) {
 		LOG(HAL, Error) << "Failed to allocate result metadata";
-		return nullptr;
+		return false;
 	}
 
 	/*
@@ -1584,5 +1772,5 @@ CameraDevice::getResultMetadata(const Camera3RequestDescriptor &descriptor) cons
 			<< " entries and " << dataCount << " bytes used";
 	}
 
-	return resultMetadata;
+	return true;
 }
@@ -88,19 +88,29 @@ private:
 	createFrameBuffer(const buffer_handle_t camera3buffer,
 			  libcamera::PixelFormat pixelFormat,
 			  const libcamera::Size &size);
+	std::unique_ptr<HALFrameBuffer>
+	getFrameBuffer(const buffer_handle_t camera3buffer,
+		       libcamera::PixelFormat pixelFormat,
+		       const libcamera::Size &size)
+		LIBCAMERA_TSA_EXCLUDES(descriptorsMutex_);
 	void abortRequest(Camera3RequestDescriptor *descriptor) const;
 	bool isValidRequest(camera3_capture_request_t *request) const;
 	void notifyShutter(uint32_t frameNumber, uint64_t timestamp);
 	void notifyError(uint32_t frameNumber, camera3_stream_t *stream,
 			 camera3_error_msg_code code) const;
 	int processControls(Camera3RequestDescriptor *descriptor);
+	std::unique_ptr<Camera3RequestDescriptor>
+	acquireDescriptor(const camera3_capture_request_t *camera3Request)
+		LIBCAMERA_TSA_EXCLUDES(descriptorsMutex_);
+	void releaseDescriptor(std::unique_ptr<Camera3RequestDescriptor> descriptor)
+		LIBCAMERA_TSA_REQUIRES(descriptorsMutex_);
 	void completeDescriptor(Camera3RequestDescriptor *descriptor)
 		LIBCAMERA_TSA_EXCLUDES(descriptorsMutex_);
 	void sendCaptureResults() LIBCAMERA_TSA_REQUIRES(descriptorsMutex_);
 	void setBufferStatus(Camera3RequestDescriptor::StreamBuffer &buffer,
 			     Camera3RequestDescriptor::Status status);
-	std::unique_ptr<CameraMetadata> getResultMetadata(
-		const Camera3RequestDescriptor &descriptor) const;
+	bool getResultMetadata(const Camera3RequestDescriptor &descriptor,
+			       CameraMetadata *resultMetadata) const;
 
 	unsigned int id_;
 	camera3_device_t camera3Device_;
@@ -120,6 +130,14 @@ private:
 	libcamera::Mutex descriptorsMutex_ LIBCAMERA_TSA_ACQUIRED_AFTER(stateMutex_);
 	std::queue<std::unique_ptr<Camera3RequestDescriptor>> descriptors_
 		LIBCAMERA_TSA_GUARDED_BY(descriptorsMutex_);
+	std::vector<std::unique_ptr<Camera3RequestDescriptor>> descriptorPool_
+		LIBCAMERA_TSA_GUARDED_BY(descriptorsMutex_);
+	std::vector<std::unique_ptr<HALFrameBuffer>> frameBufferCache_
+		LIBCAMERA_TSA_GUARDED_BY(descriptorsMutex_);
+	unsigned int maxCachedFrameBuffers_
+		LIBCAMERA_TSA_GUARDED_BY(descriptorsMutex_) = 0;
+	std::vector<camera3_stream_buffer_t> resultBuffers_
+		LIBCAMERA_TSA_GUARDED_BY(descriptorsMutex_);
 
 	std::string maker_;
 	std::string model_;
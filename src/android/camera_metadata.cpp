@@ -48,13 +48,69 @@ CameraMetadata &CameraMetadata::operator=(const CameraMetadata &other)
 	if (this == &other)
 		return *this;
 
-	if (metadata_)
+	assign(other.getMetadata());
+
+	return *this;
+}
+
+/*
+ * Copy the entries of \a metadata, reusing the storage of this instance when
+ * it is large enough. Copying a null \a metadata invalidates this instance.
+ */
+void CameraMetadata::assign(const camera_metadata_t *metadata)
+{
+	if (!metadata) {
+		valid_ = false;
+		return;
+	}
+
+	if (!reset(get_camera_metadata_entry_count(metadata),
+		   get_camera_metadata_data_count(metadata)))
+		return;
+
+	if (append_camera_metadata(metadata_, metadata))
+		valid_ = false;
+}
+
+/*
+ * Remove all entries and make this instance valid, with at least the given
+ * capacities. The storage is reused when it is large enough, and reallocated
+ * otherwise.
+ */
+bool CameraMetadata::reset(size_t entryCapacity, size_t dataCapacity)
+{
+	resized_ = false;
+
+	if (metadata_) {
+		size_t currentEntryCapacity = get_camera_metadata_entry_capacity(metadata_);
+		size_t currentDataCapacity = get_camera_metadata_data_capacity(metadata_);
+
+		if (currentEntryCapacity >= entryCapacity &&
+		    currentDataCapacity >= dataCapacity) {
+			place_camera_metadata(metadata_,
+					      get_camera_metadata_size(metadata_),
+					      currentEntryCapacity,
+					      currentDataCapacity);
+			valid_ = true;
+			return true;
+		}
+
 		free_camera_metadata(metadata_);
+	}
 
-	metadata_ = clone_camera_metadata(other.getMetadata());
+	metadata_ = allocate_camera_metadata(entryCapacity, dataCapacity);
 	valid_ = metadata_ != nullptr;
 
-	return *this;
+	return valid_;
+}
+
+/*
+ * Invalidate this instance, keeping its storage for reuse by reset() or
+ * assign().
+ */
+void CameraMetadata::clear()
+{
+	valid_ = false;
 }
 
 std::tuple<size_t, size_t> CameraMetadata::usage() const
@@ -23,6 +23,10 @@ public:
 
 	CameraMetadata &operator=(const CameraMetadata &other);
 
+	void assign(const camera_metadata_t *metadata);
+	bool reset(size_t entryCapacity, size_t dataCapacity);
+	void clear();
+
 	std::tuple<size_t, size_t> usage() const;
 	bool resized() const { return resized_; }
 
@@ -41,7 +41,8 @@ using namespace libcamera;
  * │                                                             │
  * │  processCaptureRequest(camera3_capture_request_t request)   │
  * │                                                             │
- * │   - Create Camera3RequestDescriptor tracking this request   │
+ * │   - Reuse a Camera3RequestDescriptor from the pool to track │
+ * │     this request                                            │
  * │   - Streams requiring post-processing are stored in the     │
  * │     pendingStreamsToProcess map                             │
  * │   - Add this Camera3RequestDescriptor to descriptors' queue │
@@ -106,11 +107,32 @@ using namespace libcamera;
  *   |             | - PostProcessorWorker's thread
  *   |             |
  *   +-------------+
+ *
+ * Descriptors are pooled by the CameraDevice. Once the capture result has been
+ * sent to the framework, the descriptor is cleared and returned to the pool, to
+ * be reused for a later capture request along with its libcamera::Request.
  */
 
-Camera3RequestDescriptor::Camera3RequestDescriptor(
-	Camera *camera, const camera3_capture_request_t *camera3Request)
+Camera3RequestDescriptor::Camera3RequestDescriptor(Camera *camera)
+{
+	/*
+	 * Create the CaptureRequest, stored as a unique_ptr<> to tie its
+	 * lifetime to the descriptor. The request is reused along with the
+	 * descriptor.
+	 */
+	request_ = camera->createRequest(reinterpret_cast<uint64_t>(this));
+}
+
+Camera3RequestDescriptor::~Camera3RequestDescriptor() = default;
+
+/*
+ * \brief Prepare the descriptor to track a new capture request
+ * \param[in] camera3Request The capture request placed by the framework
+ */
+void Camera3RequestDescriptor::reuse(const camera3_capture_request_t *camera3Request)
 {
+	clear();
+
 	frameNumber_ = camera3Request->frame_number;
 
 	/* Copy the camera3 request stream information for later access. */
@@ -127,18 +149,36 @@ Camera3RequestDescriptor::Camera3RequestDescriptor(
 
 		buffers_.emplace_back(stream, buffer, this);
 	}
+}
+
+/*
+ * \brief Release the resources associated with the tracked capture request
+ *
+ * Drop the stream buffers and the buffers of the libcamera::Request, and
+ * invalidate the settings and result metadata, to return the descriptor to the
+ * pool. The vector of stream buffers and the metadata keep their storage for
+ * the next request.
+ *
+ * The libcamera::Request is reused before the stream buffers are dropped, as it
+ * references the FrameBuffer instances they own.
+ */
+void Camera3RequestDescriptor::clear()
+{
+	{
+		libcamera::MutexLocker lock(streamsProcessMutex_);
+		pendingStreamsToProcess_.clear();
+	}
 
-	/* Clone the controls associated with the camera3 request. */
-	settings_ = CameraMetadata(camera3Request->settings);
+	request_->reuse();
+	buffers_.clear();
 
-	/*
-	 * Create the CaptureRequest, stored as a unique_ptr<> to tie its
-	 * lifetime to the descriptor.
-	 */
-	request_ = camera->createRequest(reinterpret_cast<uint64_t>(this));
-}
+	settings_.clear();
+	resultMetadata_.clear();
 
-Camera3RequestDescriptor::~Camera3RequestDescriptor() = default;
+	frameNumber_ = 0;
+	complete_ = false;
+	status_ = Status::Success;
+}
 
 /**
  * \struct Camera3RequestDescriptor::StreamBuffer
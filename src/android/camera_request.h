@@ -62,10 +62,12 @@ public:
 		LIBCAMERA_TSA_GUARDED_BY(streamsProcessMutex_);
 	libcamera::Mutex streamsProcessMutex_;
 
-	Camera3RequestDescriptor(libcamera::Camera *camera,
-				 const camera3_capture_request_t *camera3Request);
+	Camera3RequestDescriptor(libcamera::Camera *camera);
 	~Camera3RequestDescriptor();
 
+	void reuse(const camera3_capture_request_t *camera3Request);
+	void clear();
+
 	bool isPending() const { return !complete_; }
 
 	uint32_t frameNumber_ = 0;
@@ -74,7 +76,7 @@ public:
 
 	CameraMetadata settings_;
 	std::unique_ptr<libcamera::Request> request_;
-	std::unique_ptr<CameraMetadata> resultMetadata_;
+	CameraMetadata resultMetadata_;
 
 	bool complete_ = false;
 	Status status_ = Status::Success;
@@ -14,8 +14,10 @@
 #include <unistd.h>
 
 #include <libcamera/formats.h>
+#include <libcamera/transform.h>
 
 #include "jpeg/post_processor_jpeg.h"
+#include "yuv/post_processor_transform.h"
 #include "yuv/post_processor_yuv.h"
 
 #include "camera_buffer.h"
@@ -94,7 +96,17 @@ int CameraStream::configure()
 
 		switch (outFormat) {
 		case formats::NV12:
-			postProcessor_ = std::make_unique<PostProcessorYuv>();
+			if (camera3Stream_->rotation != CAMERA3_STREAM_ROTATION_0) {
+				/*
+				 * Android rotates counterclockwise, libcamera
+				 * transforms rotate clockwise.
+				 */
+				Transform transform =
+					transformFromRotation(-90 * camera3Stream_->rotation);
+				postProcessor_ = std::make_unique<PostProcessorTransform>(transform);
+			} else {
+				postProcessor_ = std::make_unique<PostProcessorYuv>();
+			}
 			break;
 
 		case formats::MJPEG:
@@ -185,9 +197,14 @@ int CameraStream::process(Camera3RequestDescriptor::StreamBuffer *streamBuffer)
 		streamBuffer->fence.reset();
 	}
 
+	/*
+	 * The destination buffer has the size of the Android stream, which
+	 * differs from the libcamera stream for rotated streams.
+	 */
 	const StreamConfiguration &output = configuration();
+	const Size size(camera3Stream_->width, camera3Stream_->height);
 	streamBuffer->dstBuffer = std::make_unique<CameraBuffer>(
-		*streamBuffer->camera3Buffer, output.pixelFormat, output.size,
+		*streamBuffer->camera3Buffer, output.pixelFormat, size,
 		PROT_READ | PROT_WRITE);
 	if (!streamBuffer->dstBuffer->isValid()) {
 		LOG(HAL, Error) << "Failed to create destination buffer";
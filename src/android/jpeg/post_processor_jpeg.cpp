@@ -116,7 +116,7 @@ void PostProcessorJpeg::process(Camera3RequestDescriptor::StreamBuffer *streamBu
 	ASSERT(destination->numPlanes() == 1);
 
 	const CameraMetadata &requestMetadata = streamBuffer->request->settings_;
-	CameraMetadata *resultMetadata = streamBuffer->request->resultMetadata_.get();
+	CameraMetadata *resultMetadata = &streamBuffer->request->resultMetadata_;
 	camera_metadata_ro_entry_t entry;
 	int ret;
 
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Post Processor rotating YUV frames
+ */
+
+#include "post_processor_transform.h"
+
+#include <array>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/formats.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+#include "libcamera/internal/post_processing.h"
+
+using namespace libcamera;
+
+LOG_DECLARE_CATEGORY(YUV)
+
+PostProcessorTransform::PostProcessorTransform(Transform transform)
+	: transformer_(transform)
+{
+}
+
+int PostProcessorTransform::configure(const StreamConfiguration &inCfg,
+				      const StreamConfiguration &outCfg)
+{
+	/*
+	 * Intermediate buffers are allocated as YCBCR_420_888, restrict the
+	 * source to NV12.
+	 */
+	if (inCfg.pixelFormat != formats::NV12 ||
+	    outCfg.pixelFormat != formats::NV12) {
+		LOG(YUV, Error) << "Unsupported transform from " << inCfg.pixelFormat
+				<< " to " << outCfg.pixelFormat
+				<< " (only NV12 is supported)";
+		return -EINVAL;
+	}
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(formats::NV12);
+
+	sourceCfg_ = inCfg;
+	destinationCfg_ = outCfg;
+	destinationCfg_.stride = info.stride(outCfg.size.width, 0, 1);
+
+	return transformer_.configure(sourceCfg_, destinationCfg_);
+}
+
+void PostProcessorTransform::process(Camera3RequestDescriptor::StreamBuffer *streamBuffer)
+{
+	const FrameBuffer &source = *streamBuffer->srcBuffer;
+	CameraBuffer *destination = streamBuffer->dstBuffer.get();
+
+	if (!isValidBuffers(source, *destination)) {
+		processComplete.emit(streamBuffer, PostProcessor::Status::Error);
+		return;
+	}
+
+	const MappedFrameBuffer sourceMapped(&source, MappedFrameBuffer::MapFlag::Read);
+	if (!sourceMapped.isValid()) {
+		LOG(YUV, Error) << "Failed to mmap camera frame buffer";
+		processComplete.emit(streamBuffer, PostProcessor::Status::Error);
+		return;
+	}
+
+	const std::array<Span<uint8_t>, 2> destinationPlanes = {
+		destination->plane(0),
+		destination->plane(1),
+	};
+
+	transformer_.process(sourceMapped.planes(), destinationPlanes);
+
+	processComplete.emit(streamBuffer, PostProcessor::Status::Success);
+}
+
+bool PostProcessorTransform::isValidBuffers(const FrameBuffer &source,
+					    const CameraBuffer &destination) const
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(formats::NV12);
+
+	if (source.planes().size() != 2) {
+		LOG(YUV, Error) << "Invalid number of source planes: "
+				<< source.planes().size();
+		return false;
+	}
+	if (destination.numPlanes() != 2) {
+		LOG(YUV, Error) << "Invalid number of destination planes: "
+				<< destination.numPlanes();
+		return false;
+	}
+
+	for (unsigned int i = 0; i < 2; i++) {
+		unsigned int sourceStride = PostProcessingStage::planeStride(sourceCfg_, i);
+		unsigned int destinationStride = PostProcessingStage::planeStride(destinationCfg_, i);
+
+		if (source.planes()[i].length <
+		    info.planeSize(sourceCfg_.size.height, i, sourceStride)) {
+			LOG(YUV, Error) << "Source plane " << i << " too small: "
+					<< source.planes()[i].length;
+			return false;
+		}
+
+		if (destination.stride(i) != destinationStride ||
+		    destination.plane(i).size() <
+		    info.planeSize(destinationCfg_.size.height, i, destinationStride)) {
+			LOG(YUV, Error) << "Unexpected destination plane " << i
+					<< " layout: stride " << destination.stride(i)
+					<< ", size " << destination.plane(i).size();
+			return false;
+		}
+	}
+
+	return true;
+}
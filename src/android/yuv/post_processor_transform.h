@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Post Processor rotating YUV frames
+ */
+
+#pragma once
+
+#include "../post_processor.h"
+
+#include <libcamera/stream.h>
+#include <libcamera/transform.h>
+
+#include "libcamera/internal/post_processing/transform.h"
+
+class PostProcessorTransform : public PostProcessor
+{
+public:
+	PostProcessorTransform(libcamera::Transform transform);
+
+	int configure(const libcamera::StreamConfiguration &incfg,
+		      const libcamera::StreamConfiguration &outcfg) override;
+	void process(Camera3RequestDescriptor::StreamBuffer *streamBuffer) override;
+
+private:
+	bool isValidBuffers(const libcamera::FrameBuffer &source,
+			    const CameraBuffer &destination) const;
+
+	libcamera::StreamConfiguration sourceCfg_;
+	libcamera::StreamConfiguration destinationCfg_;
+
+	libcamera::TransformStage transformer_;
+};
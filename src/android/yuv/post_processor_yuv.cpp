@@ -2,12 +2,16 @@
 /*
  * Copyright (C) 2021, Google Inc.
  *
- * Post Processor using libyuv
+ * Post Processor scaling YUV frames with libyuv or ScaleStage
  */
 
 #include "post_processor_yuv.h"
 
+#ifdef HAVE_LIBYUV
 #include <libyuv/scale.h>
+#else
+#include <array>
+#endif
 
 #include <libcamera/base/log.h>
 
@@ -39,14 +43,23 @@ int PostProcessorYuv::configure(const StreamConfiguration &inCfg,
 		return -EINVAL;
 	}
 
-	if (inCfg.pixelFormat != formats::NV12) {
+	if (inCfg.pixelFormat != formats::NV12 &&
+	    inCfg.pixelFormat != formats::NV21) {
 		LOG(YUV, Error) << "Unsupported format " << inCfg.pixelFormat
-				<< " (only NV12 is supported)";
+				<< " (only NV12 and NV21 are supported)";
 		return -EINVAL;
 	}
 
 	calculateLengths(inCfg, outCfg);
+
+#ifdef HAVE_LIBYUV
 	return 0;
+#else
+	StreamConfiguration scalerOutCfg = outCfg;
+	scalerOutCfg.stride = destinationStride_[0];
+
+	return scaler_.configure(inCfg, scalerOutCfg);
+#endif
 }
 
 void PostProcessorYuv::process(Camera3RequestDescriptor::StreamBuffer *streamBuffer)
@@ -66,6 +79,11 @@ void PostProcessorYuv::process(Camera3RequestDescriptor::StreamBuffer *streamBuf
 		return;
 	}
 
+#ifdef HAVE_LIBYUV
+	/*
+	 * NV12Scale() only sees an interleaved chroma plane, so it scales NV21
+	 * as well.
+	 */
 	int ret = libyuv::NV12Scale(sourceMapped.planes()[0].data(),
 				    sourceStride_[0],
 				    sourceMapped.planes()[1].data(),
@@ -83,6 +101,14 @@ void PostProcessorYuv::process(Camera3RequestDescriptor::StreamBuffer *streamBuf
 		processComplete.emit(streamBuffer, PostProcessor::Status::Error);
 		return;
 	}
+#else
+	const std::array<Span<uint8_t>, 2> destinationPlanes = {
+		destination->plane(0),
+		destination->plane(1),
+	};
+
+	scaler_.process(sourceMapped.planes(), destinationPlanes);
+#endif
 
 	processComplete.emit(streamBuffer, PostProcessor::Status::Success);
 }
@@ -133,14 +159,14 @@ void PostProcessorYuv::calculateLengths(const StreamConfiguration &inCfg,
 	sourceSize_ = inCfg.size;
 	destinationSize_ = outCfg.size;
 
-	const PixelFormatInfo &nv12Info = PixelFormatInfo::info(formats::NV12);
+	const PixelFormatInfo &info = PixelFormatInfo::info(inCfg.pixelFormat);
 	for (unsigned int i = 0; i < 2; i++) {
 		sourceStride_[i] = inCfg.stride;
-		destinationStride_[i] = nv12Info.stride(destinationSize_.width, i, 1);
+		destinationStride_[i] = info.stride(destinationSize_.width, i, 1);
 
-		sourceLength_[i] = nv12Info.planeSize(sourceSize_.height, i,
-						      sourceStride_[i]);
-		destinationLength_[i] = nv12Info.planeSize(destinationSize_.height, i,
-							   destinationStride_[i]);
+		sourceLength_[i] = info.planeSize(sourceSize_.height, i,
+						  sourceStride_[i]);
+		destinationLength_[i] = info.planeSize(destinationSize_.height, i,
+						       destinationStride_[i]);
 	}
 }
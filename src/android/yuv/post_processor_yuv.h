@@ -2,7 +2,7 @@
 /*
  * Copyright (C) 2021, Google Inc.
  *
- * Post Processor using libyuv
+ * Post Processor scaling YUV frames with libyuv or ScaleStage
  */
 
 #pragma once
@@ -11,6 +11,10 @@
 
 #include <libcamera/geometry.h>
 
+#ifndef HAVE_LIBYUV
+#include "libcamera/internal/post_processing/scale.h"
+#endif
+
 class PostProcessorYuv : public PostProcessor
 {
 public:
@@ -32,4 +36,8 @@ private:
 	unsigned int destinationLength_[2] = {};
 	unsigned int sourceStride_[2] = {};
 	unsigned int destinationStride_[2] = {};
+
+#ifndef HAVE_LIBYUV
+	libcamera::ScaleStage scaler_;
+#endif
 };
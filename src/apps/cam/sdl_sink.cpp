@@ -65,7 +65,14 @@ int SDLSink::configure(const libcamera::CameraConfiguration &config)
 	switch (cfg.pixelFormat) {
 #ifdef HAVE_LIBJPEG
 	case libcamera::formats::MJPEG:
-		texture_ = std::make_unique<SDLTextureMJPG>(rect_);
+		/*
+		 * MJPEG frames are decoded asynchronously, render them from
+		 * the event loop when ready.
+		 */
+		texture_ = std::make_unique<SDLTextureMJPG>(rect_, [this]() {
+			EventLoop::instance()->callLater(
+				std::bind(&SDLSink::renderTexture, this));
+		});
 		break;
 #endif
 #if SDL_VERSION_ATLEAST(2, 0, 16)
@@ -202,6 +209,8 @@ void SDLSink::renderBuffer(FrameBuffer *buffer)
 			std::cerr << "payload size " << meta.bytesused
 				  << " larger than plane size " << data.size()
 				  << std::endl;
+		else if (meta.bytesused)
+			data = data.first(meta.bytesused);
 
 		planes.push_back(data);
 		i++;
@@ -209,6 +218,14 @@ void SDLSink::renderBuffer(FrameBuffer *buffer)
 
 	texture_->update(planes);
 
+	renderTexture();
+}
+
+void SDLSink::renderTexture()
+{
+	if (!texture_ || !texture_->present())
+		return;
+
 	SDL_RenderClear(renderer_);
 	SDL_RenderCopy(renderer_, texture_->get(), nullptr, nullptr);
 	SDL_RenderPresent(renderer_);
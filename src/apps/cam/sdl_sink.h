@@ -34,6 +34,7 @@ public:
 
 private:
 	void renderBuffer(libcamera::FrameBuffer *buffer);
+	void renderTexture();
 	void processSDLEvents();
 
 	std::map<libcamera::FrameBuffer *, std::unique_ptr<Image>>
@@ -20,6 +20,7 @@ public:
 	virtual ~SDLTexture();
 	int create(SDL_Renderer *renderer);
 	virtual void update(const std::vector<libcamera::Span<const uint8_t>> &data) = 0;
+	virtual bool present() { return true; }
 	SDL_Texture *get() const { return ptr_; }
 
 protected:
@@ -7,6 +7,7 @@
 
 #include "sdl_texture_mjpg.h"
 
+#include <algorithm>
 #include <iostream>
 #include <setjmp.h>
 #include <stdio.h>
@@ -15,6 +16,8 @@
 
 using namespace libcamera;
 
+namespace {
+
 struct JpegErrorManager : public jpeg_error_mgr {
 	JpegErrorManager()
 	{
@@ -37,47 +40,330 @@ struct JpegErrorManager : public jpeg_error_mgr {
 	jmp_buf escape_;
 };
 
-SDLTextureMJPG::SDLTextureMJPG(const SDL_Rect &rect)
-	: SDLTexture(rect, SDL_PIXELFORMAT_RGB24, rect.w * 3),
-	  rgb_(std::make_unique<unsigned char[]>(stride_ * rect.h))
+/*
+ * Decode JPEG images to planar YUV 4:2:0. The decompressor is kept across
+ * frames to avoid recreating it for every image.
+ */
+class MJPGDecoder
 {
+public:
+	MJPGDecoder();
+	~MJPGDecoder();
+
+	int decode(Span<const uint8_t> data, const SDL_Rect &rect,
+		   uint8_t *const planes[3], const int strides[3]);
+
+private:
+	bool canDecodeRaw() const;
+	void decodeRaw(const SDL_Rect &rect, uint8_t *const planes[3],
+		       const int strides[3]);
+	void decodeScanlines(const SDL_Rect &rect, uint8_t *const planes[3],
+			     const int strides[3]);
+
+	JpegErrorManager errorManager_;
+	struct jpeg_decompress_struct cinfo_;
+	std::vector<uint8_t> scratch_;
+};
+
+MJPGDecoder::MJPGDecoder()
+{
+	cinfo_.err = &errorManager_;
+	jpeg_create_decompress(&cinfo_);
 }
 
-int SDLTextureMJPG::decompress(Span<const uint8_t> data)
+MJPGDecoder::~MJPGDecoder()
 {
-	struct jpeg_decompress_struct cinfo;
+	jpeg_destroy_decompress(&cinfo_);
+}
 
-	JpegErrorManager errorManager;
-	if (setjmp(errorManager.escape_)) {
+int MJPGDecoder::decode(Span<const uint8_t> data, const SDL_Rect &rect,
+			uint8_t *const planes[3], const int strides[3])
+{
+	if (setjmp(errorManager_.escape_)) {
 		/* libjpeg found an error */
-		jpeg_destroy_decompress(&cinfo);
+		jpeg_abort_decompress(&cinfo_);
 		std::cerr << "JPEG decompression error" << std::endl;
 		return -EINVAL;
 	}
 
-	cinfo.err = &errorManager;
-	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo_, data.data(), data.size());
+
+	jpeg_read_header(&cinfo_, TRUE);
+
+	if (cinfo_.image_width != static_cast<JDIMENSION>(rect.w) ||
+	    cinfo_.image_height != static_cast<JDIMENSION>(rect.h)) {
+		jpeg_abort_decompress(&cinfo_);
+		std::cerr << "JPEG image size mismatch" << std::endl;
+		return -EINVAL;
+	}
+
+	if (canDecodeRaw())
+		decodeRaw(rect, planes, strides);
+	else
+		decodeScanlines(rect, planes, strides);
 
-	jpeg_mem_src(&cinfo, data.data(), data.size());
+	jpeg_finish_decompress(&cinfo_);
 
-	jpeg_read_header(&cinfo, TRUE);
+	return 0;
+}
 
-	jpeg_start_decompress(&cinfo);
+/*
+ * Raw decoding outputs the YCbCr components without upsampling nor colour
+ * conversion. It's possible for the 4:2:0 and 4:2:2 subsamplings produced by
+ * cameras, as the chroma rows can be written directly, or dropped for 4:2:2,
+ * to the 4:2:0 output.
+ */
+bool MJPGDecoder::canDecodeRaw() const
+{
+	if (cinfo_.num_components != 3 || cinfo_.jpeg_color_space != JCS_YCbCr)
+		return false;
+
+	const jpeg_component_info *comps = cinfo_.comp_info;
+
+	return comps[0].h_samp_factor == 2 &&
+	       (comps[0].v_samp_factor == 1 || comps[0].v_samp_factor == 2) &&
+	       comps[1].h_samp_factor == 1 && comps[1].v_samp_factor == 1 &&
+	       comps[2].h_samp_factor == 1 && comps[2].v_samp_factor == 1;
+}
+
+void MJPGDecoder::decodeRaw(const SDL_Rect &rect, uint8_t *const planes[3],
+			    const int strides[3])
+{
+	cinfo_.raw_data_out = TRUE;
+	cinfo_.out_color_space = cinfo_.jpeg_color_space;
 
-	for (int i = 0; cinfo.output_scanline < cinfo.output_height; ++i) {
-		JSAMPROW rowptr = rgb_.get() + i * stride_;
-		jpeg_read_scanlines(&cinfo, &rowptr, 1);
+	jpeg_start_decompress(&cinfo_);
+
+	/*
+	 * Rows beyond the image height, and chroma rows of odd luma lines for
+	 * 4:2:2, are written to a scratch row.
+	 */
+	scratch_.resize(strides[0]);
+
+	const unsigned int vSamp = cinfo_.max_v_samp_factor;
+	const unsigned int lumaRows = vSamp * DCTSIZE;
+
+	JSAMPROW rows[3][2 * DCTSIZE];
+	JSAMPARRAY data[3] = { rows[0], rows[1], rows[2] };
+
+	while (cinfo_.output_scanline < cinfo_.output_height) {
+		const unsigned int y0 = cinfo_.output_scanline;
+
+		for (unsigned int i = 0; i < lumaRows; ++i) {
+			unsigned int y = y0 + i;
+			rows[0][i] = y < static_cast<unsigned int>(rect.h)
+				   ? planes[0] + y * strides[0]
+				   : scratch_.data();
+		}
+
+		for (unsigned int c = 1; c < 3; ++c) {
+			for (unsigned int i = 0; i < DCTSIZE; ++i) {
+				unsigned int y = y0 + i * vSamp;
+				rows[c][i] = y % 2 == 0 && y < static_cast<unsigned int>(rect.h)
+					   ? planes[c] + y / 2 * strides[c]
+					   : scratch_.data();
+			}
+		}
+
+		jpeg_read_raw_data(&cinfo_, data, lumaRows);
 	}
+}
 
-	jpeg_finish_decompress(&cinfo);
+void MJPGDecoder::decodeScanlines(const SDL_Rect &rect, uint8_t *const planes[3],
+				  const int strides[3])
+{
+	cinfo_.raw_data_out = FALSE;
+	cinfo_.out_color_space = JCS_YCbCr;
 
-	jpeg_destroy_decompress(&cinfo);
+	jpeg_start_decompress(&cinfo_);
 
-	return 0;
+	scratch_.resize(rect.w * 3);
+
+	while (cinfo_.output_scanline < cinfo_.output_height) {
+		const unsigned int y = cinfo_.output_scanline;
+		JSAMPROW row = scratch_.data();
+
+		jpeg_read_scanlines(&cinfo_, &row, 1);
+
+		uint8_t *luma = planes[0] + y * strides[0];
+		for (int x = 0; x < rect.w; ++x)
+			luma[x] = row[x * 3];
+
+		if (y % 2)
+			continue;
+
+		uint8_t *cb = planes[1] + y / 2 * strides[1];
+		uint8_t *cr = planes[2] + y / 2 * strides[2];
+		for (int x = 0; x < rect.w; x += 2) {
+			cb[x / 2] = row[x * 3 + 1];
+			cr[x / 2] = row[x * 3 + 2];
+		}
+	}
+}
+
+} /* namespace */
+
+SDLTextureMJPG::Frame::Frame(const SDL_Rect &rect)
+	: sequence(0),
+	  strides{ (rect.w + 15) & ~15, ((rect.w + 15) & ~15) / 2,
+		   ((rect.w + 15) & ~15) / 2 },
+	  heights{ rect.h, (rect.h + 1) / 2, (rect.h + 1) / 2 }
+{
+	yuv.resize(strides[0] * heights[0] + strides[1] * heights[1] +
+		   strides[2] * heights[2]);
+}
+
+uint8_t *SDLTextureMJPG::Frame::plane(unsigned int index)
+{
+	uint8_t *data = yuv.data();
+
+	for (unsigned int i = 0; i < index; ++i)
+		data += strides[i] * heights[i];
+
+	return data;
+}
+
+SDLTextureMJPG::SDLTextureMJPG(const SDL_Rect &rect,
+			       const std::function<void()> &frameReady)
+	: SDLTexture(rect, SDL_PIXELFORMAT_IYUV, (rect.w + 15) & ~15),
+	  frameReady_(frameReady), stopping_(false), sequence_(0),
+	  decodedSequence_(0), pendingFrame_(nullptr), decodedFrame_(nullptr)
+{
+	unsigned int numWorkers =
+		std::clamp(std::thread::hardware_concurrency(), 1U, 4U);
+
+	/*
+	 * Allocate enough frames for one pending frame, one frame being
+	 * decoded by each worker, one decoded frame, and one frame being
+	 * filled by update().
+	 */
+	for (unsigned int i = 0; i < numWorkers + 3; ++i) {
+		frames_.push_back(std::make_unique<Frame>(rect));
+		freeFrames_.push_back(frames_.back().get());
+	}
+
+	for (unsigned int i = 0; i < numWorkers; ++i)
+		workers_.emplace_back(&SDLTextureMJPG::decodeLoop, this);
+}
+
+SDLTextureMJPG::~SDLTextureMJPG()
+{
+	{
+		std::unique_lock<std::mutex> locker(lock_);
+		stopping_ = true;
+	}
+
+	cond_.notify_all();
+
+	for (std::thread &worker : workers_)
+		worker.join();
 }
 
 void SDLTextureMJPG::update(const std::vector<libcamera::Span<const uint8_t>> &data)
 {
-	decompress(data[0]);
-	SDL_UpdateTexture(ptr_, nullptr, rgb_.get(), stride_);
+	Frame *frame;
+
+	{
+		std::unique_lock<std::mutex> locker(lock_);
+
+		if (!freeFrames_.empty()) {
+			frame = freeFrames_.back();
+			freeFrames_.pop_back();
+		} else if (pendingFrame_) {
+			frame = pendingFrame_;
+			pendingFrame_ = nullptr;
+		} else {
+			return;
+		}
+	}
+
+	/*
+	 * Copy the compressed data, the buffer is requeued to the camera as
+	 * soon as this function returns.
+	 */
+	frame->jpeg.assign(data[0].begin(), data[0].end());
+	frame->sequence = ++sequence_;
+
+	{
+		std::unique_lock<std::mutex> locker(lock_);
+
+		/* Drop the stale frame no worker has picked up yet. */
+		if (pendingFrame_)
+			freeFrames_.push_back(pendingFrame_);
+
+		pendingFrame_ = frame;
+	}
+
+	cond_.notify_one();
+}
+
+bool SDLTextureMJPG::present()
+{
+	Frame *frame;
+
+	{
+		std::unique_lock<std::mutex> locker(lock_);
+		frame = decodedFrame_;
+		decodedFrame_ = nullptr;
+	}
+
+	if (!frame)
+		return false;
+
+	SDL_UpdateYUVTexture(ptr_, &rect_,
+			     frame->plane(0), frame->strides[0],
+			     frame->plane(1), frame->strides[1],
+			     frame->plane(2), frame->strides[2]);
+
+	{
+		std::unique_lock<std::mutex> locker(lock_);
+		freeFrames_.push_back(frame);
+	}
+
+	return true;
+}
+
+void SDLTextureMJPG::decodeLoop()
+{
+	MJPGDecoder decoder;
+
+	std::unique_lock<std::mutex> locker(lock_);
+
+	while (true) {
+		cond_.wait(locker, [&] { return stopping_ || pendingFrame_; });
+		if (stopping_)
+			return;
+
+		Frame *frame = pendingFrame_;
+		pendingFrame_ = nullptr;
+
+		locker.unlock();
+
+		uint8_t *const planes[3] = {
+			frame->plane(0), frame->plane(1), frame->plane(2)
+		};
+		int ret = decoder.decode(frame->jpeg, rect_, planes,
+					 frame->strides);
+
+		locker.lock();
+
+		/*
+		 * Drop the frame if decoding failed, or if a more recent frame
+		 * has been decoded by another worker in the meantime.
+		 */
+		if (ret < 0 || frame->sequence < decodedSequence_) {
+			freeFrames_.push_back(frame);
+			continue;
+		}
+
+		if (decodedFrame_)
+			freeFrames_.push_back(decodedFrame_);
+
+		decodedFrame_ = frame;
+		decodedSequence_ = frame->sequence;
+
+		locker.unlock();
+		frameReady_();
+		locker.lock();
+	}
 }
@@ -7,17 +7,52 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
 #include "sdl_texture.h"
 
 class SDLTextureMJPG : public SDLTexture
 {
 public:
-	SDLTextureMJPG(const SDL_Rect &rect);
+	SDLTextureMJPG(const SDL_Rect &rect, const std::function<void()> &frameReady);
+	~SDLTextureMJPG();
 
 	void update(const std::vector<libcamera::Span<const uint8_t>> &data) override;
+	bool present() override;
 
 private:
-	int decompress(libcamera::Span<const uint8_t> data);
+	struct Frame {
+		Frame(const SDL_Rect &rect);
+
+		uint8_t *plane(unsigned int index);
+
+		std::vector<uint8_t> jpeg;
+		std::vector<uint8_t> yuv;
+		uint64_t sequence;
+
+		const int strides[3];
+		const int heights[3];
+	};
+
+	void decodeLoop();
+
+	std::function<void()> frameReady_;
+	std::vector<std::thread> workers_;
+
+	std::mutex lock_;
+	std::condition_variable cond_;
+	bool stopping_;
+	uint64_t sequence_;
+	uint64_t decodedSequence_;
 
-	std::unique_ptr<unsigned char[]> rgb_;
+	std::vector<std::unique_ptr<Frame>> frames_;
+	std::vector<Frame *> freeFrames_;
+	Frame *pendingFrame_;
+	Frame *decodedFrame_;
 };
@@ -30,6 +30,11 @@ static inline void gst_clear_event(GstEvent **event_ptr)
 {
 	g_clear_pointer(event_ptr, gst_mini_object_unref);
 }
+
+static inline void gst_clear_caps(GstCaps **caps_ptr)
+{
+	g_clear_pointer(caps_ptr, gst_mini_object_unref);
+}
 #endif
 
 #if !GST_CHECK_VERSION(1, 17, 1)
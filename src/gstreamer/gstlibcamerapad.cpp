@@ -19,6 +19,11 @@ struct _GstLibcameraPad {
 	StreamRole role;
 	GstLibcameraPool *pool;
 	GstClockTime latency;
+
+	/* Caps of the stream formats, valid for the formats_generation and role. */
+	GstCaps *formats;
+	guint formats_generation;
+	StreamRole formats_role;
 };
 
 enum {
@@ -62,11 +67,46 @@ gst_libcamera_pad_get_property(GObject *object, guint prop_id, GValue *value,
 	}
 }
 
+static gboolean
+gst_libcamera_pad_query_caps(GstLibcameraPad *self, GstQuery *query)
+{
+	g_autoptr(GstCaps) caps = nullptr;
+
+	{
+		GLibLocker lock(GST_OBJECT(self));
+		if (!self->formats || self->formats_role != self->role)
+			return FALSE;
+
+		caps = gst_caps_ref(self->formats);
+	}
+
+	GstCaps *filter;
+	gst_query_parse_caps(query, &filter);
+
+	if (filter) {
+		g_autoptr(GstCaps) result =
+			gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+		gst_query_set_caps_result(query, result);
+	} else {
+		gst_query_set_caps_result(query, caps);
+	}
+
+	return TRUE;
+}
+
 static gboolean
 gst_libcamera_pad_query(GstPad *pad, GstObject *parent, GstQuery *query)
 {
 	auto *self = GST_LIBCAMERA_PAD(pad);
 
+	/*
+	 * Answer caps queries from the cached stream formats once the camera
+	 * has been configured, and fall back to the template caps before.
+	 */
+	if (query->type == GST_QUERY_CAPS &&
+	    gst_libcamera_pad_query_caps(self, query))
+		return TRUE;
+
 	if (query->type != GST_QUERY_LATENCY)
 		return gst_pad_query_default(pad, parent, query);
 
@@ -109,11 +149,22 @@ gst_libcamera_stream_role_get_type()
 	return type;
 }
 
+static void
+gst_libcamera_pad_finalize(GObject *object)
+{
+	auto *self = GST_LIBCAMERA_PAD(object);
+
+	gst_clear_caps(&self->formats);
+
+	G_OBJECT_CLASS(gst_libcamera_pad_parent_class)->finalize(object);
+}
+
 static void
 gst_libcamera_pad_class_init(GstLibcameraPadClass *klass)
 {
 	auto *object_class = G_OBJECT_CLASS(klass);
 
+	object_class->finalize = gst_libcamera_pad_finalize;
 	object_class->set_property = gst_libcamera_pad_set_property;
 	object_class->get_property = gst_libcamera_pad_get_property;
 
@@ -164,6 +215,31 @@ gst_libcamera_pad_get_stream(GstPad *pad)
 	return nullptr;
 }
 
+/*
+ * Retrieve the caps corresponding to the stream \a formats. The caps are
+ * cached in the pad and only regenerated when the camera \a generation or the
+ * pad role changes, as converting the formats to caps is costly for devices
+ * that support many formats and sizes. The cached caps also answer the caps
+ * queries on the pad. A new reference is returned.
+ */
+GstCaps *
+gst_libcamera_pad_get_formats_caps(GstPad *pad, const StreamFormats &formats,
+				   guint generation)
+{
+	auto *self = GST_LIBCAMERA_PAD(pad);
+	GLibLocker lock(GST_OBJECT(self));
+
+	if (!self->formats || self->formats_generation != generation ||
+	    self->formats_role != self->role) {
+		gst_clear_caps(&self->formats);
+		self->formats = gst_libcamera_stream_formats_to_caps(formats);
+		self->formats_generation = generation;
+		self->formats_role = self->role;
+	}
+
+	return gst_caps_ref(self->formats);
+}
+
 void
 gst_libcamera_pad_set_latency(GstPad *pad, GstClockTime latency)
 {
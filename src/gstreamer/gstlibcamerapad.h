@@ -25,4 +25,8 @@ void gst_libcamera_pad_set_pool(GstPad *pad, GstLibcameraPool *pool);
 
 libcamera::Stream *gst_libcamera_pad_get_stream(GstPad *pad);
 
+GstCaps *gst_libcamera_pad_get_formats_caps(GstPad *pad,
+					    const libcamera::StreamFormats &formats,
+					    guint generation);
+
 void gst_libcamera_pad_set_latency(GstPad *pad, GstClockTime latency);
@@ -110,6 +110,14 @@ struct GstLibcameraSrcState {
 	std::shared_ptr<Camera> cam_;
 	std::unique_ptr<CameraConfiguration> config_;
 
+	/*
+	 * The camera generation is incremented every time a camera is
+	 * acquired, and invalidates the caps cached in the pads. The stream
+	 * formats only depend on the camera and the stream role, so the cache
+	 * survives stream restarts and renegotiations.
+	 */
+	guint generation_; /* Protected by stream_lock */
+
 	std::vector<GstPad *> srcpads_; /* Protected by stream_lock */
 
 	/*
@@ -410,6 +418,7 @@ gst_libcamera_src_open(GstLibcameraSrc *self)
 	/* No need to lock here, we didn't start our threads yet. */
 	self->state->cm_ = cm;
 	self->state->cam_ = cam;
+	self->state->generation_++;
 
 	return true;
 }
@@ -427,7 +436,9 @@ gst_libcamera_src_negotiate(GstLibcameraSrc *self)
 		StreamConfiguration &stream_cfg = state->config_->at(i);
 
 		/* Retrieve the supported caps. */
-		g_autoptr(GstCaps) filter = gst_libcamera_stream_formats_to_caps(stream_cfg.formats());
+		g_autoptr(GstCaps) filter =
+			gst_libcamera_pad_get_formats_caps(srcpad, stream_cfg.formats(),
+							   state->generation_);
 		g_autoptr(GstCaps) caps = gst_pad_peer_query_caps(srcpad, filter);
 		if (gst_caps_is_empty(caps))
 			return false;
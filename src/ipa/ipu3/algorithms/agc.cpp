@@ -100,6 +100,9 @@ int Agc::configure(IPAContext &context,
 	stride_ = configuration.grid.stride;
 	bdsGrid_ = configuration.grid.bdsGrid;
 
+	/* Preallocate the per-frame statistics storage. */
+	rgbTriples_.reserve(bdsGrid_.width * bdsGrid_.height);
+
 	minShutterSpeed_ = configuration.agc.minShutterSpeed;
 	maxShutterSpeed_ = std::min(configuration.agc.maxShutterSpeed,
 				    kMaxShutterSpeed);
@@ -122,8 +125,8 @@ int Agc::configure(IPAContext &context,
 	return 0;
 }
 
-Histogram Agc::parseStatistics(const ipu3_uapi_stats_3a *stats,
-			       const ipu3_uapi_grid_config &grid)
+void Agc::parseStatistics(const ipu3_uapi_stats_3a *stats,
+			  const ipu3_uapi_grid_config &grid)
 {
 	uint32_t hist[knumHistogramBins] = { 0 };
 
@@ -152,7 +155,7 @@ Histogram Agc::parseStatistics(const ipu3_uapi_stats_3a *stats,
 		}
 	}
 
-	return Histogram(Span<uint32_t>(hist));
+	hist_.assign(Span<uint32_t>(hist));
 }
 
 /**
@@ -208,7 +211,7 @@ void Agc::process(IPAContext &context, [[maybe_unused]] const uint32_t frame,
 		  const ipu3_uapi_stats_3a *stats,
 		  ControlList &metadata)
 {
-	Histogram hist = parseStatistics(stats, context.configuration.grid.bdsGrid);
+	parseStatistics(stats, context.configuration.grid.bdsGrid);
 	rGain_ = context.activeState.awb.gains.red;
 	gGain_ = context.activeState.awb.gains.blue;
 	bGain_ = context.activeState.awb.gains.green;
@@ -226,7 +229,7 @@ void Agc::process(IPAContext &context, [[maybe_unused]] const uint32_t frame,
 	double aGain, dGain;
 	std::tie(shutterTime, aGain, dGain) =
 		calculateNewEv(context.activeState.agc.constraintMode,
-			       context.activeState.agc.exposureMode, hist,
+			       context.activeState.agc.exposureMode, hist_,
 			       effectiveExposureValue);
 
 	LOG(IPU3Agc, Debug)
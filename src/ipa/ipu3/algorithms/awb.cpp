@@ -215,6 +215,9 @@ int Awb::configure(IPAContext &context,
 	cellsPerZoneThreshold_ = cellsPerZoneX_ * cellsPerZoneY_ * kMaxCellSaturationRatio;
 	LOG(IPU3Awb, Debug) << "Threshold for AWB is set to " << cellsPerZoneThreshold_;
 
+	/* Scratch memory for the sorted zones of the grey world algorithm. */
+	context.scratch.reserve<RGB>(kAwbStatsSizeX * kAwbStatsSizeY);
+
 	return 0;
 }
 
@@ -403,7 +406,7 @@ void Awb::clearAwbStats()
 	}
 }
 
-void Awb::awbGreyWorld()
+void Awb::awbGreyWorld(IPAContext &context)
 {
 	LOG(IPU3Awb, Debug) << "Grey world AWB";
 	/*
@@ -413,7 +416,9 @@ void Awb::awbGreyWorld()
 	 * doing an L2 average etc.
 	 */
 	std::vector<RGB> &redDerivative(zones_);
-	std::vector<RGB> blueDerivative(redDerivative);
+	Span<RGB> blueDerivative = context.scratch.allocate<RGB>(zones_.size());
+	std::copy(redDerivative.begin(), redDerivative.end(),
+		  blueDerivative.begin());
 	std::sort(redDerivative.begin(), redDerivative.end(),
 		  [](RGB const &a, RGB const &b) {
 			  return a.G * b.R < b.G * a.R;
@@ -428,10 +433,8 @@ void Awb::awbGreyWorld()
 
 	RGB sumRed(0, 0, 0);
 	RGB sumBlue(0, 0, 0);
-	for (auto ri = redDerivative.begin() + discard,
-		  bi = blueDerivative.begin() + discard;
-	     ri != redDerivative.end() - discard; ri++, bi++)
-		sumRed += *ri, sumBlue += *bi;
+	for (unsigned int i = discard; i < redDerivative.size() - discard; i++)
+		sumRed += redDerivative[i], sumBlue += blueDerivative[i];
 
 	double redGain = sumRed.G / (sumRed.R + 1),
 	       blueGain = sumBlue.G / (sumBlue.B + 1);
@@ -452,7 +455,8 @@ void Awb::awbGreyWorld()
 	asyncResults_.blueGain = blueGain;
 }
 
-void Awb::calculateWBGains(const ipu3_uapi_stats_3a *stats)
+void Awb::calculateWBGains(IPAContext &context,
+			   const ipu3_uapi_stats_3a *stats)
 {
 	ASSERT(stats->stats_3a_status.awb_en);
 
@@ -463,7 +467,7 @@ void Awb::calculateWBGains(const ipu3_uapi_stats_3a *stats)
 	LOG(IPU3Awb, Debug) << "Valid zones: " << zones_.size();
 
 	if (zones_.size() > 10) {
-		awbGreyWorld();
+		awbGreyWorld(context);
 		LOG(IPU3Awb, Debug) << "Gain found for red: " << asyncResults_.redGain
 				    << " and for blue: " << asyncResults_.blueGain;
 	}
@@ -477,7 +481,7 @@ void Awb::process(IPAContext &context, [[maybe_unused]] const uint32_t frame,
 		  const ipu3_uapi_stats_3a *stats,
 		  [[maybe_unused]] ControlList &metadata)
 {
-	calculateWBGains(stats);
+	calculateWBGains(context, stats);
 
 	/*
 	 * Gains are only recalculated if enough zones were detected.
@@ -70,11 +70,12 @@ private:
 	};
 
 private:
-	void calculateWBGains(const ipu3_uapi_stats_3a *stats);
+	void calculateWBGains(IPAContext &context,
+			      const ipu3_uapi_stats_3a *stats);
 	void generateZones();
 	void generateAwbStats(const ipu3_uapi_stats_3a *stats);
 	void clearAwbStats();
-	void awbGreyWorld();
+	void awbGreyWorld(IPAContext &context);
 	uint32_t estimateCCT(double red, double green, double blue);
 	static constexpr uint16_t threshold(float value);
 	static constexpr uint16_t gainValue(double gain);
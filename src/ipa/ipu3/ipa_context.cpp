@@ -50,6 +50,10 @@ namespace libcamera::ipa::ipu3 {
  *
  * \var IPAContext::ctrlMap
  * \brief A ControlInfoMap::Map of controls populated by the algorithms
+ *
+ * \var IPAContext::scratch
+ * \brief Scratch memory for temporary data of the algorithms, reset for every
+ * frame
  */
 
 /**
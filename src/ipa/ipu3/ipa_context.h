@@ -16,6 +16,7 @@
 #include <libcamera/geometry.h>
 
 #include <libipa/fc_queue.h>
+#include <libipa/scratch_arena.h>
 
 namespace libcamera {
 
@@ -90,6 +91,8 @@ struct IPAContext {
 	FCQueue<IPAFrameContext> frameContexts;
 
 	ControlInfoMap::Map ctrlMap;
+
+	ScratchArena scratch;
 };
 
 } /* namespace ipa::ipu3 */
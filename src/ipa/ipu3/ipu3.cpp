@@ -189,7 +189,7 @@ private:
 };
 
 IPAIPU3::IPAIPU3()
-	: context_({ {}, {}, { kMaxFrameContexts }, {} })
+	: context_({ {}, {}, { kMaxFrameContexts }, {}, {} })
 {
 }
 
@@ -475,6 +475,7 @@ int IPAIPU3::configure(const IPAConfigInfo &configInfo,
 	context_.activeState = {};
 	context_.configuration = {};
 	context_.frameContexts.clear();
+	context_.scratch.release();
 
 	/* Initialise the sensor configuration. */
 	context_.configuration.sensor.lineDuration = sensorInfo_.minLineLength
@@ -603,6 +604,8 @@ void IPAIPU3::processStatsBuffer(const uint32_t frame,
 
 	ControlList metadata(controls::controls);
 
+	context_.scratch.reset();
+
 	for (auto const &algo : algorithms())
 		algo->process(context_, frame, frameContext, stats, metadata);
 
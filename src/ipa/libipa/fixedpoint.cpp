@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Paul Elder <paul.elder@ideasonboard.com>
+ *
+ * Fixed / floating point conversions
+ */
+
+#include "fixedpoint.h"
+
+/**
+ * \file fixedpoint.h
+ */
+
+namespace libcamera {
+
+namespace ipa {
+
+/**
+ * \fn R floatingToFixedPoint(T number)
+ * \brief Convert a floating point number to a fixed-point representation
+ * \tparam I Bit width of the integer part of the fixed-point
+ * \tparam F Bit width of the fractional part of the fixed-point
+ * \tparam R Return type of the fixed-point representation
+ * \tparam T Input type of the floating point representation
+ * \param number The floating point number to convert to fixed point
+ * \return The converted value
+ */
+
+/**
+ * \fn Matrix<R, Rows, Cols> floatingToFixedPoint(const Matrix<T, Rows, Cols> &matrix)
+ * \brief Convert a floating point matrix to a fixed-point representation
+ * \tparam I Bit width of the integer part of the fixed-point
+ * \tparam F Bit width of the fractional part of the fixed-point
+ * \tparam R Element type of the fixed-point matrix
+ * \tparam T Element type of the floating point matrix
+ * \tparam Rows Number of rows in the matrix
+ * \tparam Cols Number of columns in the matrix
+ * \param matrix The floating point matrix to convert to fixed point
+ *
+ * Each element is converted with floatingToFixedPoint(T number), producing
+ * values in the format expected by ISP registers, such as colour correction
+ * matrix coefficients.
+ *
+ * \return The converted matrix
+ */
+
+/**
+ * \fn R fixedToFloatingPoint(T number)
+ * \brief Convert a fixed-point number to a floating point representation
+ * \tparam I Bit width of the integer part of the fixed-point
+ * \tparam F Bit width of the fractional part of the fixed-point
+ * \tparam R Return type of the floating point representation
+ * \tparam T Input type of the fixed-point representation
+ * \param number The fixed point number to convert to floating point
+ * \return The converted value
+ */
+
+/**
+ * \fn Vector<U, Rows> fixedPointMultiply(const Matrix<T, Rows, Cols> &m, const Vector<U, Cols> &v)
+ * \brief Multiply an integer vector by a fixed-point matrix
+ * \tparam F Bit width of the fractional part of the matrix elements
+ * \tparam T Element type of the matrix, a signed integer type
+ * \tparam U Element type of the vector
+ * \tparam Rows Number of rows in the matrix
+ * \tparam Cols Number of columns in the matrix
+ * \param m The matrix, with elements scaled by 2^F
+ * \param v The vector
+ *
+ * The matrix elements are signed integers holding the matrix coefficients
+ * multiplied by 2^F, such as the colour correction matrix of a software ISP
+ * applied to pixel values. The products are accumulated in a 32-bit integer
+ * when it can hold the sum of Cols products of the element types without
+ * overflowing, and in a 64-bit integer otherwise. The result is rounded to
+ * the nearest integer and saturated to the range of \a U, so negative sums
+ * produce 0 for unsigned vector types instead of wrapping around.
+ *
+ * \return The product of \a m and \a v
+ */
+
+} /* namespace ipa */
+
+} /* namespace libcamera */
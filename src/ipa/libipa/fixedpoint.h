@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Paul Elder <paul.elder@ideasonboard.com>
+ *
+ * Fixed / floating point conversions
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <type_traits>
+
+#include "matrix.h"
+#include "vector.h"
+
+namespace libcamera {
+
+namespace ipa {
+
+#ifndef __DOXYGEN__
+template<unsigned int I, unsigned int F, typename R, typename T,
+	 std::enable_if_t<std::is_integral_v<R> &&
+			  std::is_floating_point_v<T>> * = nullptr>
+#else
+template<unsigned int I, unsigned int F, typename R, typename T>
+#endif
+constexpr R floatingToFixedPoint(T number)
+{
+	static_assert(sizeof(int) >= sizeof(R));
+	static_assert(I + F <= sizeof(R) * 8);
+
+	/*
+	 * The intermediate cast to int is needed on arm platforms to properly
+	 * cast negative values. See
+	 * https://embeddeduse.com/2013/08/25/casting-a-negative-float-to-an-unsigned-int/
+	 */
+	R mask = (1 << (F + I)) - 1;
+	R frac = static_cast<R>(static_cast<int>(std::round(number * (1 << F)))) & mask;
+
+	return frac;
+}
+
+#ifndef __DOXYGEN__
+template<unsigned int I, unsigned int F, typename R, typename T,
+	 unsigned int Rows, unsigned int Cols,
+	 std::enable_if_t<std::is_integral_v<R> &&
+			  std::is_floating_point_v<T>> * = nullptr>
+#else
+template<unsigned int I, unsigned int F, typename R, typename T,
+	 unsigned int Rows, unsigned int Cols>
+#endif
+constexpr Matrix<R, Rows, Cols> floatingToFixedPoint(const Matrix<T, Rows, Cols> &matrix)
+{
+	Matrix<R, Rows, Cols> result;
+	Span<R, Rows * Cols> r = result.data();
+	Span<const T, Rows * Cols> m = matrix.data();
+
+	for (unsigned int i = 0; i < Rows * Cols; i++)
+		r[i] = floatingToFixedPoint<I, F, R, T>(m[i]);
+
+	return result;
+}
+
+#ifndef __DOXYGEN__
+template<unsigned int I, unsigned int F, typename R, typename T,
+	 std::enable_if_t<std::is_floating_point_v<R> &&
+			  std::is_integral_v<T>> * = nullptr>
+#else
+template<unsigned int I, unsigned int F, typename R, typename T>
+#endif
+constexpr R fixedToFloatingPoint(T number)
+{
+	static_assert(sizeof(int) >= sizeof(T));
+	static_assert(I + F <= sizeof(T) * 8);
+
+	/*
+	 * Recreate the upper bits in case of a negative number by shifting the sign
+	 * bit from the fixed point to the first bit of the unsigned and then right shifting
+	 * by the same amount which keeps the sign bit in place.
+	 * This can be optimized by the compiler quite well.
+	 */
+	int remaining_bits = sizeof(int) * 8 - (I + F);
+	int t = static_cast<int>(static_cast<unsigned>(number) << remaining_bits) >> remaining_bits;
+	return static_cast<R>(t) / static_cast<R>(1 << F);
+}
+
+#ifndef __DOXYGEN__
+template<unsigned int F, typename T, typename U,
+	 unsigned int Rows, unsigned int Cols,
+	 std::enable_if_t<std::is_integral_v<T> &&
+			  std::is_integral_v<U>> * = nullptr>
+#else
+template<unsigned int F, typename T, typename U, unsigned int Rows, unsigned int Cols>
+#endif
+constexpr Vector<U, Rows> fixedPointMultiply(const Matrix<T, Rows, Cols> &m,
+					     const Vector<U, Cols> &v)
+{
+	static_assert(F > 0);
+	static_assert(std::is_signed_v<T>);
+
+	/*
+	 * Each product needs the bits of both operands, and summing Cols
+	 * products and the rounding term needs log2(Cols + 1) more bits.
+	 */
+	constexpr unsigned int kSumBits = [] {
+		unsigned int bits = 0;
+		while ((1U << bits) < Cols + 1)
+			bits++;
+		return bits;
+	}();
+	constexpr unsigned int kAccBits = (sizeof(T) + sizeof(U)) * 8 + kSumBits;
+	static_assert(kAccBits <= 64);
+
+	using Acc = std::conditional_t<kAccBits <= 32, int32_t, int64_t>;
+
+	/* The accumulator is wider than U, so the limits of U fit in it. */
+	constexpr Acc kMin = static_cast<Acc>(std::numeric_limits<U>::min());
+	constexpr Acc kMax = static_cast<Acc>(std::numeric_limits<U>::max());
+
+	Vector<U, Rows> result{};
+	Span<U, Rows> r = result.data();
+	Span<const T, Rows * Cols> a = m.data();
+	Span<const U, Cols> b = v.data();
+
+	for (unsigned int i = 0; i < Rows; i++) {
+		Acc sum = Acc{ 1 } << (F - 1);
+		for (unsigned int j = 0; j < Cols; j++)
+			sum += static_cast<Acc>(a[i * Cols + j]) * static_cast<Acc>(b[j]);
+		r[i] = static_cast<U>(std::clamp<Acc>(sum >> F, kMin, kMax));
+	}
+
+	return result;
+}
+
+} /* namespace ipa */
+
+} /* namespace libcamera */
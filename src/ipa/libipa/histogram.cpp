@@ -42,6 +42,27 @@ namespace ipa {
  * \param[in] data A (non-cumulative) histogram
  */
 Histogram::Histogram(Span<const uint32_t> data)
+{
+	assign(data);
+}
+
+/**
+ * \fn Histogram::Histogram(Span<const uint32_t> data, Transform transform)
+ * \brief Create a cumulative histogram
+ * \param[in] data A (non-cumulative) histogram
+ * \param[in] transform The transformation function to apply to every bin
+ */
+
+/**
+ * \brief Replace the histogram contents
+ * \param[in] data A (non-cumulative) histogram
+ *
+ * The cumulative histogram is computed in the memory of the current histogram,
+ * which is reallocated only if the number of bins grows. Algorithms that
+ * compute a histogram for every frame should keep a Histogram instance and
+ * assign new data to it, instead of constructing a new histogram.
+ */
+void Histogram::assign(Span<const uint32_t> data)
 {
 	cumulative_.resize(data.size() + 1);
 	cumulative_[0] = 0;
@@ -50,10 +71,12 @@ Histogram::Histogram(Span<const uint32_t> data)
 }
 
 /**
- * \fn Histogram::Histogram(Span<const uint32_t> data, Transform transform)
- * \brief Create a cumulative histogram
+ * \fn Histogram::assign(Span<const uint32_t> data, Transform transform)
+ * \brief Replace the histogram contents
  * \param[in] data A (non-cumulative) histogram
  * \param[in] transform The transformation function to apply to every bin
+ *
+ * \sa assign(Span<const uint32_t> data)
  */
 
 /**
@@ -124,7 +147,8 @@ double Histogram::quantile(double q, uint32_t first, uint32_t last) const
 	if (cumulative_[first + 1] == cumulative_[first])
 		frac = 0;
 	else
-		frac = (item - cumulative_[first]) / (cumulative_[first + 1] - cumulative_[first]);
+		frac = static_cast<double>(item - cumulative_[first]) /
+		       (cumulative_[first + 1] - cumulative_[first]);
 	return first + frac;
 }
 
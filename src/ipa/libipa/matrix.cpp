@@ -73,6 +73,22 @@ namespace ipa {
  * \copydoc Matrix::operator[](size_t i) const
  */
 
+/**
+ * \fn Span<const T, Rows * Cols> Matrix::data() const
+ * \brief Access the matrix elements
+ *
+ * The elements are stored contiguously in row-major order. Accessing them
+ * through the returned span avoids the per-row indirection of operator[] in
+ * performance-sensitive code.
+ *
+ * \return The matrix elements, as a Span
+ */
+
+/**
+ * \fn Matrix::data()
+ * \copydoc Matrix::data() const
+ */
+
 /**
  * \fn Matrix<T, Rows, Cols> &Matrix::operator*=(U d)
  * \brief Multiply the matrix by a scalar in-place
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <sstream>
 #include <vector>
@@ -31,9 +32,9 @@ template<typename T, unsigned int Rows, unsigned int Cols>
 class Matrix
 {
 public:
-	Matrix()
+	constexpr Matrix()
+		: data_{}
 	{
-		data_.fill(static_cast<T>(0));
 	}
 
 	Matrix(const std::vector<T> &data)
@@ -41,11 +42,11 @@ public:
 		std::copy(data.begin(), data.end(), data_.begin());
 	}
 
-	static Matrix identity()
+	static constexpr Matrix identity()
 	{
 		Matrix ret;
 		for (size_t i = 0; i < std::min(Rows, Cols); i++)
-			ret[i][i] = static_cast<T>(1);
+			ret.data_[i * Cols + i] = static_cast<T>(1);
 		return ret;
 	}
 
@@ -69,16 +70,19 @@ public:
 		return out.str();
 	}
 
-	Span<const T, Cols> operator[](size_t i) const
+	constexpr Span<const T, Cols> operator[](size_t i) const
 	{
 		return Span<const T, Cols>{ &data_.data()[i * Cols], Cols };
 	}
 
-	Span<T, Cols> operator[](size_t i)
+	constexpr Span<T, Cols> operator[](size_t i)
 	{
 		return Span<T, Cols>{ &data_.data()[i * Cols], Cols };
 	}
 
+	constexpr Span<const T, Rows * Cols> data() const { return data_; }
+	constexpr Span<T, Rows * Cols> data() { return data_; }
+
 #ifndef __DOXYGEN__
 	template<typename U, std::enable_if_t<std::is_arithmetic_v<U>>>
 #else
@@ -101,14 +105,14 @@ template<typename T, typename U, unsigned int Rows, unsigned int Cols,
 #else
 template<typename T, typename U, unsigned int Rows, unsigned int Cols>
 #endif /* __DOXYGEN__ */
-Matrix<U, Rows, Cols> operator*(T d, const Matrix<U, Rows, Cols> &m)
+constexpr Matrix<U, Rows, Cols> operator*(T d, const Matrix<U, Rows, Cols> &m)
 {
 	Matrix<U, Rows, Cols> result;
+	Span<U, Rows * Cols> r = result.data();
+	Span<const U, Rows * Cols> a = m.data();
 
-	for (unsigned int i = 0; i < Rows; i++) {
-		for (unsigned int j = 0; j < Cols; j++)
-			result[i][j] = d * m[i][j];
-	}
+	for (unsigned int i = 0; i < Rows * Cols; i++)
+		r[i] = d * a[i];
 
 	return result;
 }
@@ -119,7 +123,7 @@ template<typename T, typename U, unsigned int Rows, unsigned int Cols,
 #else
 template<typename T, typename U, unsigned int Rows, unsigned int Cols>
 #endif /* __DOXYGEN__ */
-Matrix<U, Rows, Cols> operator*(const Matrix<U, Rows, Cols> &m, T d)
+constexpr Matrix<U, Rows, Cols> operator*(const Matrix<U, Rows, Cols> &m, T d)
 {
 	return d * m;
 }
@@ -132,18 +136,23 @@ template<typename T,
 #else
 template<typename T, unsigned int R1, unsigned int C1, unsigned int R2, unsigned in C2>
 #endif /* __DOXYGEN__ */
-Matrix<T, R1, C2> operator*(const Matrix<T, R1, C1> &m1, const Matrix<T, R2, C2> &m2)
+constexpr Matrix<T, R1, C2> operator*(const Matrix<T, R1, C1> &m1, const Matrix<T, R2, C2> &m2)
 {
 	Matrix<T, R1, C2> result;
-
+	Span<T, R1 * C2> r = result.data();
+	Span<const T, R1 * C1> a = m1.data();
+	Span<const T, R2 * C2> b = m2.data();
+
+	/*
+	 * Accumulate rows of m2 scaled by the elements of m1, to operate on
+	 * contiguous data in the inner loop and let the compiler vectorize it.
+	 */
 	for (unsigned int i = 0; i < R1; i++) {
-		for (unsigned int j = 0; j < C2; j++) {
-			T sum = 0;
+		for (unsigned int k = 0; k < C1; k++) {
+			const T factor = a[i * C1 + k];
 
-			for (unsigned int k = 0; k < C1; k++)
-				sum += m1[i][k] * m2[k][j];
-
-			result[i][j] = sum;
+			for (unsigned int j = 0; j < C2; j++)
+				r[i * C2 + j] += factor * b[k * C2 + j];
 		}
 	}
 
@@ -151,14 +160,15 @@ Matrix<T, R1, C2> operator*(const Matrix<T, R1, C1> &m1, const Matrix<T, R2, C2>
 }
 
 template<typename T, unsigned int Rows, unsigned int Cols>
-Matrix<T, Rows, Cols> operator+(const Matrix<T, Rows, Cols> &m1, const Matrix<T, Rows, Cols> &m2)
+constexpr Matrix<T, Rows, Cols> operator+(const Matrix<T, Rows, Cols> &m1, const Matrix<T, Rows, Cols> &m2)
 {
 	Matrix<T, Rows, Cols> result;
+	Span<T, Rows * Cols> r = result.data();
+	Span<const T, Rows * Cols> a = m1.data();
+	Span<const T, Rows * Cols> b = m2.data();
 
-	for (unsigned int i = 0; i < Rows; i++) {
-		for (unsigned int j = 0; j < Cols; j++)
-			result[i][j] = m1[i][j] + m2[i][j];
-	}
+	for (unsigned int i = 0; i < Rows * Cols; i++)
+		r[i] = a[i] + b[i];
 
 	return result;
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <string>
 #include <tuple>
@@ -99,17 +100,30 @@ public:
 		if (ct >= matrices_.rbegin()->first)
 			return matrices_.rbegin()->second;
 
-		if (matrices_.find(ct) != matrices_.end())
-			return matrices_[ct];
+		/* The above three guarantee that this will succeed */
+		auto upper = matrices_.lower_bound(ct);
+		if (upper->first == ct)
+			return upper->second;
 
-		/* The above four guarantee that this will succeed */
-		auto iter = matrices_.upper_bound(ct);
-		unsigned int ctUpper = iter->first;
-		unsigned int ctLower = (--iter)->first;
+		auto lower = std::prev(upper);
+
+		double lambda = (ct - lower->first) /
+				static_cast<double>(upper->first - lower->first);
+
+		/*
+		 * Interpolate in a single pass over the elements, avoiding the
+		 * temporary matrices of the scalar multiplication and addition
+		 * operators.
+		 */
+		Matrix<T, R, C> ret;
+		Span<T, R * C> r = ret.data();
+		Span<const T, R * C> u{ upper->second.data() };
+		Span<const T, R * C> l{ lower->second.data() };
+
+		for (unsigned int i = 0; i < R * C; i++)
+			r[i] = static_cast<T>(lambda * u[i]) +
+			       static_cast<T>((1.0 - lambda) * l[i]);
 
-		double lambda = (ct - ctLower) / static_cast<double>(ctUpper - ctLower);
-		Matrix<T, R, C> ret =
-			lambda * matrices_[ctUpper] + (1.0 - lambda) * matrices_[ctLower];
 		return ret;
 	}
 
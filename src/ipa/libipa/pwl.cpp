@@ -10,9 +10,12 @@
 
 #include <assert.h>
 #include <cmath>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
+#include <libcamera/base/log.h>
+
 /**
  * \file pwl.h
  * \brief Piecewise linear functions
@@ -155,6 +158,14 @@ void Pwl::prepend(double x, double y, const double eps)
 		points_.insert(points_.begin(), Point({ x, y }));
 }
 
+/**
+ * \fn Pwl::clear()
+ * \brief Remove all points from the piecewise linear function
+ *
+ * The memory used to store the points is retained, and reused when new points
+ * are added.
+ */
+
 /**
  * \fn Pwl::empty() const
  * \brief Check if the piecewise linear function is empty
@@ -213,6 +224,64 @@ double Pwl::eval(double x, int *span, bool updateSpan) const
 		       (points_[index + 1].x() - points_[index].x());
 }
 
+/**
+ * \brief Evaluate the piecewise linear function at multiple positions
+ * \param[in] x The x values to input into the function
+ * \param[out] y The results of evaluating the function at positions \a x
+ *
+ * Evaluate the Pwl for all the values in \a x and store the results in \a y,
+ * which shall be at least as large as \a x. The results are identical to
+ * calling eval() for each value, but the Pwl spans are searched only once for
+ * each run of consecutive values that fall in the same span. When \a x is
+ * sorted in ascending order, as is typical when filling a lookup table, the
+ * whole evaluation is a single sweep over the Pwl points, and the inner
+ * interpolation loop is free of branches.
+ */
+void Pwl::eval(Span<const double> x, Span<double> y) const
+{
+	ASSERT(y.size() >= x.size());
+
+	int span = points_.size() / 2 - 1;
+	size_t start = 0;
+
+	while (start < x.size()) {
+		double lower, upper;
+
+		span = findSpan(x[start], span);
+		spanLimits(span, &lower, &upper);
+
+		size_t end = start + 1;
+		while (end < x.size() && x[end] >= lower && x[end] < upper)
+			end++;
+
+		interpolate(span, x.subspan(start, end - start),
+			    y.subspan(start, end - start));
+		start = end;
+	}
+}
+
+void Pwl::spanLimits(int span, double *lower, double *upper) const
+{
+	/* The first and last spans extend to infinity, see findSpan(). */
+	int lastSpan = points_.size() - 2;
+
+	*lower = span ? points_[span].x()
+		      : -std::numeric_limits<double>::infinity();
+	*upper = span < lastSpan ? points_[span + 1].x()
+				 : std::numeric_limits<double>::infinity();
+}
+
+void Pwl::interpolate(int span, Span<const double> x, Span<double> y) const
+{
+	const Point &p0 = points_[span];
+	const Point &p1 = points_[span + 1];
+	const double dx = p1.x() - p0.x();
+	const double dy = p1.y() - p0.y();
+
+	for (size_t i = 0; i < x.size(); i++)
+		y[i] = p0.y() + (x[i] - p0.x()) * dy / dx;
+}
+
 int Pwl::findSpan(double x, int span) const
 {
 	/*
@@ -244,8 +313,30 @@ int Pwl::findSpan(double x, int span) const
  */
 std::pair<Pwl, bool> Pwl::inverse(const double eps) const
 {
-	bool appended = false, prepended = false, neither = false;
 	Pwl inverse;
+	bool trueInverse = this->inverse(&inverse, eps);
+
+	return { inverse, trueInverse };
+}
+
+/**
+ * \brief Compute the inverse function into existing storage
+ * \param[out] result The inverse piecewise linear function
+ * \param[in] eps Epsilon for the minimum x distance between points (optional)
+ *
+ * This function behaves as inverse(double) const, but stores the inverse
+ * function in \a result, reusing its memory. It avoids allocating memory when
+ * \a result is large enough, and shall be preferred in per-frame processing.
+ * The \a result shall not be this function.
+ *
+ * \return True if the result is a proper inverse, false otherwise
+ */
+bool Pwl::inverse(Pwl *result, const double eps) const
+{
+	bool appended = false, prepended = false, neither = false;
+	Pwl &inverse = *result;
+
+	inverse.clear();
 
 	for (Point const &p : points_) {
 		if (inverse.empty()) {
@@ -269,9 +360,7 @@ std::pair<Pwl, bool> Pwl::inverse(const double eps) const
 	 * onto both ends of the inverse, or if there were points that couldn't
 	 * go on either.
 	 */
-	bool trueInverse = !(neither || (appended && prepended));
-
-	return { inverse, trueInverse };
+	return !(neither || (appended && prepended));
 }
 
 /**
@@ -284,10 +373,29 @@ std::pair<Pwl, bool> Pwl::inverse(const double eps) const
  * \return The composed piecewise linear function
  */
 Pwl Pwl::compose(Pwl const &other, const double eps) const
+{
+	Pwl result;
+	compose(other, &result, eps);
+	return result;
+}
+
+/**
+ * \brief Compose two piecewise linear functions together into existing storage
+ * \param[in] other The "other" piecewise linear function
+ * \param[out] result The composed piecewise linear function
+ * \param[in] eps Epsilon for the minimum x distance between points (optional)
+ *
+ * This function behaves as compose(const Pwl &, double) const, but stores the
+ * composed function in \a result, reusing its memory. The \a result shall be
+ * neither this function nor \a other.
+ */
+void Pwl::compose(Pwl const &other, Pwl *result, const double eps) const
 {
 	double thisX = points_[0].x(), thisY = points_[0].y();
 	int thisSpan = 0, otherSpan = other.findSpan(thisY, 0);
-	Pwl result({ Point({ thisX, other.eval(thisY, &otherSpan, false) }) });
+
+	result->clear();
+	result->points_.push_back(Point({ thisX, other.eval(thisY, &otherSpan, false) }));
 
 	while (thisSpan != (int)points_.size() - 1) {
 		double dx = points_[thisSpan + 1].x() - points_[thisSpan].x(),
@@ -322,10 +430,9 @@ Pwl Pwl::compose(Pwl const &other, const double eps) const
 			thisX = points_[thisSpan].x(),
 			thisY = points_[thisSpan].y();
 		}
-		result.append(thisX, other.eval(thisY, &otherSpan, false),
-			      eps);
+		result->append(thisX, other.eval(thisY, &otherSpan, false),
+			       eps);
 	}
-	return result;
 }
 
 /**
@@ -387,10 +494,30 @@ Pwl Pwl::combine(Pwl const &pwl0, Pwl const &pwl1,
 		 const double eps)
 {
 	Pwl result;
+	combine(pwl0, pwl1, f, &result, eps);
+	return result;
+}
+
+/**
+ * \brief Combine two Pwls into existing storage
+ * \param[in] pwl0 First piecewise linear function
+ * \param[in] pwl1 Second piecewise linear function
+ * \param[in] f Function to be applied
+ * \param[out] result The combined pwl
+ * \param[in] eps Epsilon for the minimum x distance between points (optional)
+ *
+ * This function behaves as the combine() function that returns a new Pwl, but
+ * stores the combined function in \a result, reusing its memory. The \a result
+ * shall be neither \a pwl0 nor \a pwl1.
+ */
+void Pwl::combine(Pwl const &pwl0, Pwl const &pwl1,
+		  std::function<double(double x, double y0, double y1)> f,
+		  Pwl *result, const double eps)
+{
+	result->clear();
 	map2(pwl0, pwl1, [&](double x, double y0, double y1) {
-		result.append(x, f(x, y0, y1), eps);
+		result->append(x, f(x, y0, y1), eps);
 	});
-	return result;
 }
 
 /**
@@ -13,6 +13,8 @@
 #include <utility>
 #include <vector>
 
+#include <libcamera/base/span.h>
+
 #include "libcamera/internal/yaml_parser.h"
 
 #include "vector.h"
@@ -51,6 +53,7 @@ public:
 
 	void append(double x, double y, double eps = 1e-6);
 
+	void clear() { points_.clear(); }
 	bool empty() const { return points_.empty(); }
 	size_t size() const { return points_.size(); }
 
@@ -59,9 +62,12 @@ public:
 
 	double eval(double x, int *span = nullptr,
 		    bool updateSpan = true) const;
+	void eval(Span<const double> x, Span<double> y) const;
 
 	std::pair<Pwl, bool> inverse(double eps = 1e-6) const;
+	bool inverse(Pwl *result, double eps = 1e-6) const;
 	Pwl compose(const Pwl &other, double eps = 1e-6) const;
+	void compose(const Pwl &other, Pwl *result, double eps = 1e-6) const;
 
 	void map(std::function<void(double x, double y)> f) const;
 
@@ -69,6 +75,10 @@ public:
 	combine(const Pwl &pwl0, const Pwl &pwl1,
 		std::function<double(double x, double y0, double y1)> f,
 		double eps = 1e-6);
+	static void
+	combine(const Pwl &pwl0, const Pwl &pwl1,
+		std::function<double(double x, double y0, double y1)> f,
+		Pwl *result, double eps = 1e-6);
 
 	Pwl &operator*=(double d);
 
@@ -79,6 +89,8 @@ private:
 			 std::function<void(double x, double y0, double y1)> f);
 	void prepend(double x, double y, double eps = 1e-6);
 	int findSpan(double x, int span) const;
+	void spanLimits(int span, double *lower, double *upper) const;
+	void interpolate(int span, Span<const double> x, Span<double> y) const;
 
 	std::vector<Point> points_;
 };
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Per-frame scratch memory for IPA algorithms
+ */
+
+#include "scratch_arena.h"
+
+#include <algorithm>
+
+#include <libcamera/base/log.h>
+
+/**
+ * \file scratch_arena.h
+ * \brief Per-frame scratch memory for IPA algorithms
+ */
+
+namespace libcamera {
+
+LOG_DEFINE_CATEGORY(ScratchArena)
+
+namespace ipa {
+
+/**
+ * \class ScratchArena
+ * \brief Linear allocator for temporary per-frame data
+ *
+ * IPA algorithms often need temporary arrays when processing statistics or
+ * preparing parameters, such as copies of statistics zones to be sorted.
+ * Allocating them from the heap for every frame adds latency and jitter to the
+ * IPA processing.
+ *
+ * The ScratchArena provides this memory from a single preallocated block. It
+ * is meant to be stored in the IPA context, with algorithms reserving the
+ * memory they need at configure() time with reserve(), and allocating from
+ * the arena during frame processing with allocate(). The IPA module resets
+ * the arena once per frame with reset(), which frees all allocations at once.
+ *
+ * Allocations never fail. If the reserved memory is exhausted, the arena
+ * falls back to allocating from the heap, and grows its block to the peak
+ * usage at the next reset() to avoid further heap allocations.
+ */
+
+ScratchArena::ScratchArena()
+	: capacity_(0), offset_(0), used_(0), peak_(0), reserved_(0)
+{
+}
+
+/**
+ * \brief Reserve memory in the arena for per-frame allocations
+ * \param[in] size The number of bytes the caller allocates per frame
+ * \param[in] alignment The alignment of the allocations
+ *
+ * Reservations accumulate until release() is called. Each algorithm that uses
+ * the arena shall reserve the memory it allocates per frame, typically in its
+ * configure() function. The block is resized immediately when the arena holds
+ * no allocation, or at the next reset() otherwise.
+ */
+void ScratchArena::reserve(size_t size, size_t alignment)
+{
+	reserved_ += size + alignment - 1;
+
+	if (!used_)
+		resize(std::max(reserved_, peak_));
+}
+
+/**
+ * \fn ScratchArena::reserve(size_t count)
+ * \brief Reserve memory in the arena for \a count objects of type T
+ * \tparam T The object type
+ * \param[in] count The number of objects the caller allocates per frame
+ */
+
+/**
+ * \fn ScratchArena::allocate()
+ * \brief Allocate an array of objects from the arena
+ * \tparam T The object type, which shall be trivially destructible
+ * \param[in] count The number of objects
+ *
+ * The objects are default-initialized, and stay valid until the next call to
+ * reset() or release(). They are not destroyed.
+ *
+ * \return A span covering the allocated objects
+ */
+
+/**
+ * \brief Free all allocations
+ *
+ * If allocations have overflowed the arena block since the last reset, the
+ * block is grown to the peak memory usage.
+ */
+void ScratchArena::reset()
+{
+	if (!overflow_.empty()) {
+		LOG(ScratchArena, Debug)
+			<< "Growing arena from " << capacity_ << " to "
+			<< peak_ << " bytes";
+
+		overflow_.clear();
+		resize(std::max(reserved_, peak_));
+	}
+
+	offset_ = 0;
+	used_ = 0;
+}
+
+/**
+ * \brief Free all allocations and the arena memory, and drop all reservations
+ */
+void ScratchArena::release()
+{
+	overflow_.clear();
+	block_.reset();
+	capacity_ = 0;
+	offset_ = 0;
+	used_ = 0;
+	peak_ = 0;
+	reserved_ = 0;
+}
+
+/**
+ * \fn ScratchArena::capacity()
+ * \brief Retrieve the size of the arena block
+ * \return The size of the arena block in bytes
+ */
+
+/**
+ * \fn ScratchArena::used()
+ * \brief Retrieve the memory allocated since the last reset
+ * \return The memory allocated since the last reset, in bytes, including
+ * alignment padding
+ */
+
+void *ScratchArena::allocateBytes(size_t size, size_t alignment)
+{
+	const uintptr_t base = reinterpret_cast<uintptr_t>(block_.get());
+	const uintptr_t address = (base + offset_ + alignment - 1) & ~(alignment - 1);
+	const size_t end = address - base + size;
+
+	if (block_ && end <= capacity_) {
+		used_ += end - offset_;
+		offset_ = end;
+		peak_ = std::max(peak_, used_);
+		return reinterpret_cast<void *>(address);
+	}
+
+	/*
+	 * Fall back to a heap allocation, accounting for the size and
+	 * alignment the allocation will need in the arena block.
+	 */
+	used_ += size + alignment - 1;
+	peak_ = std::max(peak_, used_);
+
+	overflow_.push_back(std::make_unique<uint8_t[]>(size + alignment - 1));
+	const uintptr_t heap = reinterpret_cast<uintptr_t>(overflow_.back().get());
+	return reinterpret_cast<void *>((heap + alignment - 1) & ~(alignment - 1));
+}
+
+void ScratchArena::resize(size_t capacity)
+{
+	if (capacity <= capacity_)
+		return;
+
+	block_ = std::make_unique<uint8_t[]>(capacity);
+	capacity_ = capacity;
+	offset_ = 0;
+}
+
+} /* namespace ipa */
+
+} /* namespace libcamera */
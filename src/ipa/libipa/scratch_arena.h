@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Per-frame scratch memory for IPA algorithms
+ */
+
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+namespace libcamera {
+
+namespace ipa {
+
+class ScratchArena
+{
+public:
+	ScratchArena();
+
+	void reserve(size_t size, size_t alignment = alignof(max_align_t));
+
+	template<typename T>
+	void reserve(size_t count)
+	{
+		reserve(count * sizeof(T), alignof(T));
+	}
+
+	template<typename T>
+	Span<T> allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>,
+			      "Scratch arena objects are not destroyed");
+
+		T *data = static_cast<T *>(allocateBytes(count * sizeof(T), alignof(T)));
+		std::uninitialized_default_construct_n(data, count);
+
+		return { data, count };
+	}
+
+	void reset();
+	void release();
+
+	size_t capacity() const { return capacity_; }
+	size_t used() const { return used_; }
+
+private:
+	void *allocateBytes(size_t size, size_t alignment);
+	void resize(size_t capacity);
+
+	std::unique_ptr<uint8_t[]> block_;
+	size_t capacity_;
+	size_t offset_;
+
+	std::vector<std::unique_ptr<uint8_t[]>> overflow_;
+	size_t used_;
+	size_t peak_;
+	size_t reserved_;
+};
+
+} /* namespace ipa */
+
+} /* namespace libcamera */
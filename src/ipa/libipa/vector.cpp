@@ -52,6 +52,21 @@ namespace ipa {
  * \copydoc Vector::operator[](size_t i) const
  */
 
+/**
+ * \fn Span<const T, Rows> Vector::data() const
+ * \brief Access the vector elements
+ *
+ * Accessing the elements through the returned span avoids the bounds check of
+ * operator[] in performance-sensitive code.
+ *
+ * \return The vector elements, as a Span
+ */
+
+/**
+ * \fn Vector::data()
+ * \copydoc Vector::data() const
+ */
+
 /**
  * \fn Vector::x()
  * \brief Convenience function to access the first element of the vector
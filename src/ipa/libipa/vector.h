@@ -53,6 +53,9 @@ public:
 		return data_[i];
 	}
 
+	constexpr Span<const T, Rows> data() const { return data_; }
+	constexpr Span<T, Rows> data() { return data_; }
+
 #ifndef __DOXYGEN__
 	template<bool Dependent = false, typename = std::enable_if_t<Dependent || Rows >= 1>>
 #endif /* __DOXYGEN__ */
@@ -143,15 +146,18 @@ private:
 };
 
 template<typename T, unsigned int Rows, unsigned int Cols>
-Vector<T, Rows> operator*(const Matrix<T, Rows, Cols> &m, const Vector<T, Cols> &v)
+constexpr Vector<T, Rows> operator*(const Matrix<T, Rows, Cols> &m, const Vector<T, Cols> &v)
 {
-	Vector<T, Rows> result;
+	Vector<T, Rows> result{};
+	Span<T, Rows> r = result.data();
+	Span<const T, Rows * Cols> a = m.data();
+	Span<const T, Cols> b = v.data();
 
 	for (unsigned int i = 0; i < Rows; i++) {
 		T sum = 0;
 		for (unsigned int j = 0; j < Cols; j++)
-			sum += m[i][j] * v[j];
-		result[i] = sum;
+			sum += a[i * Cols + j] * b[j];
+		r[i] = sum;
 	}
 
 	return result;
@@ -417,8 +417,8 @@ void Agc::process(IPAContext &context, [[maybe_unused]] const uint32_t frame,
 	ASSERT(stats->meas_type & RKISP1_CIF_ISP_STAT_AUTOEXP);
 
 	/* The lower 4 bits are fractional and meant to be discarded. */
-	Histogram hist({ params->hist.hist_bins, context.hw->numHistogramBins },
-		       [](uint32_t x) { return x >> 4; });
+	hist_.assign({ params->hist.hist_bins, context.hw->numHistogramBins },
+		     [](uint32_t x) { return x >> 4; });
 	expMeans_ = { params->ae.exp_mean, context.hw->numAeCells };
 
 	utils::Duration maxShutterSpeed =
@@ -444,7 +444,7 @@ void Agc::process(IPAContext &context, [[maybe_unused]] const uint32_t frame,
 	std::tie(shutterTime, aGain, dGain) =
 		calculateNewEv(frameContext.agc.constraintMode,
 			       frameContext.agc.exposureMode,
-			       hist, effectiveExposureValue);
+			       hist_, effectiveExposureValue);
 
 	LOG(RkISP1Agc, Debug)
 		<< "Divided up shutter, analogue gain and digital gain are "
@@ -52,6 +52,7 @@ private:
 			  ControlList &metadata);
 	double estimateLuminance(double gain) const override;
 
+	Histogram hist_;
 	Span<const uint8_t> expMeans_;
 
 	std::map<int32_t, std::vector<uint8_t>> meteringModes_;
@@ -22,7 +22,7 @@
 
 #include "libcamera/internal/yaml_parser.h"
 
-#include "../utils.h"
+#include "libipa/fixedpoint.h"
 #include "libipa/matrix_interpolator.h"
 
 /**
@@ -81,11 +81,9 @@ void Ccm::setParameters(rkisp1_params_cfg *params,
 	 * 4 bit integer and 7 bit fractional, ranging from -8 (0x400) to
 	 * +7.992 (0x3ff)
 	 */
-	for (unsigned int i = 0; i < 3; i++) {
-		for (unsigned int j = 0; j < 3; j++)
-			config.coeff[i][j] =
-				utils::floatingToFixedPoint<4, 7, uint16_t, double>(matrix[i][j]);
-	}
+	Matrix<uint16_t, 3, 3> coeffs =
+		floatingToFixedPoint<4, 7, uint16_t, float>(matrix);
+	std::copy(coeffs.data().begin(), coeffs.data().end(), &config.coeff[0][0]);
 
 	for (unsigned int i = 0; i < 3; i++)
 		config.ct_offset[i] = offsets[i][0] & 0xfff;
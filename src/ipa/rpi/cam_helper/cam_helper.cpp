@@ -215,18 +215,17 @@ unsigned int CamHelper::mistrustFramesModeSwitch() const
 void CamHelper::parseEmbeddedData(Span<const uint8_t> buffer,
 				  Metadata &metadata)
 {
-	MdParser::RegisterMap registers;
 	Metadata parsedMetadata;
 
 	if (buffer.empty())
 		return;
 
-	if (parser_->parse(buffer, registers) != MdParser::Status::OK) {
+	if (parser_->parse(buffer, registers_) != MdParser::Status::OK) {
 		LOG(IPARPI, Error) << "Embedded data buffer parsing failed";
 		return;
 	}
 
-	populateMetadata(registers, parsedMetadata);
+	populateMetadata(registers_, parsedMetadata);
 	metadata.merge(parsedMetadata);
 
 	/*
@@ -110,6 +110,9 @@ protected:
 	CameraMode mode_;
 
 private:
+	/* Register values parsed from embedded data, reused across frames. */
+	MdParser::RegisterMap registers_;
+
 	/*
 	 * Smallest difference between the frame length and integration time,
 	 * in units of lines.
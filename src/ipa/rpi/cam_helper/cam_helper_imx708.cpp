@@ -5,6 +5,7 @@
  * camera helper for imx708 sensor
  */
 
+#include <array>
 #include <cmath>
 #include <stddef.h>
 #include <stdio.h>
@@ -80,6 +81,8 @@ private:
 
 	static bool parsePdafData(const uint8_t *ptr, size_t len, unsigned bpp,
 				  PdafRegions &pdaf);
+	template<size_t Step>
+	static void unpackPdafData(const uint8_t *ptr, PdafRegions &pdaf);
 
 	bool parseAEHist(const uint8_t *ptr, size_t len, unsigned bpp);
 	void putAGCStatistics(StatisticsPtr stats);
@@ -277,21 +280,50 @@ bool CamHelperImx708::parsePdafData(const uint8_t *ptr, size_t len,
 	pdaf.init({ pdafStatsCols, pdafStatsRows });
 
 	ptr += 2 * step;
-	for (unsigned i = 0; i < pdafStatsRows; ++i) {
-		for (unsigned j = 0; j < pdafStatsCols; ++j) {
-			unsigned c = (ptr[0] << 3) | (ptr[1] >> 5);
-			int p = (((ptr[1] & 0x0F) - (ptr[1] & 0x10)) << 6) | (ptr[2] >> 2);
-			PdafData pdafData;
-			pdafData.conf = c;
-			pdafData.phase = c ? p : 0;
-			pdaf.set(libcamera::Point(j, i), { pdafData, 1, 0 });
-			ptr += step;
-		}
+	switch (step) {
+	case 5:
+		unpackPdafData<5>(ptr, pdaf);
+		break;
+	case 6:
+		unpackPdafData<6>(ptr, pdaf);
+		break;
+	default:
+		unpackPdafData<7>(ptr, pdaf);
+		break;
 	}
 
 	return true;
 }
 
+template<size_t Step>
+void CamHelperImx708::unpackPdafData(const uint8_t *ptr, PdafRegions &pdaf)
+{
+	static constexpr unsigned int numRegions = pdafStatsRows * pdafStatsCols;
+	std::array<uint16_t, numRegions> conf;
+	std::array<int16_t, numRegions> phase;
+
+	/*
+	 * Unpack the confidence and phase of all regions first. With a
+	 * compile-time stride, the loop has no data-dependent branches and can
+	 * be vectorised by the compiler.
+	 */
+	for (unsigned int i = 0; i < numRegions; ++i) {
+		const uint8_t *entry = ptr + i * Step;
+		unsigned int c = (entry[0] << 3) | (entry[1] >> 5);
+		int p = (((entry[1] & 0x0F) - (entry[1] & 0x10)) << 6) | (entry[2] >> 2);
+
+		conf[i] = c;
+		phase[i] = c ? p : 0;
+	}
+
+	for (unsigned int i = 0; i < numRegions; ++i) {
+		PdafData pdafData;
+		pdafData.conf = conf[i];
+		pdafData.phase = phase[i];
+		pdaf.set(i, { pdafData, 1, 0 });
+	}
+}
+
 bool CamHelperImx708::parseAEHist(const uint8_t *ptr, size_t len, unsigned bpp)
 {
 	static constexpr unsigned int PipelineBits = Statistics::NormalisationFactorPow2;
@@ -10,6 +10,8 @@
 #include <map>
 #include <optional>
 #include <stdint.h>
+#include <utility>
+#include <vector>
 
 #include <libcamera/base/span.h>
 
@@ -127,8 +129,12 @@ public:
 			       RegisterMap &registers) override;
 
 private:
-	/* Maps register address to offset in the buffer. */
-	using OffsetMap = std::map<uint32_t, std::optional<uint32_t>>;
+	/*
+	 * Maps register address to offset in the buffer, sorted by register
+	 * address. The offsets are computed once when the parser is reset, and
+	 * used to read the register values directly for every frame.
+	 */
+	using OffsetMap = std::vector<std::pair<uint32_t, std::optional<uint32_t>>>;
 
 	/*
 	 * Note that error codes > 0 are regarded as non-fatal; codes < 0
@@ -148,6 +154,7 @@ private:
 	};
 
 	ParseStatus findRegs(libcamera::Span<const uint8_t> buffer);
+	OffsetMap::iterator findOffset(uint32_t reg);
 
 	OffsetMap offsets_;
 };
@@ -5,6 +5,8 @@
  * SMIA specification based embedded data parser
  */
 
+#include <algorithm>
+
 #include <libcamera/base/log.h>
 #include "md_parser.h"
 
@@ -30,7 +32,11 @@ constexpr unsigned int RegSkip = 0x55;
 MdParserSmia::MdParserSmia(std::initializer_list<uint32_t> registerList)
 {
 	for (auto r : registerList)
-		offsets_[r] = {};
+		offsets_.emplace_back(r, std::nullopt);
+
+	std::sort(offsets_.begin(), offsets_.end());
+	offsets_.erase(std::unique(offsets_.begin(), offsets_.end()),
+		       offsets_.end());
 }
 
 MdParser::Status MdParserSmia::parse(libcamera::Span<const uint8_t> buffer,
@@ -43,8 +49,8 @@ MdParser::Status MdParserSmia::parse(libcamera::Span<const uint8_t> buffer,
 		 */
 		ASSERT(bitsPerPixel_);
 
-		for (const auto &kv : offsets_)
-			offsets_[kv.first] = {};
+		for (auto &kv : offsets_)
+			kv.second.reset();
 
 		ParseStatus ret = findRegs(buffer);
 		/*
@@ -59,19 +65,52 @@ MdParser::Status MdParserSmia::parse(libcamera::Span<const uint8_t> buffer,
 		reset_ = false;
 	}
 
-	/* Populate the register values requested. */
-	registers.clear();
-	for (const auto &[reg, offset] : offsets_) {
-		if (!offset) {
+	/*
+	 * Populate the register values requested. When the caller reuses the
+	 * same register map for every frame, its keys match the offsets table
+	 * and the values can be updated in place without reallocating the map.
+	 */
+	bool inPlace = registers.size() == offsets_.size();
+	if (inPlace) {
+		auto reg = registers.begin();
+		for (const auto &kv : offsets_) {
+			if ((reg++)->first != kv.first) {
+				inPlace = false;
+				break;
+			}
+		}
+	}
+
+	if (!inPlace)
+		registers.clear();
+
+	auto reg = registers.begin();
+	for (const auto &[address, offset] : offsets_) {
+		if (!offset || offset.value() >= buffer.size()) {
 			reset_ = true;
 			return NOTFOUND;
 		}
-		registers[reg] = buffer[offset.value()];
+
+		if (inPlace)
+			(reg++)->second = buffer[offset.value()];
+		else
+			registers.emplace_hint(registers.end(), address,
+					       buffer[offset.value()]);
 	}
 
 	return OK;
 }
 
+MdParserSmia::OffsetMap::iterator MdParserSmia::findOffset(uint32_t reg)
+{
+	auto it = std::lower_bound(offsets_.begin(), offsets_.end(), reg,
+				   [](const auto &kv, uint32_t r) { return kv.first < r; });
+	if (it == offsets_.end() || it->first != reg)
+		return offsets_.end();
+
+	return it;
+}
+
 MdParserSmia::ParseStatus MdParserSmia::findRegs(libcamera::Span<const uint8_t> buffer)
 {
 	ASSERT(offsets_.size());
@@ -136,10 +175,10 @@ MdParserSmia::ParseStatus MdParserSmia::findRegs(libcamera::Span<const uint8_t>
 			else if (tag == RegSkip)
 				regNum++;
 			else if (tag == RegValue) {
-				auto reg = offsets_.find(regNum);
+				auto reg = findOffset(regNum);
 
 				if (reg != offsets_.end()) {
-					offsets_[regNum] = currentOffset - 1;
+					reg->second = currentOffset - 1;
 
 					if (++regsDone == offsets_.size())
 						return ParseOk;
@@ -469,16 +469,16 @@ double Awb::computeDelta2Sum(double gainR, double gainB)
 	return delta2Sum;
 }
 
-ipa::Pwl Awb::interpolatePrior()
+void Awb::interpolatePrior(ipa::Pwl *prior)
 {
 	/*
 	 * Interpolate the prior log likelihood function for our current lux
 	 * value.
 	 */
 	if (lux_ <= config_.priors.front().lux)
-		return config_.priors.front().prior;
+		*prior = config_.priors.front().prior;
 	else if (lux_ >= config_.priors.back().lux)
-		return config_.priors.back().prior;
+		*prior = config_.priors.back().prior;
 	else {
 		int idx = 0;
 		/* find which two we lie between */
@@ -486,12 +486,12 @@ ipa::Pwl Awb::interpolatePrior()
 			idx++;
 		double lux0 = config_.priors[idx].lux,
 		       lux1 = config_.priors[idx + 1].lux;
-		return ipa::Pwl::combine(config_.priors[idx].prior,
-				    config_.priors[idx + 1].prior,
-				    [&](double /*x*/, double y0, double y1) {
-					    return y0 + (y1 - y0) *
-							(lux_ - lux0) / (lux1 - lux0);
-				    });
+		ipa::Pwl::combine(config_.priors[idx].prior,
+				  config_.priors[idx + 1].prior,
+				  [&](double /*x*/, double y0, double y1) {
+					  return y0 + (y1 - y0) *
+						      (lux_ - lux0) / (lux1 - lux0);
+				  }, prior);
 	}
 }
 
@@ -654,7 +654,8 @@ void Awb::awbBayes()
 	 * Get the current prior, and scale according to how many zones are
 	 * valid... not entirely sure about this.
 	 */
-	ipa::Pwl prior = interpolatePrior();
+	ipa::Pwl &prior = prior_;
+	interpolatePrior(&prior);
 	prior *= zones_.size() / (double)(statistics_->awbRegions.numRegions());
 	prior.map([](double x, double y) {
 		LOG(RPiAwb, Debug) << "(" << x << "," << y << ")";
@@ -698,7 +699,8 @@ void Awb::awbGrey()
 	 * doing an L2 average etc.
 	 */
 	std::vector<RGB> &derivsR(zones_);
-	std::vector<RGB> derivsB(derivsR);
+	std::vector<RGB> &derivsB(derivsB_);
+	derivsB.assign(derivsR.begin(), derivsR.end());
 	std::sort(derivsR.begin(), derivsR.end(),
 		  [](RGB const &a, RGB const &b) {
 			  return a.G * b.R < b.G * a.R;
@@ -164,10 +164,13 @@ private:
 	void awbGrey();
 	void prepareStats();
 	double computeDelta2Sum(double gainR, double gainB);
-	libcamera::ipa::Pwl interpolatePrior();
+	void interpolatePrior(libcamera::ipa::Pwl *prior);
 	double coarseSearch(libcamera::ipa::Pwl const &prior);
 	void fineSearch(double &t, double &r, double &b, libcamera::ipa::Pwl const &prior);
 	std::vector<RGB> zones_;
+	/* Storage reused across frames by the AWB algorithms. */
+	std::vector<RGB> derivsB_;
+	libcamera::ipa::Pwl prior_;
 	std::vector<libcamera::ipa::Pwl::Point> points_;
 	/* manual r setting */
 	double manualR_;
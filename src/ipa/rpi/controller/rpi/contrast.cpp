@@ -94,11 +94,11 @@ void Contrast::prepare(Metadata *imageMetadata)
 	imageMetadata->set("contrast.status", status_);
 }
 
-ipa::Pwl computeStretchCurve(Histogram const &histogram,
-			ContrastConfig const &config)
+void computeStretchCurve(Histogram const &histogram,
+			 ContrastConfig const &config, ipa::Pwl *enhance)
 {
-	ipa::Pwl enhance;
-	enhance.append(0, 0);
+	enhance->clear();
+	enhance->append(0, 0);
 	/*
 	 * If the start of the histogram is rather empty, try to pull it down a
 	 * bit.
@@ -112,13 +112,13 @@ ipa::Pwl computeStretchCurve(Histogram const &histogram,
 			  std::min(65535.0, std::min(histLo, levelLo + config.loMax)));
 	LOG(RPiContrast, Debug)
 		<< "Final values " << histLo << " -> " << levelLo;
-	enhance.append(histLo, levelLo);
+	enhance->append(histLo, levelLo);
 	/*
 	 * Keep the mid-point (median) in the same place, though, to limit the
 	 * apparent amount of global brightness shift.
 	 */
 	double mid = histogram.quantile(0.5) * (65536 / histogram.bins());
-	enhance.append(mid, mid);
+	enhance->append(mid, mid);
 
 	/*
 	 * If the top to the histogram is empty, try to pull the pixel values
@@ -133,24 +133,22 @@ ipa::Pwl computeStretchCurve(Histogram const &histogram,
 			  std::max(0.0, std::max(histHi, levelHi - config.hiMax)));
 	LOG(RPiContrast, Debug)
 		<< "Final values " << histHi << " -> " << levelHi;
-	enhance.append(histHi, levelHi);
-	enhance.append(65535, 65535);
-	return enhance;
+	enhance->append(histHi, levelHi);
+	enhance->append(65535, 65535);
 }
 
-ipa::Pwl applyManualContrast(ipa::Pwl const &gammaCurve, double brightness,
-			     double contrast)
+void applyManualContrast(ipa::Pwl const &gammaCurve, double brightness,
+			 double contrast, ipa::Pwl *newGammaCurve)
 {
-	ipa::Pwl newGammaCurve;
+	newGammaCurve->clear();
 	LOG(RPiContrast, Debug)
 		<< "Manual brightness " << brightness << " contrast " << contrast;
 	gammaCurve.map([&](double x, double y) {
-		newGammaCurve.append(
+		newGammaCurve->append(
 			x, std::max(0.0, std::min(65535.0,
 						  (y - 32768) * contrast +
 							  32768 + brightness)));
 	});
-	return newGammaCurve;
 }
 
 void Contrast::process(StatisticsPtr &stats,
@@ -162,10 +160,14 @@ void Contrast::process(StatisticsPtr &stats,
 	 * ways: 1. Adjust the gamma curve so as to pull the start of the
 	 * histogram down, and possibly push the end up.
 	 */
-	ipa::Pwl gammaCurve = config_.gammaCurve;
+	ipa::Pwl &gammaCurve = status_.gammaCurve;
+	gammaCurve = config_.gammaCurve;
 	if (ceEnable_) {
-		if (config_.loMax != 0 || config_.hiMax != 0)
-			gammaCurve = computeStretchCurve(histogram, config_).compose(gammaCurve);
+		if (config_.loMax != 0 || config_.hiMax != 0) {
+			computeStretchCurve(histogram, config_, &stretchCurve_);
+			stretchCurve_.compose(gammaCurve, &scratchCurve_);
+			std::swap(gammaCurve, scratchCurve_);
+		}
 		/*
 		 * We could apply other adjustments (e.g. partial equalisation)
 		 * based on the histogram...?
@@ -175,15 +177,17 @@ void Contrast::process(StatisticsPtr &stats,
 	 * 2. Finally apply any manually selected brightness/contrast
 	 * adjustment.
 	 */
-	if (brightness_ != 0 || contrast_ != 1.0)
-		gammaCurve = applyManualContrast(gammaCurve, brightness_, contrast_);
+	if (brightness_ != 0 || contrast_ != 1.0) {
+		applyManualContrast(gammaCurve, brightness_, contrast_,
+				    &scratchCurve_);
+		std::swap(gammaCurve, scratchCurve_);
+	}
 	/*
 	 * And fill in the status for output. Use more points towards the bottom
 	 * of the curve.
 	 */
 	status_.brightness = brightness_;
 	status_.contrast = contrast_;
-	status_.gammaCurve = std::move(gammaCurve);
 }
 
 /* Register algorithm with the system. */
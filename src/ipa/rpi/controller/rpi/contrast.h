@@ -50,6 +50,10 @@ private:
 	double contrast_;
 	ContrastStatus status_;
 	double ceEnable_;
+
+	/* Storage reused across frames to compute the gamma curve. */
+	libcamera::ipa::Pwl stretchCurve_;
+	libcamera::ipa::Pwl scratchCurve_;
 };
 
 } /* namespace RPiController */
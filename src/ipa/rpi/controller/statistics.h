@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <vector>
 
@@ -75,4 +76,59 @@ struct Statistics {
 
 using StatisticsPtr = std::shared_ptr<Statistics>;
 
+/*
+ * A pool of Statistics objects, to avoid allocating new statistics, and their
+ * region and histogram storage, for every frame. Algorithms may hold on to
+ * the statistics they receive beyond the frame they're processing, possibly
+ * in other threads, so an object is returned to the pool by the deleter of
+ * the shared pointer, when the last reference to it is dropped. The free list
+ * mutex orders all accesses to the statistics before their release with their
+ * reuse. The pool grows as needed, and quickly settles to the number of
+ * statistics in flight.
+ *
+ * The free list is shared with the deleters, so statistics may outlive the
+ * pool.
+ */
+class StatisticsPool
+{
+public:
+	StatisticsPool(Statistics::AgcStatsPos a, Statistics::ColourStatsPos c)
+		: agcStatsPos_(a), colourStatsPos_(c),
+		  freeList_(std::make_shared<FreeList>())
+	{
+	}
+
+	StatisticsPtr acquire()
+	{
+		std::unique_ptr<Statistics> statistics;
+
+		{
+			std::lock_guard<std::mutex> lock(freeList_->mutex);
+			if (!freeList_->statistics.empty()) {
+				statistics = std::move(freeList_->statistics.back());
+				freeList_->statistics.pop_back();
+			}
+		}
+
+		if (!statistics)
+			statistics = std::make_unique<Statistics>(agcStatsPos_, colourStatsPos_);
+
+		std::shared_ptr<FreeList> freeList = freeList_;
+		return StatisticsPtr(statistics.release(), [freeList](Statistics *stats) {
+			std::lock_guard<std::mutex> lock(freeList->mutex);
+			freeList->statistics.emplace_back(stats);
+		});
+	}
+
+private:
+	struct FreeList {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Statistics>> statistics;
+	};
+
+	const Statistics::AgcStatsPos agcStatsPos_;
+	const Statistics::ColourStatsPos colourStatsPos_;
+	std::shared_ptr<FreeList> freeList_;
+};
+
 } /* namespace RPiController */
@@ -5,6 +5,7 @@
  * pisp.cpp - Raspberry Pi PiSP IPA
  */
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <mutex>
 #include <string>
@@ -74,20 +75,29 @@ inline int32_t clampField(double value, std::size_t fieldBits, std::size_t fracB
 int generateLut(const ipa::Pwl &pwl, uint32_t *lut, std::size_t lutSize,
 		unsigned int SlopeBits = 14, unsigned int PosBits = 16)
 {
+	static constexpr std::size_t kMaxLutSize =
+		std::max(PISP_BE_GAMMA_LUT_SIZE, PISP_BE_TONEMAP_LUT_SIZE);
+	std::array<double, kMaxLutSize> xs, ys;
+
 	if (pwl.empty())
 		return -EINVAL;
 
-	int lastY = 0;
+	ASSERT(lutSize <= kMaxLutSize);
+
 	for (unsigned int i = 0; i < lutSize; i++) {
-		int x, y;
 		if (i < 32)
-			x = i * 512;
+			xs[i] = i * 512;
 		else if (i < 48)
-			x = (i - 32) * 1024 + 16384;
+			xs[i] = (i - 32) * 1024 + 16384;
 		else
-			x = std::min(65535u, (i - 48) * 2048 + 32768);
+			xs[i] = std::min(65535u, (i - 48) * 2048 + 32768);
+	}
 
-		y = pwl.eval(x);
+	pwl.eval({ xs.data(), lutSize }, { ys.data(), lutSize });
+
+	int lastY = 0;
+	for (unsigned int i = 0; i < lutSize; i++) {
+		int y = ys[i];
 		if (y < 0 || (i && y < lastY)) {
 			LOG(IPARPI, Error)
 				<< "Malformed PWL for Gamma, disabling!";
@@ -199,7 +209,9 @@ class IpaPiSP final : public IpaBase
 {
 public:
 	IpaPiSP()
-		: IpaBase(), fe_(nullptr), be_(nullptr)
+		: IpaBase(), fe_(nullptr), be_(nullptr),
+		  statsPool_(RPiController::Statistics::AgcStatsPos::PostWb,
+			     RPiController::Statistics::ColourStatsPos::PreLsc)
 	{
 	}
 
@@ -265,6 +277,8 @@ private:
 	utils::Duration lastExposure_;
 	std::map<std::string, utils::Duration> lastStitchExposures_;
 	HdrStatus lastStitchHdrStatus_;
+
+	RPiController::StatisticsPool statsPool_;
 };
 
 int32_t IpaPiSP::platformInit(const InitParams &params,
@@ -450,13 +464,10 @@ RPiController::StatisticsPtr IpaPiSP::platformProcessStats(Span<uint8_t> mem)
 	const pisp_statistics *stats = reinterpret_cast<pisp_statistics *>(mem.data());
 
 	unsigned int i;
-	StatisticsPtr statistics =
-		std::make_unique<Statistics>(Statistics::AgcStatsPos::PostWb,
-					     Statistics::ColourStatsPos::PreLsc);
+	StatisticsPtr statistics = statsPool_.acquire();
 
 	/* RGB histograms are not used, so do not populate them. */
-	statistics->yHist = RPiController::Histogram(stats->agc.histogram,
-						     PISP_AGC_STATS_NUM_BINS);
+	statistics->yHist.assign(stats->agc.histogram, PISP_AGC_STATS_NUM_BINS);
 
 	statistics->awbRegions.init({ PISP_AWB_STATS_SIZE, PISP_AWB_STATS_SIZE });
 	for (i = 0; i < statistics->awbRegions.numRegions(); i++)
@@ -5,6 +5,7 @@
  * Raspberry Pi VC4/BCM2835 ISP IPA.
  */
 
+#include <array>
 #include <string.h>
 #include <sys/mman.h>
 
@@ -41,7 +42,9 @@ class IpaVc4 final : public IpaBase
 {
 public:
 	IpaVc4()
-		: IpaBase(), lsTable_(nullptr)
+		: IpaBase(), lsTable_(nullptr),
+		  statsPool_(RPiController::Statistics::AgcStatsPos::PreWb,
+			     RPiController::Statistics::ColourStatsPos::PostLsc)
 	{
 	}
 
@@ -81,6 +84,8 @@ private:
 	/* LS table allocation passed in from the pipeline handler. */
 	SharedFD lsTableHandle_;
 	void *lsTable_;
+
+	RPiController::StatisticsPool statsPool_;
 };
 
 int32_t IpaVc4::platformInit([[maybe_unused]] const InitParams &params, [[maybe_unused]] InitResult *result)
@@ -200,14 +205,12 @@ RPiController::StatisticsPtr IpaVc4::platformProcessStats(Span<uint8_t> mem)
 	using namespace RPiController;
 
 	const bcm2835_isp_stats *stats = reinterpret_cast<bcm2835_isp_stats *>(mem.data());
-	StatisticsPtr statistics = std::make_shared<Statistics>(Statistics::AgcStatsPos::PreWb,
-								Statistics::ColourStatsPos::PostLsc);
+	StatisticsPtr statistics = statsPool_.acquire();
 	const Controller::HardwareConfig &hw = controller_.getHardwareConfig();
 	unsigned int i;
 
 	/* RGB histograms are not used, so do not populate them. */
-	statistics->yHist = RPiController::Histogram(stats->hist[0].g_hist,
-						     hw.numHistogramBins);
+	statistics->yHist.assign(stats->hist[0].g_hist, hw.numHistogramBins);
 
 	/* All region sums are based on a 16-bit normalised pipeline bit-depth. */
 	unsigned int scale = Statistics::NormalisationFactorPow2 - hw.pipelineWidth;
@@ -370,15 +373,21 @@ void IpaVc4::applyGamma(const struct ContrastStatus *contrastStatus, ControlList
 {
 	const unsigned int numGammaPoints = controller_.getHardwareConfig().numGammaPoints;
 	struct bcm2835_isp_gamma gamma;
+	std::array<double, BCM2835_NUM_GAMMA_PTS> x, y;
 
 	for (unsigned int i = 0; i < numGammaPoints - 1; i++) {
-		int x = i < 16 ? i * 1024
-			       : (i < 24 ? (i - 16) * 2048 + 16384
-					 : (i - 24) * 4096 + 32768);
-		gamma.x[i] = x;
-		gamma.y[i] = std::min<uint16_t>(65535, contrastStatus->gammaCurve.eval(x));
+		x[i] = i < 16 ? i * 1024
+			      : (i < 24 ? (i - 16) * 2048 + 16384
+					: (i - 24) * 4096 + 32768);
+		gamma.x[i] = x[i];
 	}
 
+	contrastStatus->gammaCurve.eval({ x.data(), numGammaPoints - 1 },
+					{ y.data(), numGammaPoints - 1 });
+
+	for (unsigned int i = 0; i < numGammaPoints - 1; i++)
+		gamma.y[i] = std::min<uint16_t>(65535, y[i]);
+
 	gamma.x[numGammaPoints - 1] = 65535;
 	gamma.y[numGammaPoints - 1] = 65535;
 	gamma.enabled = 1;
@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * Exposure and gain control for the software ISP
+ */
+
+#include "agc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <libcamera/base/log.h>
+#include <libcamera/base/span.h>
+
+#include "libipa/histogram.h"
+
+namespace libcamera {
+
+LOG_DEFINE_CATEGORY(IPASoftAgc)
+
+namespace ipa::soft {
+
+/*
+ * Target brightness of the image, relative to the range between the black
+ * level and the white level. It places the mean sample value in the lower
+ * half of the range, leaving headroom for highlights.
+ */
+static constexpr double kTargetBrightness = 0.4;
+
+/*
+ * The exposure is left untouched when the brightness is within this relative
+ * tolerance of the target, to prevent the exposure from wobbling.
+ */
+static constexpr double kBrightnessTolerance = 0.08;
+
+/*
+ * Limits of the exposure change applied at once. The brightness of an image
+ * that is almost black or white doesn't tell by how much the exposure is off,
+ * the limits let the algorithm get out of these situations in a few steps.
+ */
+static constexpr double kMaxExposureFactor = 16.0;
+static constexpr double kSaturatedExposureFactor = 0.25;
+
+/* Fraction of saturated samples above which the brightness is unreliable */
+static constexpr double kSaturatedRatio = 0.5;
+
+/**
+ * \class Agc
+ * \brief Exposure and gain control for the software ISP
+ *
+ * The Agc class computes the exposure time and analogue gain from the
+ * luminance histogram. The sensor response is modelled as linear: the mean of
+ * the histogram, excluding outliers, scales with the product of the exposure
+ * time and gain. The total exposure that reaches the target brightness is
+ * thus computed in closed form from the current one, and split between the
+ * exposure time and gain, favouring the exposure time to minimise noise.
+ *
+ * As the estimate is exact for linear sensors, the exposure converges in one
+ * or two updates instead of the many small steps of a proportional
+ * controller. Only images saturated enough to hide the real brightness need
+ * additional steps.
+ */
+
+Agc::Agc()
+	: exposureMin_(1), exposureMax_(1), againMin_(1.0), againMax_(1.0)
+{
+}
+
+/**
+ * \brief Configure the exposure time and gain limits
+ * \param[in] exposureMin The minimum exposure time, in sensor lines
+ * \param[in] exposureMax The maximum exposure time, in sensor lines
+ * \param[in] againMin The minimum analogue gain
+ * \param[in] againMax The maximum analogue gain
+ */
+void Agc::configure(int32_t exposureMin, int32_t exposureMax,
+		    double againMin, double againMax)
+{
+	exposureMin_ = exposureMin;
+	exposureMax_ = exposureMax;
+	againMin_ = againMin;
+	againMax_ = againMax;
+}
+
+/**
+ * \brief Compute the brightness of an image
+ * \param[in] histogram The luminance histogram of the image
+ * \param[in] blackLevel The black level, in 8-bit sample values
+ *
+ * \return The mean luminance, excluding the darkest and brightest 2% of the
+ * samples, relative to the range between the black level and the white level
+ */
+double Agc::brightness(const SwIspStats::Histogram &histogram, uint8_t blackLevel)
+{
+	constexpr double kBinSize = 256.0 / SwIspStats::kYHistogramSize;
+
+	ipa::Histogram hist(Span<const uint32_t>(histogram.data(), histogram.size()));
+	if (!hist.total())
+		return 0.0;
+
+	double mean = hist.interQuantileMean(0.02, 0.98) * kBinSize;
+
+	return std::max(mean - blackLevel, 0.0) / (256.0 - blackLevel);
+}
+
+/**
+ * \brief Compute the exposure time and gain for the next frames
+ * \param[in] histogram The luminance histogram of the current frame
+ * \param[in] blackLevel The black level, in 8-bit sample values
+ * \param[inout] exposure The exposure time of the current frame, updated with
+ * the new exposure time, in sensor lines
+ * \param[inout] again The analogue gain of the current frame, updated with the
+ * new gain
+ *
+ * \return True if the exposure time or gain have been changed, false otherwise
+ */
+bool Agc::process(const SwIspStats::Histogram &histogram, uint8_t blackLevel,
+		  int32_t &exposure, double &again) const
+{
+	const double current = brightness(histogram, blackLevel);
+
+	double factor = current > 0.0 ? kTargetBrightness / current
+				       : kMaxExposureFactor;
+	if (std::abs(factor - 1.0) < kBrightnessTolerance)
+		return false;
+
+	factor = std::min(factor, kMaxExposureFactor);
+
+	const uint32_t total = std::accumulate(histogram.begin(), histogram.end(), 0U);
+	const uint32_t saturated = histogram[SwIspStats::kYHistogramSize - 1];
+	if (saturated > kSaturatedRatio * total)
+		factor = std::min(factor, kSaturatedExposureFactor);
+
+	const double target = exposure * std::max(again, againMin_) * factor;
+
+	/* Favour the exposure time over the gain. */
+	const int32_t nextExposure =
+		std::lround(std::clamp<double>(target / againMin_,
+					       exposureMin_, exposureMax_));
+	const double nextAgain = nextExposure < exposureMax_
+				 ? againMin_
+				 : std::clamp(target / nextExposure, againMin_, againMax_);
+
+	LOG(IPASoftAgc, Debug)
+		<< "Brightness " << current << ", exposure " << exposure
+		<< " -> " << nextExposure << ", gain " << again << " -> "
+		<< nextAgain;
+
+	if (nextExposure == exposure && nextAgain == again)
+		return false;
+
+	exposure = nextExposure;
+	again = nextAgain;
+
+	return true;
+}
+
+} /* namespace ipa::soft */
+
+} /* namespace libcamera */
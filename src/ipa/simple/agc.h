@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * Exposure and gain control for the software ISP
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "libcamera/internal/software_isp/swisp_stats.h"
+
+namespace libcamera {
+
+namespace ipa::soft {
+
+class Agc
+{
+public:
+	Agc();
+
+	void configure(int32_t exposureMin, int32_t exposureMax,
+		       double againMin, double againMax);
+	bool process(const SwIspStats::Histogram &histogram, uint8_t blackLevel,
+		     int32_t &exposure, double &again) const;
+
+	static double brightness(const SwIspStats::Histogram &histogram,
+				 uint8_t blackLevel);
+
+private:
+	int32_t exposureMin_;
+	int32_t exposureMax_;
+	double againMin_;
+	double againMax_;
+};
+
+} /* namespace ipa::soft */
+
+} /* namespace libcamera */
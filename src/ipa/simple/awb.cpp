@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * White balance for the software ISP
+ */
+
+#include "awb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <libcamera/base/log.h>
+
+namespace libcamera {
+
+LOG_DEFINE_CATEGORY(IPASoftAwb)
+
+namespace ipa::soft {
+
+/* Limits of the red and blue gains */
+static constexpr double kMinGain = 0.25;
+static constexpr double kMaxGain = 4.0;
+
+/*
+ * Zones darker than kMinZoneLevel above the black level are too noisy to
+ * estimate their colour, and zones with a colour brighter than kMaxZoneLevel
+ * may be clipped.
+ */
+static constexpr double kMinZoneLevel = 8.0;
+static constexpr double kMaxZoneLevel = 230.0;
+
+/*
+ * Maximum distance between the colour of a grey zone, once white balanced,
+ * and the neutral axis, in natural logarithm of the R/G and B/G ratios.
+ */
+static constexpr double kGreyThreshold = 0.15;
+
+/* Minimum number of grey zones to refine the grey world estimate */
+static constexpr unsigned int kMinGreyZones = 8;
+
+/* Number of grey zone selection passes */
+static constexpr unsigned int kGreyPasses = 2;
+
+/**
+ * \class Awb
+ * \brief White balance for the software ISP
+ *
+ * The Awb class computes the red and blue gains from the colour sums of the
+ * statistics grid. The gains are first estimated from the median colour of
+ * the zones that are neither too dark nor clipped. The estimate is then
+ * refined from the grey zones only, the zones whose colour is close to
+ * neutral once white balanced with the current estimate, averaged as in the
+ * grey world assumption. Coloured objects are thus excluded from the
+ * estimate instead of biasing it.
+ *
+ * The gains are computed from a single frame, and are applied by the
+ * debayering of the next frame, without smoothing.
+ */
+
+Awb::Awb()
+	: gainR_(1.0), gainB_(1.0)
+{
+}
+
+/**
+ * \brief Compute the white balance gains from the statistics of a frame
+ * \param[in] stats The statistics of the frame
+ * \param[in] blackLevel The black level, in 8-bit sample values
+ */
+void Awb::process(const SwIspStats &stats, uint8_t blackLevel)
+{
+	struct Zone {
+		double r;
+		double g;
+		double b;
+	};
+
+	std::vector<Zone> zones;
+	zones.reserve(stats.awbGrid.size());
+
+	/* The statistics sums are not scaled to 8-bit sample values. */
+	if (!stats.sampleDivisor) {
+		LOG(IPASoftAwb, Error) << "Invalid statistics sample divisor";
+		return;
+	}
+
+	const double divisor = stats.sampleDivisor;
+
+	for (const SwIspStats::AwbZone &zone : stats.awbGrid) {
+		if (!zone.count)
+			continue;
+
+		const double count = zone.count * divisor;
+		const double r = zone.sumR / count - blackLevel;
+		const double g = zone.sumG / count - blackLevel;
+		const double b = zone.sumB / count - blackLevel;
+
+		if (r <= 0.0 || b <= 0.0 || g < kMinZoneLevel ||
+		    std::max({ r, g, b }) + blackLevel > kMaxZoneLevel)
+			continue;
+
+		zones.push_back({ r, g, b });
+	}
+
+	double gainR;
+	double gainB;
+
+	if (zones.empty()) {
+		/*
+		 * Fall back to the whole frame sums. Black level must be
+		 * subtracted to get the correct ratios, they would be off if
+		 * they were computed from the whole brightness range rather
+		 * than from the sensor range.
+		 */
+		const uint64_t nPixels = std::accumulate(stats.yHistogram.begin(),
+							 stats.yHistogram.end(), 0ULL);
+		const uint64_t offset = blackLevel * nPixels;
+		const double sumR = stats.sumR_ / divisor - offset / 4.0;
+		const double sumG = stats.sumG_ / divisor - offset / 2.0;
+		const double sumB = stats.sumB_ / divisor - offset / 4.0;
+
+		gainR = sumR > 0.0 ? sumG / sumR : kMaxGain;
+		gainB = sumB > 0.0 ? sumG / sumB : kMaxGain;
+	} else {
+		/*
+		 * Start with the median of the zone colours, which, unlike the
+		 * grey world estimate, isn't biased by coloured objects that
+		 * cover less than half of the image.
+		 */
+		auto median = [&](auto &&ratio) {
+			std::vector<double> values;
+			values.reserve(zones.size());
+			for (const Zone &zone : zones)
+				values.push_back(ratio(zone));
+
+			auto middle = values.begin() + values.size() / 2;
+			std::nth_element(values.begin(), middle, values.end());
+			return *middle;
+		};
+
+		gainR = median([](const Zone &zone) { return zone.g / zone.r; });
+		gainB = median([](const Zone &zone) { return zone.g / zone.b; });
+
+		unsigned int count = 0;
+
+		for (unsigned int pass = 0; pass < kGreyPasses; ++pass) {
+			Zone sum{ 0.0, 0.0, 0.0 };
+			count = 0;
+
+			for (const Zone &zone : zones) {
+				if (std::abs(std::log(zone.r * gainR / zone.g)) >= kGreyThreshold ||
+				    std::abs(std::log(zone.b * gainB / zone.g)) >= kGreyThreshold)
+					continue;
+
+				sum.r += zone.r;
+				sum.g += zone.g;
+				sum.b += zone.b;
+				count++;
+			}
+
+			if (count < kMinGreyZones)
+				break;
+
+			gainR = sum.g / sum.r;
+			gainB = sum.g / sum.b;
+		}
+
+		LOG(IPASoftAwb, Debug)
+			<< zones.size() << " valid zones, " << count << " grey zones";
+	}
+
+	gainR_ = std::clamp(gainR, kMinGain, kMaxGain);
+	gainB_ = std::clamp(gainB, kMinGain, kMaxGain);
+}
+
+} /* namespace ipa::soft */
+
+} /* namespace libcamera */
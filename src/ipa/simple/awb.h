@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * White balance for the software ISP
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "libcamera/internal/software_isp/swisp_stats.h"
+
+namespace libcamera {
+
+namespace ipa::soft {
+
+class Awb
+{
+public:
+	Awb();
+
+	void process(const SwIspStats &stats, uint8_t blackLevel);
+
+	double gainR() const { return gainR_; }
+	double gainB() const { return gainB_; }
+
+private:
+	double gainR_;
+	double gainB_;
+};
+
+} /* namespace ipa::soft */
+
+} /* namespace libcamera */
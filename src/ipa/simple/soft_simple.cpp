@@ -6,9 +6,9 @@
  */
 
 #include <cmath>
-#include <numeric>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <vector>
 
 #include <linux/v4l2-controls.h>
 
@@ -29,6 +29,8 @@
 
 #include "libipa/camera_sensor_helper.h"
 
+#include "agc.h"
+#include "awb.h"
 #include "black_level.h"
 
 namespace libcamera {
@@ -37,22 +39,10 @@ LOG_DEFINE_CATEGORY(IPASoft)
 namespace ipa::soft {
 
 /*
- * The number of bins to use for the optimal exposure calculations.
+ * The denoise and temporal filters reach their maximum strength, and the
+ * sharpening filter is disabled, at 24dB of analogue gain.
  */
-static constexpr unsigned int kExposureBinsCount = 5;
-
-/*
- * The exposure is optimal when the mean sample value of the histogram is
- * in the middle of the range.
- */
-static constexpr float kExposureOptimal = kExposureBinsCount / 2.0;
-
-/*
- * The below value implements the hysteresis for the exposure adjustment.
- * It is small enough to have the exposure close to the optimal, and is big
- * enough to prevent the exposure from wobbling around the optimal value.
- */
-static constexpr float kExposureSatisfactory = 0.2;
+static constexpr double kNoiseReductionMaxGainStops = 4.0;
 
 class IPASoftSimple : public ipa::soft::IPASoftInterface
 {
@@ -77,21 +67,26 @@ public:
 	void processStats(const ControlList &sensorControls) override;
 
 private:
-	void updateExposure(double exposureMSV);
+	void updateNoiseReduction();
 
 	DebayerParams *params_;
 	SwIspStats *stats_;
 	std::unique_ptr<CameraSensorHelper> camHelper_;
 	ControlInfoMap sensorInfoMap_;
 	BlackLevel blackLevel_;
+	Agc agc_;
+	Awb awb_;
 
-	static constexpr unsigned int kGammaLookupSize = 1024;
-	std::array<uint8_t, kGammaLookupSize> gammaTable_;
-	int lastBlackLevel_ = -1;
+	/* Noise reduction and sharpening strengths from the tuning file */
+	uint8_t denoiseMax_;
+	uint8_t sharpenMax_;
+	uint8_t temporalMax_;
+	uint8_t noiseLevelMin_;
+	uint8_t noiseLevelMax_;
 
 	int32_t exposureMin_, exposureMax_;
 	int32_t exposure_;
-	double againMin_, againMax_, againMinStep_;
+	double againMin_, againMax_;
 	double again_;
 	unsigned int ignoreUpdates_;
 };
@@ -134,6 +129,31 @@ int IPASoftSimple::init(const IPASettings &settings,
 	unsigned int version = (*data)["version"].get<uint32_t>(0);
 	LOG(IPASoft, Debug) << "Tuning file version " << version;
 
+	/*
+	 * Noise reduction and sharpening are optional, and disabled unless
+	 * the tuning file specifies their strengths:
+	 *
+	 * noiseReduction:
+	 *   denoise: 160      # Detail attenuation at high gain, in 1/256
+	 *   sharpen: 64       # Detail amplification at low gain, in 1/256
+	 *   temporal: 128     # Previous frame weight at high gain, in 1/256
+	 *   noiseLevel: [ 2, 8 ]  # Noise amplitude at low and high gain
+	 */
+	const YamlObject &noiseReduction = (*data)["noiseReduction"];
+	denoiseMax_ = noiseReduction["denoise"].get<uint8_t>(0);
+	sharpenMax_ = noiseReduction["sharpen"].get<uint8_t>(0);
+	temporalMax_ = noiseReduction["temporal"].get<uint8_t>(0);
+
+	std::vector<uint8_t> noiseLevel =
+		noiseReduction["noiseLevel"].getList<uint8_t>().value_or(std::vector<uint8_t>{});
+	if (noiseLevel.size() == 2) {
+		noiseLevelMin_ = noiseLevel[0];
+		noiseLevelMax_ = noiseLevel[1];
+	} else {
+		noiseLevelMin_ = 2;
+		noiseLevelMax_ = 8;
+	}
+
 	params_ = nullptr;
 	stats_ = nullptr;
 
@@ -208,7 +228,6 @@ int IPASoftSimple::configure(const ControlInfoMap &sensorInfoMap)
 	if (camHelper_) {
 		againMin_ = camHelper_->gain(againMin);
 		againMax_ = camHelper_->gain(againMax);
-		againMinStep_ = (againMax_ - againMin_) / 100.0;
 	} else {
 		/*
 		 * The camera sensor gain (g) is usually not equal to the value written
@@ -220,18 +239,20 @@ int IPASoftSimple::configure(const ControlInfoMap &sensorInfoMap)
 		 * the AGC algorithm (abrupt near one edge, and very small near the
 		 * other) we limit the range of the gain values used.
 		 */
+		againMin_ = againMin;
 		againMax_ = againMax;
 		if (!againMin) {
 			LOG(IPASoft, Warning)
 				<< "Minimum gain is zero, that can't be linear";
 			againMin_ = std::min(100, againMin / 2 + againMax / 2);
 		}
-		againMinStep_ = 1.0;
 	}
 
+	again_ = againMin_;
+	agc_.configure(exposureMin_, exposureMax_, againMin_, againMax_);
+
 	LOG(IPASoft, Info) << "Exposure " << exposureMin_ << "-" << exposureMax_
-			   << ", gain " << againMin_ << "-" << againMax_
-			   << " (" << againMinStep_ << ")";
+			   << ", gain " << againMin_ << "-" << againMax_;
 
 	return 0;
 }
@@ -252,56 +273,33 @@ void IPASoftSimple::processStats(const ControlList &sensorControls)
 		blackLevel_.update(histogram);
 	const uint8_t blackLevel = blackLevel_.get();
 
-	/*
-	 * Black level must be subtracted to get the correct AWB ratios, they
-	 * would be off if they were computed from the whole brightness range
-	 * rather than from the sensor range.
-	 */
-	const uint64_t nPixels = std::accumulate(
-		histogram.begin(), histogram.end(), 0);
-	const uint64_t offset = blackLevel * nPixels;
-	const uint64_t sumR = stats_->sumR_ - offset / 4;
-	const uint64_t sumG = stats_->sumG_ - offset / 2;
-	const uint64_t sumB = stats_->sumB_ - offset / 4;
+	/* Retrieve the exposure and gain applied to the current frame. */
+	const bool sensorControlsValid =
+		sensorControls.contains(V4L2_CID_EXPOSURE) &&
+		sensorControls.contains(V4L2_CID_ANALOGUE_GAIN);
+	if (sensorControlsValid) {
+		exposure_ = sensorControls.get(V4L2_CID_EXPOSURE).get<int32_t>();
+		int32_t again = sensorControls.get(V4L2_CID_ANALOGUE_GAIN).get<int32_t>();
+		again_ = camHelper_ ? camHelper_->gain(again) : again;
+	}
 
 	/*
-	 * Calculate red and blue gains for AWB.
-	 * Clamp max gain at 4.0, this also avoids 0 division.
-	 * Gain: 128 = 0.5, 256 = 1.0, 512 = 2.0, etc.
+	 * Calculate red and blue gains for AWB. The debayering lookup tables
+	 * are built from the black level, the gains and the gamma value, and
+	 * are only rebuilt when those change.
 	 */
-	const unsigned int gainR = sumR <= sumG / 4 ? 1024 : 256 * sumG / sumR;
-	const unsigned int gainB = sumB <= sumG / 4 ? 1024 : 256 * sumG / sumB;
-	/* Green gain and gamma values are fixed */
-	constexpr unsigned int gainG = 256;
-
-	/* Update the gamma table if needed */
-	if (blackLevel != lastBlackLevel_) {
-		constexpr float gamma = 0.5;
-		const unsigned int blackIndex = blackLevel * kGammaLookupSize / 256;
-		std::fill(gammaTable_.begin(), gammaTable_.begin() + blackIndex, 0);
-		const float divisor = kGammaLookupSize - blackIndex - 1.0;
-		for (unsigned int i = blackIndex; i < kGammaLookupSize; i++)
-			gammaTable_[i] = UINT8_MAX *
-					 std::pow((i - blackIndex) / divisor, gamma);
-
-		lastBlackLevel_ = blackLevel;
-	}
-
-	for (unsigned int i = 0; i < DebayerParams::kRGBLookupSize; i++) {
-		constexpr unsigned int div =
-			DebayerParams::kRGBLookupSize * 256 / kGammaLookupSize;
-		unsigned int idx;
+	awb_.process(*stats_, blackLevel);
+	const unsigned int gainR = std::lround(awb_.gainR() * DebayerParams::kGainOne);
+	const unsigned int gainB = std::lround(awb_.gainB() * DebayerParams::kGainOne);
 
-		/* Apply gamma after gain! */
-		idx = std::min({ i * gainR / div, (kGammaLookupSize - 1) });
-		params_->red[i] = gammaTable_[idx];
-
-		idx = std::min({ i * gainG / div, (kGammaLookupSize - 1) });
-		params_->green[i] = gammaTable_[idx];
+	params_->blackLevel = blackLevel << 8;
+	params_->gainR = gainR;
+	params_->gainB = gainB;
+	/* Green gain and gamma values are fixed */
+	params_->gainG = DebayerParams::kGainOne;
+	params_->gamma = 0.5f;
 
-		idx = std::min({ i * gainB / div, (kGammaLookupSize - 1) });
-		params_->blue[i] = gammaTable_[idx];
-	}
+	updateNoiseReduction();
 
 	setIspParams.emit();
 
@@ -317,46 +315,13 @@ void IPASoftSimple::processStats(const ControlList &sensorControls)
 		return;
 	}
 
-	/*
-	 * Calculate Mean Sample Value (MSV) according to formula from:
-	 * https://www.araa.asn.au/acra/acra2007/papers/paper84final.pdf
-	 */
-	const unsigned int blackLevelHistIdx =
-		blackLevel / (256 / SwIspStats::kYHistogramSize);
-	const unsigned int histogramSize =
-		SwIspStats::kYHistogramSize - blackLevelHistIdx;
-	const unsigned int yHistValsPerBin = histogramSize / kExposureBinsCount;
-	const unsigned int yHistValsPerBinMod =
-		histogramSize / (histogramSize % kExposureBinsCount + 1);
-	int exposureBins[kExposureBinsCount] = {};
-	unsigned int denom = 0;
-	unsigned int num = 0;
-
-	for (unsigned int i = 0; i < histogramSize; i++) {
-		unsigned int idx = (i - (i / yHistValsPerBinMod)) / yHistValsPerBin;
-		exposureBins[idx] += stats_->yHistogram[blackLevelHistIdx + i];
-	}
-
-	for (unsigned int i = 0; i < kExposureBinsCount; i++) {
-		LOG(IPASoft, Debug) << i << ": " << exposureBins[i];
-		denom += exposureBins[i];
-		num += exposureBins[i] * (i + 1);
-	}
-
-	float exposureMSV = static_cast<float>(num) / denom;
-
 	/* Sanity check */
-	if (!sensorControls.contains(V4L2_CID_EXPOSURE) ||
-	    !sensorControls.contains(V4L2_CID_ANALOGUE_GAIN)) {
+	if (!sensorControlsValid) {
 		LOG(IPASoft, Error) << "Control(s) missing";
 		return;
 	}
 
-	exposure_ = sensorControls.get(V4L2_CID_EXPOSURE).get<int32_t>();
-	int32_t again = sensorControls.get(V4L2_CID_ANALOGUE_GAIN).get<int32_t>();
-	again_ = camHelper_ ? camHelper_->gain(again) : again;
-
-	updateExposure(exposureMSV);
+	agc_.process(histogram, blackLevel, exposure_, again_);
 
 	ControlList ctrls(sensorInfoMap_);
 
@@ -368,57 +333,33 @@ void IPASoftSimple::processStats(const ControlList &sensorControls)
 
 	setSensorControls.emit(ctrls);
 
-	LOG(IPASoft, Debug) << "exposureMSV " << exposureMSV
-			    << " exp " << exposure_ << " again " << again_
+	LOG(IPASoft, Debug) << "exp " << exposure_ << " again " << again_
 			    << " gain R/B " << gainR << "/" << gainB
 			    << " black level " << static_cast<unsigned int>(blackLevel);
 }
 
-void IPASoftSimple::updateExposure(double exposureMSV)
+void IPASoftSimple::updateNoiseReduction()
 {
 	/*
-	 * kExpDenominator of 10 gives ~10% increment/decrement;
-	 * kExpDenominator of 5 - about ~20%
+	 * Scale the filter strengths with the analogue gain applied for the
+	 * current frame, in stops above the minimum gain when the gain model of
+	 * the sensor is known, or linearly over the gain range otherwise.
 	 */
-	static constexpr uint8_t kExpDenominator = 10;
-	static constexpr uint8_t kExpNumeratorUp = kExpDenominator + 1;
-	static constexpr uint8_t kExpNumeratorDown = kExpDenominator - 1;
-
-	double next;
-
-	if (exposureMSV < kExposureOptimal - kExposureSatisfactory) {
-		next = exposure_ * kExpNumeratorUp / kExpDenominator;
-		if (next - exposure_ < 1)
-			exposure_ += 1;
-		else
-			exposure_ = next;
-		if (exposure_ >= exposureMax_) {
-			next = again_ * kExpNumeratorUp / kExpDenominator;
-			if (next - again_ < againMinStep_)
-				again_ += againMinStep_;
-			else
-				again_ = next;
-		}
-	}
-
-	if (exposureMSV > kExposureOptimal + kExposureSatisfactory) {
-		if (exposure_ == exposureMax_ && again_ > againMin_) {
-			next = again_ * kExpNumeratorDown / kExpDenominator;
-			if (again_ - next < againMinStep_)
-				again_ -= againMinStep_;
-			else
-				again_ = next;
-		} else {
-			next = exposure_ * kExpNumeratorDown / kExpDenominator;
-			if (exposure_ - next < 1)
-				exposure_ -= 1;
-			else
-				exposure_ = next;
-		}
-	}
-
-	exposure_ = std::clamp(exposure_, exposureMin_, exposureMax_);
-	again_ = std::clamp(again_, againMin_, againMax_);
+	double level;
+	if (camHelper_)
+		level = std::log2(again_ / againMin_) / kNoiseReductionMaxGainStops;
+	else if (againMax_ > againMin_)
+		level = (again_ - againMin_) / (againMax_ - againMin_);
+	else
+		level = 0.0;
+
+	level = std::clamp(level, 0.0, 1.0);
+
+	params_->denoise = std::lround(denoiseMax_ * level);
+	params_->sharpen = std::lround(sharpenMax_ * (1.0 - level));
+	params_->temporal = std::lround(temporalMax_ * level);
+	params_->noiseLevel = std::lround(noiseLevelMin_ +
+					  (noiseLevelMax_ - noiseLevelMin_) * level);
 }
 
 } /* namespace ipa::soft */
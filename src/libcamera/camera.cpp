@@ -7,14 +7,17 @@
 
 #include <libcamera/camera.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <iomanip>
 
 #include <libcamera/base/log.h>
 #include <libcamera/base/thread.h>
+#include <libcamera/base/utils.h>
 
 #include <libcamera/color_space.h>
+#include <libcamera/framebuffer.h>
 #include <libcamera/framebuffer_allocator.h>
 #include <libcamera/request.h>
 #include <libcamera/stream.h>
@@ -577,7 +580,8 @@ CameraConfiguration::Status CameraConfiguration::validateColorSpaces(ColorSpaceF
  */
 Camera::Private::Private(PipelineHandler *pipe)
 	: requestSequence_(0), pipe_(pipe->shared_from_this()),
-	  disconnected_(false), state_(CameraAvailable)
+	  disconnected_(false), state_(CameraAvailable), memoryBudget_(0),
+	  batchMaxRequests_(0), batchMaxLatency_(0)
 {
 }
 
@@ -642,6 +646,167 @@ Camera::Private::~Private()
  * over a single capture session.
  */
 
+/**
+ * \brief Record a memory allocation made for the camera
+ * \param[in] purpose The purpose of the allocation
+ * \param[in] type The type of memory
+ * \param[in] size The size of the allocation in bytes
+ *
+ * Pipeline handlers shall call this function for all memory they allocate for
+ * the camera, and call removeMemory() with the same parameters when the memory
+ * is freed.
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::Private::addMemory(MemoryUsage::Purpose purpose,
+				MemoryUsage::Type type, std::size_t size)
+{
+	MutexLocker locker(memoryLock_);
+	memoryUsage_.add(purpose, type, size);
+}
+
+/**
+ * \brief Record the release of a memory allocation made for the camera
+ * \param[in] purpose The purpose of the allocation
+ * \param[in] type The type of memory
+ * \param[in] size The size of the allocation in bytes
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::Private::removeMemory(MemoryUsage::Purpose purpose,
+				   MemoryUsage::Type type, std::size_t size)
+{
+	MutexLocker locker(memoryLock_);
+	memoryUsage_.remove(purpose, type, size);
+}
+
+namespace {
+
+std::size_t bufferSize(const FrameBuffer *buffer)
+{
+	std::size_t size = 0;
+
+	for (const FrameBuffer::Plane &plane : buffer->planes())
+		size += plane.length;
+
+	return size;
+}
+
+std::size_t buffersSize(const std::vector<std::unique_ptr<FrameBuffer>> &buffers)
+{
+	std::size_t size = 0;
+
+	for (const std::unique_ptr<FrameBuffer> &buffer : buffers)
+		size += bufferSize(buffer.get());
+
+	return size;
+}
+
+} /* namespace */
+
+/**
+ * \brief Record the allocation of a dmabuf-backed frame buffer
+ * \param[in] purpose The purpose of the buffer
+ * \param[in] buffer The frame buffer
+ *
+ * This helper function is a single buffer version of addBuffers(), for
+ * pipeline handlers that allocate internal buffers on demand.
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::Private::addBuffer(MemoryUsage::Purpose purpose, const FrameBuffer *buffer)
+{
+	addMemory(purpose, MemoryUsage::Type::DmaBuf, bufferSize(buffer));
+}
+
+/**
+ * \brief Record the allocation of dmabuf-backed frame buffers
+ * \param[in] purpose The purpose of the buffers
+ * \param[in] buffers The frame buffers
+ *
+ * This helper function records a MemoryUsage::Type::DmaBuf allocation whose
+ * size is the total length of all planes of all \a buffers.
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::Private::addBuffers(MemoryUsage::Purpose purpose,
+				 const std::vector<std::unique_ptr<FrameBuffer>> &buffers)
+{
+	addMemory(purpose, MemoryUsage::Type::DmaBuf, buffersSize(buffers));
+}
+
+/**
+ * \brief Record the release of dmabuf-backed frame buffers
+ * \param[in] purpose The purpose of the buffers
+ * \param[in] buffers The frame buffers
+ *
+ * This function is the counterpart of addBuffers(). It shall be called before
+ * the \a buffers are destroyed.
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::Private::removeBuffers(MemoryUsage::Purpose purpose,
+				    const std::vector<std::unique_ptr<FrameBuffer>> &buffers)
+{
+	removeMemory(purpose, MemoryUsage::Type::DmaBuf, buffersSize(buffers));
+}
+
+/**
+ * \brief Compute the number of internal buffers that fit in the memory budget
+ * \param[in] count The number of buffers the pipeline handler would like to
+ * allocate
+ * \param[in] minCount The minimum number of buffers the pipeline handler can
+ * operate with
+ * \param[in] bufferSize The size of a single buffer in bytes
+ *
+ * Pipeline handlers that allocate internal buffers shall call this function to
+ * scale down the number of buffers they allocate when the memory budget set by
+ * the application with Camera::setMemoryBudget() would otherwise be exceeded.
+ * The returned value is the largest number of buffers, between \a minCount and
+ * \a count, that can be allocated on top of the memory currently in use
+ * without exceeding the budget.
+ *
+ * If even \a minCount buffers exceed the budget, a warning is logged and
+ * \a minCount is returned, as the camera can't operate with less buffers.
+ *
+ * \context This function is \threadsafe.
+ *
+ * \return The number of buffers to allocate
+ */
+unsigned int Camera::Private::budgetBufferCount(unsigned int count,
+						unsigned int minCount,
+						std::size_t bufferSize) const
+{
+	std::size_t budget = memoryBudget_.load(std::memory_order_relaxed);
+	if (!budget || !bufferSize || count <= minCount)
+		return count;
+
+	std::size_t used;
+	{
+		MutexLocker locker(memoryLock_);
+		used = memoryUsage_.total();
+	}
+
+	std::size_t available = budget > used ? budget - used : 0;
+	unsigned int fit = std::min<std::size_t>(available / bufferSize, count);
+	if (fit == count)
+		return count;
+
+	if (fit < minCount) {
+		LOG(Camera, Warning)
+			<< "Memory budget of " << budget << " bytes exceeded, "
+			<< "allocating " << minCount << " buffers of "
+			<< bufferSize << " bytes";
+		return minCount;
+	}
+
+	LOG(Camera, Info)
+		<< "Reducing internal buffers from " << count << " to " << fit
+		<< " to fit memory budget of " << budget << " bytes";
+
+	return fit;
+}
+
 static const char *const camera_state_names[] = {
 	"Available",
 	"Acquired",
@@ -720,6 +885,22 @@ void Camera::Private::setState(State state)
 	state_.store(state, std::memory_order_release);
 }
 
+/**
+ * \brief Deliver the current batch of completed requests to the application
+ */
+void Camera::Private::flushCompletedRequests()
+{
+	if (batchTimer_)
+		batchTimer_->stop();
+
+	if (completedRequests_.empty())
+		return;
+
+	Camera *camera = _o<Camera>();
+	camera->requestsCompleted.emit(completedRequests_);
+	completedRequests_.clear();
+}
+
 /**
  * \class Camera
  * \brief Camera device
@@ -781,7 +962,7 @@ void Camera::Private::setState(State state)
  *
  *   Running -> Stopping [label = "stop()"];
  *   Stopping -> Configured;
- *   Running -> Running [label = "createRequest(), queueRequest()"];
+ *   Running -> Running [label = "createRequest(), queueRequest(),\nswitchConfiguration()"];
  * }
  * \enddot
  *
@@ -883,6 +1064,22 @@ const std::string &Camera::id() const
 /**
  * \var Camera::requestCompleted
  * \brief Signal emitted when a request queued to the camera has completed
+ *
+ * This signal is not emitted when completion batching is enabled with
+ * setCompletionBatching(), completed requests are then reported through the
+ * requestsCompleted signal.
+ */
+
+/**
+ * \var Camera::requestsCompleted
+ * \brief Signal emitted when a batch of requests queued to the camera has
+ * completed
+ *
+ * This signal is emitted in place of requestCompleted when completion batching
+ * is enabled with setCompletionBatching(). The requests are reported in
+ * completion order. The vector passed to the signal is only valid for the
+ * duration of the signal emission, slots that need to access it later shall
+ * copy it.
  */
 
 /**
@@ -1187,6 +1384,28 @@ int Camera::configure(CameraConfiguration *config)
 	if (ret)
 		return ret;
 
+	ret = applyConfiguration(config);
+	if (ret)
+		return ret;
+
+	d->setState(Private::CameraConfigured);
+
+	return 0;
+}
+
+/**
+ * \brief Record the configuration applied by the pipeline handler
+ * \param[in] config The camera configuration
+ *
+ * Update the active streams and their configuration after the pipeline
+ * handler has configured the device with \a config.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int Camera::applyConfiguration(CameraConfiguration *config)
+{
+	Private *const d = _d();
+
 	d->activeStreams_.clear();
 	for (const StreamConfiguration &cfg : *config) {
 		Stream *stream = cfg.stream();
@@ -1201,8 +1420,6 @@ int Camera::configure(CameraConfiguration *config)
 		d->activeStreams_.insert(stream);
 	}
 
-	d->setState(Private::CameraConfigured);
-
 	return 0;
 }
 
@@ -1349,6 +1566,8 @@ int Camera::start(const ControlList *controls)
 
 	d->setState(Private::CameraRunning);
 
+	LOG(Camera, Debug) << "Memory usage: " << memoryUsage();
+
 	return 0;
 }
 
@@ -1357,6 +1576,8 @@ int Camera::start(const ControlList *controls)
  *
  * This function stops capturing and processing requests immediately. All
  * pending requests are cancelled and complete synchronously in an error state.
+ * When completion batching is enabled, the requests of a partly filled batch
+ * are delivered before this function returns.
  *
  * \context This function may be called in any camera state as defined in \ref
  * camera_operation, and shall be synchronized by the caller with other
@@ -1391,8 +1612,198 @@ int Camera::stop()
 
 	ASSERT(!d->pipe_->hasPendingRequests(this));
 
+	invokeMethod(&Camera::flushCompletedRequests, ConnectionTypeBlocking);
+
+	d->setState(Private::CameraConfigured);
+
+	return 0;
+}
+
+/**
+ * \brief Switch a running camera to a new configuration
+ * \param[in] config The camera configuration to switch to
+ *
+ * Switching between configurations with stop(), configure() and start() frees
+ * and reallocates the internal pipeline buffers and reconfigures the whole
+ * device, which can take a significant amount of time. This function switches
+ * a running camera to a new configuration, letting the pipeline handler keep
+ * the resources that the new configuration can reuse. The latency of the
+ * switch depends on the pipeline handler, but is never higher than stopping,
+ * configuring and restarting the camera.
+ *
+ * Applications that switch repeatedly between a fixed set of configurations,
+ * such as preview and still capture, should generate and validate all the
+ * configurations upfront and keep them around. The \a config shall be valid,
+ * this function returns an error if validate() would adjust it.
+ *
+ * All requests pending when this function is called are cancelled and
+ * complete before the function returns, as with stop(). The camera then
+ * resumes capture with the new configuration and requests can be queued
+ * immediately. Request sequence numbers restart from zero. Buffers allocated
+ * for the streams of the previous configuration can be reused with the new
+ * configuration if they are large enough. Applications should thus allocate
+ * buffers for the largest configuration they switch to.
+ *
+ * If the switch fails, the camera is stopped. If the new configuration could
+ * be applied, the camera is left in the Configured state and can be started
+ * again. Otherwise it is left in the Acquired state and shall be configured
+ * with configure().
+ *
+ * \context This function may only be called when the camera is running, and
+ * affects the state of the camera, see \ref camera_operation.
+ *
+ * \return 0 on success or a negative error code otherwise
+ * \retval -ENODEV The camera has been disconnected from the system
+ * \retval -EACCES The camera is not running
+ * \retval -EINVAL The configuration is not valid
+ */
+int Camera::switchConfiguration(CameraConfiguration *config)
+{
+	Private *const d = _d();
+
+	int ret = d->isAccessAllowed(Private::CameraRunning);
+	if (ret < 0)
+		return ret;
+
+	for (StreamConfiguration &cfg : *config)
+		cfg.setStream(nullptr);
+
+	if (config->validate() != CameraConfiguration::Valid) {
+		LOG(Camera, Error)
+			<< "Can't switch to an invalid configuration";
+		return -EINVAL;
+	}
+
+	LOG(Camera, Debug) << "Switching configuration";
+
+	d->setState(Private::CameraStopping);
+
+	ret = d->pipe_->invokeMethod(&PipelineHandler::reconfigure,
+				     ConnectionTypeBlocking, this, config);
+
+	ASSERT(!d->pipe_->hasPendingRequests(this));
+
+	invokeMethod(&Camera::flushCompletedRequests, ConnectionTypeBlocking);
+
+	if (!ret)
+		ret = applyConfiguration(config);
+	if (ret) {
+		d->activeStreams_.clear();
+		d->setState(Private::CameraAcquired);
+		return ret;
+	}
+
 	d->setState(Private::CameraConfigured);
 
+	ret = d->pipe_->invokeMethod(&PipelineHandler::start,
+				     ConnectionTypeBlocking, this, nullptr);
+	if (ret)
+		return ret;
+
+	d->setState(Private::CameraRunning);
+
+	return 0;
+}
+
+/**
+ * \brief Retrieve the memory currently allocated for the camera
+ *
+ * This function reports the memory allocated by libcamera for the camera,
+ * including the frame buffers allocated for the application with a
+ * FrameBufferAllocator and the internal buffers allocated by the pipeline
+ * handler. Internal buffers are typically allocated when the camera is
+ * configured or started, and freed when it is stopped or released.
+ *
+ * \context This function is \threadsafe.
+ *
+ * \return The memory usage of the camera
+ */
+MemoryUsage Camera::memoryUsage() const
+{
+	const Private *const d = _d();
+
+	MutexLocker locker(d->memoryLock_);
+	return d->memoryUsage_;
+}
+
+/**
+ * \brief Set the memory budget for the camera
+ * \param[in] budget The memory budget in bytes, or 0 to disable the budget
+ *
+ * The memory budget is an upper bound for the memory usage of the camera, as
+ * reported by memoryUsage(). When allocating internal buffers, pipeline
+ * handlers reduce the number of buffers they allocate, down to the minimum
+ * they require to operate, to keep the memory usage within the budget. This
+ * may increase the risk of frame drops. The budget is a soft limit, it never
+ * causes memory allocations to fail.
+ *
+ * The budget applies to internal buffers allocated after this function is
+ * called, and thus should be set before starting the camera.
+ *
+ * \context This function is \threadsafe.
+ */
+void Camera::setMemoryBudget(std::size_t budget)
+{
+	_d()->memoryBudget_.store(budget, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Retrieve the memory budget for the camera
+ * \context This function is \threadsafe.
+ * \return The memory budget in bytes, or 0 if no budget is set
+ * \sa setMemoryBudget()
+ */
+std::size_t Camera::memoryBudget() const
+{
+	return _d()->memoryBudget_.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Deliver completed requests to the application in batches
+ * \param[in] maxRequests The maximum number of requests in a batch
+ * \param[in] maxLatency The maximum time a completed request can be delayed
+ *
+ * Applications that run cameras at high frame rates, or many cameras
+ * concurrently, can spend a significant amount of CPU time waking up to handle
+ * each completed request individually. This function enables an opt-in mode
+ * where completed requests are accumulated and reported together through the
+ * requestsCompleted signal, instead of individually through the
+ * requestCompleted signal.
+ *
+ * A batch is delivered as soon as it contains \a maxRequests requests, or
+ * when the first request of the batch has been waiting for \a maxLatency,
+ * whichever comes first. Requests completed while the camera is stopping are
+ * delivered immediately.
+ *
+ * Setting \a maxRequests to 0 or 1 disables batching, which is the default.
+ *
+ * This function shall be called when the camera is not running.
+ *
+ * \context This function affects the state of the camera, see \ref
+ * camera_operation.
+ *
+ * \return 0 on success or a negative error code otherwise
+ * \retval -ENODEV The camera has been disconnected from the system
+ * \retval -EACCES The camera is not in a state where batching can be configured
+ * \retval -EINVAL The \a maxLatency is not positive
+ */
+int Camera::setCompletionBatching(unsigned int maxRequests,
+				  std::chrono::microseconds maxLatency)
+{
+	Private *const d = _d();
+
+	int ret = d->isAccessAllowed(Private::CameraAcquired,
+				     Private::CameraConfigured);
+	if (ret < 0)
+		return ret;
+
+	if (maxRequests > 1 && maxLatency <= std::chrono::microseconds(0))
+		return -EINVAL;
+
+	d->batchMaxRequests_ = maxRequests > 1 ? maxRequests : 0;
+	d->batchMaxLatency_ = maxLatency;
+	d->completedRequests_.reserve(d->batchMaxRequests_);
+
 	return 0;
 }
 
@@ -1401,16 +1812,58 @@ int Camera::stop()
  * \param[in] request The request that has completed
  *
  * This function is called by the pipeline handler to notify the camera that
- * the request has completed. It emits the requestCompleted signal.
+ * the request has completed. It emits the requestCompleted signal, or adds the
+ * request to the current batch if completion batching is enabled.
  */
 void Camera::requestComplete(Request *request)
 {
+	Private *const d = _d();
+
 	/* Disconnected cameras are still able to complete requests. */
-	if (_d()->isAccessAllowed(Private::CameraStopping, Private::CameraRunning,
-				  true))
+	if (d->isAccessAllowed(Private::CameraStopping, Private::CameraRunning,
+			       true))
 		LOG(Camera, Fatal) << "Trying to complete a request when stopped";
 
-	requestCompleted.emit(request);
+	if (!d->batchMaxRequests_) {
+		requestCompleted.emit(request);
+		return;
+	}
+
+	d->completedRequests_.push_back(request);
+
+	if (d->completedRequests_.size() >= d->batchMaxRequests_ ||
+	    !d->isRunning()) {
+		d->flushCompletedRequests();
+		return;
+	}
+
+	if (d->completedRequests_.size() > 1)
+		return;
+
+	/*
+	 * Start the latency timer for the first request of the batch. The timer
+	 * is created here to be bound to the pipeline handler thread.
+	 */
+	if (!d->batchTimer_) {
+		d->batchTimer_ = std::make_unique<Timer>();
+		d->batchTimer_->timeout.connect(d, &Private::flushCompletedRequests);
+	}
+
+	d->batchTimer_->start(utils::clock::now() + d->batchMaxLatency_);
+}
+
+/**
+ * \brief Deliver the requests of the current completion batch
+ *
+ * This function stops the batch latency timer and emits the requestsCompleted
+ * signal for the requests that have completed but haven't been delivered to
+ * the application yet. It is called when the camera stops, to ensure that all
+ * requests have been delivered when stop() returns. It must be called in the
+ * thread the camera is bound to, which owns the batch latency timer.
+ */
+void Camera::flushCompletedRequests()
+{
+	_d()->flushCompletedRequests();
 }
 
 } /* namespace libcamera */
@@ -0,0 +1,437 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Synchronised capture from multiple cameras
+ */
+
+#include <libcamera/camera_group.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <stdlib.h>
+
+#include <libcamera/base/log.h>
+#include <libcamera/base/mutex.h>
+
+#include <libcamera/camera.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+
+#include "libcamera/internal/timestamp_matcher.h"
+
+/**
+ * \file camera_group.h
+ * \brief Synchronised capture from multiple cameras
+ */
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Camera)
+
+class CameraGroup::Private : public Extensible::Private
+{
+	LIBCAMERA_DECLARE_PUBLIC(CameraGroup)
+
+public:
+	Private(const std::vector<std::shared_ptr<Camera>> &cameras);
+
+	void requestCompleted(unsigned int index, Request *request);
+	int queueRequests(Span<Request *const> requests);
+	void flush();
+
+	struct Member {
+		std::shared_ptr<Camera> camera;
+
+		bool canAdjust = false;
+
+		enum class Adjustment {
+			Idle,
+			Restore,
+			Settle,
+		} adjustment = Adjustment::Idle;
+		int64_t nominalDuration = 0;
+		unsigned int settleCount = 0;
+	};
+
+	/* Number of request sets to wait for a correction to take effect. */
+	static constexpr unsigned int kSettleFrames = 8;
+
+	std::vector<std::shared_ptr<Camera>> cameras_;
+
+	Mutex mutex_;
+	std::vector<Member> members_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	TimestampMatcher<Request *> matcher_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	bool phaseAlignment_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+};
+
+CameraGroup::Private::Private(const std::vector<std::shared_ptr<Camera>> &cameras)
+	: cameras_(cameras), matcher_(cameras.size()), phaseAlignment_(false)
+{
+	members_.resize(cameras.size());
+
+	for (unsigned int i = 0; i < cameras.size(); ++i) {
+		Member &member = members_[i];
+		member.camera = cameras[i];
+		member.canAdjust = cameras[i]->controls().count(&controls::FrameDurationLimits);
+	}
+}
+
+void CameraGroup::Private::requestCompleted(unsigned int index, Request *request)
+{
+	CameraGroup *const o = LIBCAMERA_O_PTR();
+	std::vector<Request *> dropped;
+	std::vector<std::vector<Request *>> sets;
+
+	/*
+	 * Use the sensor timestamp when available, and fall back to the
+	 * timestamp of the first buffer otherwise.
+	 */
+	int64_t timestamp = 0;
+	const auto sensorTimestamp = request->metadata().get(controls::SensorTimestamp);
+	if (sensorTimestamp)
+		timestamp = *sensorTimestamp;
+	else if (!request->buffers().empty())
+		timestamp = request->buffers().begin()->second->metadata().timestamp;
+
+	{
+		MutexLocker locker(mutex_);
+
+		if (request->status() != Request::RequestComplete || !timestamp) {
+			dropped.push_back(request);
+		} else {
+			const auto frameDuration = request->metadata().get(controls::FrameDuration);
+
+			matcher_.add(index, timestamp,
+				     frameDuration ? *frameDuration * 1000 : 0,
+				     request, &dropped, &sets);
+
+			/* Count down the request sets until the last correction settles. */
+			for (Member &member : members_) {
+				if (member.adjustment != Member::Adjustment::Settle)
+					continue;
+
+				member.settleCount -= std::min<unsigned int>(member.settleCount,
+									     sets.size());
+			}
+		}
+	}
+
+	for (Request *req : dropped)
+		o->requestDropped.emit(req);
+
+	for (const std::vector<Request *> &set : sets)
+		o->requestSetCompleted.emit(set);
+}
+
+int CameraGroup::Private::queueRequests(Span<Request *const> requests)
+{
+	if (requests.size() != cameras_.size()) {
+		LOG(Camera, Error)
+			<< "Expected " << cameras_.size() << " requests, got "
+			<< requests.size();
+		return -EINVAL;
+	}
+
+	{
+		MutexLocker locker(mutex_);
+
+		/*
+		 * Converge the sensor phases by stretching or shrinking one
+		 * frame of the cameras that drift from the first camera, and
+		 * restore the nominal frame duration on the next request. The
+		 * IPA applies the frame duration to the sensor. Requests that
+		 * already carry frame duration limits are left untouched.
+		 */
+		for (unsigned int i = 1; phaseAlignment_ && i < members_.size(); ++i) {
+			Member &member = members_[i];
+			ControlList &controls = requests[i]->controls();
+
+			if (!member.canAdjust ||
+			    controls.contains(controls::FrameDurationLimits.id()))
+				continue;
+
+			switch (member.adjustment) {
+			case Member::Adjustment::Idle: {
+				const int64_t duration = matcher_.frameDuration(i);
+				const int64_t phaseError = matcher_.phaseError(i);
+				if (!duration || llabs(phaseError) <= matcher_.tolerance() / 2)
+					break;
+
+				int64_t correction = std::clamp(phaseError,
+								-duration / 8,
+								duration / 8);
+				int64_t limit = (duration - correction) / 1000;
+				controls.set(controls::FrameDurationLimits,
+					     { limit, limit });
+
+				LOG(Camera, Debug)
+					<< "Camera " << member.camera->id()
+					<< " phase error " << phaseError
+					<< "ns, frame duration " << limit << "us";
+
+				member.nominalDuration = duration;
+				member.adjustment = Member::Adjustment::Restore;
+				break;
+			}
+
+			case Member::Adjustment::Restore: {
+				int64_t limit = member.nominalDuration / 1000;
+				controls.set(controls::FrameDurationLimits,
+					     { limit, limit });
+
+				member.settleCount = kSettleFrames;
+				member.adjustment = Member::Adjustment::Settle;
+				break;
+			}
+
+			case Member::Adjustment::Settle:
+				if (!member.settleCount)
+					member.adjustment = Member::Adjustment::Idle;
+				break;
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < requests.size(); ++i) {
+		int ret = cameras_[i]->queueRequest(requests[i]);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Drop all the requests waiting for a match, and reset the phase measurements.
+ */
+void CameraGroup::Private::flush()
+{
+	CameraGroup *const o = LIBCAMERA_O_PTR();
+	std::vector<Request *> dropped;
+
+	{
+		MutexLocker locker(mutex_);
+
+		matcher_.flush(&dropped);
+
+		for (Member &member : members_) {
+			member.adjustment = Member::Adjustment::Idle;
+			member.settleCount = 0;
+		}
+	}
+
+	for (Request *request : dropped)
+		o->requestDropped.emit(request);
+}
+
+/**
+ * \class CameraGroup
+ * \brief Capture timestamp-matched frames from multiple cameras
+ *
+ * Systems with multiple cameras looking at the same scene often need to
+ * process frames captured at the same time by all cameras. Each Camera
+ * completes requests independently, leaving the application to pair frames
+ * by timestamp and to buffer the frames of the cameras that run ahead.
+ *
+ * The CameraGroup performs this pairing. Applications configure the cameras
+ * individually, and then start them, queue requests and receive completed
+ * requests through the group. Requests are queued as sets of one request per
+ * camera with queueRequests(). When the requests complete, the group matches
+ * them by sensor timestamp, and emits the requestSetCompleted signal with one
+ * request per camera whose timestamps differ by at most the sync tolerance.
+ * Requests that can't be matched, because the corresponding frame has been
+ * lost by another camera, are reported through the requestDropped signal.
+ * The group buffers at most a configurable number of completed requests per
+ * camera, and drops the oldest requests when a camera stalls.
+ *
+ * Requests complete and the signals are emitted in the internal libcamera
+ * thread, as for the Camera::requestCompleted signal.
+ *
+ * The group can additionally steer the cameras towards phase alignment, see
+ * setPhaseAlignment().
+ */
+
+/**
+ * \brief Create a group of cameras
+ * \param[in] cameras The cameras, in the order of the requests in the sets
+ *
+ * The cameras shall have been acquired by the application. The first camera
+ * is used as the reference for phase alignment.
+ */
+CameraGroup::CameraGroup(const std::vector<std::shared_ptr<Camera>> &cameras)
+	: Extensible(std::make_unique<Private>(cameras))
+{
+	Private *const d = _d();
+
+	for (unsigned int i = 0; i < cameras.size(); ++i) {
+		Camera *camera = cameras[i].get();
+
+		camera->requestCompleted.connect(d, [d, i](Request *request) {
+			d->requestCompleted(i, request);
+		});
+		camera->requestsCompleted.connect(d, [d, i](const std::vector<Request *> &requests) {
+			for (Request *request : requests)
+				d->requestCompleted(i, request);
+		});
+	}
+}
+
+CameraGroup::~CameraGroup()
+{
+	Private *const d = _d();
+
+	for (const std::shared_ptr<Camera> &camera : d->cameras_) {
+		camera->requestCompleted.disconnect(d);
+		camera->requestsCompleted.disconnect(d);
+	}
+}
+
+/**
+ * \brief Retrieve the cameras in the group
+ * \return The cameras, in the order of the requests in the sets
+ */
+const std::vector<std::shared_ptr<Camera>> &CameraGroup::cameras() const
+{
+	return _d()->cameras_;
+}
+
+/**
+ * \brief Set the maximum timestamp difference of matched requests
+ * \param[in] tolerance The tolerance
+ *
+ * The tolerance defaults to 2ms.
+ */
+void CameraGroup::setSyncTolerance(std::chrono::microseconds tolerance)
+{
+	Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	d->matcher_.setTolerance(std::chrono::nanoseconds(tolerance).count());
+}
+
+/**
+ * \brief Set the maximum number of completed requests buffered per camera
+ * \param[in] count The number of requests
+ *
+ * When a camera has more than \a count completed requests waiting for a
+ * match, its oldest requests are dropped. The count defaults to 4.
+ */
+void CameraGroup::setMaxPendingRequests(unsigned int count)
+{
+	Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	d->matcher_.setMaxPending(count);
+}
+
+/**
+ * \brief Enable or disable phase alignment of the cameras
+ * \param[in] enable True to enable phase alignment
+ *
+ * When phase alignment is enabled, the group measures the phase of the frames
+ * of each camera relative to the first camera. When the phase error exceeds
+ * half the sync tolerance, the group stretches or shrinks one frame of the
+ * drifting camera by setting controls::FrameDurationLimits in the next queued
+ * request, and restores the nominal frame duration in the following request.
+ * The correction is bounded to an eighth of the frame duration, and repeated
+ * after the previous correction has taken effect until the phase error falls
+ * within the tolerance.
+ *
+ * Only cameras that support controls::FrameDurationLimits are adjusted, and
+ * requests for which the application sets frame duration limits are left
+ * untouched. The cameras are locked to their nominal frame duration once
+ * adjusted. Phase alignment is disabled by default.
+ */
+void CameraGroup::setPhaseAlignment(bool enable)
+{
+	Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	d->phaseAlignment_ = enable;
+}
+
+/**
+ * \brief Start all cameras in the group
+ *
+ * The cameras shall have been configured. If a camera fails to start, the
+ * cameras started previously are stopped.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int CameraGroup::start()
+{
+	Private *const d = _d();
+
+	d->flush();
+
+	for (unsigned int i = 0; i < d->cameras_.size(); ++i) {
+		int ret = d->cameras_[i]->start();
+		if (ret < 0) {
+			while (i--)
+				d->cameras_[i]->stop();
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Stop all cameras in the group
+ *
+ * All pending requests are cancelled and reported through the requestDropped
+ * signal, including completed requests that were waiting for a match.
+ *
+ * \return 0 on success or a negative error code if a camera failed to stop
+ */
+int CameraGroup::stop()
+{
+	Private *const d = _d();
+	int ret = 0;
+
+	for (const std::shared_ptr<Camera> &camera : d->cameras_) {
+		int err = camera->stop();
+		if (err < 0 && !ret)
+			ret = err;
+	}
+
+	d->flush();
+
+	return ret;
+}
+
+/**
+ * \brief Queue a set of requests to the cameras
+ * \param[in] requests One request per camera, in the order of cameras()
+ *
+ * The requests are queued to the cameras in order. If queuing a request
+ * fails, the requests for the following cameras are not queued.
+ *
+ * \return 0 on success or a negative error code otherwise
+ * \retval -EINVAL The number of requests doesn't match the number of cameras
+ */
+int CameraGroup::queueRequests(Span<Request *const> requests)
+{
+	return _d()->queueRequests(requests);
+}
+
+/**
+ * \var CameraGroup::requestSetCompleted
+ * \brief Signal emitted when a set of matching requests has completed
+ *
+ * The requests are ordered as the cameras of the group, and their timestamps
+ * differ by at most the sync tolerance.
+ */
+
+/**
+ * \var CameraGroup::requestDropped
+ * \brief Signal emitted when a request is dropped
+ *
+ * Requests are dropped when they fail or are cancelled, when no matching
+ * request has been captured by another camera, or when the group buffers too
+ * many completed requests for a camera. The application can reuse the request.
+ */
+
+} /* namespace libcamera */
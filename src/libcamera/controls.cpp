@@ -7,8 +7,11 @@
 
 #include <libcamera/controls.h>
 
+#include <atomic>
 #include <iomanip>
+#include <new>
 #include <sstream>
+#include <stddef.h>
 #include <string>
 #include <string.h>
 
@@ -92,6 +95,34 @@ static constexpr size_t ControlValueSize[] = {
 /** \todo Revisit the ControlValue layout when stabilizing the ABI */
 static_assert(sizeof(ControlValue) == 16, "Invalid size of ControlValue class");
 
+namespace {
+
+/*
+ * Values that don't fit in the ControlValue are stored in a heap-allocated
+ * block, shared between copies of the value and copied on write. The block
+ * starts with a reference count, followed by the value data.
+ */
+struct ControlValueStorage {
+	std::atomic<unsigned int> refcount;
+};
+
+constexpr std::size_t kStorageHeaderSize = alignof(max_align_t);
+static_assert(sizeof(ControlValueStorage) <= kStorageHeaderSize);
+
+void *allocateStorage(std::size_t size)
+{
+	uint8_t *block = new uint8_t[kStorageHeaderSize + size];
+	new (block) ControlValueStorage{ 1 };
+	return block;
+}
+
+ControlValueStorage *storageHeader(void *storage)
+{
+	return reinterpret_cast<ControlValueStorage *>(storage);
+}
+
+} /* namespace */
+
 /**
  * \brief Construct an empty ControlValue.
  */
@@ -117,7 +148,11 @@ void ControlValue::release()
 	std::size_t size = numElements_ * ControlValueSize[type_];
 
 	if (size > sizeof(value_)) {
-		delete[] reinterpret_cast<uint8_t *>(storage_);
+		ControlValueStorage *header = storageHeader(storage_);
+		if (header->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			header->~ControlValueStorage();
+			delete[] reinterpret_cast<uint8_t *>(storage_);
+		}
 		storage_ = nullptr;
 	}
 }
@@ -130,6 +165,13 @@ ControlValue::~ControlValue()
 /**
  * \brief Construct a ControlValue with the content of \a other
  * \param[in] other The ControlValue to copy content from
+ *
+ * Values larger than 8 bytes, such as large arrays, are not copied. The new
+ * instance shares the storage of \a other instead, and the data is copied only
+ * when one of the instances is modified. Copying control values, and thus
+ * ControlList instances, is cheap regardless of the size of their values. This
+ * allows passing large metadata, such as raw statistics, from IPA modules to
+ * applications without copying the data at every step.
  */
 ControlValue::ControlValue(const ControlValue &other)
 	: type_(ControlTypeNone), numElements_(0)
@@ -145,8 +187,26 @@ ControlValue::ControlValue(const ControlValue &other)
  */
 ControlValue &ControlValue::operator=(const ControlValue &other)
 {
-	set(other.type_, other.isArray_, other.data().data(),
-	    other.numElements_, ControlValueSize[other.type_]);
+	if (this == &other)
+		return *this;
+
+	std::size_t size = other.numElements_ * ControlValueSize[other.type_];
+	if (size <= sizeof(value_)) {
+		set(other.type_, other.isArray_, other.data().data(),
+		    other.numElements_, ControlValueSize[other.type_]);
+		return *this;
+	}
+
+	/* Share the storage of large values, see ControlValue(const ControlValue &). */
+	storageHeader(other.storage_)->refcount.fetch_add(1, std::memory_order_relaxed);
+
+	release();
+
+	type_ = other.type_;
+	isArray_ = other.isArray_;
+	numElements_ = other.numElements_;
+	storage_ = other.storage_;
+
 	return *this;
 }
 
@@ -187,16 +247,33 @@ Span<const uint8_t> ControlValue::data() const
 {
 	std::size_t size = numElements_ * ControlValueSize[type_];
 	const uint8_t *data = size > sizeof(value_)
-			    ? reinterpret_cast<const uint8_t *>(storage_)
+			    ? reinterpret_cast<const uint8_t *>(storage_) + kStorageHeaderSize
 			    : reinterpret_cast<const uint8_t *>(&value_);
 	return { data, size };
 }
 
 /**
  * \copydoc ControlValue::data() const
+ *
+ * If the storage is shared with other copies of the value, this function
+ * copies it first, so that modifications through the returned span affect this
+ * instance only.
  */
 Span<uint8_t> ControlValue::data()
 {
+	std::size_t size = numElements_ * ControlValueSize[type_];
+
+	if (size > sizeof(value_) &&
+	    storageHeader(storage_)->refcount.load(std::memory_order_acquire) > 1) {
+		void *storage = allocateStorage(size);
+		memcpy(reinterpret_cast<uint8_t *>(storage) + kStorageHeaderSize,
+		       reinterpret_cast<const uint8_t *>(storage_) + kStorageHeaderSize,
+		       size);
+
+		release();
+		storage_ = storage;
+	}
+
 	Span<const uint8_t> data = const_cast<const ControlValue *>(this)->data();
 	return { const_cast<uint8_t *>(data.data()), data.size() };
 }
@@ -360,18 +437,27 @@ void ControlValue::reserve(ControlType type, bool isArray, std::size_t numElemen
 	std::size_t oldSize = numElements_ * ControlValueSize[type_];
 	std::size_t newSize = numElements * ControlValueSize[type];
 
-	if (oldSize != newSize)
+	/*
+	 * Reuse the storage if the size doesn't change and the storage isn't
+	 * shared with other copies of the value, as the caller will overwrite
+	 * it.
+	 */
+	bool reuse = oldSize == newSize &&
+		     (oldSize <= sizeof(value_) ||
+		      storageHeader(storage_)->refcount.load(std::memory_order_acquire) == 1);
+
+	if (!reuse)
 		release();
 
 	type_ = type;
 	isArray_ = isArray;
 	numElements_ = numElements;
 
-	if (oldSize == newSize)
+	if (reuse)
 		return;
 
 	if (newSize > sizeof(value_))
-		storage_ = reinterpret_cast<void *>(new uint8_t[newSize]);
+		storage_ = allocateStorage(newSize);
 }
 
 /**
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Fixed-capacity ring of per-frame pipeline information
+ */
+
+#include "libcamera/internal/frame_info_ring.h"
+
+/**
+ * \file frame_info_ring.h
+ * \brief Fixed-capacity ring of per-frame pipeline information
+ */
+
+namespace libcamera {
+
+/**
+ * \class FrameInfoRing
+ * \brief Preallocated storage for the information of frames in flight
+ * \tparam Info The pipeline handler-specific per-frame information type
+ *
+ * Pipeline handlers track information about each request being processed,
+ * such as the internal buffers associated with the request and the progress
+ * of its processing. The information is created when the request is queued
+ * to the device, looked up by frame number and by buffer when the IPA and the
+ * video devices signal progress, and destroyed when the request completes.
+ *
+ * The FrameInfoRing stores the per-frame information in a preallocated array
+ * of slots, sized with reset() for the maximum number of frames in flight.
+ * Creating and destroying frame information doesn't allocate memory, and
+ * lookups by frame number, by request and by buffer complete in constant time
+ * as long as the frame numbers and request sequence numbers of the frames in
+ * flight don't collide modulo the ring capacity.
+ *
+ * Buffers are looked up through the request they belong to, as returned by
+ * FrameBuffer::request(). Pipeline handlers shall thus associate their
+ * internal buffers with the request they are used for.
+ *
+ * If more frames than the ring capacity are created, the ring doubles its
+ * capacity. This invalidates all pointers to frame information previously
+ * returned by the ring.
+ */
+
+/**
+ * \fn FrameInfoRing::FrameInfoRing()
+ * \brief Construct an empty FrameInfoRing
+ *
+ * The ring has no capacity until reset() is called.
+ */
+
+/**
+ * \fn FrameInfoRing::reset()
+ * \brief Drop all frame information and set the ring capacity
+ * \param[in] capacity The maximum number of frames in flight
+ */
+
+/**
+ * \fn FrameInfoRing::create()
+ * \brief Create information for a new frame
+ * \param[in] frame The frame number
+ * \param[in] request The request processed for the frame
+ *
+ * The \a frame number shall not be in use by another frame in the ring. The
+ * returned information is value-initialized.
+ *
+ * \return The frame information
+ */
+
+/**
+ * \fn FrameInfoRing::remove()
+ * \brief Destroy the information for a frame
+ * \param[in] frame The frame number
+ * \return True if the frame has been found and removed, false otherwise
+ */
+
+/**
+ * \fn FrameInfoRing::find(unsigned int frame)
+ * \brief Find the information for a frame by frame number
+ * \param[in] frame The frame number
+ * \return The frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoRing::find(const Request *request)
+ * \brief Find the information for a frame by request
+ * \param[in] request The request processed for the frame
+ * \return The frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoRing::find(const FrameBuffer *buffer)
+ * \brief Find the information for a frame by buffer
+ * \param[in] buffer A buffer belonging to the request processed for the frame
+ * \return The frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoRing::forEach()
+ * \brief Call a function on the information of all frames in the ring
+ * \param[in] func The function, taking an Info reference as argument
+ */
+
+/**
+ * \fn FrameInfoRing::empty()
+ * \brief Check if the ring contains no frame
+ * \return True if the ring is empty, false otherwise
+ */
+
+/**
+ * \fn FrameInfoRing::size()
+ * \brief Retrieve the number of frames in the ring
+ * \return The number of frames in the ring
+ */
+
+/**
+ * \fn FrameInfoRing::capacity()
+ * \brief Retrieve the number of frames the ring can hold without growing
+ * \return The ring capacity
+ */
+
+} /* namespace libcamera */
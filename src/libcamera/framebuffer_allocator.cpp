@@ -15,6 +15,7 @@
 #include <libcamera/framebuffer.h>
 #include <libcamera/stream.h>
 
+#include "libcamera/internal/camera.h"
 #include "libcamera/internal/pipeline_handler.h"
 
 /**
@@ -50,6 +51,9 @@ LOG_DEFINE_CATEGORY(Allocator)
  * buffers are not deleted while they are in use (part of a Request that has
  * been queued and hasn't completed yet).
  *
+ * The memory of the allocated buffers is reported by Camera::memoryUsage()
+ * under MemoryUsage::Purpose::Application until the buffers are freed.
+ *
  * Usage of the FrameBufferAllocator is optional, if all buffers for a camera
  * are provided externally applications shall not use this class.
  */
@@ -63,7 +67,12 @@ FrameBufferAllocator::FrameBufferAllocator(std::shared_ptr<Camera> camera)
 {
 }
 
-FrameBufferAllocator::~FrameBufferAllocator() = default;
+FrameBufferAllocator::~FrameBufferAllocator()
+{
+	for (const auto &[stream, buffers] : buffers_)
+		camera_->_d()->removeBuffers(MemoryUsage::Purpose::Application,
+					     buffers);
+}
 
 /**
  * \brief Allocate buffers for a configured stream
@@ -98,8 +107,13 @@ int FrameBufferAllocator::allocate(Stream *stream)
 			<< "Stream is not part of " << camera_->id()
 			<< " active configuration";
 
-	if (ret < 0)
+	if (ret < 0) {
 		buffers_.erase(it);
+		return ret;
+	}
+
+	camera_->_d()->addBuffers(MemoryUsage::Purpose::Application,
+				  it->second);
 
 	return ret;
 }
@@ -122,6 +136,8 @@ int FrameBufferAllocator::free(Stream *stream)
 	if (iter == buffers_.end())
 		return -EINVAL;
 
+	camera_->_d()->removeBuffers(MemoryUsage::Purpose::Application,
+				     iter->second);
 	buffers_.erase(iter);
 
 	return 0;
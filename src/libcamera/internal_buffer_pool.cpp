@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Lazily allocated pool of internal pipeline buffers
+ */
+
+#include "libcamera/internal/internal_buffer_pool.h"
+
+#include <algorithm>
+#include <errno.h>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/v4l2_videodevice.h"
+
+/**
+ * \file internal_buffer_pool.h
+ * \brief Lazily allocated pool of internal pipeline buffers
+ */
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Pipeline)
+
+/**
+ * \class InternalBufferPool
+ * \brief Pool of internal buffers allocated on demand for a video device
+ *
+ * Pipeline handlers commonly allocate internal buffers for video devices that
+ * capture data the application doesn't necessarily provide buffers for, such
+ * as raw frames when no raw stream is part of a request. Allocating the full
+ * set of buffers when the camera starts delays the first frame and consumes
+ * memory even when the buffers end up unused, for instance when the
+ * application supplies its own buffers in every request.
+ *
+ * The InternalBufferPool allocates a small initial set of buffers from the
+ * video device with allocate(), and grows incrementally up to a maximum
+ * number of buffers with allocateBuffer() when the pipeline handler runs out
+ * of available buffers. Buffers allocated on demand are backed by dma-buf
+ * heap memory, as the V4L2 device can't allocate new buffers while streaming.
+ * The video device shall thus be set up to import buffers, with
+ * V4L2VideoDevice::importBuffers(), for at least the maximum number of
+ * buffers.
+ *
+ * If no dma-buf heap is available, or if the device format can't be
+ * represented with one dma-buf per V4L2 plane, the pool falls back to
+ * allocating the maximum number of buffers from the video device in
+ * allocate().
+ *
+ * The pool owns all the buffers it allocates, until release() is called. It
+ * doesn't track which buffers are in use, this is left to the pipeline
+ * handler.
+ */
+
+/**
+ * \brief Construct an InternalBufferPool
+ * \param[in] name The name of the pool, used to name the dma-buf allocations
+ * \param[in] flags The dma-buf providers suitable for the video device
+ *
+ * The \a flags shall only include providers whose memory can be imported by
+ * the video device, for instance CmaHeap only for devices that require
+ * physically contiguous memory.
+ */
+InternalBufferPool::InternalBufferPool(const std::string &name,
+				       DmaBufAllocator::DmaBufAllocatorFlags flags)
+	: name_(name), dmaHeap_(flags), maxCount_(0)
+{
+}
+
+InternalBufferPool::~InternalBufferPool()
+{
+	release();
+}
+
+/**
+ * \brief Allocate the initial buffers of the pool
+ * \param[in] video The video device the buffers are allocated for
+ * \param[in] initialCount The number of buffers to allocate immediately
+ * \param[in] maxCount The maximum number of buffers in the pool
+ *
+ * Allocate \a initialCount buffers from the \a video device, sized for its
+ * current format. The remaining buffers, up to \a maxCount, are allocated on
+ * demand by allocateBuffer(). If buffers can't be allocated on demand,
+ * \a maxCount buffers are allocated immediately.
+ *
+ * This function shall be called before buffers are imported on the \a video
+ * device. The bufferAllocated signal is emitted for each allocated buffer.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int InternalBufferPool::allocate(V4L2VideoDevice *video, unsigned int initialCount,
+				 unsigned int maxCount)
+{
+	V4L2DeviceFormat format;
+	int ret;
+
+	release();
+
+	ret = video->getFormat(&format);
+	if (ret)
+		return ret;
+
+	bool lazy = dmaHeap_.isValid();
+
+	/*
+	 * Buffers allocated on demand use one dma-buf per V4L2 plane. Formats
+	 * that store multiple colour planes in a single V4L2 plane need the
+	 * plane offsets computed by the video device.
+	 */
+	const PixelFormatInfo &info =
+		PixelFormatInfo::info(format.fourcc.toPixelFormat(false));
+	if (info.isValid() && info.numPlanes() != format.planesCount)
+		lazy = false;
+
+	for (unsigned int i = 0; i < format.planesCount; ++i)
+		planeSizes_.push_back(format.planes[i].size);
+
+	maxCount_ = maxCount;
+	if (!lazy)
+		initialCount = maxCount;
+	initialCount = std::min(initialCount, maxCount);
+
+	if (initialCount) {
+		ret = video->exportBuffers(initialCount, &buffers_);
+		if (ret < 0) {
+			release();
+			return ret;
+		}
+	}
+
+	LOG(Pipeline, Debug)
+		<< "Allocated " << buffers_.size() << "/" << maxCount_
+		<< " " << name_ << " buffers";
+
+	for (const std::unique_ptr<FrameBuffer> &buffer : buffers_)
+		bufferAllocated.emit(buffer.get());
+
+	return 0;
+}
+
+/**
+ * \brief Allocate one more buffer in the pool
+ *
+ * Pipeline handlers shall call this function when they run out of internal
+ * buffers. The new buffer is allocated from a dma-buf heap and sized for the
+ * video device format at the time allocate() was called. The bufferAllocated
+ * signal is emitted for the new buffer.
+ *
+ * The allocation is synchronous and runs in the caller's thread, usually while
+ * streaming. An informational message is logged every time the pool grows, to
+ * help sizing the initial allocation when growing the pool delays frames.
+ *
+ * \return The new buffer, or nullptr if the pool has reached its maximum size
+ * or the allocation failed
+ */
+FrameBuffer *InternalBufferPool::allocateBuffer()
+{
+	if (buffers_.size() >= maxCount_)
+		return nullptr;
+
+	std::vector<FrameBuffer::Plane> planes;
+
+	for (unsigned int size : planeSizes_) {
+		std::string name = name_ + std::to_string(buffers_.size());
+
+		UniqueFD fd = dmaHeap_.alloc(name.c_str(), size);
+		if (!fd.isValid()) {
+			LOG(Pipeline, Error)
+				<< "Failed to allocate " << name_ << " buffer";
+			return nullptr;
+		}
+
+		FrameBuffer::Plane plane;
+		plane.fd = SharedFD(std::move(fd));
+		plane.offset = 0;
+		plane.length = size;
+
+		planes.push_back(std::move(plane));
+	}
+
+	buffers_.push_back(std::make_unique<FrameBuffer>(planes));
+	FrameBuffer *buffer = buffers_.back().get();
+
+	/*
+	 * The pool grows while streaming, from the pipeline handler thread.
+	 * Report it, as heap allocations, especially from the CMA heap, can
+	 * take long enough to delay frames.
+	 */
+	LOG(Pipeline, Info)
+		<< "Grew " << name_ << " pool to " << buffers_.size()
+		<< "/" << maxCount_ << " buffers";
+
+	bufferAllocated.emit(buffer);
+
+	return buffer;
+}
+
+/**
+ * \brief Free all the buffers in the pool
+ *
+ * The buffers shall not be in use by the video device when this function is
+ * called.
+ */
+void InternalBufferPool::release()
+{
+	buffers_.clear();
+	planeSizes_.clear();
+	maxCount_ = 0;
+}
+
+/**
+ * \brief Check if a buffer belongs to the pool
+ * \param[in] buffer The buffer
+ * \return True if \a buffer has been allocated by the pool, false otherwise
+ */
+bool InternalBufferPool::contains(const FrameBuffer *buffer) const
+{
+	return std::any_of(buffers_.begin(), buffers_.end(),
+			   [buffer](const std::unique_ptr<FrameBuffer> &buf) {
+				   return buf.get() == buffer;
+			   });
+}
+
+/**
+ * \fn InternalBufferPool::maxCount()
+ * \brief Retrieve the maximum number of buffers in the pool
+ * \return The maximum number of buffers in the pool
+ */
+
+/**
+ * \fn InternalBufferPool::buffers()
+ * \brief Retrieve the buffers currently allocated in the pool
+ * \return The buffers currently allocated in the pool
+ */
+
+/**
+ * \var InternalBufferPool::bufferAllocated
+ * \brief A signal emitted when a buffer is allocated in the pool
+ *
+ * Pipeline handlers can connect to this signal to account for memory
+ * allocated on demand.
+ */
+
+} /* namespace libcamera */
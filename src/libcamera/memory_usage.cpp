@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Memory usage accounting
+ */
+
+#include <libcamera/memory_usage.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <libcamera/base/utils.h>
+
+/**
+ * \file memory_usage.h
+ * \brief Accounting of the memory allocated by a camera
+ */
+
+namespace libcamera {
+
+/**
+ * \class MemoryUsage
+ * \brief Record the amount of memory allocated by a camera
+ *
+ * Cameras allocate memory in many places: frame buffers exported to
+ * applications through the FrameBufferAllocator, and internal buffers used by
+ * pipeline handlers to capture raw frames, exchange parameters and statistics
+ * with the ISP, or share data with the IPA. The MemoryUsage class records the
+ * size of those allocations, broken down by purpose and by type of memory.
+ *
+ * The memory usage of a camera is retrieved with Camera::memoryUsage(). It
+ * reports the memory allocated by libcamera at the time of the call, and thus
+ * changes when the camera is configured, started or stopped, and when buffers
+ * are allocated or freed.
+ */
+
+/**
+ * \enum MemoryUsage::Purpose
+ * \brief The purpose of a memory allocation
+ *
+ * \var MemoryUsage::Purpose::Application
+ * \brief Frame buffers allocated for the application
+ *
+ * \var MemoryUsage::Purpose::Raw
+ * \brief Internal raw frame buffers, captured from the sensor and processed
+ * by an ISP or converter
+ *
+ * \var MemoryUsage::Purpose::Statistics
+ * \brief Internal statistics buffers
+ *
+ * \var MemoryUsage::Purpose::Parameters
+ * \brief Internal ISP parameters buffers
+ *
+ * \var MemoryUsage::Purpose::EmbeddedData
+ * \brief Internal sensor embedded data buffers
+ *
+ * \var MemoryUsage::Purpose::Processing
+ * \brief Other internal memory used by processing blocks, such as ISP
+ * intermediate buffers or software ISP state
+ */
+
+/**
+ * \enum MemoryUsage::Type
+ * \brief The type of memory
+ *
+ * \var MemoryUsage::Type::DmaBuf
+ * \brief Memory allocated as dmabuf, from a V4L2 device or a DMA heap
+ *
+ * \var MemoryUsage::Type::SharedMemory
+ * \brief Anonymous shared memory, typically used to share data with IPA
+ * modules
+ */
+
+/**
+ * \brief Construct an empty MemoryUsage
+ */
+MemoryUsage::MemoryUsage()
+	: sizes_{}
+{
+}
+
+/**
+ * \brief Record a memory allocation
+ * \param[in] purpose The purpose of the allocation
+ * \param[in] type The type of memory
+ * \param[in] size The size of the allocation in bytes
+ */
+void MemoryUsage::add(Purpose purpose, Type type, std::size_t size)
+{
+	sizes_[utils::to_underlying(purpose)][utils::to_underlying(type)] += size;
+}
+
+/**
+ * \brief Record the release of a memory allocation
+ * \param[in] purpose The purpose of the allocation
+ * \param[in] type The type of memory
+ * \param[in] size The size of the allocation in bytes
+ *
+ * The recorded size is clamped to 0 if \a size is larger than the amount of
+ * memory currently recorded for \a purpose and \a type.
+ */
+void MemoryUsage::remove(Purpose purpose, Type type, std::size_t size)
+{
+	std::size_t &current =
+		sizes_[utils::to_underlying(purpose)][utils::to_underlying(type)];
+
+	current -= std::min(current, size);
+}
+
+/**
+ * \brief Retrieve the memory allocated for a purpose and type of memory
+ * \param[in] purpose The purpose of the allocations
+ * \param[in] type The type of memory
+ * \return The size in bytes of the memory of \a type allocated for \a purpose
+ */
+std::size_t MemoryUsage::size(Purpose purpose, Type type) const
+{
+	return sizes_[utils::to_underlying(purpose)][utils::to_underlying(type)];
+}
+
+/**
+ * \brief Retrieve the memory allocated for a purpose
+ * \param[in] purpose The purpose of the allocations
+ * \return The size in bytes of the memory of all types allocated for
+ * \a purpose
+ */
+std::size_t MemoryUsage::size(Purpose purpose) const
+{
+	std::size_t total = 0;
+
+	for (std::size_t size : sizes_[utils::to_underlying(purpose)])
+		total += size;
+
+	return total;
+}
+
+/**
+ * \brief Retrieve the memory allocated for a type of memory
+ * \param[in] type The type of memory
+ * \return The size in bytes of the memory of \a type allocated for all
+ * purposes
+ */
+std::size_t MemoryUsage::size(Type type) const
+{
+	std::size_t total = 0;
+
+	for (const auto &sizes : sizes_)
+		total += sizes[utils::to_underlying(type)];
+
+	return total;
+}
+
+/**
+ * \brief Retrieve the total memory allocated
+ * \return The size in bytes of all memory allocations
+ */
+std::size_t MemoryUsage::total() const
+{
+	std::size_t total = 0;
+
+	for (const auto &sizes : sizes_) {
+		for (std::size_t size : sizes)
+			total += size;
+	}
+
+	return total;
+}
+
+/**
+ * \brief Assemble and return a string describing the memory usage
+ *
+ * The string lists the total memory usage, followed by the usage of each
+ * purpose and type that has non-zero allocations.
+ *
+ * \return A string describing the MemoryUsage
+ */
+std::string MemoryUsage::toString() const
+{
+	std::stringstream ss;
+	ss << *this;
+
+	return ss.str();
+}
+
+/**
+ * \brief Insert a text representation of a MemoryUsage::Purpose into an output
+ * stream
+ * \param[in] out The output stream
+ * \param[in] purpose The purpose
+ * \return The output stream \a out
+ */
+std::ostream &operator<<(std::ostream &out, MemoryUsage::Purpose purpose)
+{
+	static constexpr std::array<const char *, 6> names = {
+		"Application",
+		"Raw",
+		"Statistics",
+		"Parameters",
+		"EmbeddedData",
+		"Processing",
+	};
+
+	out << names[utils::to_underlying(purpose)];
+	return out;
+}
+
+/**
+ * \brief Insert a text representation of a MemoryUsage::Type into an output
+ * stream
+ * \param[in] out The output stream
+ * \param[in] type The type of memory
+ * \return The output stream \a out
+ */
+std::ostream &operator<<(std::ostream &out, MemoryUsage::Type type)
+{
+	static constexpr std::array<const char *, 2> names = {
+		"dmabuf",
+		"shmem",
+	};
+
+	out << names[utils::to_underlying(type)];
+	return out;
+}
+
+/**
+ * \brief Insert a text representation of a MemoryUsage into an output stream
+ * \param[in] out The output stream
+ * \param[in] usage The memory usage
+ * \return The output stream \a out
+ */
+std::ostream &operator<<(std::ostream &out, const MemoryUsage &usage)
+{
+	static constexpr MemoryUsage::Purpose purposes[] = {
+		MemoryUsage::Purpose::Application,
+		MemoryUsage::Purpose::Raw,
+		MemoryUsage::Purpose::Statistics,
+		MemoryUsage::Purpose::Parameters,
+		MemoryUsage::Purpose::EmbeddedData,
+		MemoryUsage::Purpose::Processing,
+	};
+	static constexpr MemoryUsage::Type types[] = {
+		MemoryUsage::Type::DmaBuf,
+		MemoryUsage::Type::SharedMemory,
+	};
+
+	out << usage.total() << " bytes";
+
+	for (MemoryUsage::Purpose purpose : purposes) {
+		for (MemoryUsage::Type type : types) {
+			std::size_t size = usage.size(purpose, type);
+			if (!size)
+				continue;
+
+			out << ", " << purpose << "/" << type << ": " << size;
+		}
+	}
+
+	return out;
+}
+
+} /* namespace libcamera */
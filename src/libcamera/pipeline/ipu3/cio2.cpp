@@ -38,6 +38,9 @@ const std::map<uint32_t, PixelFormat> mbusCodesToPixelFormat = {
 } /* namespace */
 
 CIO2Device::CIO2Device()
+	: bufferSize_(0),
+	  pool_("cio2-raw", DmaBufAllocator::DmaBufAllocatorFlag::CmaHeap |
+			    DmaBufAllocator::DmaBufAllocatorFlag::SystemHeap)
 {
 }
 
@@ -214,6 +217,8 @@ int CIO2Device::configure(const Size &size, const Transform &transform,
 	if (ret)
 		return ret;
 
+	bufferSize_ = outputFormat->planes[0].size;
+
 	LOG(IPU3, Debug) << "CIO2 output format " << *outputFormat;
 
 	return 0;
@@ -338,9 +343,25 @@ int CIO2Device::exportBuffers(unsigned int count,
 	return output_->exportBuffers(count, buffers);
 }
 
-int CIO2Device::start()
+/**
+ * \brief Start the CIO2 unit
+ * \param[in] bufferCount The maximum number of internal raw buffers
+ *
+ * The internal raw buffers are used to capture frames for requests that don't
+ * contain a raw stream buffer. A single buffer is allocated when starting, and
+ * more are allocated on demand, up to \a bufferCount, when requests run out of
+ * internal buffers. Applications that provide a raw buffer in every request
+ * thus don't pay for the internal buffers.
+ *
+ * If starting fails after the internal buffers have been allocated, they are
+ * not released, to let the caller account for them before releasing them with
+ * stop().
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int CIO2Device::start(unsigned int bufferCount)
 {
-	int ret = output_->exportBuffers(kBufferCount, &buffers_);
+	int ret = pool_.allocate(output_.get(), 1, bufferCount);
 	if (ret < 0)
 		return ret;
 
@@ -348,22 +369,14 @@ int CIO2Device::start()
 	if (ret)
 		LOG(IPU3, Error) << "Failed to import CIO2 buffers";
 
-	for (std::unique_ptr<FrameBuffer> &buffer : buffers_)
+	for (const std::unique_ptr<FrameBuffer> &buffer : pool_.buffers())
 		availableBuffers_.push(buffer.get());
 
 	ret = output_->streamOn();
-	if (ret) {
-		freeBuffers();
-		return ret;
-	}
-
-	ret = csi2_->setFrameStartEnabled(true);
-	if (ret) {
-		stop();
+	if (ret)
 		return ret;
-	}
 
-	return 0;
+	return csi2_->setFrameStartEnabled(true);
 }
 
 int CIO2Device::stop()
@@ -385,13 +398,17 @@ FrameBuffer *CIO2Device::queueBuffer(Request *request, FrameBuffer *rawBuffer)
 
 	/* If no buffer is provided in the request, use an internal one. */
 	if (!buffer) {
-		if (availableBuffers_.empty()) {
-			LOG(IPU3, Debug) << "CIO2 buffer underrun";
-			return nullptr;
+		if (!availableBuffers_.empty()) {
+			buffer = availableBuffers_.front();
+			availableBuffers_.pop();
+		} else {
+			buffer = pool_.allocateBuffer();
+			if (!buffer) {
+				LOG(IPU3, Debug) << "CIO2 buffer underrun";
+				return nullptr;
+			}
 		}
 
-		buffer = availableBuffers_.front();
-		availableBuffers_.pop();
 		buffer->_d()->setRequest(request);
 	}
 
@@ -404,18 +421,8 @@ FrameBuffer *CIO2Device::queueBuffer(Request *request, FrameBuffer *rawBuffer)
 
 void CIO2Device::tryReturnBuffer(FrameBuffer *buffer)
 {
-	/*
-	 * \todo Once more pipelines deal with buffers that may be allocated
-	 * internally or externally this pattern might become a common need. At
-	 * that point this check should be moved to something clever in
-	 * FrameBuffer.
-	 */
-	for (const std::unique_ptr<FrameBuffer> &buf : buffers_) {
-		if (buf.get() == buffer) {
-			availableBuffers_.push(buffer);
-			break;
-		}
-	}
+	if (pool_.contains(buffer))
+		availableBuffers_.push(buffer);
 
 	bufferAvailable.emit();
 }
@@ -423,7 +430,7 @@ void CIO2Device::tryReturnBuffer(FrameBuffer *buffer)
 void CIO2Device::freeBuffers()
 {
 	availableBuffers_ = {};
-	buffers_.clear();
+	pool_.release();
 
 	if (output_->releaseBuffers())
 		LOG(IPU3, Error) << "Failed to release CIO2 buffers";
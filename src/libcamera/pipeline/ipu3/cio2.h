@@ -13,6 +13,7 @@
 
 #include <libcamera/base/signal.h>
 
+#include "libcamera/internal/internal_buffer_pool.h"
 #include "libcamera/internal/v4l2_subdevice.h"
 #include "libcamera/internal/v4l2_videodevice.h"
 
@@ -50,16 +51,20 @@ public:
 	V4L2SubdeviceFormat getSensorFormat(const std::vector<unsigned int> &mbusCodes,
 					    const Size &size) const;
 
-	int start();
+	int start(unsigned int bufferCount = kBufferCount);
 	int stop();
 
 	CameraSensor *sensor() { return sensor_.get(); }
 	const CameraSensor *sensor() const { return sensor_.get(); }
 
+	std::size_t bufferSize() const { return bufferSize_; }
+	const std::vector<std::unique_ptr<FrameBuffer>> &buffers() const { return pool_.buffers(); }
+
 	FrameBuffer *queueBuffer(Request *request, FrameBuffer *rawBuffer);
 	void tryReturnBuffer(FrameBuffer *buffer);
 	Signal<FrameBuffer *> &bufferReady() { return output_->bufferReady; }
 	Signal<uint32_t> &frameStart() { return csi2_->frameStart; }
+	Signal<FrameBuffer *> &bufferAllocated() { return pool_.bufferAllocated; }
 
 	Signal<> bufferAvailable;
 
@@ -72,7 +77,8 @@ private:
 	std::unique_ptr<V4L2Subdevice> csi2_;
 	std::unique_ptr<V4L2VideoDevice> output_;
 
-	std::vector<std::unique_ptr<FrameBuffer>> buffers_;
+	std::size_t bufferSize_;
+	InternalBufferPool pool_;
 	std::queue<FrameBuffer *> availableBuffers_;
 };
 
@@ -7,6 +7,8 @@
 
 #include "frames.h"
 
+#include <algorithm>
+
 #include <libcamera/framebuffer.h>
 #include <libcamera/request.h>
 
@@ -25,19 +27,25 @@ IPU3Frames::IPU3Frames()
 void IPU3Frames::init(const std::vector<std::unique_ptr<FrameBuffer>> &paramBuffers,
 		      const std::vector<std::unique_ptr<FrameBuffer>> &statBuffers)
 {
+	availableParamBuffers_.reserve(paramBuffers.size());
 	for (const std::unique_ptr<FrameBuffer> &buffer : paramBuffers)
-		availableParamBuffers_.push(buffer.get());
+		availableParamBuffers_.push_back(buffer.get());
 
+	availableStatBuffers_.reserve(statBuffers.size());
 	for (const std::unique_ptr<FrameBuffer> &buffer : statBuffers)
-		availableStatBuffers_.push(buffer.get());
+		availableStatBuffers_.push_back(buffer.get());
 
-	frameInfo_.clear();
+	/*
+	 * The number of frames in flight is bounded by the number of
+	 * parameters and statistics buffers.
+	 */
+	frameInfo_.reset(std::min(paramBuffers.size(), statBuffers.size()));
 }
 
 void IPU3Frames::clear()
 {
-	availableParamBuffers_ = {};
-	availableStatBuffers_ = {};
+	availableParamBuffers_.clear();
+	availableStatBuffers_.clear();
 }
 
 IPU3Frames::Info *IPU3Frames::create(Request *request)
@@ -54,17 +62,16 @@ IPU3Frames::Info *IPU3Frames::create(Request *request)
 		return nullptr;
 	}
 
-	FrameBuffer *paramBuffer = availableParamBuffers_.front();
-	FrameBuffer *statBuffer = availableStatBuffers_.front();
+	FrameBuffer *paramBuffer = availableParamBuffers_.back();
+	FrameBuffer *statBuffer = availableStatBuffers_.back();
 
 	paramBuffer->_d()->setRequest(request);
 	statBuffer->_d()->setRequest(request);
 
-	availableParamBuffers_.pop();
-	availableStatBuffers_.pop();
+	availableParamBuffers_.pop_back();
+	availableStatBuffers_.pop_back();
 
-	/* \todo Remove the dynamic allocation of Info */
-	std::unique_ptr<Info> info = std::make_unique<Info>();
+	Info *info = frameInfo_.create(id, request);
 
 	info->id = id;
 	info->request = request;
@@ -74,19 +81,17 @@ IPU3Frames::Info *IPU3Frames::create(Request *request)
 	info->paramDequeued = false;
 	info->metadataProcessed = false;
 
-	frameInfo_[id] = std::move(info);
-
-	return frameInfo_[id].get();
+	return info;
 }
 
 void IPU3Frames::remove(IPU3Frames::Info *info)
 {
 	/* Return params and stat buffer for reuse. */
-	availableParamBuffers_.push(info->paramBuffer);
-	availableStatBuffers_.push(info->statBuffer);
+	availableParamBuffers_.push_back(info->paramBuffer);
+	availableStatBuffers_.push_back(info->statBuffer);
 
-	/* Delete the extended frame information. */
-	frameInfo_.erase(info->id);
+	/* Release the extended frame information. */
+	frameInfo_.remove(info->id);
 }
 
 bool IPU3Frames::tryComplete(IPU3Frames::Info *info)
@@ -111,10 +116,9 @@ bool IPU3Frames::tryComplete(IPU3Frames::Info *info)
 
 IPU3Frames::Info *IPU3Frames::find(unsigned int id)
 {
-	const auto &itInfo = frameInfo_.find(id);
-
-	if (itInfo != frameInfo_.end())
-		return itInfo->second.get();
+	Info *info = frameInfo_.find(id);
+	if (info)
+		return info;
 
 	LOG(IPU3, Fatal) << "Can't find tracking information for frame " << id;
 
@@ -123,17 +127,13 @@ IPU3Frames::Info *IPU3Frames::find(unsigned int id)
 
 IPU3Frames::Info *IPU3Frames::find(FrameBuffer *buffer)
 {
-	for (auto const &itInfo : frameInfo_) {
-		Info *info = itInfo.second.get();
-
-		for (auto const itBuffers : info->request->buffers())
-			if (itBuffers.second == buffer)
-				return info;
-
-		if (info->rawBuffer == buffer || info->paramBuffer == buffer ||
-		    info->statBuffer == buffer)
-			return info;
-	}
+	/*
+	 * All buffers, including the internal raw, parameters and statistics
+	 * buffers, are associated with the request they're used for.
+	 */
+	Info *info = frameInfo_.find(buffer);
+	if (info)
+		return info;
 
 	LOG(IPU3, Fatal) << "Can't find tracking information from buffer";
 
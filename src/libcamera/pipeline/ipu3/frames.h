@@ -7,15 +7,15 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
-#include <queue>
 #include <vector>
 
 #include <libcamera/base/signal.h>
 
 #include <libcamera/controls.h>
 
+#include "libcamera/internal/frame_info_ring.h"
+
 namespace libcamera {
 
 class FrameBuffer;
@@ -58,10 +58,10 @@ public:
 	Signal<> bufferAvailable;
 
 private:
-	std::queue<FrameBuffer *> availableParamBuffers_;
-	std::queue<FrameBuffer *> availableStatBuffers_;
+	std::vector<FrameBuffer *> availableParamBuffers_;
+	std::vector<FrameBuffer *> availableStatBuffers_;
 
-	std::map<unsigned int, std::unique_ptr<Info>> frameInfo_;
+	FrameInfoRing<Info> frameInfo_;
 };
 
 } /* namespace libcamera */
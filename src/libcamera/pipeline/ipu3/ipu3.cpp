@@ -59,6 +59,7 @@ public:
 
 	void imguOutputBufferReady(FrameBuffer *buffer);
 	void cio2BufferReady(FrameBuffer *buffer);
+	void cio2BufferAllocated(FrameBuffer *buffer);
 	void paramBufferReady(FrameBuffer *buffer);
 	void statBufferReady(FrameBuffer *buffer);
 	void queuePendingRequests();
@@ -126,6 +127,7 @@ class PipelineHandlerIPU3 : public PipelineHandler
 public:
 	static constexpr unsigned int V4L2_CID_IPU3_PIPE_MODE = 0x009819c1;
 	static constexpr Size kViewfinderSize{ 1280, 720 };
+	static constexpr unsigned int kMinRawBufferCount = 2;
 
 	enum IPU3PipeModes {
 		IPU3PipeModeVideo = 0,
@@ -689,6 +691,9 @@ int PipelineHandlerIPU3::allocateBuffers(Camera *camera)
 
 	data->ipa_->mapBuffers(ipaBuffers_);
 
+	data->addBuffers(MemoryUsage::Purpose::Parameters, imgu->paramBuffers_);
+	data->addBuffers(MemoryUsage::Purpose::Statistics, imgu->statBuffers_);
+
 	data->frameInfos_.init(imgu->paramBuffers_, imgu->statBuffers_);
 	data->frameInfos_.bufferAvailable.connect(
 		data, &IPU3CameraData::queuePendingRequests);
@@ -709,6 +714,11 @@ int PipelineHandlerIPU3::freeBuffers(Camera *camera)
 	data->ipa_->unmapBuffers(ids);
 	ipaBuffers_.clear();
 
+	data->removeBuffers(MemoryUsage::Purpose::Parameters,
+			    data->imgu_->paramBuffers_);
+	data->removeBuffers(MemoryUsage::Purpose::Statistics,
+			    data->imgu_->statBuffers_);
+
 	data->imgu_->freeBuffers();
 
 	return 0;
@@ -741,8 +751,14 @@ int PipelineHandlerIPU3::start(Camera *camera, [[maybe_unused]] const ControlLis
 	/*
 	 * Start the ImgU video devices, buffers will be queued to the
 	 * ImgU output and viewfinder when requests will be queued.
+	 *
+	 * Requests without a raw buffer wait for an internal CIO2 buffer to be
+	 * available, the number of internal buffers can thus be reduced to
+	 * honour the memory budget.
 	 */
-	ret = cio2->start();
+	ret = cio2->start(data->budgetBufferCount(CIO2Device::kBufferCount,
+						  kMinRawBufferCount,
+						  cio2->bufferSize()));
 	if (ret)
 		goto error;
 
@@ -754,6 +770,8 @@ int PipelineHandlerIPU3::start(Camera *camera, [[maybe_unused]] const ControlLis
 
 error:
 	imgu->stop();
+	/* Undo the raw buffers accounting before cio2->stop() frees them. */
+	data->removeBuffers(MemoryUsage::Purpose::Raw, cio2->buffers());
 	cio2->stop();
 	data->ipa_->stop();
 	freeBuffers(camera);
@@ -772,6 +790,7 @@ void PipelineHandlerIPU3::stopDevice(Camera *camera)
 	data->ipa_->stop();
 
 	ret |= data->imgu_->stop();
+	data->removeBuffers(MemoryUsage::Purpose::Raw, data->cio2_.buffers());
 	ret |= data->cio2_.stop();
 	if (ret)
 		LOG(IPU3, Warning) << "Failed to stop camera " << camera->id();
@@ -1120,6 +1139,8 @@ int PipelineHandlerIPU3::registerCameras()
 					&IPU3CameraData::cio2BufferReady);
 		data->cio2_.bufferAvailable.connect(
 			data.get(), &IPU3CameraData::queuePendingRequests);
+		data->cio2_.bufferAllocated().connect(
+			data.get(), &IPU3CameraData::cio2BufferAllocated);
 		data->imgu_->input_->bufferReady.connect(&data->cio2_,
 					&CIO2Device::tryReturnBuffer);
 		data->imgu_->output_->bufferReady.connect(data.get(),
@@ -1287,6 +1308,15 @@ void IPU3CameraData::imguOutputBufferReady(FrameBuffer *buffer)
 		pipe()->completeRequest(request);
 }
 
+/**
+ * \brief Account for an internal raw buffer allocated by the CIO2
+ * \param[in] buffer The allocated buffer
+ */
+void IPU3CameraData::cio2BufferAllocated(FrameBuffer *buffer)
+{
+	addBuffer(MemoryUsage::Purpose::Raw, buffer);
+}
+
 /**
  * \brief Handle buffers completion at the CIO2 output
  * \param[in] buffer The completed buffer
@@ -35,6 +35,7 @@
 #include "libcamera/internal/camera_sensor.h"
 #include "libcamera/internal/delayed_controls.h"
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/frame_info_ring.h"
 #include "libcamera/internal/framebuffer.h"
 #include "libcamera/internal/ipa_manager.h"
 #include "libcamera/internal/media_device.h"
@@ -69,6 +70,7 @@ class RkISP1Frames
 public:
 	RkISP1Frames(PipelineHandler *pipe);
 
+	void init(unsigned int capacity);
 	RkISP1FrameInfo *create(const RkISP1CameraData *data, Request *request,
 				bool isRaw);
 	int destroy(unsigned int frame);
@@ -80,7 +82,7 @@ public:
 
 private:
 	PipelineHandlerRkISP1 *pipe_;
-	std::map<unsigned int, RkISP1FrameInfo *> frameInfo_;
+	FrameInfoRing<RkISP1FrameInfo> frameInfo_;
 };
 
 class RkISP1CameraData : public Camera::Private
@@ -156,6 +158,7 @@ public:
 
 	int start(Camera *camera, const ControlList *controls) override;
 	void stopDevice(Camera *camera) override;
+	int reconfigureDevice(Camera *camera, CameraConfiguration *config) override;
 
 	int queueRequestDevice(Camera *camera, Request *request) override;
 
@@ -183,6 +186,7 @@ private:
 
 	int allocateBuffers(Camera *camera);
 	int freeBuffers(Camera *camera);
+	void stopStreaming(Camera *camera);
 
 	MediaDevice *media_;
 	std::unique_ptr<V4L2Subdevice> isp_;
@@ -211,6 +215,11 @@ RkISP1Frames::RkISP1Frames(PipelineHandler *pipe)
 {
 }
 
+void RkISP1Frames::init(unsigned int capacity)
+{
+	frameInfo_.reset(capacity);
+}
+
 RkISP1FrameInfo *RkISP1Frames::create(const RkISP1CameraData *data, Request *request,
 				      bool isRaw)
 {
@@ -235,12 +244,16 @@ RkISP1FrameInfo *RkISP1Frames::create(const RkISP1CameraData *data, Request *req
 
 		statBuffer = pipe_->availableStatBuffers_.front();
 		pipe_->availableStatBuffers_.pop();
+
+		/* Associate the buffers with the request for find(). */
+		paramBuffer->_d()->setRequest(request);
+		statBuffer->_d()->setRequest(request);
 	}
 
 	FrameBuffer *mainPathBuffer = request->findBuffer(&data->mainPathStream_);
 	FrameBuffer *selfPathBuffer = request->findBuffer(&data->selfPathStream_);
 
-	RkISP1FrameInfo *info = new RkISP1FrameInfo;
+	RkISP1FrameInfo *info = frameInfo_.create(frame, request);
 
 	info->frame = frame;
 	info->request = request;
@@ -251,8 +264,6 @@ RkISP1FrameInfo *RkISP1Frames::create(const RkISP1CameraData *data, Request *req
 	info->paramDequeued = false;
 	info->metadataProcessed = false;
 
-	frameInfo_[frame] = info;
-
 	return info;
 }
 
@@ -265,33 +276,26 @@ int RkISP1Frames::destroy(unsigned int frame)
 	pipe_->availableParamBuffers_.push(info->paramBuffer);
 	pipe_->availableStatBuffers_.push(info->statBuffer);
 
-	frameInfo_.erase(info->frame);
-
-	delete info;
+	frameInfo_.remove(info->frame);
 
 	return 0;
 }
 
 void RkISP1Frames::clear()
 {
-	for (const auto &entry : frameInfo_) {
-		RkISP1FrameInfo *info = entry.second;
-
-		pipe_->availableParamBuffers_.push(info->paramBuffer);
-		pipe_->availableStatBuffers_.push(info->statBuffer);
-
-		delete info;
-	}
+	frameInfo_.forEach([&](RkISP1FrameInfo &info) {
+		pipe_->availableParamBuffers_.push(info.paramBuffer);
+		pipe_->availableStatBuffers_.push(info.statBuffer);
+	});
 
-	frameInfo_.clear();
+	frameInfo_.reset(frameInfo_.capacity());
 }
 
 RkISP1FrameInfo *RkISP1Frames::find(unsigned int frame)
 {
-	auto itInfo = frameInfo_.find(frame);
-
-	if (itInfo != frameInfo_.end())
-		return itInfo->second;
+	RkISP1FrameInfo *info = frameInfo_.find(frame);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from frame";
 
@@ -300,15 +304,9 @@ RkISP1FrameInfo *RkISP1Frames::find(unsigned int frame)
 
 RkISP1FrameInfo *RkISP1Frames::find(FrameBuffer *buffer)
 {
-	for (auto &itInfo : frameInfo_) {
-		RkISP1FrameInfo *info = itInfo.second;
-
-		if (info->paramBuffer == buffer ||
-		    info->statBuffer == buffer ||
-		    info->mainPathBuffer == buffer ||
-		    info->selfPathBuffer == buffer)
-			return info;
-	}
+	RkISP1FrameInfo *info = frameInfo_.find(buffer);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from buffer";
 
@@ -317,12 +315,9 @@ RkISP1FrameInfo *RkISP1Frames::find(FrameBuffer *buffer)
 
 RkISP1FrameInfo *RkISP1Frames::find(Request *request)
 {
-	for (auto &itInfo : frameInfo_) {
-		RkISP1FrameInfo *info = itInfo.second;
-
-		if (info->request == request)
-			return info;
-	}
+	RkISP1FrameInfo *info = frameInfo_.find(request);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from request";
 
@@ -799,17 +794,24 @@ int PipelineHandlerRkISP1::configure(Camera *camera, CameraConfiguration *c)
 			return ret;
 	}
 
-	V4L2DeviceFormat paramFormat;
-	paramFormat.fourcc = V4L2PixelFormat(V4L2_META_FMT_RK_ISP1_PARAMS);
-	ret = param_->setFormat(&paramFormat);
-	if (ret)
-		return ret;
+	/*
+	 * The parameters and statistics formats never change. Skip them when
+	 * the buffers have been kept across a reconfiguration, as the format
+	 * can't be set while buffers are allocated.
+	 */
+	if (paramBuffers_.empty()) {
+		V4L2DeviceFormat paramFormat;
+		paramFormat.fourcc = V4L2PixelFormat(V4L2_META_FMT_RK_ISP1_PARAMS);
+		ret = param_->setFormat(&paramFormat);
+		if (ret)
+			return ret;
 
-	V4L2DeviceFormat statFormat;
-	statFormat.fourcc = V4L2PixelFormat(V4L2_META_FMT_RK_ISP1_STAT_3A);
-	ret = stat_->setFormat(&statFormat);
-	if (ret)
-		return ret;
+		V4L2DeviceFormat statFormat;
+		statFormat.fourcc = V4L2PixelFormat(V4L2_META_FMT_RK_ISP1_STAT_3A);
+		ret = stat_->setFormat(&statFormat);
+		if (ret)
+			return ret;
+	}
 
 	/* Inform IPA of stream configuration and sensor controls. */
 	ipa::rkisp1::IPAConfigInfo ipaConfig{};
@@ -853,6 +855,14 @@ int PipelineHandlerRkISP1::allocateBuffers(Camera *camera)
 		data->selfPathStream_.configuration().bufferCount,
 	});
 
+	/* Reuse the buffers kept across a reconfiguration if possible. */
+	if (!paramBuffers_.empty()) {
+		if (!isRaw_ && paramBuffers_.size() == maxCount)
+			return 0;
+
+		freeBuffers(camera);
+	}
+
 	if (!isRaw_) {
 		ret = param_->allocateBuffers(maxCount, &paramBuffers_);
 		if (ret < 0)
@@ -863,6 +873,9 @@ int PipelineHandlerRkISP1::allocateBuffers(Camera *camera)
 			goto error;
 	}
 
+	data->addBuffers(MemoryUsage::Purpose::Parameters, paramBuffers_);
+	data->addBuffers(MemoryUsage::Purpose::Statistics, statBuffers_);
+
 	for (std::unique_ptr<FrameBuffer> &buffer : paramBuffers_) {
 		buffer->setCookie(ipaBufferId++);
 		data->ipaBuffers_.emplace_back(buffer->cookie(),
@@ -879,6 +892,13 @@ int PipelineHandlerRkISP1::allocateBuffers(Camera *camera)
 
 	data->ipa_->mapBuffers(data->ipaBuffers_);
 
+	/*
+	 * Size the frame information ring for the number of parameters and
+	 * statistics buffers, which bounds the number of requests in flight.
+	 * In raw mode the ring grows if more requests are queued.
+	 */
+	data->frameInfo_.init(maxCount);
+
 	return 0;
 
 error:
@@ -898,6 +918,9 @@ int PipelineHandlerRkISP1::freeBuffers(Camera *camera)
 	while (!availableParamBuffers_.empty())
 		availableParamBuffers_.pop();
 
+	data->removeBuffers(MemoryUsage::Purpose::Parameters, paramBuffers_);
+	data->removeBuffers(MemoryUsage::Purpose::Statistics, statBuffers_);
+
 	paramBuffers_.clear();
 	statBuffers_.clear();
 
@@ -987,7 +1010,7 @@ int PipelineHandlerRkISP1::start(Camera *camera, [[maybe_unused]] const ControlL
 	return ret;
 }
 
-void PipelineHandlerRkISP1::stopDevice(Camera *camera)
+void PipelineHandlerRkISP1::stopStreaming(Camera *camera)
 {
 	RkISP1CameraData *data = cameraData(camera);
 	int ret;
@@ -1015,9 +1038,29 @@ void PipelineHandlerRkISP1::stopDevice(Camera *camera)
 	ASSERT(data->queuedRequests_.empty());
 	data->frameInfo_.clear();
 
+	activeCamera_ = nullptr;
+}
+
+void PipelineHandlerRkISP1::stopDevice(Camera *camera)
+{
+	stopStreaming(camera);
 	freeBuffers(camera);
+}
 
-	activeCamera_ = nullptr;
+int PipelineHandlerRkISP1::reconfigureDevice(Camera *camera, CameraConfiguration *c)
+{
+	/*
+	 * Keep the parameters and statistics buffers allocated and mapped to
+	 * the IPA, start() reuses them if the new configuration requires the
+	 * same number of buffers.
+	 */
+	stopStreaming(camera);
+
+	int ret = configure(camera, c);
+	if (ret)
+		freeBuffers(camera);
+
+	return ret;
 }
 
 int PipelineHandlerRkISP1::queueRequestDevice(Camera *camera, Request *request)
@@ -978,6 +978,12 @@ void CameraData::freeBuffers()
 		bufferIds_.clear();
 	}
 
+	for (auto const &[stream, purpose] : internalBufferStreams_) {
+		stream->internalBufferAllocated()->disconnect(this);
+		removeBuffers(purpose, stream->internalBuffers());
+	}
+	internalBufferStreams_.clear();
+
 	for (auto const stream : streams_)
 		stream->releaseBuffers();
 
@@ -986,6 +992,34 @@ void CameraData::freeBuffers()
 	buffersAllocated_ = false;
 }
 
+unsigned int CameraData::budgetInternalBuffers(Stream *stream, unsigned int count,
+					       unsigned int minCount) const
+{
+	V4L2DeviceFormat format;
+	if (stream->dev()->getFormat(&format))
+		return count;
+
+	std::size_t size = 0;
+	for (unsigned int i = 0; i < format.planesCount; i++)
+		size += format.planes[i].size;
+
+	return budgetBufferCount(count, minCount, size);
+}
+
+void CameraData::addInternalBuffers(Stream *stream, MemoryUsage::Purpose purpose)
+{
+	Signal<FrameBuffer *> *allocated = stream->internalBufferAllocated();
+	if (!allocated)
+		return;
+
+	/* Account for the buffers allocated now, and for those allocated later. */
+	addBuffers(purpose, stream->internalBuffers());
+	allocated->connect(this, [this, purpose](FrameBuffer *buffer) {
+		addBuffer(purpose, buffer);
+	});
+	internalBufferStreams_.emplace_back(stream, purpose);
+}
+
 /*
  * enumerateVideoDevices() iterates over the Media Controller topology, starting
  * at the sensor and finishing at the frontend. For each sensor, CameraData stores
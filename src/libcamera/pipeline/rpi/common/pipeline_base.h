@@ -68,6 +68,10 @@ public:
 	void freeBuffers();
 	virtual void platformFreeBuffers() = 0;
 
+	unsigned int budgetInternalBuffers(Stream *stream, unsigned int count,
+					   unsigned int minCount) const;
+	void addInternalBuffers(Stream *stream, MemoryUsage::Purpose purpose);
+
 	void enumerateVideoDevices(MediaLink *link, const std::string &frontend);
 
 	int loadPipelineConfiguration();
@@ -147,6 +151,8 @@ public:
 
 	/* Have internal buffers been allocated? */
 	bool buffersAllocated_;
+	/* Streams whose internal buffers are recorded in the memory usage. */
+	std::vector<std::pair<Stream *, MemoryUsage::Purpose>> internalBufferStreams_;
 
 	struct Config {
 		/*
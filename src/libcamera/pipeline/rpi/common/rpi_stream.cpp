@@ -71,7 +71,7 @@ void Stream::resetBuffers()
 {
 	/* Add all internal buffers to the queue of usable buffers. */
 	availableBuffers_ = {};
-	for (auto const &buffer : internalBuffers_)
+	for (auto const &buffer : internalBuffers())
 		availableBuffers_.push(buffer.get());
 }
 
@@ -106,18 +106,38 @@ void Stream::setExportedBuffer(FrameBuffer *buffer)
 	bufferEmplace(++id_, buffer);
 }
 
+const std::vector<std::unique_ptr<FrameBuffer>> &Stream::internalBuffers() const
+{
+	static const std::vector<std::unique_ptr<FrameBuffer>> empty;
+
+	return pool_ ? pool_->buffers() : empty;
+}
+
+Signal<FrameBuffer *> *Stream::internalBufferAllocated()
+{
+	return pool_ ? &pool_->bufferAllocated : nullptr;
+}
+
 int Stream::prepareBuffers(unsigned int count)
 {
 	int ret;
 
 	if (!(flags_ & StreamFlag::ImportOnly)) {
-		/* Export some frame buffers for internal use. */
-		ret = dev_->exportBuffers(count, &internalBuffers_);
+		/*
+		 * Export some frame buffers for internal use. Internal buffers
+		 * of external streams are only used when a Request doesn't
+		 * provide a buffer, so start with a single one and allocate
+		 * the rest on demand.
+		 */
+		unsigned int initialCount = flags_ & StreamFlag::External
+					  ? std::min(count, 1U) : count;
+		ret = pool_->allocate(dev_.get(), initialCount, count);
 		if (ret < 0)
 			return ret;
 
 		/* Add these exported buffers to the internal/external buffer list. */
-		setExportedBuffers(&internalBuffers_);
+		for (auto const &buffer : pool_->buffers())
+			bufferEmplace(++id_, buffer.get());
 		resetBuffers();
 	}
 
@@ -132,7 +152,7 @@ int Stream::queueBuffer(FrameBuffer *buffer)
 	 * availableBuffers_ queue.
 	 */
 	if (!buffer) {
-		if (availableBuffers_.empty()) {
+		if (availableBuffers_.empty() && !allocateInternalBuffer()) {
 			LOG(RPISTREAM, Debug) << "No buffers available for "
 					      << name_;
 			/*
@@ -214,7 +234,7 @@ const BufferObject &Stream::getBuffer(unsigned int id)
 const BufferObject &Stream::acquireBuffer()
 {
 	/* No id provided, so pick up the next available buffer if possible. */
-	if (availableBuffers_.empty())
+	if (availableBuffers_.empty() && !allocateInternalBuffer())
 		return errorBufferObject;
 
 	unsigned int id = getBufferId(availableBuffers_.front());
@@ -257,11 +277,27 @@ void Stream::bufferEmplace(unsigned int id, FrameBuffer *buffer)
 				   std::forward_as_tuple(buffer, false));
 }
 
+bool Stream::allocateInternalBuffer()
+{
+	if (!pool_)
+		return false;
+
+	FrameBuffer *buffer = pool_->allocateBuffer();
+	if (!buffer)
+		return false;
+
+	bufferEmplace(++id_, buffer);
+	availableBuffers_.push(buffer);
+
+	return true;
+}
+
 void Stream::clearBuffers()
 {
 	availableBuffers_ = std::queue<FrameBuffer *>{};
 	requestBuffers_ = std::queue<FrameBuffer *>{};
-	internalBuffers_.clear();
+	if (pool_)
+		pool_->release();
 	bufferMap_.clear();
 	id_ = 0;
 }
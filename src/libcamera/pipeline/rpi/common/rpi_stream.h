@@ -14,10 +14,12 @@
 #include <vector>
 
 #include <libcamera/base/flags.h>
+#include <libcamera/base/signal.h>
 #include <libcamera/base/utils.h>
 
 #include <libcamera/stream.h>
 
+#include "libcamera/internal/internal_buffer_pool.h"
 #include "libcamera/internal/mapped_framebuffer.h"
 #include "libcamera/internal/v4l2_videodevice.h"
 
@@ -101,6 +103,9 @@ public:
 		  dev_(std::make_unique<V4L2VideoDevice>(dev)), id_(0),
 		  swDownscale_(0)
 	{
+		if (!(flags_ & StreamFlag::ImportOnly))
+			pool_ = std::make_unique<InternalBufferPool>(name_,
+								     DmaBufAllocator::DmaBufAllocatorFlag::CmaHeap);
 	}
 
 	void setFlags(StreamFlags flags);
@@ -119,6 +124,8 @@ public:
 	unsigned int getBufferId(FrameBuffer *buffer) const;
 
 	void setExportedBuffer(FrameBuffer *buffer);
+	const std::vector<std::unique_ptr<FrameBuffer>> &internalBuffers() const;
+	Signal<FrameBuffer *> *internalBufferAllocated();
 
 	int prepareBuffers(unsigned int count);
 	int queueBuffer(FrameBuffer *buffer);
@@ -135,6 +142,7 @@ public:
 
 private:
 	void bufferEmplace(unsigned int id, FrameBuffer *buffer);
+	bool allocateInternalBuffer();
 	void clearBuffers();
 	int queueToDevice(FrameBuffer *buffer);
 
@@ -173,10 +181,11 @@ private:
 	std::queue<FrameBuffer *> requestBuffers_;
 
 	/*
-	 * This is a list of buffers exported internally. Need to keep this around
-	 * as the stream needs to maintain ownership of these buffers.
+	 * Pool of buffers exported internally. The stream needs to maintain
+	 * ownership of these buffers. For external streams, the buffers are
+	 * allocated on demand when a Request doesn't provide one.
 	 */
-	std::vector<std::unique_ptr<FrameBuffer>> internalBuffers_;
+	std::unique_ptr<InternalBufferPool> pool_;
 };
 
 /*
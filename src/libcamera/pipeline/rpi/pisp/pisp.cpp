@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <array>
 #include <fstream>
 #include <memory>
 #include <mutex>
@@ -26,6 +27,8 @@
 #include <libcamera/formats.h>
 
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/post_processing/downscale.h"
 #include "libcamera/internal/shared_mem_object.h"
 
 #include "libpisp/backend/backend.hpp"
@@ -416,72 +419,6 @@ void downscaleInterleaved3(void *mem, unsigned int height, unsigned int src_widt
 	}
 }
 
-void downscaleInterleaved4(void *mem, unsigned int height, unsigned int src_width,
-			   unsigned int stride)
-{
-	std::vector<uint8_t> incache(4 * src_width);
-	unsigned int dst_width = src_width / 2;
-	std::vector<uint8_t> outcache(4 * dst_width);
-
-	memcpy(incache.data(), mem, 4 * src_width);
-	for (unsigned int j = 0; j < height; j++) {
-		uint8_t *ptr = (uint8_t *)mem + j * stride;
-
-		uint8_t *src = incache.data(), *dst = outcache.data();
-		for (unsigned int i = 0; i < dst_width; i++, src += 8, dst += 4) {
-			dst[0] = ((int)src[0] + (int)src[4] + 1) >> 1;
-			dst[1] = ((int)src[1] + (int)src[5] + 1) >> 1;
-			dst[2] = ((int)src[2] + (int)src[6] + 1) >> 1;
-			dst[3] = ((int)src[3] + (int)src[7] + 1) >> 1;
-		}
-
-		if (j < height - 1)
-			memcpy(incache.data(), ptr + stride, 4 * src_width);
-		memcpy(ptr, outcache.data(), 4 * dst_width);
-	}
-}
-
-void downscalePlaneInternal(void *mem, unsigned int height, unsigned int src_width,
-			    unsigned int stride, std::vector<uint8_t> &incache,
-			    std::vector<uint8_t> &outcache)
-{
-	unsigned int dst_width = src_width / 2;
-	memcpy(incache.data(), mem, src_width);
-	for (unsigned int j = 0; j < height; j++) {
-		uint8_t *ptr = (uint8_t *)mem + j * stride;
-
-		uint8_t *src = incache.data(), *dst = outcache.data();
-		for (unsigned int i = 0; i < dst_width; i++, src += 2, dst++)
-			*dst = ((int)src[0] + (int)src[1] + 1) >> 1;
-
-		if (j < height - 1)
-			memcpy(incache.data(), ptr + stride, src_width);
-		memcpy(ptr, outcache.data(), dst_width);
-	}
-}
-
-void downscalePlanar420(void *memY, void *memU, void *memV, unsigned int height,
-			unsigned int src_width, unsigned int stride)
-{
-	std::vector<uint8_t> incache(src_width);
-	std::vector<uint8_t> outcache(src_width / 2);
-
-	downscalePlaneInternal(memY, height, src_width, stride, incache, outcache);
-	downscalePlaneInternal(memU, height / 2, src_width / 2, stride / 2, incache, outcache);
-	downscalePlaneInternal(memV, height / 2, src_width / 2, stride / 2, incache, outcache);
-}
-
-void downscalePlanar422(void *memY, void *memU, void *memV,
-			unsigned int height, unsigned int src_width, unsigned int stride)
-{
-	std::vector<uint8_t> incache(src_width);
-	std::vector<uint8_t> outcache(src_width / 2);
-
-	downscalePlaneInternal(memY, height, src_width, stride, incache, outcache);
-	downscalePlaneInternal(memU, height, src_width / 2, stride / 2, incache, outcache);
-	downscalePlaneInternal(memV, height, src_width / 2, stride / 2, incache, outcache);
-}
-
 void downscaleInterleavedYuyv(void *mem, unsigned int height, unsigned int src_width,
 			      unsigned int stride)
 {
@@ -532,39 +469,33 @@ void downscaleInterleavedUyvy(void *mem, unsigned int height, unsigned int src_w
 	}
 }
 
-void downscaleInterleaved2Internal(void *mem, unsigned int height, unsigned int src_width,
-				   unsigned int stride, std::vector<uint8_t> &incache,
-				   std::vector<uint8_t> &outcache)
+void downscaleInPlace(DownscaleStage *stage, const RPi::BufferObject &b,
+		      const StreamConfiguration &cfg)
 {
-	unsigned int dst_width = src_width / 2;
-	memcpy(incache.data(), mem, 2 * src_width);
-	for (unsigned int j = 0; j < height; j++) {
-		uint8_t *ptr = (uint8_t *)mem + j * stride;
+	/* These may look like either single or multi-planar buffers. */
+	const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+	std::array<Span<uint8_t>, 3> planes;
 
-		uint8_t *src = incache.data(), *dst = outcache.data();
-		for (unsigned int i = 0; i < dst_width; i++, src += 4, dst += 2) {
-			dst[0] = ((int)src[0] + (int)src[2] + 1) >> 1;
-			dst[1] = ((int)src[1] + (int)src[3] + 1) >> 1;
-		}
+	if (b.mapped->planes().size() == info.numPlanes()) {
+		std::copy(b.mapped->planes().begin(), b.mapped->planes().end(),
+			  planes.begin());
+	} else {
+		uint8_t *mem = b.mapped->planes()[0].data();
 
-		if (j < height - 1)
-			memcpy(incache.data(), ptr + stride, 2 * src_width);
-		memcpy(ptr, outcache.data(), 2 * dst_width);
-	}
-}
+		for (unsigned int i = 0; i < info.numPlanes(); i++) {
+			unsigned int stride = PostProcessingStage::planeStride(cfg, i);
+			unsigned int size = info.planeSize(cfg.size.height, i, stride);
 
-void downscaleSemiPlanar420(void *memY, void *memUV, unsigned int height,
-			    unsigned int src_width, unsigned int stride)
-{
-	std::vector<uint8_t> incache(src_width);
-	std::vector<uint8_t> outcache(src_width / 2);
+			planes[i] = { mem, size };
+			mem += size;
+		}
+	}
 
-	downscalePlaneInternal(memY, height, src_width, stride, incache, outcache);
-	downscaleInterleaved2Internal(memUV, height / 2, src_width / 2, stride,
-				      incache, outcache);
+	Span<const Span<uint8_t>> frame(planes.data(), info.numPlanes());
+	stage->process(frame, frame);
 }
 
-void downscaleStreamBuffer(RPi::Stream *stream, int index)
+void downscaleStreamBuffer(RPi::Stream *stream, int index, DownscaleStage *stage)
 {
 	unsigned int downscale = stream->swDownscale();
 	/* Must be a power of 2. */
@@ -575,59 +506,32 @@ void downscaleStreamBuffer(RPi::Stream *stream, int index)
 	unsigned int height = stream->configuration().size.height;
 	const PixelFormat &pixFormat = stream->configuration().pixelFormat;
 	const RPi::BufferObject &b = stream->getBuffer(index);
-	void *mem = b.mapped->planes()[0].data();
 	ASSERT(b.mapped);
+	void *mem = b.mapped->planes()[0].data();
+
+	/*
+	 * The RGB, planar and semi-planar YUV formats are downscaled in a
+	 * single pass by the stage created at configure time.
+	 */
+	if (stage) {
+		downscaleInPlace(stage, b, stream->configuration());
+		return;
+	}
+
+	/* On some devices these may actually be 24bpp at this point. */
+	bool is24bpp = (pixFormat == formats::XRGB8888 || pixFormat == formats::XBGR8888) &&
+		       (stream->getFlags() & StreamFlag::Needs32bitConv);
 
 	/* Do repeated downscale-by-2 in place until we're done. */
 	for (; downscale > 1; downscale >>= 1) {
 		unsigned int src_width = downscale * dst_width;
 
-		if (pixFormat == formats::RGB888 || pixFormat == formats::BGR888) {
+		if (is24bpp) {
 			downscaleInterleaved3(mem, height, src_width, stride);
-		} else if (pixFormat == formats::XRGB8888 || pixFormat == formats::XBGR8888) {
-			/* On some devices these may actually be 24bpp at this point. */
-			if (stream->getFlags() & StreamFlag::Needs32bitConv)
-				downscaleInterleaved3(mem, height, src_width, stride);
-			else
-				downscaleInterleaved4(mem, height, src_width, stride);
-		} else if (pixFormat == formats::YUV420 || pixFormat == formats::YVU420) {
-			/* These may look like either single or multi-planar buffers. */
-			void *mem1;
-			void *mem2;
-			if (b.mapped->planes().size() == 3) {
-				mem1 = b.mapped->planes()[1].data();
-				mem2 = b.mapped->planes()[2].data();
-			} else {
-				unsigned int ySize = height * stride;
-				mem1 = static_cast<uint8_t *>(mem) + ySize;
-				mem2 = static_cast<uint8_t *>(mem1) + ySize / 4;
-			}
-			downscalePlanar420(mem, mem1, mem2, height, src_width, stride);
-		} else if (pixFormat == formats::YUV422 || pixFormat == formats::YVU422) {
-			/* These may look like either single or multi-planar buffers. */
-			void *mem1;
-			void *mem2;
-			if (b.mapped->planes().size() == 3) {
-				mem1 = b.mapped->planes()[1].data();
-				mem2 = b.mapped->planes()[2].data();
-			} else {
-				unsigned int ySize = height * stride;
-				mem1 = static_cast<uint8_t *>(mem) + ySize;
-				mem2 = static_cast<uint8_t *>(mem1) + ySize / 2;
-			}
-			downscalePlanar422(mem, mem1, mem2, height, src_width, stride);
 		} else if (pixFormat == formats::YUYV || pixFormat == formats::YVYU) {
 			downscaleInterleavedYuyv(mem, height, src_width, stride);
 		} else if (pixFormat == formats::UYVY || pixFormat == formats::VYUY) {
 			downscaleInterleavedUyvy(mem, height, src_width, stride);
-		} else if (pixFormat == formats::NV12 || pixFormat == formats::NV21) {
-			/* These may look like either single or multi-planar buffers. */
-			void *mem1;
-			if (b.mapped->planes().size() == 2)
-				mem1 = b.mapped->planes()[1].data();
-			else
-				mem1 = static_cast<uint8_t *>(mem) + height * stride;
-			downscaleSemiPlanar420(mem, mem1, height, src_width, stride);
 		} else {
 			LOG(RPI, Error) << "Sw downscale unsupported for " << pixFormat;
 			ASSERT(0);
@@ -746,6 +650,9 @@ public:
 	std::unique_ptr<V4L2Subdevice> csi2Subdev_;
 	std::unique_ptr<V4L2Subdevice> feSubdev_;
 
+	/* In-place software downscalers of the ISP output streams. */
+	std::unordered_map<const RPi::Stream *, std::unique_ptr<DownscaleStage>> swDownscalers_;
+
 	std::vector<FrameBuffer *> tdnBuffers_;
 	std::vector<FrameBuffer *> stitchBuffers_;
 	unsigned int tdnInputIndex_;
@@ -916,6 +823,10 @@ bool PipelineHandlerPiSP::match(DeviceEnumerator *enumerator)
 				break;
 			}
 
+			pisp->addMemory(MemoryUsage::Purpose::Processing,
+					MemoryUsage::Type::SharedMemory,
+					pisp->fe_.mem().size() + pisp->be_.mem().size());
+
 			int ret = registerCamera(cameraData, cfeDevice, "csi2",
 						 ispDevice, entity);
 			if (ret)
@@ -947,6 +858,7 @@ int PipelineHandlerPiSP::prepareBuffers(Camera *camera)
 
 	/* Decide how many internal buffers to allocate. */
 	for (auto const stream : data->streams_) {
+		MemoryUsage::Purpose purpose = MemoryUsage::Purpose::Processing;
 		unsigned int numBuffers;
 		/*
 		 * For CFE, allocate a minimum of 4 buffers as we want
@@ -958,9 +870,12 @@ int PipelineHandlerPiSP::prepareBuffers(Camera *camera)
 			 * If an application has configured a RAW stream, allocate
 			 * additional buffers to make up the minimum, but ensure
 			 * we have at least 2 sets of internal buffers to use to
-			 * minimise frame drops.
+			 * minimise frame drops, unless the memory budget
+			 * requires going down to a single buffer.
 			 */
 			numBuffers = std::max<int>(2, minBuffers - numRawBuffers);
+			numBuffers = data->budgetInternalBuffers(stream, numBuffers, 1);
+			purpose = MemoryUsage::Purpose::Raw;
 		} else if (stream == &data->isp_[Isp::Input]) {
 			/*
 			 * ISP input buffers are imported from the CFE, so follow
@@ -975,9 +890,13 @@ int PipelineHandlerPiSP::prepareBuffers(Camera *camera)
 			 * so allocate a reasonably large amount.
 			 */
 			numBuffers = 12;
+			purpose = MemoryUsage::Purpose::EmbeddedData;
 		} else if (stream == &data->cfe_[Cfe::Stats] ||
 			   stream == &data->cfe_[Cfe::Config]) {
 			numBuffers = data->config_.numCfeConfigStatsBuffers;
+			purpose = stream == &data->cfe_[Cfe::Stats]
+				? MemoryUsage::Purpose::Statistics
+				: MemoryUsage::Purpose::Parameters;
 		} else if (!data->beEnabled_) {
 			/* Backend not enabled, we don't need to allocate buffers. */
 			numBuffers = 0;
@@ -998,6 +917,8 @@ int PipelineHandlerPiSP::prepareBuffers(Camera *camera)
 		ret = stream->prepareBuffers(numBuffers);
 		if (ret < 0)
 			return ret;
+
+		data->addInternalBuffers(stream, purpose);
 	}
 
 	/*
@@ -1469,6 +1390,7 @@ int PiSPCameraData::platformConfigure(const RPi::RPiCameraConfiguration *rpiConf
 		       [this] (const RPi::Stream *s) { return s == &isp_[Isp::Output0] ||
 							      s == &isp_[Isp::Output1]; }),
 		       streams_.end());
+	swDownscalers_.clear();
 
 	for (unsigned int i = 0; i < outStreams.size(); i++) {
 		StreamConfiguration *cfg = outStreams[i].cfg;
@@ -1531,6 +1453,33 @@ int PiSPCameraData::platformConfigure(const RPi::RPiCameraConfiguration *rpiConf
 		stream->setFlags(flags);
 		stream->setSwDownscale(swDownscale);
 		streams_.push_back(stream);
+
+		/*
+		 * Create the software downscaler once here, as it allocates
+		 * memory when configured. The ISP output is wider than the
+		 * stream by the downscale factor, with the same stride. The
+		 * stage reads each input line before writing the corresponding
+		 * output line, so it processes the buffer in place. 24bpp data
+		 * in XRGB buffers is left to the legacy halving code.
+		 */
+		if (swDownscale > 1 && DownscaleStage::isSupported(cfg->pixelFormat) &&
+		    !needs32BitConversion) {
+			StreamConfiguration outputCfg = *cfg;
+			outputCfg.stride = format.planes[0].bpl;
+
+			StreamConfiguration inputCfg = outputCfg;
+			inputCfg.size.width = hwWidth;
+
+			auto stage = std::make_unique<DownscaleStage>();
+			ret = stage->configure(inputCfg, outputCfg);
+			if (ret) {
+				LOG(RPI, Error) << "Sw downscale unsupported for "
+						<< outputCfg.toString();
+				return ret;
+			}
+
+			swDownscalers_[stream] = std::move(stage);
+		}
 	}
 
 	pisp_be_global_config global;
@@ -1754,7 +1703,9 @@ void PiSPCameraData::beOutputDequeue(FrameBuffer *buffer)
 
 	if (downscale) {
 		/* Further software downscaling must be applied. */
-		downscaleStreamBuffer(stream, index);
+		auto it = swDownscalers_.find(stream);
+		downscaleStreamBuffer(stream, index,
+				      it != swDownscalers_.end() ? it->second.get() : nullptr);
 	}
 
 	/* Convert 24bpp outputs to 32bpp outputs where necessary. */
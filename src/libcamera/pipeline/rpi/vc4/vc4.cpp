@@ -271,6 +271,7 @@ int PipelineHandlerVc4::prepareBuffers(Camera *camera)
 
 	/* Decide how many internal buffers to allocate. */
 	for (auto const stream : data->streams_) {
+		MemoryUsage::Purpose purpose = MemoryUsage::Purpose::Processing;
 		unsigned int numBuffers;
 		/*
 		 * For Unicam, allocate a minimum number of buffers for internal
@@ -282,9 +283,20 @@ int PipelineHandlerVc4::prepareBuffers(Camera *camera)
 			 * additional buffers to make up the minimum, but ensure
 			 * we have at least minUnicamBuffers of internal buffers
 			 * to use to minimise frame drops.
+			 *
+			 * Requests wait for an internal buffer when none is
+			 * available, so scale the number of buffers down to a
+			 * single one if needed to honour the memory budget.
+			 * The min_unicam_buffers and min_total_unicam_buffers
+			 * options can both be 0, in which case no internal
+			 * buffer is needed and none is forced by the budget.
 			 */
 			numBuffers = std::max<int>(minUnicamBuffers,
 						   minTotalUnicamBuffers - numRawBuffers);
+			const unsigned int minBuffers = numBuffers ? 1 : 0;
+			numBuffers = data->budgetInternalBuffers(stream, numBuffers,
+								 minBuffers);
+			purpose = MemoryUsage::Purpose::Raw;
 			LOG(RPI, Debug) << "Unicam::Image numBuffers " << numBuffers;
 		} else if (stream == &data->isp_[Isp::Input]) {
 			/*
@@ -314,6 +326,7 @@ int PipelineHandlerVc4::prepareBuffers(Camera *camera)
 			 * buffers, as these will be recycled quicker.
 			 */
 			numBuffers = 12;
+			purpose = MemoryUsage::Purpose::EmbeddedData;
 		} else if (stream == &data->isp_[Isp::Output0]) {
 			/* Buffer count for this is handled in the earlier loop above. */
 			numBuffers = minIspBuffers;
@@ -325,6 +338,8 @@ int PipelineHandlerVc4::prepareBuffers(Camera *camera)
 			 * for colour denoise) and ISP statistics.
 			 */
 			numBuffers = 1;
+			if (stream == &data->isp_[Isp::Stats])
+				purpose = MemoryUsage::Purpose::Statistics;
 			LOG(RPI, Debug) << "Other numBuffers " << numBuffers;
 		}
 
@@ -334,6 +349,8 @@ int PipelineHandlerVc4::prepareBuffers(Camera *camera)
 		ret = stream->prepareBuffers(numBuffers);
 		if (ret < 0)
 			return ret;
+
+		data->addInternalBuffers(stream, purpose);
 	}
 
 	/*
@@ -355,6 +372,18 @@ int PipelineHandlerVc4::platformRegister(std::unique_ptr<RPi::CameraData> &camer
 	if (!data->dmaHeap_.isValid())
 		return -ENOMEM;
 
+	/*
+	 * Allocate the lens shading table once for the lifetime of the camera,
+	 * and account for it here. It is shared with the IPA at every
+	 * configuration.
+	 */
+	data->lsTable_ = SharedFD(data->dmaHeap_.alloc("ls_grid", ipa::RPi::MaxLsGridSize));
+	if (!data->lsTable_.isValid())
+		return -ENOMEM;
+
+	data->addMemory(MemoryUsage::Purpose::Parameters,
+			MemoryUsage::Type::DmaBuf, ipa::RPi::MaxLsGridSize);
+
 	MediaEntity *unicamImage = unicam->getEntityByName("unicam-image");
 	MediaEntity *ispOutput0 = isp->getEntityByName("bcm2835-isp0-output0");
 	MediaEntity *ispCapture1 = isp->getEntityByName("bcm2835-isp0-capture1");
@@ -768,19 +797,12 @@ int Vc4CameraData::platformConfigureIpa(ipa::RPi::ConfigParams &params)
 {
 	params.ispControls = isp_[Isp::Input].dev()->controls();
 
-	/* Allocate the lens shading table via dmaHeap and pass to the IPA. */
-	if (!lsTable_.isValid()) {
-		lsTable_ = SharedFD(dmaHeap_.alloc("ls_grid", ipa::RPi::MaxLsGridSize));
-		if (!lsTable_.isValid())
-			return -ENOMEM;
-
-		/* Allow the IPA to mmap the LS table via the file descriptor. */
-		/*
-		 * \todo Investigate if mapping the lens shading table buffer
-		 * could be handled with mapBuffers().
-		 */
-		params.lsTableHandle = lsTable_;
-	}
+	/* Allow the IPA to mmap the LS table via the file descriptor. */
+	/*
+	 * \todo Investigate if mapping the lens shading table buffer
+	 * could be handled with mapBuffers().
+	 */
+	params.lsTableHandle = lsTable_;
 
 	return 0;
 }
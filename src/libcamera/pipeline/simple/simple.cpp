@@ -22,6 +22,7 @@
 #include <linux/media-bus-format.h>
 
 #include <libcamera/base/log.h>
+#include <libcamera/base/thread.h>
 
 #include <libcamera/camera.h>
 #include <libcamera/control_ids.h>
@@ -219,6 +220,8 @@ public:
 
 	int init();
 	int setupLinks();
+	void enumerateConfigurations();
+	int setupConfigurations();
 	int setupFormats(V4L2SubdeviceFormat *format,
 			 V4L2Subdevice::Whence whence,
 			 Transform transform = Transform::Identity);
@@ -275,6 +278,7 @@ public:
 
 	std::vector<Configuration> configs_;
 	std::map<PixelFormat, std::vector<const Configuration *>> formats_;
+	const Configuration *pipeConfig_;
 
 	std::vector<std::unique_ptr<FrameBuffer>> conversionBuffers_;
 	std::queue<std::map<unsigned int, FrameBuffer *>> conversionQueue_;
@@ -284,8 +288,8 @@ public:
 	std::unique_ptr<SoftwareIsp> swIsp_;
 
 private:
-	void tryPipeline(unsigned int code, const Size &size);
-	static std::vector<const MediaPad *> routedSourcePads(MediaPad *sink);
+	void tryPipeline(unsigned int code, const Size &size,
+			 std::map<uint32_t, V4L2VideoDevice::Formats> &videoFormats);
 
 	void conversionInputDone(FrameBuffer *buffer);
 	void conversionOutputDone(FrameBuffer *buffer);
@@ -337,11 +341,13 @@ public:
 
 	int start(Camera *camera, const ControlList *controls) override;
 	void stopDevice(Camera *camera) override;
+	int reconfigureDevice(Camera *camera, CameraConfiguration *config) override;
 
 	bool match(DeviceEnumerator *enumerator) override;
 
 	V4L2VideoDevice *video(const MediaEntity *entity);
 	V4L2Subdevice *subdev(const MediaEntity *entity);
+	const std::vector<const MediaPad *> &routedSourcePads(MediaPad *sink);
 	MediaDevice *converter() { return converter_; }
 	bool swIspEnabled() const { return swIspEnabled_; }
 
@@ -365,12 +371,20 @@ private:
 	std::vector<MediaEntity *> locateSensors();
 	static int resetRoutingTable(V4L2Subdevice *subdev);
 
+	int configureConversion(SimpleCameraData *data,
+				SimpleCameraConfiguration *config);
+
 	const MediaPad *acquirePipeline(SimpleCameraData *data);
 	void releasePipeline(SimpleCameraData *data);
 
+	void enumerateConfigurations(Span<SimpleCameraData *const> pipelines);
+
 	MediaDevice *media_;
 	std::map<const MediaEntity *, EntityData> entities_;
 
+	/* Active routes cache, only valid during match(). */
+	std::map<const MediaPad *, std::vector<const MediaPad *>> routes_;
+
 	MediaDevice *converter_;
 	bool swIspEnabled_;
 };
@@ -382,7 +396,7 @@ private:
 SimpleCameraData::SimpleCameraData(SimplePipelineHandler *pipe,
 				   unsigned int numStreams,
 				   MediaEntity *sensor)
-	: Camera::Private(pipe), streams_(numStreams)
+	: Camera::Private(pipe), streams_(numStreams), pipeConfig_(nullptr)
 {
 	int ret;
 
@@ -432,7 +446,7 @@ SimpleCameraData::SimpleCameraData(SimplePipelineHandler *pipe,
 		bool supportsRouting = false;
 
 		if (sinkPad) {
-			pads = routedSourcePads(sinkPad);
+			pads = pipe->routedSourcePads(sinkPad);
 			if (!pads.empty())
 				supportsRouting = true;
 		}
@@ -506,7 +520,6 @@ SimplePipelineHandler *SimpleCameraData::pipe()
 int SimpleCameraData::init()
 {
 	SimplePipelineHandler *pipe = SimpleCameraData::pipe();
-	int ret;
 
 	/* Open the converter, if any. */
 	MediaDevice *converter = pipe->converter();
@@ -550,34 +563,86 @@ int SimpleCameraData::init()
 			swIsp_->outputBufferReady.connect(this, &SimpleCameraData::conversionOutputDone);
 			swIsp_->ispStatsReady.connect(this, &SimpleCameraData::ispStatsReady);
 			swIsp_->setSensorControls.connect(this, &SimpleCameraData::setSensorControls);
+
+			addMemory(MemoryUsage::Purpose::Processing,
+				  MemoryUsage::Type::SharedMemory,
+				  swIsp_->sharedMemorySize());
 		}
 	}
 
 	video_ = pipe->video(entities_.back().entity);
 	ASSERT(video_);
 
-	/*
-	 * Setup links first as some subdev drivers take active links into
-	 * account to propagate TRY formats. Such is life :-(
-	 */
-	ret = setupLinks();
-	if (ret < 0)
-		return ret;
+	return 0;
+}
 
+/*
+ * Generate the list of possible pipeline configurations by trying each media
+ * bus format and size supported by the sensor.
+ *
+ * The links must have been set up with setupLinks() first, as some subdev
+ * drivers take active links into account to propagate TRY formats. Such is
+ * life :-(
+ *
+ * This function only accesses the devices of the pipeline, and can thus be
+ * called concurrently for pipelines that don't share any entity. The
+ * configurations it generates are completed by setupConfigurations().
+ */
+void SimpleCameraData::enumerateConfigurations()
+{
 	/*
-	 * Generate the list of possible pipeline configurations by trying each
-	 * media bus format and size supported by the sensor.
+	 * The pixel formats supported by the video node only depend on the
+	 * media bus code, cache them to avoid enumerating them for every
+	 * sensor size.
 	 */
+	std::map<uint32_t, V4L2VideoDevice::Formats> videoFormats;
+
 	for (unsigned int code : sensor_->mbusCodes()) {
 		for (const Size &size : sensor_->sizes(code))
-			tryPipeline(code, size);
+			tryPipeline(code, size, videoFormats);
 	}
+}
 
+/*
+ * Complete the pipeline configurations generated by enumerateConfigurations()
+ * with the output formats and sizes of the converter or software ISP, and
+ * index them by pixel format. The converter is shared by all pipelines, so
+ * this function must be called from the pipeline handler thread.
+ */
+int SimpleCameraData::setupConfigurations()
+{
 	if (configs_.empty()) {
 		LOG(SimplePipeline, Error) << "No valid configuration found";
 		return -EINVAL;
 	}
 
+	std::map<PixelFormat, std::vector<PixelFormat>> outputFormats;
+
+	for (Configuration &config : configs_) {
+		PixelFormat pixelFormat = config.captureFormat;
+
+		if (converter_) {
+			auto it = outputFormats.find(pixelFormat);
+			if (it == outputFormats.end())
+				it = outputFormats.emplace(pixelFormat,
+							   converter_->formats(pixelFormat)).first;
+
+			config.outputFormats = it->second;
+			config.outputSizes = converter_->sizes(config.captureSize);
+		} else if (swIsp_) {
+			config.outputFormats = swIsp_->formats(pixelFormat);
+			config.outputSizes = swIsp_->sizes(pixelFormat, config.captureSize);
+			if (config.outputFormats.empty()) {
+				/* Do not use swIsp for unsupported pixelFormat's. */
+				config.outputFormats = { pixelFormat };
+				config.outputSizes = config.captureSize;
+			}
+		} else {
+			config.outputFormats = { pixelFormat };
+			config.outputSizes = config.captureSize;
+		}
+	}
+
 	/* Map the pixel formats to configurations. */
 	for (const Configuration &config : configs_) {
 		formats_[config.captureFormat].push_back(&config);
@@ -597,10 +662,12 @@ int SimpleCameraData::init()
  *
  * First propagate the media bus code and size through the pipeline from the
  * camera sensor to the video node. Then, query the video node for all supported
- * pixel formats compatible with the media bus code. For each pixel format, store
- * a full pipeline configuration in the configs_ vector.
+ * pixel formats compatible with the media bus code, using the \a videoFormats
+ * cache when possible. For each pixel format, store a pipeline configuration in
+ * the configs_ vector.
  */
-void SimpleCameraData::tryPipeline(unsigned int code, const Size &size)
+void SimpleCameraData::tryPipeline(unsigned int code, const Size &size,
+				   std::map<uint32_t, V4L2VideoDevice::Formats> &videoFormats)
 {
 	/*
 	 * Propagate the format through the pipeline, and enumerate the
@@ -621,18 +688,23 @@ void SimpleCameraData::tryPipeline(unsigned int code, const Size &size)
 		return;
 	}
 
-	V4L2VideoDevice::Formats videoFormats = video_->formats(format.code);
+	auto it = videoFormats.find(format.code);
+	if (it == videoFormats.end())
+		it = videoFormats.emplace(format.code,
+					  video_->formats(format.code)).first;
+
+	const V4L2VideoDevice::Formats &formats = it->second;
 
 	LOG(SimplePipeline, Debug)
 		<< "Adding configuration for " << format.size
 		<< " in pixel formats [ "
-		<< utils::join(videoFormats, ", ",
+		<< utils::join(formats, ", ",
 			       [](const auto &f) {
 				       return f.first.toString();
 			       })
 		<< " ]";
 
-	for (const auto &videoFormat : videoFormats) {
+	for (const auto &videoFormat : formats) {
 		PixelFormat pixelFormat = videoFormat.first.toPixelFormat();
 		if (!pixelFormat)
 			continue;
@@ -643,22 +715,6 @@ void SimpleCameraData::tryPipeline(unsigned int code, const Size &size)
 		config.captureFormat = pixelFormat;
 		config.captureSize = format.size;
 
-		if (converter_) {
-			config.outputFormats = converter_->formats(pixelFormat);
-			config.outputSizes = converter_->sizes(format.size);
-		} else if (swIsp_) {
-			config.outputFormats = swIsp_->formats(pixelFormat);
-			config.outputSizes = swIsp_->sizes(pixelFormat, format.size);
-			if (config.outputFormats.empty()) {
-				/* Do not use swIsp for unsupported pixelFormat's. */
-				config.outputFormats = { pixelFormat };
-				config.outputSizes = config.captureSize;
-			}
-		} else {
-			config.outputFormats = { pixelFormat };
-			config.outputSizes = config.captureSize;
-		}
-
 		configs_.push_back(config);
 	}
 }
@@ -903,43 +959,6 @@ void SimpleCameraData::setSensorControls(const ControlList &sensorControls)
 	sensor_->setControls(&ctrls);
 }
 
-/* Retrieve all source pads connected to a sink pad through active routes. */
-std::vector<const MediaPad *> SimpleCameraData::routedSourcePads(MediaPad *sink)
-{
-	MediaEntity *entity = sink->entity();
-	std::unique_ptr<V4L2Subdevice> subdev =
-		std::make_unique<V4L2Subdevice>(entity);
-
-	int ret = subdev->open();
-	if (ret < 0)
-		return {};
-
-	V4L2Subdevice::Routing routing = {};
-	ret = subdev->getRouting(&routing, V4L2Subdevice::ActiveFormat);
-	if (ret < 0)
-		return {};
-
-	std::vector<const MediaPad *> pads;
-
-	for (const V4L2Subdevice::Route &route : routing) {
-		if (sink->index() != route.sink.pad ||
-		    !(route.flags & V4L2_SUBDEV_ROUTE_FL_ACTIVE))
-			continue;
-
-		const MediaPad *pad = entity->getPadByIndex(route.source.pad);
-		if (!pad) {
-			LOG(SimplePipeline, Warning)
-				<< "Entity " << entity->name()
-				<< " has invalid route source pad "
-				<< route.source.pad;
-		}
-
-		pads.push_back(pad);
-	}
-
-	return pads;
-}
-
 /* -----------------------------------------------------------------------------
  * Camera Configuration
  */
@@ -1263,7 +1282,16 @@ int SimplePipelineHandler::configure(Camera *camera, CameraConfiguration *c)
 		return -EINVAL;
 	}
 
+	data->pipeConfig_ = pipeConfig;
+
 	/* Configure the converter if needed. */
+	return configureConversion(data, config);
+}
+
+int SimplePipelineHandler::configureConversion(SimpleCameraData *data,
+					       SimpleCameraConfiguration *config)
+{
+	const SimpleCameraData::Configuration *pipeConfig = config->pipeConfig();
 	std::vector<std::reference_wrapper<StreamConfiguration>> outputCfgs;
 	data->useConversion_ = config->needConversion();
 
@@ -1279,6 +1307,11 @@ int SimplePipelineHandler::configure(Camera *camera, CameraConfiguration *c)
 	if (outputCfgs.empty())
 		return 0;
 
+	V4L2DeviceFormat captureFormat;
+	int ret = data->video_->getFormat(&captureFormat);
+	if (ret)
+		return ret;
+
 	StreamConfiguration inputCfg;
 	inputCfg.pixelFormat = pipeConfig->captureFormat;
 	inputCfg.size = pipeConfig->captureSize;
@@ -1325,13 +1358,26 @@ int SimplePipelineHandler::start(Camera *camera, [[maybe_unused]] const ControlL
 		return -EBUSY;
 	}
 
-	if (data->useConversion_) {
+	if (data->useConversion_ && !data->conversionBuffers_.empty()) {
+		/* Reuse the internal buffers kept by reconfigureDevice(). */
+		ret = 0;
+	} else if (data->useConversion_) {
 		/*
 		 * When using the converter allocate a fixed number of internal
-		 * buffers.
+		 * buffers, reduced to double-buffering if needed to honour
+		 * the memory budget.
 		 */
-		ret = video->allocateBuffers(kNumInternalBuffers,
-					     &data->conversionBuffers_);
+		V4L2DeviceFormat captureFormat;
+		unsigned int count = kNumInternalBuffers;
+
+		if (!video->getFormat(&captureFormat))
+			count = data->budgetBufferCount(kNumInternalBuffers, 2,
+							captureFormat.planes[0].size);
+
+		ret = video->allocateBuffers(count, &data->conversionBuffers_);
+		if (ret >= 0)
+			data->addBuffers(MemoryUsage::Purpose::Raw,
+					 data->conversionBuffers_);
 	} else {
 		/* Otherwise, prepare for using buffers from the only stream. */
 		Stream *stream = &data->streams_[0];
@@ -1388,11 +1434,49 @@ void SimplePipelineHandler::stopDevice(Camera *camera)
 
 	video->bufferReady.disconnect(data, &SimpleCameraData::bufferReady);
 
+	data->removeBuffers(MemoryUsage::Purpose::Raw, data->conversionBuffers_);
 	data->conversionBuffers_.clear();
 
 	releasePipeline(data);
 }
 
+int SimplePipelineHandler::reconfigureDevice(Camera *camera, CameraConfiguration *c)
+{
+	SimpleCameraConfiguration *config =
+		static_cast<SimpleCameraConfiguration *>(c);
+	SimpleCameraData *data = cameraData(camera);
+	V4L2VideoDevice *video = data->video_;
+
+	/*
+	 * If the converter is used before and after the switch with the same
+	 * capture configuration, only the converter outputs change. Keep the
+	 * pipeline links, the sensor and video node formats and the internal
+	 * buffers, and reconfigure the converter only.
+	 */
+	if (!data->useConversion_ || !config->needConversion() ||
+	    config->pipeConfig() != data->pipeConfig_)
+		return PipelineHandler::reconfigureDevice(camera, c);
+
+	if (data->converter_)
+		data->converter_->stop();
+	else if (data->swIsp_)
+		data->swIsp_->stop();
+
+	video->streamOff();
+	video->bufferReady.disconnect(data, &SimpleCameraData::bufferReady);
+
+	int ret = configureConversion(data, config);
+	if (ret < 0) {
+		video->releaseBuffers();
+		data->removeBuffers(MemoryUsage::Purpose::Raw,
+				    data->conversionBuffers_);
+		data->conversionBuffers_.clear();
+		releasePipeline(data);
+	}
+
+	return ret;
+}
+
 int SimplePipelineHandler::queueRequestDevice(Camera *camera, Request *request)
 {
 	SimpleCameraData *data = cameraData(camera);
@@ -1577,6 +1661,9 @@ bool SimplePipelineHandler::match(DeviceEnumerator *enumerator)
 		pipelines.push_back(std::move(data));
 	}
 
+	/* The routes have been used to find the pipelines, drop the cache. */
+	routes_.clear();
+
 	if (entities.empty())
 		return false;
 
@@ -1637,11 +1724,29 @@ bool SimplePipelineHandler::match(DeviceEnumerator *enumerator)
 		entities_[entity] = { std::move(video), std::move(subdev), {} };
 	}
 
-	/* Initialize each pipeline and register a corresponding camera. */
-	bool registered = false;
+	/* Initialize each pipeline and generate its configurations. */
+	std::vector<SimpleCameraData *> initialized;
 
 	for (std::unique_ptr<SimpleCameraData> &data : pipelines) {
 		int ret = data->init();
+		if (ret < 0) {
+			data.reset();
+			continue;
+		}
+
+		initialized.push_back(data.get());
+	}
+
+	enumerateConfigurations(initialized);
+
+	/* Register a camera for each pipeline. */
+	bool registered = false;
+
+	for (std::unique_ptr<SimpleCameraData> &data : pipelines) {
+		if (!data)
+			continue;
+
+		int ret = data->setupConfigurations();
 		if (ret < 0)
 			continue;
 
@@ -1660,6 +1765,85 @@ bool SimplePipelineHandler::match(DeviceEnumerator *enumerator)
 	return registered;
 }
 
+namespace {
+
+class SimpleEnumerationThread : public Thread
+{
+public:
+	SimpleEnumerationThread(SimpleCameraData *data)
+		: data_(data)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		data_->enumerateConfigurations();
+	}
+
+private:
+	SimpleCameraData *data_;
+};
+
+} /* namespace */
+
+void SimplePipelineHandler::enumerateConfigurations(Span<SimpleCameraData *const> pipelines)
+{
+	/*
+	 * Enumerating the configurations of a pipeline requires its links to
+	 * be set up, and propagates TRY formats through all its subdevs. This
+	 * involves many ioctls, which can be slow with some drivers.
+	 *
+	 * Pipelines that share entities with other pipelines need conflicting
+	 * link configurations and TRY formats, they are thus processed one at
+	 * a time. The remaining pipelines are independent from each other, and
+	 * their configurations are enumerated concurrently, one thread per
+	 * pipeline.
+	 */
+	std::map<const MediaEntity *, unsigned int> usage;
+	for (const SimpleCameraData *data : pipelines) {
+		for (const SimpleCameraData::Entity &entity : data->entities_)
+			usage[entity.entity]++;
+	}
+
+	std::vector<SimpleCameraData *> independent;
+
+	for (SimpleCameraData *data : pipelines) {
+		int ret = data->setupLinks();
+		if (ret < 0) {
+			LOG(SimplePipeline, Error)
+				<< "Failed to setup links for sensor '"
+				<< data->sensor_->entity()->name() << "': "
+				<< strerror(-ret);
+			continue;
+		}
+
+		bool shared = std::any_of(data->entities_.begin(), data->entities_.end(),
+					  [&](const SimpleCameraData::Entity &entity) {
+						  return usage[entity.entity] > 1;
+					  });
+		if (shared)
+			data->enumerateConfigurations();
+		else
+			independent.push_back(data);
+	}
+
+	if (independent.size() == 1) {
+		independent[0]->enumerateConfigurations();
+		return;
+	}
+
+	std::vector<std::unique_ptr<SimpleEnumerationThread>> threads;
+
+	for (SimpleCameraData *data : independent) {
+		threads.push_back(std::make_unique<SimpleEnumerationThread>(data));
+		threads.back()->start();
+	}
+
+	for (std::unique_ptr<SimpleEnumerationThread> &thread : threads)
+		thread->wait();
+}
+
 V4L2VideoDevice *SimplePipelineHandler::video(const MediaEntity *entity)
 {
 	auto iter = entities_.find(entity);
@@ -1678,6 +1862,53 @@ V4L2Subdevice *SimplePipelineHandler::subdev(const MediaEntity *entity)
 	return iter->second.subdev.get();
 }
 
+/*
+ * Retrieve all source pads connected to a sink pad through active routes.
+ *
+ * The pipelines of all sensors are searched during match(), and often go
+ * through the same entities. The routes are cached to avoid opening the same
+ * subdevs and querying their routing table once per sensor.
+ */
+const std::vector<const MediaPad *> &
+SimplePipelineHandler::routedSourcePads(MediaPad *sink)
+{
+	auto [it, inserted] = routes_.try_emplace(sink);
+	std::vector<const MediaPad *> &pads = it->second;
+	if (!inserted)
+		return pads;
+
+	MediaEntity *entity = sink->entity();
+	std::unique_ptr<V4L2Subdevice> subdev =
+		std::make_unique<V4L2Subdevice>(entity);
+
+	int ret = subdev->open();
+	if (ret < 0)
+		return pads;
+
+	V4L2Subdevice::Routing routing = {};
+	ret = subdev->getRouting(&routing, V4L2Subdevice::ActiveFormat);
+	if (ret < 0)
+		return pads;
+
+	for (const V4L2Subdevice::Route &route : routing) {
+		if (sink->index() != route.sink.pad ||
+		    !(route.flags & V4L2_SUBDEV_ROUTE_FL_ACTIVE))
+			continue;
+
+		const MediaPad *pad = entity->getPadByIndex(route.source.pad);
+		if (!pad) {
+			LOG(SimplePipeline, Warning)
+				<< "Entity " << entity->name()
+				<< " has invalid route source pad "
+				<< route.source.pad;
+		}
+
+		pads.push_back(pad);
+	}
+
+	return pads;
+}
+
 /**
  * \brief Acquire all resources needed by the camera pipeline
  * \return nullptr on success, a pointer to the contended pad on error
@@ -331,6 +331,85 @@ void PipelineHandler::stop(Camera *camera)
 	/* Stop the pipeline handler and let the queued requests complete. */
 	stopDevice(camera);
 
+	cancelWaitingRequests(camera);
+}
+
+/**
+ * \fn PipelineHandler::stopDevice()
+ * \brief Stop capturing from all running streams
+ * \param[in] camera The camera to stop
+ *
+ * This function stops capturing and processing requests immediately. All
+ * pending requests are cancelled and complete immediately in an error state.
+ */
+
+/**
+ * \brief Stop capturing and switch to a new configuration
+ * \param[in] camera The camera to reconfigure
+ * \param[in] config The camera configuration to switch to
+ *
+ * This function stops capturing and processing requests as stop() does, and
+ * applies the new \a config by calling reconfigureDevice(). All pending
+ * requests are cancelled and complete immediately in an error state. The
+ * caller shall then restart capture with start().
+ *
+ * The only intended caller is Camera::switchConfiguration().
+ *
+ * \context This function is called from the CameraManager thread.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int PipelineHandler::reconfigure(Camera *camera, CameraConfiguration *config)
+{
+	int ret = reconfigureDevice(camera, config);
+
+	cancelWaitingRequests(camera);
+
+	return ret;
+}
+
+/**
+ * \brief Stop capturing and apply a new configuration to the device
+ * \param[in] camera The camera to reconfigure
+ * \param[in] config The camera configuration to switch to
+ *
+ * This function stops capturing and processing requests immediately, as
+ * stopDevice() does, and configures the device with \a config, as configure()
+ * does. Once it returns, the pipeline handler shall be ready to be started
+ * with start().
+ *
+ * The default implementation calls stopDevice() and configure(). Pipeline
+ * handlers may override it to keep resources that the new configuration can
+ * reuse, such as internal buffers, IPA buffer mappings or unchanged device
+ * formats, and to skip the corresponding setup in start(). This reduces the
+ * latency of switching between configurations, for instance between preview
+ * and still capture.
+ *
+ * If this function fails, the device shall be left stopped and all resources
+ * allocated for capture released.
+ *
+ * \context This function is called from the CameraManager thread.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int PipelineHandler::reconfigureDevice(Camera *camera, CameraConfiguration *config)
+{
+	stopDevice(camera);
+
+	return configure(camera, config);
+}
+
+/**
+ * \brief Cancel the requests waiting to be queued to a stopped device
+ * \param[in] camera The camera that has been stopped
+ *
+ * Complete all the requests waiting to be queued to the device in an error
+ * state, and reset the request sequence of the \a camera. This is the part of
+ * the teardown shared by stop() and reconfigure(), once the device has been
+ * stopped and its queued requests have completed.
+ */
+void PipelineHandler::cancelWaitingRequests(Camera *camera)
+{
 	/* Cancel and signal as complete all waiting requests. */
 	while (!waitingRequests_.empty()) {
 		Request *request = waitingRequests_.front();
@@ -347,15 +426,6 @@ void PipelineHandler::stop(Camera *camera)
 	data->requestSequence_ = 0;
 }
 
-/**
- * \fn PipelineHandler::stopDevice()
- * \brief Stop capturing from all running streams
- * \param[in] camera The camera to stop
- *
- * This function stops capturing and processing requests immediately. All
- * pending requests are cancelled and complete immediately in an error state.
- */
-
 /**
  * \brief Determine if the camera has any requests pending
  * \param[in] camera The camera to check
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * CPU post-processing stages
+ */
+
+#include "libcamera/internal/post_processing.h"
+
+#include <algorithm>
+#include <thread>
+
+#include <libcamera/base/object.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/utils.h>
+
+#include "libcamera/internal/formats.h"
+
+/**
+ * \file internal/post_processing.h
+ * \brief CPU post-processing of frames
+ */
+
+namespace libcamera {
+
+LOG_DEFINE_CATEGORY(PostProcessing)
+
+/**
+ * \class PostProcessingStage
+ * \brief A single CPU image processing operation
+ *
+ * A post-processing stage implements one image processing operation, such as
+ * scaling or format conversion, on frames stored in CPU-accessible memory.
+ * Stages only implement the processing kernel. Mapping the frame buffers and
+ * scheduling the processing is left to their users, such as pipeline handlers
+ * or the Android HAL post-processors.
+ *
+ * Stages are configured once, and their process() function is then called for
+ * every frame. Calls to process() shall not be concurrent, which allows stages
+ * to keep per-frame scratch memory in their instance. Stages that split the
+ * processing of a frame across threads do so internally, with
+ * ParallelStripes.
+ */
+
+PostProcessingStage::~PostProcessingStage() = default;
+
+/**
+ * \fn PostProcessingStage::configure()
+ * \brief Configure the stage
+ * \param[in] inputCfg The input frame configuration
+ * \param[in] outputCfg The output frame configuration
+ *
+ * The pixel format, size and stride of the input and output frames are
+ * specified by the \a inputCfg and \a outputCfg. The stride of the first plane
+ * is specified explicitly, the stride of the other planes is derived from it
+ * as described in planeStride().
+ *
+ * \return 0 on success or a negative error code if the stage doesn't support
+ * the configuration
+ */
+
+/**
+ * \fn PostProcessingStage::process()
+ * \brief Process a frame
+ * \param[in] input The memory of the input frame planes
+ * \param[out] output The memory of the output frame planes
+ */
+
+/**
+ * \brief Compute the stride of a plane of a frame
+ * \param[in] cfg The frame configuration
+ * \param[in] plane The plane index
+ *
+ * The stride of the first plane is given by the \a cfg. The stride of the
+ * other planes is derived from it, scaled by the ratio of the number of bytes
+ * per pixel group between the plane and the first plane, following the
+ * convention of V4L2 single-planar multi-plane formats.
+ *
+ * \return The stride of the \a plane in bytes
+ */
+unsigned int PostProcessingStage::planeStride(const StreamConfiguration &cfg,
+					      unsigned int plane)
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+
+	if (!plane)
+		return cfg.stride;
+
+	return cfg.stride * info.planes[plane].bytesPerGroup /
+	       info.planes[0].bytesPerGroup;
+}
+
+namespace {
+
+/* Limit the number of threads spawned when the caller doesn't specify it. */
+constexpr unsigned int kMaxDefaultStripes = 4;
+
+} /* namespace */
+
+class ParallelStripes::Worker : public Object
+{
+public:
+	Worker(ParallelStripes *stripes)
+		: stripes_(stripes)
+	{
+	}
+
+	void run(unsigned int index)
+	{
+		(*stripes_->func_)(index);
+		stripes_->done_.release();
+	}
+
+private:
+	ParallelStripes *stripes_;
+};
+
+/**
+ * \class ParallelStripes
+ * \brief Split the processing of a frame across threads
+ *
+ * Post-processing stages that are bound by computation rather than by memory
+ * bandwidth benefit from processing a frame on multiple CPU cores. The
+ * ParallelStripes class helps them doing so by splitting the frame in a fixed
+ * number of stripes, typically groups of lines, and processing them in
+ * parallel.
+ *
+ * The first stripe is processed in the calling thread, and the other ones in
+ * worker threads owned by the ParallelStripes instance. The threads are
+ * created at construction time and live until the instance is destroyed.
+ */
+
+/**
+ * \brief Construct a ParallelStripes instance
+ * \param[in] count The number of stripes, or 0 to select a value based on the
+ * number of CPU cores
+ */
+ParallelStripes::ParallelStripes(unsigned int count)
+	: count_(count), func_(nullptr)
+{
+	if (!count_)
+		count_ = std::min(std::thread::hardware_concurrency(),
+				  kMaxDefaultStripes);
+	count_ = std::max(count_, 1U);
+
+	for (unsigned int i = 1; i < count_; ++i) {
+		threads_.push_back(std::make_unique<Thread>());
+		workers_.push_back(std::make_unique<Worker>(this));
+		workers_.back()->moveToThread(threads_.back().get());
+		threads_.back()->start();
+	}
+}
+
+ParallelStripes::~ParallelStripes()
+{
+	for (std::unique_ptr<Thread> &thread : threads_) {
+		thread->exit();
+		thread->wait();
+	}
+}
+
+/**
+ * \fn ParallelStripes::count()
+ * \brief Retrieve the number of stripes
+ * \return The number of stripes
+ */
+
+/**
+ * \brief Process all stripes
+ * \param[in] func The function that processes one stripe
+ *
+ * Call \a func once for each stripe, with the stripe index as argument, and
+ * wait for all calls to complete. The calls run concurrently in different
+ * threads.
+ */
+void ParallelStripes::run(const std::function<void(unsigned int)> &func)
+{
+	func_ = &func;
+
+	for (const auto &[i, worker] : utils::enumerate(workers_))
+		worker->invokeMethod(&Worker::run, ConnectionTypeQueued, i + 1);
+
+	func(0);
+
+	done_.acquire(workers_.size());
+	func_ = nullptr;
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Integer ratio downscaling post-processing stage
+ */
+
+#include "libcamera/internal/post_processing/downscale.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <map>
+
+#include <libcamera/base/utils.h>
+
+#include <libcamera/formats.h>
+
+#include "libcamera/internal/formats.h"
+
+/**
+ * \file internal/post_processing/downscale.h
+ * \brief Integer ratio downscaling post-processing stage
+ */
+
+namespace libcamera {
+
+namespace {
+
+struct FormatPlane {
+	/* Number of interleaved 8-bit components per sample. */
+	unsigned int components;
+	unsigned int horizontalSubSampling;
+};
+
+const std::map<PixelFormat, std::vector<FormatPlane>> downscaleFormats = {
+	{ formats::R8, { { 1, 1 } } },
+	{ formats::RGB888, { { 3, 1 } } },
+	{ formats::BGR888, { { 3, 1 } } },
+	{ formats::XRGB8888, { { 4, 1 } } },
+	{ formats::XBGR8888, { { 4, 1 } } },
+	{ formats::ARGB8888, { { 4, 1 } } },
+	{ formats::ABGR8888, { { 4, 1 } } },
+	{ formats::NV12, { { 1, 1 }, { 2, 2 } } },
+	{ formats::NV21, { { 1, 1 }, { 2, 2 } } },
+	{ formats::NV16, { { 1, 1 }, { 2, 2 } } },
+	{ formats::NV61, { { 1, 1 }, { 2, 2 } } },
+	{ formats::YUV420, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+	{ formats::YVU420, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+	{ formats::YUV422, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+	{ formats::YVU422, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+};
+
+/*
+ * The vertical sums are accumulated on 16 bits, which limits the vertical
+ * factor to 257. Use a lower, more realistic, limit for both directions.
+ */
+constexpr unsigned int kMaxFactor = 16;
+
+} /* namespace */
+
+/**
+ * \class DownscaleStage
+ * \brief Post-processing stage that downscales frames by integer factors
+ *
+ * The downscale stage reduces the size of frames by integer horizontal and
+ * vertical factors, averaging each block of input pixels into one output
+ * pixel. It supports 8-bit RGB and YUV formats, packed or planar, and doesn't
+ * convert the pixel format.
+ *
+ * Each output line is computed by first summing the input lines of the block
+ * into a line of 16-bit accumulators, and then summing and averaging the
+ * accumulators horizontally. The first step, which accounts for most of the
+ * memory bandwidth, operates on contiguous arrays and is vectorised by the
+ * compiler.
+ */
+
+/**
+ * \brief Check if the stage supports a pixel format
+ * \param[in] format The pixel format
+ * \return True if frames in \a format can be downscaled, false otherwise
+ */
+bool DownscaleStage::isSupported(const PixelFormat &format)
+{
+	return downscaleFormats.find(format) != downscaleFormats.end();
+}
+
+/**
+ * \copydoc PostProcessingStage::configure()
+ *
+ * The input and output pixel formats shall be identical, and the input size
+ * shall be an integer multiple of the output size, with factors not larger
+ * than 16.
+ */
+int DownscaleStage::configure(const StreamConfiguration &inputCfg,
+			      const StreamConfiguration &outputCfg)
+{
+	const Size &in = inputCfg.size;
+	const Size &out = outputCfg.size;
+
+	auto it = downscaleFormats.find(inputCfg.pixelFormat);
+	if (it == downscaleFormats.end() ||
+	    outputCfg.pixelFormat != inputCfg.pixelFormat) {
+		LOG(PostProcessing, Error)
+			<< "Unsupported downscale from " << inputCfg.pixelFormat
+			<< " to " << outputCfg.pixelFormat;
+		return -EINVAL;
+	}
+
+	if (out.isNull() || in.width % out.width || in.height % out.height) {
+		LOG(PostProcessing, Error)
+			<< "Can't downscale " << in << " to " << out
+			<< " by an integer factor";
+		return -EINVAL;
+	}
+
+	factorX_ = in.width / out.width;
+	factorY_ = in.height / out.height;
+
+	if (factorX_ > kMaxFactor || factorY_ > kMaxFactor) {
+		LOG(PostProcessing, Error)
+			<< "Downscale factor " << factorX_ << "x" << factorY_
+			<< " too large";
+		return -EINVAL;
+	}
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(inputCfg.pixelFormat);
+	unsigned int maxLine = 0;
+
+	planes_.clear();
+
+	for (const auto &[i, format] : utils::enumerate(it->second)) {
+		unsigned int hSub = format.horizontalSubSampling;
+		unsigned int vSub = info.planes[i].verticalSubSampling;
+
+		if (out.width % hSub || out.height % vSub) {
+			LOG(PostProcessing, Error)
+				<< "Output size " << out
+				<< " incompatible with chroma subsampling";
+			return -EINVAL;
+		}
+
+		Plane plane;
+		plane.components = format.components;
+		plane.width = out.width / hSub;
+		plane.height = out.height / vSub;
+		plane.inputStride = planeStride(inputCfg, i);
+		plane.outputStride = planeStride(outputCfg, i);
+
+		maxLine = std::max(maxLine, plane.width * factorX_ * plane.components);
+		planes_.push_back(plane);
+	}
+
+	rowSums_.resize(maxLine);
+
+	return 0;
+}
+
+/**
+ * \copydoc PostProcessingStage::process()
+ */
+void DownscaleStage::process(Span<const Span<uint8_t>> input,
+			     Span<const Span<uint8_t>> output)
+{
+	ASSERT(input.size() >= planes_.size() && output.size() >= planes_.size());
+
+	for (const auto &[i, plane] : utils::enumerate(planes_))
+		downscalePlane(plane, input[i].data(), output[i].data());
+}
+
+void DownscaleStage::downscalePlane(const Plane &plane, const uint8_t *src,
+				    uint8_t *dst)
+{
+	const unsigned int components = plane.components;
+	const unsigned int lineSize = plane.width * factorX_ * components;
+	const unsigned int divisor = factorX_ * factorY_;
+	uint16_t *sums = rowSums_.data();
+
+	for (unsigned int y = 0; y < plane.height; ++y) {
+		/* Sum the input lines vertically. */
+		for (unsigned int i = 0; i < lineSize; ++i)
+			sums[i] = src[i];
+
+		for (unsigned int j = 1; j < factorY_; ++j) {
+			const uint8_t *line = src + j * plane.inputStride;
+
+			for (unsigned int i = 0; i < lineSize; ++i)
+				sums[i] += line[i];
+		}
+
+		/* Then horizontally, and average. */
+		const uint16_t *block = sums;
+
+		for (unsigned int x = 0; x < plane.width; ++x) {
+			for (unsigned int c = 0; c < components; ++c) {
+				unsigned int sum = divisor / 2;
+
+				for (unsigned int k = 0; k < factorX_; ++k)
+					sum += block[k * components + c];
+
+				dst[x * components + c] = sum / divisor;
+			}
+
+			block += factorX_ * components;
+		}
+
+		src += factorY_ * plane.inputStride;
+		dst += plane.outputStride;
+	}
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,309 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Semi-planar YUV scaling post-processing stage
+ */
+
+#include "libcamera/internal/post_processing/scale.h"
+
+#include <algorithm>
+#include <cmath>
+#include <errno.h>
+
+#include <libcamera/base/utils.h>
+
+#include <libcamera/formats.h>
+
+#include "libcamera/internal/formats.h"
+
+/**
+ * \file internal/post_processing/scale.h
+ * \brief Semi-planar YUV scaling post-processing stage
+ */
+
+namespace libcamera {
+
+namespace {
+
+/*
+ * Filter weights are stored with 12 fractional bits, and the weights of each
+ * output sample sum to 1.0 in both directions. The horizontal sums of the
+ * vertically filtered 8-bit samples thus fit in 32 bits.
+ */
+constexpr unsigned int kWeightBits = 12;
+constexpr unsigned int kWeightOne = 1 << kWeightBits;
+
+} /* namespace */
+
+/**
+ * \class ScaleStage
+ * \brief Post-processing stage that scales semi-planar YUV frames
+ *
+ * The scale stage resizes NV12, NV21, NV16 and NV61 frames to an arbitrary
+ * size, without converting the pixel format. Two filters are available:
+ *
+ * - Filter::Bilinear interpolates between the two nearest input samples in
+ *   each direction. It is fast, but aliases when downscaling by more than a
+ *   factor of two.
+ * - Filter::Area averages all input samples covered by each output sample,
+ *   weighted by their coverage. It should be preferred for large downscaling
+ *   factors.
+ *
+ * Both filters are implemented as separable filters with precomputed integer
+ * weights. Each output line is computed by filtering the input lines into a
+ * line of 32-bit accumulators, a loop over contiguous arrays that the compiler
+ * vectorises, followed by a horizontal pass over the accumulators.
+ *
+ * The output lines are split in horizontal stripes that are processed in
+ * parallel with ParallelStripes.
+ */
+
+/**
+ * \enum ScaleStage::Filter
+ * \brief The scaling filter
+ * \var ScaleStage::Filter::Bilinear
+ * \brief Bilinear interpolation
+ * \var ScaleStage::Filter::Area
+ * \brief Area averaging
+ */
+
+/**
+ * \brief Construct a ScaleStage
+ * \param[in] filter The scaling filter
+ * \param[in] stripes The number of stripes processed in parallel, or 0 to
+ * select a value based on the number of CPU cores
+ */
+ScaleStage::ScaleStage(Filter filter, unsigned int stripes)
+	: filter_(filter), stripes_(stripes)
+{
+	lines_.resize(stripes_.count());
+}
+
+/**
+ * \brief Check if the stage supports a pixel format
+ * \param[in] format The pixel format
+ * \return True if frames in \a format can be scaled, false otherwise
+ */
+bool ScaleStage::isSupported(const PixelFormat &format)
+{
+	return format == formats::NV12 || format == formats::NV21 ||
+	       format == formats::NV16 || format == formats::NV61;
+}
+
+/**
+ * \copydoc PostProcessingStage::configure()
+ *
+ * The input and output pixel formats shall be identical, and the output width
+ * and height shall be multiples of the chroma subsampling factors.
+ */
+int ScaleStage::configure(const StreamConfiguration &inputCfg,
+			  const StreamConfiguration &outputCfg)
+{
+	const Size &in = inputCfg.size;
+	const Size &out = outputCfg.size;
+
+	if (!isSupported(inputCfg.pixelFormat) ||
+	    outputCfg.pixelFormat != inputCfg.pixelFormat) {
+		LOG(PostProcessing, Error)
+			<< "Unsupported scaling from " << inputCfg.pixelFormat
+			<< " to " << outputCfg.pixelFormat;
+		return -EINVAL;
+	}
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(inputCfg.pixelFormat);
+	const unsigned int vSub = info.planes[1].verticalSubSampling;
+
+	if (in.isNull() || out.isNull() || in.width % 2 || out.width % 2 ||
+	    in.height % vSub || out.height % vSub) {
+		LOG(PostProcessing, Error)
+			<< "Can't scale " << in << " to " << out;
+		return -EINVAL;
+	}
+
+	planes_.clear();
+	planes_.resize(2);
+
+	unsigned int maxLine = 0;
+
+	for (const auto &[i, plane] : utils::enumerate(planes_)) {
+		const unsigned int hSub = i ? 2 : 1;
+		const unsigned int vs = i ? vSub : 1;
+
+		plane.components = i ? 2 : 1;
+		plane.input = { in.width / hSub, in.height / vs };
+		plane.output = { out.width / hSub, out.height / vs };
+		plane.inputStride = planeStride(inputCfg, i);
+		plane.outputStride = planeStride(outputCfg, i);
+
+		plane.weights.clear();
+		computeTaps(plane.input.width, plane.output.width,
+			    plane.xTaps, plane.weights);
+		computeTaps(plane.input.height, plane.output.height,
+			    plane.yTaps, plane.weights);
+
+		maxLine = std::max(maxLine, plane.input.width * plane.components);
+	}
+
+	for (std::vector<uint32_t> &line : lines_)
+		line.resize(maxLine);
+
+	return 0;
+}
+
+/**
+ * \copydoc PostProcessingStage::process()
+ */
+void ScaleStage::process(Span<const Span<uint8_t>> input,
+			 Span<const Span<uint8_t>> output)
+{
+	ASSERT(input.size() >= 2 && output.size() >= 2);
+
+	input_ = input;
+	output_ = output;
+
+	stripes_.run([this](unsigned int index) { processStripe(index); });
+}
+
+void ScaleStage::computeTaps(unsigned int input, unsigned int output,
+			     std::vector<Tap> &taps, std::vector<uint16_t> &weights)
+{
+	const double scale = static_cast<double>(input) / output;
+
+	taps.resize(output);
+
+	for (unsigned int o = 0; o < output; ++o) {
+		Tap &tap = taps[o];
+		tap.weights = weights.size();
+
+		if (filter_ == Filter::Bilinear) {
+			double center = (o + 0.5) * scale - 0.5;
+			center = std::clamp(center, 0.0, input - 1.0);
+
+			unsigned int first = std::min<unsigned int>(center, input - 1);
+			double frac = center - first;
+
+			/* Keep both taps in the image at the right edge. */
+			if (first == input - 1 && input > 1) {
+				first--;
+				frac = 1.0;
+			}
+
+			tap.first = first;
+
+			if (input == 1) {
+				tap.count = 1;
+				weights.push_back(kWeightOne);
+			} else {
+				unsigned int w = std::lround(frac * kWeightOne);
+
+				tap.count = 2;
+				weights.push_back(kWeightOne - w);
+				weights.push_back(w);
+			}
+
+			continue;
+		}
+
+		/* Area filter, weight the input samples by their coverage. */
+		const double begin = o * scale;
+		const double end = (o + 1) * scale;
+		const unsigned int first = begin;
+		const unsigned int last = std::min<unsigned int>(std::ceil(end), input);
+
+		tap.first = first;
+		tap.count = last - first;
+
+		unsigned int sum = 0;
+		unsigned int largest = tap.weights;
+
+		for (unsigned int i = first; i < last; ++i) {
+			double coverage = std::min<double>(end, i + 1) -
+					  std::max<double>(begin, i);
+			unsigned int w = std::lround(coverage / scale * kWeightOne);
+
+			weights.push_back(w);
+			sum += w;
+
+			if (w > weights[largest])
+				largest = weights.size() - 1;
+		}
+
+		/* Distribute the rounding error to the largest weight. */
+		weights[largest] += kWeightOne - sum;
+	}
+}
+
+void ScaleStage::processStripe(unsigned int index)
+{
+	uint32_t *line = lines_[index].data();
+
+	for (const auto &[i, plane] : utils::enumerate(planes_)) {
+		const unsigned int height = plane.output.height;
+		const unsigned int begin = height * index / stripes_.count();
+		const unsigned int end = height * (index + 1) / stripes_.count();
+
+		scalePlane(plane, input_[i].data(), output_[i].data(),
+			   begin, end, line);
+	}
+}
+
+template<unsigned int Components>
+void ScaleStage::filterLine(const Plane &plane, const uint32_t *line, uint8_t *dst)
+{
+	const uint16_t *weights = plane.weights.data();
+
+	for (const Tap &tap : plane.xTaps) {
+		const uint16_t *xWeights = weights + tap.weights;
+		const uint32_t *samples = line + tap.first * Components;
+
+		for (unsigned int c = 0; c < Components; ++c) {
+			uint32_t sum = 1U << (2 * kWeightBits - 1);
+
+			for (unsigned int k = 0; k < tap.count; ++k)
+				sum += xWeights[k] * samples[k * Components + c];
+
+			*dst++ = sum >> (2 * kWeightBits);
+		}
+	}
+}
+
+void ScaleStage::scalePlane(const Plane &plane, const uint8_t *src, uint8_t *dst,
+			    unsigned int begin, unsigned int end, uint32_t *line)
+{
+	const unsigned int components = plane.components;
+	const unsigned int lineSize = plane.input.width * components;
+	const uint16_t *weights = plane.weights.data();
+
+	dst += begin * plane.outputStride;
+
+	for (unsigned int y = begin; y < end; ++y) {
+		const Tap &yTap = plane.yTaps[y];
+		const uint16_t *yWeights = weights + yTap.weights;
+
+		/* Filter the input lines vertically. */
+		const uint8_t *row = src + yTap.first * plane.inputStride;
+		const uint32_t w0 = yWeights[0];
+
+		for (unsigned int i = 0; i < lineSize; ++i)
+			line[i] = w0 * row[i];
+
+		for (unsigned int k = 1; k < yTap.count; ++k) {
+			const uint32_t w = yWeights[k];
+
+			row += plane.inputStride;
+			for (unsigned int i = 0; i < lineSize; ++i)
+				line[i] += w * row[i];
+		}
+
+		/* Then horizontally, with rounding. */
+		if (components == 1)
+			filterLine<1>(plane, line, dst);
+		else
+			filterLine<2>(plane, line, dst);
+
+		dst += plane.outputStride;
+	}
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Rotation and flipping post-processing stage
+ */
+
+#include "libcamera/internal/post_processing/transform.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <map>
+#include <string.h>
+
+#include <libcamera/base/utils.h>
+
+#include <libcamera/formats.h>
+
+/**
+ * \file internal/post_processing/transform.h
+ * \brief Rotation and flipping post-processing stage
+ */
+
+namespace libcamera {
+
+namespace {
+
+struct FormatPlane {
+	unsigned int bytesPerPixel;
+	unsigned int subSampling;
+};
+
+const std::map<PixelFormat, std::vector<FormatPlane>> transformFormats = {
+	{ formats::R8, { { 1, 1 } } },
+	{ formats::RGB565, { { 2, 1 } } },
+	{ formats::RGB888, { { 3, 1 } } },
+	{ formats::BGR888, { { 3, 1 } } },
+	{ formats::XRGB8888, { { 4, 1 } } },
+	{ formats::XBGR8888, { { 4, 1 } } },
+	{ formats::ARGB8888, { { 4, 1 } } },
+	{ formats::ABGR8888, { { 4, 1 } } },
+	{ formats::NV12, { { 1, 1 }, { 2, 2 } } },
+	{ formats::NV21, { { 1, 1 }, { 2, 2 } } },
+	{ formats::YUV420, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+	{ formats::YVU420, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+};
+
+/*
+ * Size of the square tiles, in pixels, used to transpose images. A tile
+ * touches as many input lines as its size, small enough to stay in the L1
+ * cache while the tile is written.
+ */
+constexpr unsigned int kTileSize = 32;
+
+} /* namespace */
+
+/**
+ * \class TransformStage
+ * \brief Post-processing stage that rotates and flips frames
+ *
+ * The transform stage applies a Transform to frames, for cameras whose
+ * pipeline can't rotate or flip images in hardware. It supports 8-bit RGB
+ * formats, RGB565, and YUV 4:2:0 formats, either semi-planar or planar. YUV
+ * 4:2:2 formats are not supported, as transposing them would change their
+ * chroma subsampling.
+ *
+ * Transforms that don't include a transposition copy lines, reversing them
+ * for horizontal flips. Transpositions read the input frame in columns, and
+ * are processed in square tiles to keep the input lines in cache while the
+ * output lines are written. The output lines are split in stripes processed
+ * in parallel with ParallelStripes.
+ */
+
+/**
+ * \brief Construct a TransformStage
+ * \param[in] transform The transform to apply to frames
+ * \param[in] stripes The number of stripes processed in parallel, or 0 to
+ * select a value based on the number of CPU cores
+ */
+TransformStage::TransformStage(Transform transform, unsigned int stripes)
+	: transform_(transform), stripes_(stripes)
+{
+}
+
+/**
+ * \brief Check if the stage supports a pixel format
+ * \param[in] format The pixel format
+ * \return True if frames in \a format can be transformed, false otherwise
+ */
+bool TransformStage::isSupported(const PixelFormat &format)
+{
+	return transformFormats.find(format) != transformFormats.end();
+}
+
+/**
+ * \copydoc PostProcessingStage::configure()
+ *
+ * The input and output pixel formats shall be identical. The output size
+ * shall be equal to the input size, transposed if the transform includes a
+ * transposition.
+ */
+int TransformStage::configure(const StreamConfiguration &inputCfg,
+			      const StreamConfiguration &outputCfg)
+{
+	const bool transpose = !!(transform_ & Transform::Transpose);
+	const bool hflip = !!(transform_ & Transform::HFlip);
+	const bool vflip = !!(transform_ & Transform::VFlip);
+
+	const Size &in = inputCfg.size;
+	const Size &out = outputCfg.size;
+
+	auto it = transformFormats.find(inputCfg.pixelFormat);
+	if (it == transformFormats.end() ||
+	    outputCfg.pixelFormat != inputCfg.pixelFormat) {
+		LOG(PostProcessing, Error)
+			<< "Unsupported transform from " << inputCfg.pixelFormat
+			<< " to " << outputCfg.pixelFormat;
+		return -EINVAL;
+	}
+
+	const Size expected = transpose ? Size(in.height, in.width) : in;
+	if (in.isNull() || out != expected) {
+		LOG(PostProcessing, Error)
+			<< "Can't apply " << transformToString(transform_)
+			<< " from " << in << " to " << out;
+		return -EINVAL;
+	}
+
+	planes_.clear();
+
+	for (const auto &[i, format] : utils::enumerate(it->second)) {
+		const unsigned int sub = format.subSampling;
+		const unsigned int bpp = format.bytesPerPixel;
+
+		if (in.width % sub || in.height % sub) {
+			LOG(PostProcessing, Error)
+				<< "Size " << in
+				<< " incompatible with chroma subsampling";
+			return -EINVAL;
+		}
+
+		const unsigned int width = in.width / sub;
+		const unsigned int height = in.height / sub;
+		const ptrdiff_t stride = planeStride(inputCfg, i);
+
+		/* Steps of the input pixels along the input lines and columns. */
+		const ptrdiff_t stepH = hflip ? -static_cast<ptrdiff_t>(bpp) : bpp;
+		const ptrdiff_t stepV = vflip ? -stride : stride;
+
+		Plane plane;
+		plane.bytesPerPixel = bpp;
+		plane.output = out / sub;
+		plane.outputStride = planeStride(outputCfg, i);
+		plane.offset = (hflip ? (width - 1) * bpp : 0) +
+			       (vflip ? (height - 1) * stride : 0);
+		plane.stepX = transpose ? stepV : stepH;
+		plane.stepY = transpose ? stepH : stepV;
+
+		planes_.push_back(plane);
+	}
+
+	return 0;
+}
+
+/**
+ * \copydoc PostProcessingStage::process()
+ */
+void TransformStage::process(Span<const Span<uint8_t>> input,
+			     Span<const Span<uint8_t>> output)
+{
+	ASSERT(input.size() >= planes_.size() && output.size() >= planes_.size());
+
+	input_ = input;
+	output_ = output;
+
+	stripes_.run([this](unsigned int index) { processStripe(index); });
+}
+
+void TransformStage::processStripe(unsigned int index)
+{
+	const unsigned int count = stripes_.count();
+
+	for (const auto &[i, plane] : utils::enumerate(planes_)) {
+		/* Align the stripes to the tiles. */
+		const unsigned int height = plane.output.height;
+		const unsigned int lines = utils::alignUp((height + count - 1) / count,
+							  kTileSize);
+		const unsigned int begin = std::min(index * lines, height);
+		const unsigned int end = std::min(begin + lines, height);
+
+		const uint8_t *src = input_[i].data();
+		uint8_t *dst = output_[i].data();
+
+		switch (plane.bytesPerPixel) {
+		case 1:
+			transformPlane<1>(plane, src, dst, begin, end);
+			break;
+		case 2:
+			transformPlane<2>(plane, src, dst, begin, end);
+			break;
+		case 3:
+			transformPlane<3>(plane, src, dst, begin, end);
+			break;
+		case 4:
+			transformPlane<4>(plane, src, dst, begin, end);
+			break;
+		}
+	}
+}
+
+template<unsigned int N>
+void TransformStage::transformPlane(const Plane &plane, const uint8_t *src,
+				    uint8_t *dst, unsigned int begin, unsigned int end)
+{
+	const unsigned int width = plane.output.width;
+	const ptrdiff_t stepX = plane.stepX;
+	const ptrdiff_t stepY = plane.stepY;
+
+	src += plane.offset;
+
+	/* Lines are contiguous in the input, copy them in a single pass. */
+	if (!(transform_ & Transform::Transpose)) {
+		for (unsigned int y = begin; y < end; ++y) {
+			const uint8_t *in = src + y * stepY;
+			uint8_t *out = dst + y * plane.outputStride;
+
+			if (stepX > 0) {
+				memcpy(out, in, width * N);
+				continue;
+			}
+
+			for (unsigned int x = 0; x < width; ++x, in -= N, out += N)
+				memcpy(out, in, N);
+		}
+
+		return;
+	}
+
+	for (unsigned int ty = begin; ty < end; ty += kTileSize) {
+		const unsigned int tileEnd = std::min(ty + kTileSize, end);
+
+		for (unsigned int tx = 0; tx < width; tx += kTileSize) {
+			const unsigned int tileWidth = std::min(kTileSize, width - tx);
+
+			for (unsigned int y = ty; y < tileEnd; ++y) {
+				const uint8_t *in = src + tx * stepX + y * stepY;
+				uint8_t *out = dst + y * plane.outputStride + tx * N;
+
+				for (unsigned int x = 0; x < tileWidth; ++x) {
+					memcpy(out, in, N);
+					in += stepX;
+					out += N;
+				}
+			}
+		}
+	}
+}
+
+} /* namespace libcamera */
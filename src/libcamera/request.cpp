@@ -7,10 +7,15 @@
 
 #include "libcamera/internal/request.h"
 
+#include <algorithm>
 #include <map>
 #include <sstream>
+#include <sys/ioctl.h>
+
+#include <linux/sync_file.h>
 
 #include <libcamera/base/log.h>
+#include <libcamera/base/utils.h>
 
 #include <libcamera/camera.h>
 #include <libcamera/control_ids.h>
@@ -32,6 +37,37 @@ namespace libcamera {
 
 LOG_DEFINE_CATEGORY(Request)
 
+namespace {
+
+/*
+ * Merge the acquire fences of all \a buffers into a single sync_file, to wait
+ * on all of them with a single event notifier. Return an invalid fd if any of
+ * the fences isn't a sync_file, in which case the fences have to be waited on
+ * individually.
+ */
+UniqueFD mergeFences(const std::vector<FrameBuffer *> &buffers)
+{
+	int fd = buffers[0]->_d()->fence()->fd().get();
+	UniqueFD merged;
+
+	for (unsigned int i = 1; i < buffers.size(); ++i) {
+		struct sync_merge_data data = {};
+
+		utils::strlcpy(data.name, "libcamera-request", sizeof(data.name));
+		data.fd2 = buffers[i]->_d()->fence()->fd().get();
+
+		if (ioctl(fd, SYNC_IOC_MERGE, &data) < 0)
+			return {};
+
+		merged = UniqueFD(data.fence);
+		fd = merged.get();
+	}
+
+	return merged;
+}
+
+} /* namespace */
+
 /**
  * \class Request::Private
  * \brief Request private data
@@ -170,7 +206,13 @@ void Request::Private::reset()
 	prepared_ = false;
 	pending_.clear();
 	notifiers_.clear();
-	timer_.reset();
+
+	/*
+	 * Keep the timer for the next preparation unless it's still running,
+	 * as it can only be stopped from the thread it is bound to.
+	 */
+	if (timer_ && timer_->isRunning())
+		timer_.reset();
 }
 
 /*
@@ -195,6 +237,11 @@ void Request::Private::emitPrepareCompleted()
  * fences have been signalled correctly before the timeout expires the Request
  * is cancelled.
  *
+ * When the acquire fences are sync_file instances, they are merged into a
+ * single sync_file, so that waiting on a request costs a single event notifier
+ * regardless of the number of buffers it contains. Other fences are waited on
+ * individually.
+ *
  * The function immediately emits the prepared signal if all the prepare
  * operations have been completed synchronously. If instead the prepare
  * operations require to wait the completion of asynchronous events, such as
@@ -215,37 +262,43 @@ void Request::Private::emitPrepareCompleted()
  */
 void Request::Private::prepare(std::chrono::milliseconds timeout)
 {
-	/* Create and connect one notifier for each synchronization fence. */
-	for (FrameBuffer *buffer : pending_) {
-		const Fence *fence = buffer->_d()->fence();
-		if (!fence)
-			continue;
-
-		std::unique_ptr<EventNotifier> notifier =
-			std::make_unique<EventNotifier>(fence->fd().get(),
-							EventNotifier::Read);
-
-		notifier->activated.connect(this, [this, buffer] {
-							notifierActivated(buffer);
-					    });
+	std::vector<FrameBuffer *> buffers;
 
-		notifiers_[buffer] = std::move(notifier);
+	for (FrameBuffer *buffer : pending_) {
+		if (buffer->_d()->fence())
+			buffers.push_back(buffer);
 	}
 
-	if (notifiers_.empty()) {
+	if (buffers.empty()) {
 		emitPrepareCompleted();
 		return;
 	}
 
+	/*
+	 * Wait on a single merged fence if possible, or create one notifier
+	 * for each synchronization fence otherwise.
+	 */
+	UniqueFD merged = buffers.size() > 1 ? mergeFences(buffers) : UniqueFD();
+	if (merged.isValid()) {
+		addFenceNotifier(std::move(buffers), std::move(merged));
+	} else {
+		for (FrameBuffer *buffer : buffers)
+			addFenceNotifier({ buffer }, {});
+	}
+
 	/*
 	 * In case a timeout is specified, create a timer and set it up.
 	 *
 	 * The timer must be created here instead of in the Request constructor,
-	 * in order to be bound to the pipeline handler thread.
+	 * in order to be bound to the pipeline handler thread. It is reused
+	 * when the request is prepared again.
 	 */
 	if (timeout != 0ms) {
-		timer_ = std::make_unique<Timer>();
-		timer_->timeout.connect(this, &Request::Private::timeout);
+		if (!timer_) {
+			timer_ = std::make_unique<Timer>();
+			timer_->timeout.connect(this, &Request::Private::timeout);
+		}
+
 		timer_->start(timeout);
 	}
 }
@@ -263,27 +316,49 @@ void Request::Private::prepare(std::chrono::milliseconds timeout)
  * if they have failed preparing.
  */
 
-void Request::Private::notifierActivated(FrameBuffer *buffer)
+void Request::Private::addFenceNotifier(std::vector<FrameBuffer *> buffers,
+					UniqueFD mergedFence)
 {
-	/* Close the fence if successfully signalled. */
-	ASSERT(buffer);
-	buffer->releaseFence();
+	FenceNotifier &fence = notifiers_.emplace_back();
 
-	/* Remove the entry from the map and check if other fences are pending. */
-	auto it = notifiers_.find(buffer);
-	ASSERT(it != notifiers_.end());
-	notifiers_.erase(it);
+	fence.buffers = std::move(buffers);
+	fence.mergedFence = std::move(mergedFence);
+
+	int fd = fence.mergedFence.isValid()
+	       ? fence.mergedFence.get()
+	       : fence.buffers[0]->_d()->fence()->fd().get();
 
+	fence.notifier = std::make_unique<EventNotifier>(fd, EventNotifier::Read);
+	fence.notifier->activated.connect(this, [this, &fence] {
+						  notifierActivated(&fence);
+					  });
+}
+
+void Request::Private::notifierActivated(FenceNotifier *fence)
+{
 	Request *request = _o<Request>();
-	LOG(Request, Debug)
-		<< "Request " << request->cookie() << " buffer " << buffer
-		<< " fence signalled";
+
+	/* Close the fences if successfully signalled. */
+	for (FrameBuffer *buffer : fence->buffers) {
+		buffer->releaseFence();
+
+		LOG(Request, Debug)
+			<< "Request " << request->cookie() << " buffer " << buffer
+			<< " fence signalled";
+	}
+
+	/* Remove the entry from the list and check if other fences are pending. */
+	auto it = std::find_if(notifiers_.begin(), notifiers_.end(),
+			       [fence](const FenceNotifier &f) { return &f == fence; });
+	ASSERT(it != notifiers_.end());
+	notifiers_.erase(it);
 
 	if (!notifiers_.empty())
 		return;
 
-	/* All fences completed, delete the timer and emit the prepared signal. */
-	timer_.reset();
+	/* All fences completed, stop the timer and emit the prepared signal. */
+	if (timer_)
+		timer_->stop();
 	emitPrepareCompleted();
 }
 
@@ -122,6 +122,8 @@ int CameraSensor::init()
 	subdev_->setControls(&ctrls);
 
 	/* Enumerate, sort and cache media bus codes and sizes. */
+	clearFormatCache();
+
 	formats_ = subdev_->formats(pad_);
 	if (formats_.empty()) {
 		LOG(CameraSensor, Error) << "No image format found";
@@ -701,6 +703,36 @@ Size CameraSensor::resolution() const
  */
 V4L2SubdeviceFormat CameraSensor::getFormat(const std::vector<unsigned int> &mbusCodes,
 					    const Size &size) const
+{
+	/*
+	 * Format negotiation calls this function repeatedly with the same
+	 * arguments, memoise the result. The memo is cleared when the sensor
+	 * formats are enumerated.
+	 */
+	MutexLocker locker(formatCacheMutex_);
+
+	for (const FormatCacheEntry &entry : formatCache_) {
+		if (entry.size == size && entry.mbusCodes == mbusCodes)
+			return entry.format;
+	}
+
+	V4L2SubdeviceFormat format = findFormat(mbusCodes, size);
+
+	if (formatCache_.size() >= kFormatCacheSize)
+		formatCache_.erase(formatCache_.begin());
+	formatCache_.push_back({ mbusCodes, size, format });
+
+	return format;
+}
+
+void CameraSensor::clearFormatCache()
+{
+	MutexLocker locker(formatCacheMutex_);
+	formatCache_.clear();
+}
+
+V4L2SubdeviceFormat CameraSensor::findFormat(const std::vector<unsigned int> &mbusCodes,
+					     const Size &size) const
 {
 	unsigned int desiredArea = size.width * size.height;
 	unsigned int bestArea = UINT_MAX;
@@ -19,28 +19,73 @@ namespace libcamera {
  */
 
 /**
- * \var DebayerParams::kRGBLookupSize
- * \brief Size of a color lookup table
+ * \var DebayerParams::kGainOne
+ * \brief Value of the colour gains corresponding to a gain of 1.0
+ *
+ * The colour gains are fixed-point values with 8 fractional bits: 128 is a
+ * gain of 0.5, 256 a gain of 1.0 and 512 a gain of 2.0.
+ */
+
+/**
+ * \var DebayerParams::blackLevel
+ * \brief Black level of the raw input, on a 16-bit scale
+ *
+ * The black level is expressed on a 16-bit scale regardless of the bit depth
+ * of the sensor, and is subtracted from the raw values at their native
+ * precision before the colour gains are applied.
  */
 
 /**
- * \typedef DebayerParams::ColorLookupTable
- * \brief Type of the lookup tables for red, green, blue values
+ * \var DebayerParams::gainR
+ * \brief Red colour gain, in units of 1/kGainOne
  */
 
 /**
- * \var DebayerParams::red
- * \brief Lookup table for red color, mapping input values to output values
+ * \var DebayerParams::gainG
+ * \brief Green colour gain, in units of 1/kGainOne
  */
 
 /**
- * \var DebayerParams::green
- * \brief Lookup table for green color, mapping input values to output values
+ * \var DebayerParams::gainB
+ * \brief Blue colour gain, in units of 1/kGainOne
  */
 
 /**
- * \var DebayerParams::blue
- * \brief Lookup table for blue color, mapping input values to output values
+ * \var DebayerParams::gamma
+ * \brief Exponent of the gamma curve applied after the colour gains
+ */
+
+/**
+ * \var DebayerParams::denoise
+ * \brief Strength of the spatial noise reduction
+ *
+ * Fraction, in 1/256 units, by which the output image details smaller than
+ * noiseLevel are attenuated. 0 disables spatial noise reduction.
+ */
+
+/**
+ * \var DebayerParams::sharpen
+ * \brief Strength of the sharpening
+ *
+ * Fraction, in 1/256 units, by which the output image details larger than
+ * noiseLevel are amplified. 0 disables sharpening.
+ */
+
+/**
+ * \var DebayerParams::temporal
+ * \brief Strength of the temporal noise reduction
+ *
+ * Weight, in 1/256 units, of the previous output frame blended into the
+ * current frame in static areas. 0 disables temporal noise reduction.
+ */
+
+/**
+ * \var DebayerParams::noiseLevel
+ * \brief Amplitude of the noise in the output image
+ *
+ * Differences between output samples and their local average, or between
+ * consecutive frames, that are smaller than the noise level are considered as
+ * noise. The noise level is expressed in 8-bit output sample values.
  */
 
 /**
@@ -11,7 +11,10 @@
 
 #include "debayer_cpu.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <libcamera/formats.h>
@@ -22,6 +25,79 @@
 
 namespace libcamera {
 
+namespace {
+
+/*
+ * The filter processes lines in blocks of a fixed number of bytes. At -O2 the
+ * compiler only vectorises loops with a trip count known at compile time.
+ */
+constexpr int kFilterBlockSize = 16;
+
+/*
+ * The strengths are stored on 16 bits, with ranges such that all intermediate
+ * values of the filter fit in 16 bits.
+ */
+struct FilterStrengths {
+	uint16_t noise;
+	uint16_t motion;
+	uint16_t attenuation;
+	uint16_t amplification;
+	int16_t temporal;
+};
+
+void filterColumns(uint16_t *__restrict columns, const uint8_t *__restrict prev,
+		   const uint8_t *__restrict curr, const uint8_t *__restrict next)
+{
+	for (int i = 0; i < kFilterBlockSize; i++)
+		columns[i] = prev[i] + 2 * curr[i] + next[i];
+}
+
+/*
+ * All computations are truncated to 16 bits explicitly. C++ promotes them to
+ * int, which would otherwise make the compiler vectorise the loop with 32-bit
+ * lanes, halving the number of samples processed per instruction.
+ */
+template<bool Blend, bool Store>
+void filterBlock(uint8_t *__restrict dst, const uint8_t *__restrict curr,
+		 const uint16_t *__restrict columns, uint8_t *__restrict reference,
+		 const FilterStrengths &strengths)
+{
+	for (int i = 0; i < kFilterBlockSize; i++) {
+		/* Neighbouring pixels are 3 bytes apart, the sum is at most 4088 */
+		uint16_t sum = columns[i - 3] + 2 * columns[i] + columns[i + 3] + 8;
+		int16_t blur = sum >> 4;
+
+		int16_t detail = curr[i] - blur;
+		uint16_t magnitude = detail < 0 ? -detail : detail;
+		uint16_t small = std::min(magnitude, strengths.noise);
+
+		/* At most 255 * 127 + 32 */
+		uint16_t scaled = small * strengths.attenuation +
+				  (magnitude - small) * strengths.amplification + 32;
+		magnitude = scaled >> 6;
+
+		int16_t value = blur + (detail < 0 ? -magnitude : magnitude);
+
+		if (Blend) {
+			int16_t diff = reference[i] - value;
+			uint16_t distance = diff < 0 ? -diff : diff;
+			diff = distance <= strengths.motion ? diff : 0;
+
+			/* At most 510 * 63 in absolute value */
+			int16_t weighted = diff * strengths.temporal;
+			value += weighted / 64;
+		}
+
+		value = std::clamp<int16_t>(value, 0, 255);
+		dst[i] = value;
+
+		if (Store)
+			reference[i] = value;
+	}
+}
+
+} /* namespace */
+
 /**
  * \class DebayerCpu
  * \brief Class for debayering on the CPU
@@ -46,12 +122,14 @@ DebayerCpu::DebayerCpu(std::unique_ptr<SwStatsCpu> stats)
 	 */
 	enableInputMemcpy_ = true;
 
-	/* Initialize color lookup tables */
-	for (unsigned int i = 0; i < DebayerParams::kRGBLookupSize; i++)
-		red_[i] = green_[i] = blue_[i] = i;
+	lookupBits_ = 8;
+	lookupValid_ = false;
 
 	for (unsigned int i = 0; i < kMaxLineBuffers; i++)
 		lineBuffers_[i] = nullptr;
+
+	filterEnabled_ = false;
+	referenceValid_ = false;
 }
 
 DebayerCpu::~DebayerCpu()
@@ -70,10 +148,10 @@ DebayerCpu::~DebayerCpu()
  * GBG
  * RGR
  */
-#define BGGR_BGR888(p, n, div)                                                                \
-	*dst++ = blue_[curr[x] / (div)];                                                      \
-	*dst++ = green_[(prev[x] + curr[x - p] + curr[x + n] + next[x]) / (4 * (div))];       \
-	*dst++ = red_[(prev[x - p] + prev[x + n] + next[x - p] + next[x + n]) / (4 * (div))]; \
+#define BGGR_BGR888(p, n)                                                           \
+	*dst++ = blue_[curr[x]];                                                    \
+	*dst++ = green_[(prev[x] + curr[x - p] + curr[x + n] + next[x]) / 4];       \
+	*dst++ = red_[(prev[x - p] + prev[x + n] + next[x - p] + next[x + n]) / 4]; \
 	x++;
 
 /*
@@ -81,10 +159,10 @@ DebayerCpu::~DebayerCpu()
  * RGR
  * GBG
  */
-#define GRBG_BGR888(p, n, div)                                    \
-	*dst++ = blue_[(prev[x] + next[x]) / (2 * (div))];        \
-	*dst++ = green_[curr[x] / (div)];                         \
-	*dst++ = red_[(curr[x - p] + curr[x + n]) / (2 * (div))]; \
+#define GRBG_BGR888(p, n)                               \
+	*dst++ = blue_[(prev[x] + next[x]) / 2];        \
+	*dst++ = green_[curr[x]];                       \
+	*dst++ = red_[(curr[x - p] + curr[x + n]) / 2]; \
 	x++;
 
 /*
@@ -92,10 +170,10 @@ DebayerCpu::~DebayerCpu()
  * BGB
  * GRG
  */
-#define GBRG_BGR888(p, n, div)                                     \
-	*dst++ = blue_[(curr[x - p] + curr[x + n]) / (2 * (div))]; \
-	*dst++ = green_[curr[x] / (div)];                          \
-	*dst++ = red_[(prev[x] + next[x]) / (2 * (div))];          \
+#define GBRG_BGR888(p, n)                                \
+	*dst++ = blue_[(curr[x - p] + curr[x + n]) / 2]; \
+	*dst++ = green_[curr[x]];                        \
+	*dst++ = red_[(prev[x] + next[x]) / 2];          \
 	x++;
 
 /*
@@ -103,10 +181,10 @@ DebayerCpu::~DebayerCpu()
  * GRG
  * BGB
  */
-#define RGGB_BGR888(p, n, div)                                                                 \
-	*dst++ = blue_[(prev[x - p] + prev[x + n] + next[x - p] + next[x + n]) / (4 * (div))]; \
-	*dst++ = green_[(prev[x] + curr[x - p] + curr[x + n] + next[x]) / (4 * (div))];        \
-	*dst++ = red_[curr[x] / (div)];                                                        \
+#define RGGB_BGR888(p, n)                                                            \
+	*dst++ = blue_[(prev[x - p] + prev[x + n] + next[x - p] + next[x + n]) / 4]; \
+	*dst++ = green_[(prev[x] + curr[x - p] + curr[x + n] + next[x]) / 4];        \
+	*dst++ = red_[curr[x]];                                                      \
 	x++;
 
 void DebayerCpu::debayer8_BGBG_BGR888(uint8_t *dst, const uint8_t *src[])
@@ -114,8 +192,8 @@ void DebayerCpu::debayer8_BGBG_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint8_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		BGGR_BGR888(1, 1, 1)
-		GBRG_BGR888(1, 1, 1)
+		BGGR_BGR888(1, 1)
+		GBRG_BGR888(1, 1)
 	}
 }
 
@@ -124,8 +202,8 @@ void DebayerCpu::debayer8_GRGR_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint8_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		GRBG_BGR888(1, 1, 1)
-		RGGB_BGR888(1, 1, 1)
+		GRBG_BGR888(1, 1)
+		RGGB_BGR888(1, 1)
 	}
 }
 
@@ -134,9 +212,8 @@ void DebayerCpu::debayer10_BGBG_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint16_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		/* divide values by 4 for 10 -> 8 bpp value */
-		BGGR_BGR888(1, 1, 4)
-		GBRG_BGR888(1, 1, 4)
+		BGGR_BGR888(1, 1)
+		GBRG_BGR888(1, 1)
 	}
 }
 
@@ -145,9 +222,8 @@ void DebayerCpu::debayer10_GRGR_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint16_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		/* divide values by 4 for 10 -> 8 bpp value */
-		GRBG_BGR888(1, 1, 4)
-		RGGB_BGR888(1, 1, 4)
+		GRBG_BGR888(1, 1)
+		RGGB_BGR888(1, 1)
 	}
 }
 
@@ -156,9 +232,8 @@ void DebayerCpu::debayer12_BGBG_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint16_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		/* divide values by 16 for 12 -> 8 bpp value */
-		BGGR_BGR888(1, 1, 16)
-		GBRG_BGR888(1, 1, 16)
+		BGGR_BGR888(1, 1)
+		GBRG_BGR888(1, 1)
 	}
 }
 
@@ -167,9 +242,8 @@ void DebayerCpu::debayer12_GRGR_BGR888(uint8_t *dst, const uint8_t *src[])
 	DECLARE_SRC_POINTERS(uint16_t)
 
 	for (int x = 0; x < (int)window_.width;) {
-		/* divide values by 16 for 12 -> 8 bpp value */
-		GRBG_BGR888(1, 1, 16)
-		RGGB_BGR888(1, 1, 16)
+		GRBG_BGR888(1, 1)
+		RGGB_BGR888(1, 1)
 	}
 }
 
@@ -187,12 +261,12 @@ void DebayerCpu::debayer10P_BGBG_BGR888(uint8_t *dst, const uint8_t *src[])
 	 */
 	for (int x = 0; x < widthInBytes;) {
 		/* First pixel */
-		BGGR_BGR888(2, 1, 1)
+		BGGR_BGR888(2, 1)
 		/* Second pixel BGGR -> GBRG */
-		GBRG_BGR888(1, 1, 1)
+		GBRG_BGR888(1, 1)
 		/* Same thing for third and fourth pixels */
-		BGGR_BGR888(1, 1, 1)
-		GBRG_BGR888(1, 2, 1)
+		BGGR_BGR888(1, 1)
+		GBRG_BGR888(1, 2)
 		/* Skip 5th src byte with 4 x 2 least-significant-bits */
 		x++;
 	}
@@ -207,12 +281,12 @@ void DebayerCpu::debayer10P_GRGR_BGR888(uint8_t *dst, const uint8_t *src[])
 
 	for (int x = 0; x < widthInBytes;) {
 		/* First pixel */
-		GRBG_BGR888(2, 1, 1)
+		GRBG_BGR888(2, 1)
 		/* Second pixel GRBG -> RGGB */
-		RGGB_BGR888(1, 1, 1)
+		RGGB_BGR888(1, 1)
 		/* Same thing for third and fourth pixels */
-		GRBG_BGR888(1, 1, 1)
-		RGGB_BGR888(1, 2, 1)
+		GRBG_BGR888(1, 1)
+		RGGB_BGR888(1, 2)
 		/* Skip 5th src byte with 4 x 2 least-significant-bits */
 		x++;
 	}
@@ -227,12 +301,12 @@ void DebayerCpu::debayer10P_GBGB_BGR888(uint8_t *dst, const uint8_t *src[])
 
 	for (int x = 0; x < widthInBytes;) {
 		/* Even pixel */
-		GBRG_BGR888(2, 1, 1)
+		GBRG_BGR888(2, 1)
 		/* Odd pixel GBGR -> BGGR */
-		BGGR_BGR888(1, 1, 1)
+		BGGR_BGR888(1, 1)
 		/* Same thing for next 2 pixels */
-		GBRG_BGR888(1, 1, 1)
-		BGGR_BGR888(1, 2, 1)
+		GBRG_BGR888(1, 1)
+		BGGR_BGR888(1, 2)
 		/* Skip 5th src byte with 4 x 2 least-significant-bits */
 		x++;
 	}
@@ -247,12 +321,12 @@ void DebayerCpu::debayer10P_RGRG_BGR888(uint8_t *dst, const uint8_t *src[])
 
 	for (int x = 0; x < widthInBytes;) {
 		/* Even pixel */
-		RGGB_BGR888(2, 1, 1)
+		RGGB_BGR888(2, 1)
 		/* Odd pixel RGGB -> GRBG */
-		GRBG_BGR888(1, 1, 1)
+		GRBG_BGR888(1, 1)
 		/* Same thing for next 2 pixels */
-		RGGB_BGR888(1, 1, 1)
-		GRBG_BGR888(1, 2, 1)
+		RGGB_BGR888(1, 1)
+		GRBG_BGR888(1, 2)
 		/* Skip 5th src byte with 4 x 2 least-significant-bits */
 		x++;
 	}
@@ -381,6 +455,9 @@ int DebayerCpu::setDebayerFunctions(PixelFormat inputFormat, PixelFormat outputF
 	if ((bayerFormat.bitDepth == 8 || bayerFormat.bitDepth == 10 || bayerFormat.bitDepth == 12) &&
 	    bayerFormat.packing == BayerFormat::Packing::None &&
 	    isStandardBayerOrder(bayerFormat.order)) {
+		/* The lookup tables are indexed at the native bit depth */
+		lookupBits_ = bayerFormat.bitDepth;
+
 		switch (bayerFormat.bitDepth) {
 		case 8:
 			debayer0_ = &DebayerCpu::debayer8_BGBG_BGR888;
@@ -401,6 +478,9 @@ int DebayerCpu::setDebayerFunctions(PixelFormat inputFormat, PixelFormat outputF
 
 	if (bayerFormat.bitDepth == 10 &&
 	    bayerFormat.packing == BayerFormat::Packing::CSI2) {
+		/* Only the 8 most significant bits of packed pixels are used */
+		lookupBits_ = 8;
+
 		switch (bayerFormat.order) {
 		case BayerFormat::BGGR:
 			debayer0_ = &DebayerCpu::debayer10P_BGBG_BGR888;
@@ -469,6 +549,9 @@ int DebayerCpu::configure(const StreamConfiguration &inputCfg,
 	if (setDebayerFunctions(inputCfg.pixelFormat, outputCfg.pixelFormat) != 0)
 		return -EINVAL;
 
+	/* The bit depth may have changed, rebuild the lookup tables. */
+	lookupValid_ = false;
+
 	window_.x = ((inputCfg.size.width - outputCfg.size.width) / 2) &
 		    ~(inputConfig_.patternSize.width - 1);
 	window_.y = ((inputCfg.size.height - outputCfg.size.height) / 2) &
@@ -492,6 +575,16 @@ int DebayerCpu::configure(const StreamConfiguration &inputCfg,
 			return -ENOMEM;
 	}
 
+	/*
+	 * Three debayered lines, padded with one pixel on both sides, and with
+	 * one block at the end for the vertical filter to process whole blocks.
+	 */
+	filterLineLength_ = (window_.width + 2) * 3 + kFilterBlockSize;
+	filterLines_.resize(3 * filterLineLength_);
+	filterColumns_.resize(filterLineLength_);
+	reference_.clear();
+	referenceValid_ = false;
+
 	measuredFrames_ = 0;
 	frameProcessTime_ = 0;
 
@@ -578,6 +671,197 @@ void DebayerCpu::memcpyNextLine(const uint8_t *linePointers[])
 	lineBufferIndex_ = (lineBufferIndex_ + 1) % (patternHeight + 1);
 }
 
+/*
+ * The lookup tables combine black level subtraction, the colour gains and the
+ * gamma curve, and are indexed by raw values at the native bit depth of the
+ * input. Building them costs one pass over up to 4096 entries per table, they
+ * are thus only rebuilt when the parameters they depend on change. A change of
+ * a colour gain only rebuilds the table of that colour, while the gamma curve
+ * is only recomputed when the gamma value changes.
+ */
+void DebayerCpu::updateLookupTables(const DebayerParams &params)
+{
+	const unsigned int size = 1U << lookupBits_;
+	const unsigned int maxValue = size - 1;
+	const unsigned int blackLevel =
+		std::min<unsigned int>(params.blackLevel >> (16 - lookupBits_),
+				       maxValue - 1);
+	const std::array<uint16_t, 3> gains = {
+		swapRedBlueGains_ ? params.gainB : params.gainR,
+		params.gainG,
+		swapRedBlueGains_ ? params.gainR : params.gainB,
+	};
+	const std::array<LookupTable *, 3> tables = { &red_, &green_, &blue_ };
+
+	bool rebuild = !lookupValid_ || blackLevel != lookupBlackLevel_;
+
+	if (!lookupValid_ || params.gamma != lookupGamma_) {
+		for (unsigned int i = 0; i < size; i++)
+			gammaTable_[i] = UINT8_MAX *
+					 std::pow(i / static_cast<double>(maxValue),
+						  params.gamma);
+
+		lookupGamma_ = params.gamma;
+		rebuild = true;
+	}
+
+	for (unsigned int c = 0; c < tables.size(); c++) {
+		if (!rebuild && gains[c] == lookupGains_[c])
+			continue;
+
+		/*
+		 * Scale the values above the black level to the full range,
+		 * and apply the gain. The factor has 16 fractional bits, round
+		 * the scaled values to the nearest gamma table entry.
+		 */
+		const uint64_t factor = (static_cast<uint64_t>(gains[c]) << 8) *
+					maxValue / (maxValue - blackLevel);
+		LookupTable &table = *tables[c];
+
+		for (unsigned int i = 0; i < size; i++) {
+			const uint64_t value = i > blackLevel
+						     ? ((i - blackLevel) * factor + (1U << 15)) >> 16
+						     : 0;
+			table[i] = gammaTable_[std::min<uint64_t>(value, maxValue)];
+		}
+
+		lookupGains_[c] = gains[c];
+	}
+
+	lookupBlackLevel_ = blackLevel;
+	lookupValid_ = true;
+}
+
+/*
+ * The denoise and sharpening filter splits each output sample into a local
+ * average, computed with a 3x3 binomial kernel, and a detail. Details smaller
+ * than the noise level are attenuated, larger details are amplified. Samples
+ * that differ from the previous output frame by less than twice the noise
+ * level are then blended with it, which reduces noise in static areas without
+ * ghosting on moving objects.
+ *
+ * The filter needs the next line to process the current one, lines are thus
+ * debayered to a ring of three cached line buffers, and written to the output
+ * buffer with a delay of one line. The cost per sample is fixed and the loops
+ * are free of data-dependent branches, so that the compiler can vectorise
+ * them.
+ */
+void DebayerCpu::setupFilter(const DebayerParams &params)
+{
+	denoise_ = params.denoise;
+	sharpen_ = params.sharpen;
+	temporal_ = params.temporal;
+	noiseLevel_ = params.noiseLevel;
+
+	filterEnabled_ = denoise_ || sharpen_ || temporal_;
+	filterLineCount_ = 0;
+
+	if (!temporal_) {
+		referenceValid_ = false;
+		return;
+	}
+
+	reference_.resize(window_.width * 3 * window_.height);
+}
+
+uint8_t *DebayerCpu::filterLineBuffer(unsigned int y)
+{
+	return filterLines_.data() + (y % 3) * filterLineLength_ + 3;
+}
+
+void DebayerCpu::debayerLine(debayerFn debayer, uint8_t *dst, const uint8_t *src[])
+{
+	if (!filterEnabled_) {
+		(this->*debayer)(dst, src);
+		return;
+	}
+
+	const unsigned int y = filterLineCount_++;
+	const unsigned int length = window_.width * 3;
+	uint8_t *line = filterLineBuffer(y);
+
+	(this->*debayer)(line, src);
+
+	/* Replicate the first and last pixels in the padding */
+	memcpy(line - 3, line, 3);
+	memcpy(line + length, line + length - 3, 3);
+
+	if (y)
+		filterOutputLine(y - 1, line);
+
+	filterDst_ = dst;
+}
+
+void DebayerCpu::filterOutputLine(unsigned int y, const uint8_t *next)
+{
+	const uint8_t *curr = filterLineBuffer(y);
+	const uint8_t *prev = y ? filterLineBuffer(y - 1) : curr;
+
+	if (!temporal_) {
+		filterLine<false, false>(filterDst_, prev, curr, next, nullptr);
+		return;
+	}
+
+	uint8_t *reference = reference_.data() + y * window_.width * 3;
+
+	if (!referenceValid_)
+		filterLine<false, true>(filterDst_, prev, curr, next, reference);
+	else
+		filterLine<true, true>(filterDst_, prev, curr, next, reference);
+}
+
+template<bool Blend, bool Store>
+void DebayerCpu::filterLine(uint8_t *__restrict dst, const uint8_t *prev,
+			    const uint8_t *curr, const uint8_t *next,
+			    uint8_t *__restrict reference)
+{
+	const int length = window_.width * 3;
+	const FilterStrengths strengths = {
+		static_cast<uint16_t>(noiseLevel_),
+		static_cast<uint16_t>(2 * noiseLevel_),
+		/* Use 1/64 units to keep the intermediate values within 16 bits */
+		static_cast<uint16_t>((256 - denoise_) / 4),
+		static_cast<uint16_t>((256 + sharpen_) / 4),
+		static_cast<int16_t>(temporal_ / 4),
+	};
+
+	/*
+	 * Filter vertically first, including the padding pixels. The line
+	 * buffers are padded to a whole number of blocks.
+	 */
+	uint16_t *columns = filterColumns_.data() + 3;
+
+	for (int i = -3; i < length + 3; i += kFilterBlockSize)
+		filterColumns(columns + i, prev + i, curr + i, next + i);
+
+	/*
+	 * Filter the last partial block to temporary buffers, as neither the
+	 * destination nor the reference are padded.
+	 */
+	uint8_t dstTail[kFilterBlockSize];
+	uint8_t referenceTail[kFilterBlockSize] = {};
+
+	for (int i = 0; i < length; i += kFilterBlockSize) {
+		const int count = std::min(length - i, kFilterBlockSize);
+		uint8_t *out = count == kFilterBlockSize ? dst + i : dstTail;
+		uint8_t *ref = nullptr;
+
+		if (Store) {
+			ref = count == kFilterBlockSize ? reference + i : referenceTail;
+			if (Blend && ref == referenceTail)
+				memcpy(referenceTail, reference + i, count);
+		}
+
+		filterBlock<Blend, Store>(out, curr + i, columns + i, ref, strengths);
+
+		if (out == dstTail) {
+			memcpy(dst + i, dstTail, count);
+			if (Store)
+				memcpy(reference + i, referenceTail, count);
+		}
+	}
+}
+
 void DebayerCpu::process2(const uint8_t *src, uint8_t *dst)
 {
 	unsigned int yEnd = window_.y + window_.height;
@@ -605,13 +889,13 @@ void DebayerCpu::process2(const uint8_t *src, uint8_t *dst)
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
 		stats_->processLine0(y, linePointers);
-		(this->*debayer0_)(dst, linePointers);
+		debayerLine(debayer0_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
-		(this->*debayer1_)(dst, linePointers);
+		debayerLine(debayer1_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 	}
@@ -620,14 +904,14 @@ void DebayerCpu::process2(const uint8_t *src, uint8_t *dst)
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
 		stats_->processLine0(yEnd, linePointers);
-		(this->*debayer0_)(dst, linePointers);
+		debayerLine(debayer0_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 
 		shiftLinePointers(linePointers, src);
 		/* next line may point outside of src, use prev. */
 		linePointers[2] = linePointers[0];
-		(this->*debayer1_)(dst, linePointers);
+		debayerLine(debayer1_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 	}
@@ -657,26 +941,26 @@ void DebayerCpu::process4(const uint8_t *src, uint8_t *dst)
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
 		stats_->processLine0(y, linePointers);
-		(this->*debayer0_)(dst, linePointers);
+		debayerLine(debayer0_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
-		(this->*debayer1_)(dst, linePointers);
+		debayerLine(debayer1_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
 		stats_->processLine2(y, linePointers);
-		(this->*debayer2_)(dst, linePointers);
+		debayerLine(debayer2_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 
 		shiftLinePointers(linePointers, src);
 		memcpyNextLine(linePointers);
-		(this->*debayer3_)(dst, linePointers);
+		debayerLine(debayer3_, dst, linePointers);
 		src += inputConfig_.stride;
 		dst += outputConfig_.stride;
 	}
@@ -697,9 +981,9 @@ void DebayerCpu::process(FrameBuffer *input, FrameBuffer *output, DebayerParams
 		clock_gettime(CLOCK_MONOTONIC_RAW, &frameStartTime);
 	}
 
-	green_ = params.green;
-	red_ = swapRedBlueGains_ ? params.blue : params.red;
-	blue_ = swapRedBlueGains_ ? params.red : params.blue;
+	updateLookupTables(params);
+
+	setupFilter(params);
 
 	/* Copy metadata from the input buffer */
 	FrameMetadata &metadata = output->_d()->metadata();
@@ -722,6 +1006,11 @@ void DebayerCpu::process(FrameBuffer *input, FrameBuffer *output, DebayerParams
 	else
 		process4(in.planes()[0].data(), out.planes()[0].data());
 
+	if (filterEnabled_) {
+		filterOutputLine(filterLineCount_ - 1, filterLineBuffer(filterLineCount_ - 1));
+		referenceValid_ = temporal_;
+	}
+
 	metadata.planes()[0].bytesused = out.planes()[0].size();
 
 	/* Measure before emitting signals */
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <stdint.h>
 #include <vector>
@@ -119,15 +120,36 @@ private:
 	void setupInputMemcpy(const uint8_t *linePointers[]);
 	void shiftLinePointers(const uint8_t *linePointers[], const uint8_t *src);
 	void memcpyNextLine(const uint8_t *linePointers[]);
+	void debayerLine(debayerFn debayer, uint8_t *dst, const uint8_t *src[]);
+	void updateLookupTables(const DebayerParams &params);
+	void setupFilter(const DebayerParams &params);
+	uint8_t *filterLineBuffer(unsigned int y);
+	void filterOutputLine(unsigned int y, const uint8_t *next);
+	template<bool Blend, bool Store>
+	void filterLine(uint8_t *__restrict dst, const uint8_t *prev,
+			const uint8_t *curr, const uint8_t *next,
+			uint8_t *__restrict reference);
 	void process2(const uint8_t *src, uint8_t *dst);
 	void process4(const uint8_t *src, uint8_t *dst);
 
 	/* Max. supported Bayer pattern height is 4, debayering this requires 5 lines */
 	static constexpr unsigned int kMaxLineBuffers = 5;
 
-	DebayerParams::ColorLookupTable red_;
-	DebayerParams::ColorLookupTable green_;
-	DebayerParams::ColorLookupTable blue_;
+	/* Lookup tables are indexed by raw values at up to 12 bits precision */
+	static constexpr unsigned int kMaxLookupSize = 1 << 12;
+
+	using LookupTable = std::array<uint8_t, kMaxLookupSize>;
+
+	LookupTable red_;
+	LookupTable green_;
+	LookupTable blue_;
+	/* Parameters the lookup tables have been built from */
+	LookupTable gammaTable_;
+	unsigned int lookupBits_;
+	bool lookupValid_;
+	float lookupGamma_;
+	unsigned int lookupBlackLevel_;
+	std::array<uint16_t, 3> lookupGains_;
 	debayerFn debayer0_;
 	debayerFn debayer1_;
 	debayerFn debayer2_;
@@ -141,6 +163,19 @@ private:
 	unsigned int lineBufferPadding_;
 	unsigned int lineBufferIndex_;
 	unsigned int xShift_; /* Offset of 0/1 applied to window_.x */
+	/* Denoise and sharpening filter, applied to the debayered lines */
+	bool filterEnabled_;
+	unsigned int denoise_;
+	unsigned int sharpen_;
+	unsigned int temporal_;
+	unsigned int noiseLevel_;
+	std::vector<uint8_t> filterLines_;
+	std::vector<uint16_t> filterColumns_;
+	unsigned int filterLineLength_;
+	unsigned int filterLineCount_;
+	uint8_t *filterDst_;
+	std::vector<uint8_t> reference_;
+	bool referenceValid_;
 	bool enableInputMemcpy_;
 	bool swapRedBlueGains_;
 	unsigned int measuredFrames_;
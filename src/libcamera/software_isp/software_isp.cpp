@@ -7,7 +7,6 @@
 
 #include "libcamera/internal/software_isp/software_isp.h"
 
-#include <cmath>
 #include <stdint.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -21,6 +20,7 @@
 #include "libcamera/internal/ipa_manager.h"
 #include "libcamera/internal/mapped_framebuffer.h"
 #include "libcamera/internal/software_isp/debayer_params.h"
+#include "libcamera/internal/software_isp/swisp_stats.h"
 
 #include "debayer_cpu.h"
 
@@ -70,23 +70,6 @@ SoftwareIsp::SoftwareIsp(PipelineHandler *pipe, const CameraSensor *sensor)
 		   DmaBufAllocator::DmaBufAllocatorFlag::SystemHeap |
 		   DmaBufAllocator::DmaBufAllocatorFlag::UDmaBuf)
 {
-	/*
-	 * debayerParams_ must be initialized because the initial value is used for
-	 * the first two frames, i.e. until stats processing starts providing its
-	 * own parameters.
-	 *
-	 * \todo This should be handled in the same place as the related
-	 * operations, in the IPA module.
-	 */
-	std::array<uint8_t, 256> gammaTable;
-	for (unsigned int i = 0; i < 256; i++)
-		gammaTable[i] = UINT8_MAX * std::pow(i / 256.0, 0.5);
-	for (unsigned int i = 0; i < DebayerParams::kRGBLookupSize; i++) {
-		debayerParams_.red[i] = gammaTable[i];
-		debayerParams_.green[i] = gammaTable[i];
-		debayerParams_.blue[i] = gammaTable[i];
-	}
-
 	if (!dmaHeap_.isValid()) {
 		LOG(SoftwareIsp, Error) << "Failed to create DmaBufAllocator object";
 		return;
@@ -179,6 +162,19 @@ bool SoftwareIsp::isValid() const
 	return !!debayer_;
 }
 
+/**
+ * \brief Retrieve the size of the shared memory allocated by the software ISP
+ *
+ * The software ISP shares the ISP parameters and the statistics with the IPA
+ * module through anonymous shared memory.
+ *
+ * \return The size of the shared memory in bytes
+ */
+std::size_t SoftwareIsp::sharedMemorySize() const
+{
+	return sharedParams_.mem().size() + SharedMemObject<SwIspStats>::kSize;
+}
+
 /**
   * \brief Get the output formats supported for the given input format
   * \param[in] inputFormat The input format
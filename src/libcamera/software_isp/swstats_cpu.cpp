@@ -11,6 +11,8 @@
 
 #include "swstats_cpu.h"
 
+#include <algorithm>
+
 #include <libcamera/base/log.h>
 
 #include <libcamera/stream.h>
@@ -145,11 +147,14 @@ static constexpr unsigned int kBlueYMul = 29; /* 0.114 * 256 */
 	pixel_t r, g, g2, b;              \
 	uint64_t yVal;                    \
                                           \
-	uint64_t sumR = 0;                \
-	uint64_t sumG = 0;                \
+	SwIspStats::AwbZone *zone = awbZoneRow_;
+
+#define SWSTATS_START_ZONE_STATS() \
+	uint64_t sumR = 0;         \
+	uint64_t sumG = 0;         \
 	uint64_t sumB = 0;
 
-#define SWSTATS_ACCUMULATE_LINE_STATS(div) \
+#define SWSTATS_ACCUMULATE_ZONE_STATS(div) \
 	sumR += r;                         \
 	sumG += g;                         \
 	sumB += b;                         \
@@ -159,86 +164,122 @@ static constexpr unsigned int kBlueYMul = 29; /* 0.114 * 256 */
 	yVal += b * kBlueYMul;             \
 	stats_.yHistogram[yVal * SwIspStats::kYHistogramSize / (256 * 256 * (div))]++;
 
-#define SWSTATS_FINISH_LINE_STATS() \
-	stats_.sumR_ += sumR;       \
-	stats_.sumG_ += sumG;       \
+#define SWSTATS_FINISH_ZONE_STATS(step)                          \
+	zone->sumR += sumR;                                      \
+	zone->sumG += sumG;                                      \
+	zone->sumB += sumB;                                      \
+	zone->count += (zoneEnd - zoneStart + (step) - 1) / (step); \
+                                                                 \
+	stats_.sumR_ += sumR;                                    \
+	stats_.sumG_ += sumG;                                    \
 	stats_.sumB_ += sumB;
 
+/*
+ * The lines are processed one AWB zone at a time, to accumulate the zone sums
+ * in registers and store them once per zone instead of once per sample. The
+ * sums are stored unscaled, the IPA scales them to 8-bit sample values with
+ * SwIspStats::sampleDivisor.
+ */
+
 void SwStatsCpu::statsBGGR8Line0(const uint8_t *src[])
 {
 	const uint8_t *src0 = src[1] + window_.x;
 	const uint8_t *src1 = src[2] + window_.x;
+	const int width = window_.width;
+	const int zoneWidth = awbZoneWidth_;
 
 	SWSTATS_START_LINE_STATS(uint8_t)
 
 	if (swapLines_)
 		std::swap(src0, src1);
 
-	/* x += 4 sample every other 2x2 block */
-	for (int x = 0; x < (int)window_.width; x += 4) {
-		b = src0[x];
-		g = src0[x + 1];
-		g2 = src1[x];
-		r = src1[x + 1];
+	for (int zoneStart = 0; zoneStart < width; zoneStart += zoneWidth, zone++) {
+		const int zoneEnd = std::min(zoneStart + zoneWidth, width);
 
-		g = (g + g2) / 2;
+		SWSTATS_START_ZONE_STATS()
 
-		SWSTATS_ACCUMULATE_LINE_STATS(1)
-	}
+		/* x += 4 sample every other 2x2 block */
+		for (int x = zoneStart; x < zoneEnd; x += 4) {
+			b = src0[x];
+			g = src0[x + 1];
+			g2 = src1[x];
+			r = src1[x + 1];
+
+			g = (g + g2) / 2;
 
-	SWSTATS_FINISH_LINE_STATS()
+			SWSTATS_ACCUMULATE_ZONE_STATS(1)
+		}
+
+		SWSTATS_FINISH_ZONE_STATS(4)
+	}
 }
 
 void SwStatsCpu::statsBGGR10Line0(const uint8_t *src[])
 {
 	const uint16_t *src0 = (const uint16_t *)src[1] + window_.x;
 	const uint16_t *src1 = (const uint16_t *)src[2] + window_.x;
+	const int width = window_.width;
+	const int zoneWidth = awbZoneWidth_;
 
 	SWSTATS_START_LINE_STATS(uint16_t)
 
 	if (swapLines_)
 		std::swap(src0, src1);
 
-	/* x += 4 sample every other 2x2 block */
-	for (int x = 0; x < (int)window_.width; x += 4) {
-		b = src0[x];
-		g = src0[x + 1];
-		g2 = src1[x];
-		r = src1[x + 1];
+	for (int zoneStart = 0; zoneStart < width; zoneStart += zoneWidth, zone++) {
+		const int zoneEnd = std::min(zoneStart + zoneWidth, width);
 
-		g = (g + g2) / 2;
+		SWSTATS_START_ZONE_STATS()
 
-		/* divide Y by 4 for 10 -> 8 bpp value */
-		SWSTATS_ACCUMULATE_LINE_STATS(4)
-	}
+		/* x += 4 sample every other 2x2 block */
+		for (int x = zoneStart; x < zoneEnd; x += 4) {
+			b = src0[x];
+			g = src0[x + 1];
+			g2 = src1[x];
+			r = src1[x + 1];
+
+			g = (g + g2) / 2;
+
+			/* divide Y by 4 for 10 -> 8 bpp value */
+			SWSTATS_ACCUMULATE_ZONE_STATS(4)
+		}
 
-	SWSTATS_FINISH_LINE_STATS()
+		SWSTATS_FINISH_ZONE_STATS(4)
+	}
 }
 
 void SwStatsCpu::statsBGGR12Line0(const uint8_t *src[])
 {
 	const uint16_t *src0 = (const uint16_t *)src[1] + window_.x;
 	const uint16_t *src1 = (const uint16_t *)src[2] + window_.x;
+	const int width = window_.width;
+	const int zoneWidth = awbZoneWidth_;
 
 	SWSTATS_START_LINE_STATS(uint16_t)
 
 	if (swapLines_)
 		std::swap(src0, src1);
 
-	/* x += 4 sample every other 2x2 block */
-	for (int x = 0; x < (int)window_.width; x += 4) {
-		b = src0[x];
-		g = src0[x + 1];
-		g2 = src1[x];
-		r = src1[x + 1];
+	for (int zoneStart = 0; zoneStart < width; zoneStart += zoneWidth, zone++) {
+		const int zoneEnd = std::min(zoneStart + zoneWidth, width);
 
-		g = (g + g2) / 2;
+		SWSTATS_START_ZONE_STATS()
 
-		/* divide Y by 16 for 12 -> 8 bpp value */
-		SWSTATS_ACCUMULATE_LINE_STATS(16)
-	}
+		/* x += 4 sample every other 2x2 block */
+		for (int x = zoneStart; x < zoneEnd; x += 4) {
+			b = src0[x];
+			g = src0[x + 1];
+			g2 = src1[x];
+			r = src1[x + 1];
 
-	SWSTATS_FINISH_LINE_STATS()
+			g = (g + g2) / 2;
+
+			/* divide Y by 16 for 12 -> 8 bpp value */
+			SWSTATS_ACCUMULATE_ZONE_STATS(16)
+		}
+
+		SWSTATS_FINISH_ZONE_STATS(4)
+	}
 }
 
 void SwStatsCpu::statsBGGR10PLine0(const uint8_t *src[])
@@ -246,25 +287,33 @@ void SwStatsCpu::statsBGGR10PLine0(const uint8_t *src[])
 	const uint8_t *src0 = src[1] + window_.x * 5 / 4;
 	const uint8_t *src1 = src[2] + window_.x * 5 / 4;
 	const int widthInBytes = window_.width * 5 / 4;
+	const int zoneWidthInBytes = awbZoneWidth_ * 5 / 4;
 
 	if (swapLines_)
 		std::swap(src0, src1);
 
 	SWSTATS_START_LINE_STATS(uint8_t)
 
-	/* x += 5 sample every other 2x2 block */
-	for (int x = 0; x < widthInBytes; x += 5) {
-		/* BGGR */
-		b = src0[x];
-		g = src0[x + 1];
-		g2 = src1[x];
-		r = src1[x + 1];
-		g = (g + g2) / 2;
-		/* Data is already 8 bits, divide by 1 */
-		SWSTATS_ACCUMULATE_LINE_STATS(1)
-	}
+	for (int zoneStart = 0; zoneStart < widthInBytes;
+	     zoneStart += zoneWidthInBytes, zone++) {
+		const int zoneEnd = std::min(zoneStart + zoneWidthInBytes, widthInBytes);
+
+		SWSTATS_START_ZONE_STATS()
+
+		/* x += 5 sample every other 2x2 block */
+		for (int x = zoneStart; x < zoneEnd; x += 5) {
+			/* BGGR */
+			b = src0[x];
+			g = src0[x + 1];
+			g2 = src1[x];
+			r = src1[x + 1];
+			g = (g + g2) / 2;
+			/* Data is already 8 bits, divide by 1 */
+			SWSTATS_ACCUMULATE_ZONE_STATS(1)
+		}
 
-	SWSTATS_FINISH_LINE_STATS()
+		SWSTATS_FINISH_ZONE_STATS(5)
+	}
 }
 
 void SwStatsCpu::statsGBRG10PLine0(const uint8_t *src[])
@@ -272,25 +321,33 @@ void SwStatsCpu::statsGBRG10PLine0(const uint8_t *src[])
 	const uint8_t *src0 = src[1] + window_.x * 5 / 4;
 	const uint8_t *src1 = src[2] + window_.x * 5 / 4;
 	const int widthInBytes = window_.width * 5 / 4;
+	const int zoneWidthInBytes = awbZoneWidth_ * 5 / 4;
 
 	if (swapLines_)
 		std::swap(src0, src1);
 
 	SWSTATS_START_LINE_STATS(uint8_t)
 
-	/* x += 5 sample every other 2x2 block */
-	for (int x = 0; x < widthInBytes; x += 5) {
-		/* GBRG */
-		g = src0[x];
-		b = src0[x + 1];
-		r = src1[x];
-		g2 = src1[x + 1];
-		g = (g + g2) / 2;
-		/* Data is already 8 bits, divide by 1 */
-		SWSTATS_ACCUMULATE_LINE_STATS(1)
-	}
+	for (int zoneStart = 0; zoneStart < widthInBytes;
+	     zoneStart += zoneWidthInBytes, zone++) {
+		const int zoneEnd = std::min(zoneStart + zoneWidthInBytes, widthInBytes);
+
+		SWSTATS_START_ZONE_STATS()
+
+		/* x += 5 sample every other 2x2 block */
+		for (int x = zoneStart; x < zoneEnd; x += 5) {
+			/* GBRG */
+			g = src0[x];
+			b = src0[x + 1];
+			r = src1[x];
+			g2 = src1[x + 1];
+			g = (g + g2) / 2;
+			/* Data is already 8 bits, divide by 1 */
+			SWSTATS_ACCUMULATE_ZONE_STATS(1)
+		}
 
-	SWSTATS_FINISH_LINE_STATS()
+		SWSTATS_FINISH_ZONE_STATS(5)
+	}
 }
 
 /**
@@ -307,6 +364,7 @@ void SwStatsCpu::startFrame(void)
 	stats_.sumB_ = 0;
 	stats_.sumG_ = 0;
 	stats_.yHistogram.fill(0);
+	stats_.awbGrid.fill({});
 }
 
 /**
@@ -372,12 +430,15 @@ int SwStatsCpu::configure(const StreamConfiguration &inputCfg)
 		switch (bayerFormat.bitDepth) {
 		case 8:
 			stats0_ = &SwStatsCpu::statsBGGR8Line0;
+			stats_.sampleDivisor = 1;
 			return 0;
 		case 10:
 			stats0_ = &SwStatsCpu::statsBGGR10Line0;
+			stats_.sampleDivisor = 4;
 			return 0;
 		case 12:
 			stats0_ = &SwStatsCpu::statsBGGR12Line0;
+			stats_.sampleDivisor = 16;
 			return 0;
 		}
 	}
@@ -389,6 +450,8 @@ int SwStatsCpu::configure(const StreamConfiguration &inputCfg)
 		/* Skip every 3th and 4th line, sample every other 2x2 block */
 		ySkipMask_ = 0x02;
 		xShift_ = 0;
+		/* Only the 8 most significant bits are sampled */
+		stats_.sampleDivisor = 1;
 
 		switch (bayerFormat.order) {
 		case BayerFormat::BGGR:
@@ -427,6 +490,17 @@ void SwStatsCpu::setWindow(const Rectangle &window)
 	window_.width -= xShift_;
 	window_.width &= ~(patternSize_.width - 1);
 	window_.height &= ~(patternSize_.height - 1);
+
+	/*
+	 * Round the AWB zone width up to a multiple of the horizontal sampling
+	 * step of every other pattern, so that the zones cover the whole window
+	 * and all start on a sampled pattern.
+	 */
+	const unsigned int step = 2 * patternSize_.width;
+	awbZoneWidth_ = (window_.width + SwIspStats::kAwbGridWidth - 1) /
+			SwIspStats::kAwbGridWidth;
+	awbZoneWidth_ = (awbZoneWidth_ + step - 1) / step * step;
+	awbZoneRow_ = &stats_.awbGrid[0];
 }
 
 } /* namespace libcamera */
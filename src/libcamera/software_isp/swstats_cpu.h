@@ -49,6 +49,7 @@ public:
 		    y >= (window_.y + window_.height))
 			return;
 
+		setAwbZoneRow(y);
 		(this->*stats0_)(src);
 	}
 
@@ -58,6 +59,7 @@ public:
 		    y >= (window_.y + window_.height))
 			return;
 
+		setAwbZoneRow(y);
 		(this->*stats2_)(src);
 	}
 
@@ -67,6 +69,13 @@ private:
 	using statsProcessFn = void (SwStatsCpu::*)(const uint8_t *src[]);
 
 	int setupStandardBayerOrder(BayerFormat::Order order);
+	void setAwbZoneRow(unsigned int y)
+	{
+		unsigned int row = (y - window_.y) * SwIspStats::kAwbGridHeight /
+				   window_.height;
+		awbZoneRow_ = &stats_.awbGrid[row * SwIspStats::kAwbGridWidth];
+	}
+
 	/* Bayer 8 bpp unpacked */
 	void statsBGGR8Line0(const uint8_t *src[]);
 	/* Bayer 10 bpp unpacked */
@@ -90,6 +99,10 @@ private:
 
 	unsigned int xShift_;
 
+	/* Width of the AWB grid zones in pixels, and zones of the current line */
+	unsigned int awbZoneWidth_;
+	SwIspStats::AwbZone *awbZoneRow_;
+
 	SharedMemObject<SwIspStats> sharedStats_;
 	SwIspStats stats_;
 };
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Timestamp-based matching of frames from multiple streams
+ */
+
+#include "libcamera/internal/timestamp_matcher.h"
+
+/**
+ * \file timestamp_matcher.h
+ * \brief Timestamp-based matching of frames from multiple streams
+ */
+
+namespace libcamera {
+
+/**
+ * \class TimestampMatcher
+ * \brief Match frames captured at the same time by multiple streams
+ * \tparam T The type of the items associated with the frames
+ *
+ * The TimestampMatcher pairs the frames of a fixed number of streams, such as
+ * the cameras of a CameraGroup, by timestamp. Frames are added to the matcher
+ * in capture order for each stream, and the matcher produces sets of one item
+ * per stream whose timestamps differ by at most the tolerance.
+ *
+ * The oldest pending frames of all streams are matched first. A frame older
+ * than the most recent of the oldest frames by more than the tolerance can't
+ * be matched anymore, as the other streams have already captured later
+ * frames, and is dropped. The matcher also buffers at most a configurable
+ * number of pending frames per stream, and drops the oldest frames of a
+ * stream when another stream stalls.
+ *
+ * The matcher additionally measures the frame duration of each stream and its
+ * phase relative to the first stream, for the caller to steer the streams
+ * towards phase alignment.
+ *
+ * The TimestampMatcher isn't thread-safe.
+ */
+
+/**
+ * \fn TimestampMatcher::TimestampMatcher()
+ * \brief Construct a TimestampMatcher
+ * \param[in] count The number of streams
+ *
+ * The tolerance defaults to 2ms and the number of pending frames to 4.
+ */
+
+/**
+ * \fn TimestampMatcher::setTolerance()
+ * \brief Set the maximum timestamp difference of matched frames
+ * \param[in] tolerance The tolerance, in nanoseconds
+ */
+
+/**
+ * \fn TimestampMatcher::tolerance()
+ * \brief Retrieve the maximum timestamp difference of matched frames
+ * \return The tolerance, in nanoseconds
+ */
+
+/**
+ * \fn TimestampMatcher::setMaxPending()
+ * \brief Set the maximum number of pending frames per stream
+ * \param[in] count The number of frames, at least 1
+ */
+
+/**
+ * \fn TimestampMatcher::maxPending()
+ * \brief Retrieve the maximum number of pending frames per stream
+ * \return The number of frames
+ */
+
+/**
+ * \fn TimestampMatcher::add()
+ * \brief Add a frame captured by a stream and match the pending frames
+ * \param[in] index The stream index
+ * \param[in] timestamp The frame timestamp, in nanoseconds
+ * \param[in] frameDuration The frame duration in nanoseconds, or 0 to measure
+ * it from the timestamps of consecutive frames
+ * \param[in] item The item associated with the frame
+ * \param[out] dropped The items of the frames dropped, appended to the vector
+ * \param[out] sets The matched sets, appended to the vector, with one item
+ * per stream in stream order
+ */
+
+/**
+ * \fn TimestampMatcher::flush()
+ * \brief Drop all pending frames and reset the measurements
+ * \param[out] dropped The items of the pending frames, appended to the vector
+ */
+
+/**
+ * \fn TimestampMatcher::pending()
+ * \brief Retrieve the number of pending frames of a stream
+ * \param[in] index The stream index
+ * \return The number of frames waiting for a match
+ */
+
+/**
+ * \fn TimestampMatcher::frameDuration()
+ * \brief Retrieve the frame duration of a stream
+ * \param[in] index The stream index
+ * \return The last frame duration in nanoseconds, or 0 if unknown
+ */
+
+/**
+ * \fn TimestampMatcher::phaseError()
+ * \brief Retrieve the phase of a stream relative to the first stream
+ * \param[in] index The stream index
+ *
+ * The phase is measured when matching frames, and wrapped to half a frame
+ * duration of the first stream.
+ *
+ * \return The phase error in nanoseconds
+ */
+
+} /* namespace libcamera */
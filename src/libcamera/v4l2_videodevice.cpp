@@ -535,7 +535,8 @@ std::ostream &operator<<(std::ostream &out, const V4L2DeviceFormat &f)
 V4L2VideoDevice::V4L2VideoDevice(const std::string &deviceNode)
 	: V4L2Device(deviceNode), formatInfo_(nullptr), cache_(nullptr),
 	  fdBufferNotifier_(nullptr), state_(State::Stopped),
-	  watchdogDuration_(0.0)
+	  watchdogDuration_(0.0), m2mPeer_(nullptr), formatGeneration_(0),
+	  peerFormatGeneration_(0)
 {
 	/*
 	 * We default to an MMAP based CAPTURE video device, however this will
@@ -763,6 +764,11 @@ void V4L2VideoDevice::close()
 
 	formatInfo_ = nullptr;
 
+	{
+		MutexLocker locker(tryFormatMutex_);
+		tryFormatCache_.clear();
+	}
+
 	V4L2Device::close();
 }
 
@@ -811,6 +817,25 @@ int V4L2VideoDevice::getFormat(V4L2DeviceFormat *format)
 		return getFormatSingleplane(format);
 }
 
+namespace {
+
+bool isSameFormat(const V4L2DeviceFormat &a, const V4L2DeviceFormat &b)
+{
+	if (a.fourcc != b.fourcc || a.size != b.size ||
+	    a.colorSpace != b.colorSpace || a.planesCount != b.planesCount)
+		return false;
+
+	for (unsigned int i = 0; i < a.planes.size(); ++i) {
+		if (a.planes[i].size != b.planes[i].size ||
+		    a.planes[i].bpl != b.planes[i].bpl)
+			return false;
+	}
+
+	return true;
+}
+
+} /* namespace */
+
 /**
  * \brief Try an image format on the V4L2 video device
  * \param[inout] format The image format to test applicability to the video device
@@ -819,16 +844,56 @@ int V4L2VideoDevice::getFormat(V4L2DeviceFormat *format)
  * the format that would be applied. This is equivalent to setFormat(), except
  * that the device configuration is not changed.
  *
+ * Format negotiation commonly tries the same formats repeatedly. The results of
+ * successful attempts are cached and returned without calling the driver, until
+ * a format is set on the device with setFormat() or the device is closed. On
+ * memory-to-memory devices, setting a format on the other queue of the device
+ * also drops the cached results, as they depend on the format of both queues.
+ *
  * \return 0 on success or a negative error code otherwise
  */
 int V4L2VideoDevice::tryFormat(V4L2DeviceFormat *format)
 {
+	MutexLocker locker(tryFormatMutex_);
+
+	/*
+	 * Sample the generation before calling the driver. A result obtained
+	 * while the peer format changes is then not cached.
+	 */
+	const unsigned int peerGeneration = m2mPeer_ ? m2mPeer_->formatGeneration_.load() : 0;
+	if (peerGeneration != peerFormatGeneration_) {
+		tryFormatCache_.clear();
+		peerFormatGeneration_ = peerGeneration;
+	}
+
+	for (const TryFormatEntry &entry : tryFormatCache_) {
+		if (isSameFormat(entry.format, *format)) {
+			*format = entry.result;
+			return 0;
+		}
+	}
+
+	V4L2DeviceFormat requested = *format;
+	int ret;
+
 	if (caps_.isMeta())
-		return trySetFormatMeta(format, false);
+		ret = trySetFormatMeta(format, false);
 	else if (caps_.isMultiplanar())
-		return trySetFormatMultiplane(format, false);
+		ret = trySetFormatMultiplane(format, false);
 	else
-		return trySetFormatSingleplane(format, false);
+		ret = trySetFormatSingleplane(format, false);
+
+	if (ret)
+		return ret;
+
+	if (m2mPeer_ && m2mPeer_->formatGeneration_.load() != peerGeneration)
+		return 0;
+
+	if (tryFormatCache_.size() >= kTryFormatCacheSize)
+		tryFormatCache_.erase(tryFormatCache_.begin());
+	tryFormatCache_.push_back({ requested, *format });
+
+	return 0;
 }
 
 /**
@@ -842,6 +907,14 @@ int V4L2VideoDevice::tryFormat(V4L2DeviceFormat *format)
  */
 int V4L2VideoDevice::setFormat(V4L2DeviceFormat *format)
 {
+	/*
+	 * The results of tryFormat() may depend on the device configuration,
+	 * drop them. Keep the lock until the new format is applied, to prevent
+	 * tryFormat() from caching a result of the previous configuration.
+	 */
+	MutexLocker locker(tryFormatMutex_);
+	tryFormatCache_.clear();
+
 	int ret = 0;
 	if (caps_.isMeta())
 		ret = trySetFormatMeta(format, true);
@@ -850,6 +923,12 @@ int V4L2VideoDevice::setFormat(V4L2DeviceFormat *format)
 	else
 		ret = trySetFormatSingleplane(format, true);
 
+	/*
+	 * Signal the format change to the other queue of memory-to-memory
+	 * devices after applying it, to drop its cached tryFormat() results.
+	 */
+	formatGeneration_++;
+
 	/* Cache the set format on success. */
 	if (ret)
 		return ret;
@@ -2099,6 +2178,10 @@ V4L2M2MDevice::V4L2M2MDevice(const std::string &deviceNode)
 {
 	output_ = new V4L2VideoDevice(deviceNode);
 	capture_ = new V4L2VideoDevice(deviceNode);
+
+	/* The formats of the two queues depend on each other. */
+	output_->m2mPeer_ = capture_;
+	capture_->m2mPeer_ = output_;
 }
 
 V4L2M2MDevice::~V4L2M2MDevice()
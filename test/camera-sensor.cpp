@@ -65,6 +65,64 @@ protected:
 		return TestPass;
 	}
 
+	int testFormatMemo(const V4L2SubdeviceFormat &expected)
+	{
+		const std::vector<unsigned int> mbusCodes{
+			0xdeadbeef, MEDIA_BUS_FMT_SBGGR10_1X10,
+			MEDIA_BUS_FMT_BGR888_1X24
+		};
+
+		/* A repeated query must return the memoised format. */
+		V4L2SubdeviceFormat format = sensor_->getFormat(mbusCodes, Size(1024, 768));
+		if (format.code != expected.code || format.size != expected.size) {
+			cerr << "Repeated getFormat() returned " << format
+			     << " instead of " << expected << endl;
+			return TestFail;
+		}
+
+		/* Queries that differ only by the media bus codes. */
+		format = sensor_->getFormat({ MEDIA_BUS_FMT_BGR888_1X24 },
+					    Size(1024, 768));
+		if (format.code != MEDIA_BUS_FMT_BGR888_1X24) {
+			cerr << "getFormat() ignored the media bus codes, got "
+			     << format << endl;
+			return TestFail;
+		}
+
+		format = sensor_->getFormat({ 0xdeadbeef }, Size(1024, 768));
+		if (format.code) {
+			cerr << "getFormat() returned unsupported format "
+			     << format << endl;
+			return TestFail;
+		}
+
+		/* Evict the first query from the memo and repeat it. */
+		for (unsigned int i = 0; i < 32; ++i)
+			sensor_->getFormat(mbusCodes, Size(640 + i, 480));
+
+		format = sensor_->getFormat(mbusCodes, Size(1024, 768));
+		if (format.code != expected.code || format.size != expected.size) {
+			cerr << "getFormat() returned " << format
+			     << " after eviction instead of " << expected << endl;
+			return TestFail;
+		}
+
+		/* Setting a format and flips must not affect the selection. */
+		if (sensor_->setFormat(&format, Transform::HVFlip)) {
+			cerr << "Failed to set sensor format" << endl;
+			return TestFail;
+		}
+
+		format = sensor_->getFormat(mbusCodes, Size(1024, 768));
+		if (format.code != expected.code || format.size != expected.size) {
+			cerr << "getFormat() returned " << format
+			     << " after setFormat() instead of " << expected << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
 	int run()
 	{
 		if (sensor_->model() != "Sensor A") {
@@ -108,6 +166,9 @@ protected:
 			return TestFail;
 		}
 
+		if (testFormatMemo(format) != TestPass)
+			return TestFail;
+
 		if (lens_ && lens_->setFocusPosition(10)) {
 			cerr << "Failed to set lens focus position" << endl;
 			return TestFail;
@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera camera group synchronised capture test
+ */
+
+#include <iostream>
+#include <map>
+#include <stdlib.h>
+
+#include <libcamera/camera_group.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class CameraGroupTest : public CameraTest, public Test
+{
+public:
+	CameraGroupTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	static constexpr auto kTolerance = 500ms;
+
+	struct CameraData {
+		shared_ptr<Camera> camera;
+		unique_ptr<CameraConfiguration> config;
+		unique_ptr<FrameBufferAllocator> allocator;
+		vector<unique_ptr<Request>> requests;
+	};
+
+	vector<CameraData> cameras_;
+	unique_ptr<CameraGroup> group_;
+	map<Request *, Camera *> requestCameras_;
+
+	unsigned int completeSetsCount_;
+	bool invalidSet_;
+	bool running_;
+
+	void requeue(Request *request)
+	{
+		const Request::BufferMap &buffers = request->buffers();
+		const Stream *stream = buffers.begin()->first;
+		FrameBuffer *buffer = buffers.begin()->second;
+
+		request->reuse();
+		request->addBuffer(stream, buffer);
+	}
+
+	void requestSetComplete(const vector<Request *> &requests)
+	{
+		if (requests.size() != cameras_.size()) {
+			invalidSet_ = true;
+			return;
+		}
+
+		int64_t first = *requests[0]->metadata().get(controls::SensorTimestamp);
+		for (Request *request : requests) {
+			int64_t timestamp = *request->metadata().get(controls::SensorTimestamp);
+			if (llabs(timestamp - first) > chrono::nanoseconds(kTolerance).count())
+				invalidSet_ = true;
+		}
+
+		completeSetsCount_++;
+
+		if (!running_)
+			return;
+
+		for (Request *request : requests)
+			requeue(request);
+
+		group_->queueRequests(requests);
+
+		dispatcher_->interrupt();
+	}
+
+	void requestDropped(Request *request)
+	{
+		if (!running_)
+			return;
+
+		/* Give the request back to its camera to keep capturing. */
+		requeue(request);
+		requestCameras_[request]->queueRequest(request);
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		shared_ptr<Camera> other = cm_->get("platform/vimc.0 Sensor A");
+		if (!other) {
+			cout << "Second vimc camera not found" << endl;
+			return TestSkip;
+		}
+
+		for (shared_ptr<Camera> camera : { camera_, other }) {
+			CameraData data;
+			data.camera = camera;
+			data.config = camera->generateConfiguration({ StreamRole::VideoRecording });
+			if (!data.config || data.config->size() != 1) {
+				cout << "Failed to generate default configuration" << endl;
+				return TestFail;
+			}
+
+			data.allocator = make_unique<FrameBufferAllocator>(camera);
+			cameras_.push_back(std::move(data));
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		vector<shared_ptr<Camera>> cameras;
+		unsigned int nBuffers = ~0U;
+
+		for (CameraData &data : cameras_) {
+			if (data.camera->acquire()) {
+				cout << "Failed to acquire the camera" << endl;
+				return TestFail;
+			}
+
+			if (data.camera->configure(data.config.get())) {
+				cout << "Failed to set default configuration" << endl;
+				return TestFail;
+			}
+
+			Stream *stream = data.config->at(0).stream();
+			if (data.allocator->allocate(stream) < 0)
+				return TestFail;
+
+			for (const unique_ptr<FrameBuffer> &buffer : data.allocator->buffers(stream)) {
+				unique_ptr<Request> request = data.camera->createRequest();
+				if (!request || request->addBuffer(stream, buffer.get())) {
+					cout << "Failed to create request" << endl;
+					return TestFail;
+				}
+
+				requestCameras_[request.get()] = data.camera.get();
+				data.requests.push_back(std::move(request));
+			}
+
+			nBuffers = std::min<unsigned int>(nBuffers, data.requests.size());
+			cameras.push_back(data.camera);
+		}
+
+		group_ = make_unique<CameraGroup>(cameras);
+		group_->setSyncTolerance(kTolerance);
+		group_->setMaxPendingRequests(nBuffers);
+		group_->setPhaseAlignment(true);
+
+		if (group_->queueRequests({}) != -EINVAL) {
+			cout << "Incomplete request set accepted" << endl;
+			return TestFail;
+		}
+
+		group_->requestSetCompleted.connect(this, &CameraGroupTest::requestSetComplete);
+		group_->requestDropped.connect(this, &CameraGroupTest::requestDropped);
+
+		completeSetsCount_ = 0;
+		invalidSet_ = false;
+		running_ = true;
+
+		if (group_->start()) {
+			cout << "Failed to start cameras" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < nBuffers; ++i) {
+			vector<Request *> requests;
+			for (CameraData &data : cameras_)
+				requests.push_back(data.requests[i].get());
+
+			if (group_->queueRequests(requests)) {
+				cout << "Failed to queue requests" << endl;
+				return TestFail;
+			}
+		}
+
+		unsigned int nFrames = nBuffers * 2;
+
+		Timer timer;
+		timer.start(500ms * nFrames);
+		while (timer.isRunning()) {
+			dispatcher_->processEvents();
+			if (completeSetsCount_ > nFrames)
+				break;
+		}
+
+		running_ = false;
+
+		if (group_->stop()) {
+			cout << "Failed to stop cameras" << endl;
+			return TestFail;
+		}
+
+		if (completeSetsCount_ < nFrames) {
+			cout << "Failed to capture enough request sets (got "
+			     << completeSetsCount_ << " expected at least "
+			     << nFrames << ")" << endl;
+			return TestFail;
+		}
+
+		if (invalidSet_) {
+			cout << "Invalid request set completed" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		group_.reset();
+
+		for (CameraData &data : cameras_) {
+			data.requests.clear();
+			data.allocator.reset();
+			data.camera->release();
+		}
+
+		cameras_.clear();
+	}
+
+	EventDispatcher *dispatcher_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(CameraGroupTest)
@@ -0,0 +1,284 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera request completion batching test
+ */
+
+#include <iostream>
+
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class CaptureBatching : public CameraTest, public Test
+{
+public:
+	CaptureBatching()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	static constexpr unsigned int kMaxRequests = 2;
+
+	unsigned int completeRequestsCount_;
+	unsigned int completeBatchesCount_;
+	unsigned int singleCompletionsCount_;
+	bool oversizedBatch_;
+
+	void requestComplete([[maybe_unused]] Request *request)
+	{
+		singleCompletionsCount_++;
+	}
+
+	void requestsComplete(const std::vector<Request *> &requests)
+	{
+		completeBatchesCount_++;
+
+		if (requests.empty() || requests.size() > kMaxRequests)
+			oversizedBatch_ = true;
+
+		for (Request *request : requests) {
+			if (request->status() != Request::RequestComplete)
+				continue;
+
+			completeRequestsCount_++;
+
+			/* Create a new request. */
+			const Request::BufferMap &buffers = request->buffers();
+			const Stream *stream = buffers.begin()->first;
+			FrameBuffer *buffer = buffers.begin()->second;
+
+			request->reuse();
+			request->addBuffer(stream, buffer);
+			camera_->queueRequest(request);
+		}
+
+		dispatcher_->interrupt();
+	}
+
+	void pendingRequestsComplete(const std::vector<Request *> &requests)
+	{
+		for (Request *request : requests)
+			pendingRequests_.push_back(request);
+	}
+
+	int testStopWithPendingBatch(Stream *stream)
+	{
+		/*
+		 * Use a latency bound long enough for the batch to still be
+		 * pending when the camera is stopped.
+		 */
+		if (camera_->setCompletionBatching(requests_.size() + 1, 10s)) {
+			cout << "Failed to configure completion batching" << endl;
+			return TestFail;
+		}
+
+		camera_->requestsCompleted.disconnect(this);
+		camera_->requestsCompleted.connect(this, &CaptureBatching::pendingRequestsComplete);
+
+		pendingRequests_.clear();
+
+		Request *request = requests_.front().get();
+		FrameBuffer *buffer = request->buffers().begin()->second;
+		request->reuse();
+		request->addBuffer(stream, buffer);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->queueRequest(request)) {
+			cout << "Failed to queue request" << endl;
+			return TestFail;
+		}
+
+		/* Wait for the request to complete and be added to the batch. */
+		Timer timer;
+		timer.start(1000ms);
+		while (timer.isRunning() &&
+		       request->status() == Request::RequestPending)
+			dispatcher_->processEvents();
+
+		if (request->status() != Request::RequestComplete) {
+			cout << "Request failed to complete" << endl;
+			return TestFail;
+		}
+
+		if (!pendingRequests_.empty()) {
+			cout << "Batch delivered before the latency bound" << endl;
+			return TestFail;
+		}
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (pendingRequests_.size() != 1 ||
+		    pendingRequests_.front() != request) {
+			cout << "Pending batch not delivered at stop time" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording });
+		if (!config_ || config_->size() != 1) {
+			cout << "Failed to generate default configuration" << endl;
+			return TestFail;
+		}
+
+		allocator_ = std::make_unique<FrameBufferAllocator>(camera_);
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->setCompletionBatching(kMaxRequests, 100ms) != -EACCES) {
+			cout << "Batching configured on a camera not acquired" << endl;
+			return TestFail;
+		}
+
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->setCompletionBatching(kMaxRequests, 0ms) != -EINVAL) {
+			cout << "Batching configured without latency bound" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to set default configuration" << endl;
+			return TestFail;
+		}
+
+		if (camera_->setCompletionBatching(kMaxRequests, 100ms)) {
+			cout << "Failed to configure completion batching" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config_->at(0).stream();
+
+		int ret = allocator_->allocate(stream);
+		if (ret < 0)
+			return TestFail;
+
+		for (const std::unique_ptr<FrameBuffer> &buffer : allocator_->buffers(stream)) {
+			std::unique_ptr<Request> request = camera_->createRequest();
+			if (!request) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			if (request->addBuffer(stream, buffer.get())) {
+				cout << "Failed to associate buffer with request" << endl;
+				return TestFail;
+			}
+
+			requests_.push_back(std::move(request));
+		}
+
+		completeRequestsCount_ = 0;
+		completeBatchesCount_ = 0;
+		singleCompletionsCount_ = 0;
+		oversizedBatch_ = false;
+
+		camera_->requestCompleted.connect(this, &CaptureBatching::requestComplete);
+		camera_->requestsCompleted.connect(this, &CaptureBatching::requestsComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (std::unique_ptr<Request> &request : requests_) {
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		unsigned int nFrames = allocator_->buffers(stream).size() * 2;
+
+		Timer timer;
+		timer.start(500ms * nFrames);
+		while (timer.isRunning()) {
+			dispatcher_->processEvents();
+			if (completeRequestsCount_ > nFrames)
+				break;
+		}
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		/* Deliver the requests cancelled at stop time. */
+		dispatcher_->processEvents();
+
+		cout << completeRequestsCount_ << " requests completed in "
+		     << completeBatchesCount_ << " wakeups" << endl;
+
+		if (completeRequestsCount_ < nFrames) {
+			cout << "Failed to capture enough frames (got "
+			     << completeRequestsCount_ << " expected at least "
+			     << nFrames << ")" << endl;
+			return TestFail;
+		}
+
+		if (singleCompletionsCount_) {
+			cout << "Request completed individually with batching enabled"
+			     << endl;
+			return TestFail;
+		}
+
+		if (oversizedBatch_) {
+			cout << "Invalid batch size" << endl;
+			return TestFail;
+		}
+
+		if (completeBatchesCount_ >= completeRequestsCount_) {
+			cout << "Requests have not been batched" << endl;
+			return TestFail;
+		}
+
+		return testStopWithPendingBatch(stream);
+	}
+
+	EventDispatcher *dispatcher_;
+
+	std::vector<Request *> pendingRequests_;
+
+	std::vector<std::unique_ptr<Request>> requests_;
+
+	std::unique_ptr<CameraConfiguration> config_;
+	std::unique_ptr<FrameBufferAllocator> allocator_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(CaptureBatching)
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera Camera memory usage accounting test
+ */
+
+#include <iostream>
+#include <memory>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+class MemoryUsageTest : public CameraTest, public Test
+{
+public:
+	MemoryUsageTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording });
+		if (!config_ || config_->size() != 1) {
+			cout << "Failed to generate default configuration" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->memoryUsage().total() != 0) {
+			cout << "Memory usage of unused camera is not zero" << endl;
+			return TestFail;
+		}
+
+		camera_->setMemoryBudget(1 << 20);
+		if (camera_->memoryBudget() != 1 << 20) {
+			cout << "Failed to set memory budget" << endl;
+			return TestFail;
+		}
+		camera_->setMemoryBudget(0);
+
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to set default configuration" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config_->at(0).stream();
+		std::size_t size = 0;
+
+		{
+			FrameBufferAllocator allocator(camera_);
+
+			if (allocator.allocate(stream) < 0) {
+				cout << "Failed to allocate buffers" << endl;
+				return TestFail;
+			}
+
+			for (const std::unique_ptr<FrameBuffer> &buffer : allocator.buffers(stream)) {
+				for (const FrameBuffer::Plane &plane : buffer->planes())
+					size += plane.length;
+			}
+
+			MemoryUsage usage = camera_->memoryUsage();
+			if (usage.size(MemoryUsage::Purpose::Application,
+				       MemoryUsage::Type::DmaBuf) != size ||
+			    usage.total() < size) {
+				cout << "Application buffers not accounted: "
+				     << usage << endl;
+				return TestFail;
+			}
+
+			if (allocator.free(stream)) {
+				cout << "Failed to free buffers" << endl;
+				return TestFail;
+			}
+
+			if (camera_->memoryUsage().size(MemoryUsage::Purpose::Application)) {
+				cout << "Freed buffers still accounted" << endl;
+				return TestFail;
+			}
+
+			/* Destroying the allocator shall release the buffers. */
+			if (allocator.allocate(stream) < 0) {
+				cout << "Failed to reallocate buffers" << endl;
+				return TestFail;
+			}
+		}
+
+		if (camera_->memoryUsage().size(MemoryUsage::Purpose::Application)) {
+			cout << "Buffers still accounted after allocator destruction"
+			     << endl;
+			return TestFail;
+		}
+
+		if (camera_->release()) {
+			cout << "Failed to release the camera" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	std::unique_ptr<CameraConfiguration> config_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(MemoryUsageTest)
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera camera configuration switch test
+ */
+
+#include <iostream>
+
+#include "switch_configuration_test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+class SwitchConfiguration : public SwitchConfigurationTest
+{
+protected:
+	static constexpr unsigned int kIterations = 5;
+
+	int run() override
+	{
+		if (prepare() != TestPass)
+			return TestFail;
+
+		if (camera_->switchConfiguration(configs_[1].get()) != -EACCES) {
+			cout << "Configuration switched on a stopped camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		if (queueIdleRequests() != TestPass || capture(2) != TestPass)
+			return TestFail;
+
+		for (unsigned int i = 0; i < kIterations * 2; ++i) {
+			CameraConfiguration *config = configs_[(i + 1) % 2].get();
+
+			if (camera_->switchConfiguration(config)) {
+				cout << "Failed to switch configuration" << endl;
+				return TestFail;
+			}
+
+			expectedSize_ = config->at(0).size;
+
+			if (queueIdleRequests() != TestPass || capture(2) != TestPass)
+				return TestFail;
+		}
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+};
+
+} /* namespace */
+
+TEST_REGISTER(SwitchConfiguration)
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera camera configuration switch latency benchmark
+ */
+
+#include <chrono>
+#include <iostream>
+
+#include "switch_configuration_test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+class SwitchConfigurationBenchmark : public SwitchConfigurationTest
+{
+protected:
+	static constexpr unsigned int kIterations = 20;
+
+	int run() override
+	{
+		if (prepare() != TestPass)
+			return TestFail;
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		if (queueIdleRequests() != TestPass || capture(2) != TestPass)
+			return TestFail;
+
+		/*
+		 * Compare switchConfiguration() with a full stop(), configure()
+		 * and start() sequence, capturing frames after each iteration
+		 * to make sure the camera is running.
+		 */
+		chrono::steady_clock::duration switchTime{};
+		chrono::steady_clock::duration restartTime{};
+
+		for (unsigned int i = 0; i < kIterations * 2; ++i) {
+			CameraConfiguration *config = configs_[(i + 1) % 2].get();
+			auto begin = chrono::steady_clock::now();
+
+			if (camera_->switchConfiguration(config)) {
+				cout << "Failed to switch configuration" << endl;
+				return TestFail;
+			}
+
+			switchTime += chrono::steady_clock::now() - begin;
+
+			expectedSize_ = config->at(0).size;
+
+			if (queueIdleRequests() != TestPass || capture(2) != TestPass)
+				return TestFail;
+		}
+
+		for (unsigned int i = 0; i < kIterations * 2; ++i) {
+			CameraConfiguration *config = configs_[(i + 1) % 2].get();
+			auto begin = chrono::steady_clock::now();
+
+			if (camera_->stop() || camera_->configure(config) ||
+			    camera_->start()) {
+				cout << "Failed to restart camera" << endl;
+				return TestFail;
+			}
+
+			restartTime += chrono::steady_clock::now() - begin;
+
+			expectedSize_ = config->at(0).size;
+
+			if (queueIdleRequests() != TestPass || capture(2) != TestPass)
+				return TestFail;
+		}
+
+		using chrono::duration_cast;
+		using chrono::microseconds;
+
+		cout << "Average switch latency: "
+		     << duration_cast<microseconds>(switchTime).count() / (kIterations * 2)
+		     << "us, stop/configure/start: "
+		     << duration_cast<microseconds>(restartTime).count() / (kIterations * 2)
+		     << "us" << endl;
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+};
+
+} /* namespace */
+
+TEST_REGISTER(SwitchConfigurationBenchmark)
@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera camera configuration switch test base class
+ */
+
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+class SwitchConfigurationTest : public CameraTest, public Test
+{
+public:
+	SwitchConfigurationTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	void requestComplete(libcamera::Request *request)
+	{
+		if (request->status() != libcamera::Request::RequestComplete) {
+			idleRequests_.push_back(request);
+			return;
+		}
+
+		const libcamera::Request::BufferMap &buffers = request->buffers();
+		const libcamera::Stream *stream = buffers.begin()->first;
+		libcamera::FrameBuffer *buffer = buffers.begin()->second;
+
+		if (stream->configuration().size != expectedSize_)
+			sizeMismatch_ = true;
+
+		completeRequestsCount_++;
+
+		request->reuse();
+		request->addBuffer(stream, buffer);
+		if (camera_->queueRequest(request))
+			idleRequests_.push_back(request);
+	}
+
+	int queueIdleRequests()
+	{
+		for (libcamera::Request *request : idleRequests_) {
+			const libcamera::Request::BufferMap &buffers = request->buffers();
+			const libcamera::Stream *stream = buffers.begin()->first;
+			libcamera::FrameBuffer *buffer = buffers.begin()->second;
+
+			request->reuse();
+			request->addBuffer(stream, buffer);
+			if (camera_->queueRequest(request)) {
+				std::cout << "Failed to queue request" << std::endl;
+				return TestFail;
+			}
+		}
+
+		idleRequests_.clear();
+
+		return TestPass;
+	}
+
+	int capture(unsigned int nFrames)
+	{
+		using namespace std::chrono_literals;
+
+		completeRequestsCount_ = 0;
+
+		libcamera::Timer timer;
+		timer.start(500ms * nFrames);
+		while (timer.isRunning() && completeRequestsCount_ < nFrames)
+			dispatcher_->processEvents();
+
+		if (completeRequestsCount_ < nFrames) {
+			std::cout << "Failed to capture enough frames (got "
+				  << completeRequestsCount_ << " expected at least "
+				  << nFrames << ")" << std::endl;
+			return TestFail;
+		}
+
+		if (sizeMismatch_) {
+			std::cout << "Frame captured with the wrong configuration"
+				  << std::endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		dispatcher_ = libcamera::Thread::current()->eventDispatcher();
+
+		/* Configurations are validated upfront to switch quickly. */
+		for (unsigned int i = 0; i < 2; ++i) {
+			std::unique_ptr<libcamera::CameraConfiguration> config =
+				camera_->generateConfiguration({ libcamera::StreamRole::VideoRecording });
+			if (!config || config->size() != 1) {
+				std::cout << "Failed to generate default configuration"
+					  << std::endl;
+				return TestFail;
+			}
+
+			configs_.push_back(std::move(config));
+		}
+
+		configs_[1]->at(0).size = configs_[0]->at(0).size / 2;
+		if (configs_[1]->validate() == libcamera::CameraConfiguration::Invalid) {
+			std::cout << "Failed to validate the reduced configuration"
+				  << std::endl;
+			return TestFail;
+		}
+
+		if (configs_[1]->at(0).size == configs_[0]->at(0).size)
+			return TestSkip;
+
+		return TestPass;
+	}
+
+	/*
+	 * Acquire the camera, configure it with the first configuration and
+	 * create requests with buffers sized for it, which is the largest.
+	 */
+	int prepare()
+	{
+		if (camera_->acquire()) {
+			std::cout << "Failed to acquire the camera" << std::endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(configs_[0].get())) {
+			std::cout << "Failed to set default configuration" << std::endl;
+			return TestFail;
+		}
+
+		libcamera::Stream *stream = configs_[0]->at(0).stream();
+		allocator_ = std::make_unique<libcamera::FrameBufferAllocator>(camera_);
+
+		if (allocator_->allocate(stream) < 0)
+			return TestFail;
+
+		for (const std::unique_ptr<libcamera::FrameBuffer> &buffer :
+		     allocator_->buffers(stream)) {
+			std::unique_ptr<libcamera::Request> request = camera_->createRequest();
+			if (!request || request->addBuffer(stream, buffer.get())) {
+				std::cout << "Failed to create request" << std::endl;
+				return TestFail;
+			}
+
+			idleRequests_.push_back(request.get());
+			requests_.push_back(std::move(request));
+		}
+
+		camera_->requestCompleted.connect(this, &SwitchConfigurationTest::requestComplete);
+
+		expectedSize_ = configs_[0]->at(0).size;
+		sizeMismatch_ = false;
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		requests_.clear();
+		allocator_.reset();
+	}
+
+	libcamera::EventDispatcher *dispatcher_;
+
+	std::vector<std::unique_ptr<libcamera::CameraConfiguration>> configs_;
+	std::unique_ptr<libcamera::FrameBufferAllocator> allocator_;
+	std::vector<std::unique_ptr<libcamera::Request>> requests_;
+
+	unsigned int completeRequestsCount_;
+	std::vector<libcamera::Request *> idleRequests_;
+	libcamera::Size expectedSize_;
+	bool sizeMismatch_;
+};
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <libcamera/controls.h>
 
@@ -257,6 +258,49 @@ protected:
 			return TestFail;
 		}
 
+		/*
+		 * Large values are shared between copies, and copied on write.
+		 */
+		std::vector<uint8_t> large(4096);
+		for (unsigned int i = 0; i < large.size(); i++)
+			large[i] = i;
+
+		value.set(Span<const uint8_t>(large));
+		ControlValue copy = value;
+		ControlValue assigned;
+		assigned = copy;
+
+		const uint8_t *storage = value.get<Span<const uint8_t>>().data();
+		if (copy.get<Span<const uint8_t>>().data() != storage ||
+		    assigned.get<Span<const uint8_t>>().data() != storage) {
+			cerr << "Large control value storage not shared" << endl;
+			return TestFail;
+		}
+
+		large[0] = 0xff;
+		value.set(Span<const uint8_t>(large));
+
+		if (copy.get<Span<const uint8_t>>()[0] != 0 ||
+		    value.get<Span<const uint8_t>>()[0] != 0xff) {
+			cerr << "Control value copy modified by set()" << endl;
+			return TestFail;
+		}
+
+		copy.data()[1] = 0xfe;
+		if (assigned.get<Span<const uint8_t>>()[1] != 1 ||
+		    copy.get<Span<const uint8_t>>()[1] != 0xfe) {
+			cerr << "Control value copy modified through data()" << endl;
+			return TestFail;
+		}
+
+		copy = value;
+		value = ControlValue();
+		if (copy.get<Span<const uint8_t>>()[0] != 0xff ||
+		    copy.numElements() != large.size()) {
+			cerr << "Shared control value storage released early" << endl;
+			return TestFail;
+		}
+
 		return TestPass;
 	}
 };
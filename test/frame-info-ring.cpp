@@ -0,0 +1,285 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * FrameInfoRing tests
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+
+#include "libcamera/internal/frame_info_ring.h"
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+struct TestInfo {
+	unsigned int frame;
+	unsigned int value;
+};
+
+class FrameInfoRingTest : public CameraTest, public Test
+{
+public:
+	FrameInfoRingTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	static constexpr unsigned int kCapacity = 4;
+	static constexpr unsigned int kNumRequests = 16;
+
+	Request *createFrame(unsigned int frame)
+	{
+		Request *request = requests_[frame % requests_.size()].get();
+
+		TestInfo *info = ring_.create(frame, request);
+		info->frame = frame;
+		info->value = frame * 10;
+
+		return request;
+	}
+
+	int checkFrame(unsigned int frame, const Request *request)
+	{
+		TestInfo *info = ring_.find(frame);
+		if (!info || info->frame != frame || info->value != frame * 10) {
+			cerr << "Frame " << frame << " not found by number" << endl;
+			return TestFail;
+		}
+
+		if (ring_.find(request) != info) {
+			cerr << "Frame " << frame << " not found by request" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		if (camera_->acquire()) {
+			cerr << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		unique_ptr<CameraConfiguration> config =
+			camera_->generateConfiguration({ StreamRole::Viewfinder });
+		if (!config || camera_->configure(config.get())) {
+			cerr << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < kNumRequests; ++i) {
+			unique_ptr<Request> request = camera_->createRequest(i);
+			if (!request) {
+				cerr << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			requests_.push_back(std::move(request));
+		}
+
+		return TestPass;
+	}
+
+	int testMissing()
+	{
+		ring_.reset(kCapacity);
+
+		/* Lookups in an empty ring. */
+		if (ring_.find(0U) || ring_.find(requests_[0].get()) ||
+		    ring_.remove(0)) {
+			cerr << "Empty ring returned an entry" << endl;
+			return TestFail;
+		}
+
+		Request *request = createFrame(3);
+
+		/* Frames sharing the home slot of a stored frame. */
+		if (ring_.find(3 + kCapacity) || ring_.remove(3 + kCapacity)) {
+			cerr << "Colliding missing frame found" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * The requests are never queued, their sequence numbers are
+		 * all 0 and collide in the request index.
+		 */
+		if (ring_.find(requests_[7].get())) {
+			cerr << "Colliding missing request found" << endl;
+			return TestFail;
+		}
+
+		/* A buffer that is not associated with a request. */
+		std::vector<FrameBuffer::Plane> planes;
+		FrameBuffer buffer(planes);
+		if (ring_.find(&buffer)) {
+			cerr << "Buffer without request found" << endl;
+			return TestFail;
+		}
+
+		if (!ring_.remove(3) || ring_.find(3U) || ring_.find(request) ||
+		    !ring_.empty()) {
+			cerr << "Removed frame still found" << endl;
+			return TestFail;
+		}
+
+		if (ring_.remove(3)) {
+			cerr << "Frame removed twice" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testWrapAround()
+	{
+		ring_.reset(kCapacity);
+
+		/*
+		 * Keep up to kCapacity - 1 frames in flight, removing the
+		 * oldest frame each time a new one is created. Frame numbers
+		 * wrap around the ring several times, and the slots freed by
+		 * completed frames are reused.
+		 */
+		std::vector<Request *> inFlight;
+
+		for (unsigned int frame = 0; frame < kNumRequests * 2; ++frame) {
+			inFlight.push_back(createFrame(frame));
+
+			if (inFlight.size() == kCapacity) {
+				unsigned int oldest = frame - (kCapacity - 1);
+				if (!ring_.remove(oldest)) {
+					cerr << "Failed to remove frame " << oldest << endl;
+					return TestFail;
+				}
+
+				inFlight.erase(inFlight.begin());
+			}
+
+			for (unsigned int i = 0; i < inFlight.size(); ++i) {
+				unsigned int f = frame + 1 - inFlight.size() + i;
+				if (checkFrame(f, inFlight[i]) != TestPass)
+					return TestFail;
+			}
+
+			if (ring_.capacity() != kCapacity) {
+				cerr << "Ring grew with free slots" << endl;
+				return TestFail;
+			}
+		}
+
+		/* Remove a frame out of order, leaving a hole before others. */
+		unsigned int last = kNumRequests * 2 - 1;
+		if (!ring_.remove(last - 2) ||
+		    checkFrame(last - 1, inFlight[1]) != TestPass ||
+		    checkFrame(last, inFlight[2]) != TestPass) {
+			cerr << "Lookup failed after out of order removal" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testCollisions()
+	{
+		ring_.reset(kCapacity);
+
+		/* Frame numbers that all map to the same home slot. */
+		std::vector<Request *> requests;
+		for (unsigned int i = 0; i < kCapacity; ++i)
+			requests.push_back(createFrame(i * kCapacity));
+
+		for (unsigned int i = 0; i < kCapacity; ++i) {
+			if (checkFrame(i * kCapacity, requests[i]) != TestPass)
+				return TestFail;
+		}
+
+		/* Free the home slot, the other frames must still be found. */
+		if (!ring_.remove(0)) {
+			cerr << "Failed to remove frame 0" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 1; i < kCapacity; ++i) {
+			if (checkFrame(i * kCapacity, requests[i]) != TestPass)
+				return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testGrow()
+	{
+		ring_.reset(kCapacity);
+
+		std::vector<Request *> requests;
+		for (unsigned int frame = 0; frame < kCapacity * 2 + 1; ++frame)
+			requests.push_back(createFrame(frame));
+
+		if (ring_.size() != kCapacity * 2 + 1 ||
+		    ring_.capacity() < ring_.size()) {
+			cerr << "Ring failed to grow" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int frame = 0; frame < requests.size(); ++frame) {
+			if (checkFrame(frame, requests[frame]) != TestPass)
+				return TestFail;
+		}
+
+		unsigned int count = 0;
+		ring_.forEach([&count](TestInfo &) { count++; });
+		if (count != ring_.size()) {
+			cerr << "forEach() visited " << count << " frames" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testMissing() != TestPass)
+			return TestFail;
+
+		if (testWrapAround() != TestPass)
+			return TestFail;
+
+		if (testCollisions() != TestPass)
+			return TestFail;
+
+		if (testGrow() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		requests_.clear();
+		camera_->release();
+	}
+
+private:
+	std::vector<std::unique_ptr<Request>> requests_;
+	FrameInfoRing<TestInfo> ring_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(FrameInfoRingTest)
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * GStreamer stream formats caps cache test
+ */
+
+#include <iostream>
+#include <unistd.h>
+
+#include <gst/gst.h>
+
+#include "gstreamer_test.h"
+#include "test.h"
+
+using namespace std;
+
+class GstreamerCapsCacheTest : public GstreamerTest, public Test
+{
+public:
+	GstreamerCapsCacheTest()
+		: GstreamerTest()
+	{
+	}
+
+protected:
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		fakesink_ = gst_element_factory_make("fakesink", nullptr);
+		if (!fakesink_) {
+			g_printerr("Your installation is missing 'fakesink'\n");
+			return TestFail;
+		}
+		g_object_ref_sink(fakesink_);
+
+		return createPipeline();
+	}
+
+	int run() override
+	{
+		/* Build the pipeline */
+		gst_bin_add_many(GST_BIN(pipeline_), libcameraSrc_, fakesink_, nullptr);
+		if (!gst_element_link(libcameraSrc_, fakesink_)) {
+			g_printerr("Elements could not be linked.\n");
+			return TestFail;
+		}
+
+		g_autoptr(GstPad) srcpad = gst_element_get_static_pad(libcameraSrc_, "src");
+
+		/* Negotiate a first time, which fills the cache. */
+		if (negotiate(srcpad) != TestPass)
+			return TestFail;
+
+		g_autoptr(GstCaps) caps = gst_pad_query_caps(srcpad, nullptr);
+		if (gst_caps_is_any(caps)) {
+			g_printerr("Caps query not answered from the stream formats\n");
+			return TestFail;
+		}
+
+		/* A second caps query shall hit the cache. */
+		g_autoptr(GstCaps) queried = gst_pad_query_caps(srcpad, nullptr);
+		if (queried != caps) {
+			g_printerr("Caps query missed the cache\n");
+			return TestFail;
+		}
+
+		/*
+		 * Restart streaming. The second negotiation shall reuse the
+		 * cached caps instead of rebuilding them.
+		 */
+		gst_element_set_state(pipeline_, GST_STATE_READY);
+
+		if (negotiate(srcpad) != TestPass)
+			return TestFail;
+
+		g_autoptr(GstCaps) renegotiated = gst_pad_query_caps(srcpad, nullptr);
+		if (renegotiated != caps) {
+			g_printerr("Second negotiation missed the cache\n");
+			return TestFail;
+		}
+
+		if (processEvent() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		g_clear_object(&fakesink_);
+	}
+
+private:
+	int negotiate(GstPad *srcpad)
+	{
+		if (startPipeline() != TestPass)
+			return TestFail;
+
+		/* Negotiation happens in the streaming thread, wait for it. */
+		for (unsigned int i = 0; i < 200; i++) {
+			g_autoptr(GstCaps) current = gst_pad_get_current_caps(srcpad);
+			if (current)
+				return TestPass;
+
+			usleep(10000);
+		}
+
+		g_printerr("Caps not negotiated\n");
+		return TestFail;
+	}
+
+	GstElement *fakesink_;
+};
+
+TEST_REGISTER(GstreamerCapsCacheTest)
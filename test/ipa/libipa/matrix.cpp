@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Matrix and vector operations tests
+ */
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdint.h>
+
+#include "fixedpoint.h"
+#include "matrix.h"
+#include "matrix_interpolator.h"
+#include "vector.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa;
+
+namespace {
+
+constexpr Matrix<int, 2, 2> kIdentity = Matrix<int, 2, 2>::identity();
+constexpr Matrix<int, 2, 2> kMatrix = []() {
+	Matrix<int, 2, 2> m;
+	m[0][0] = 1;
+	m[0][1] = 2;
+	m[1][0] = 3;
+	m[1][1] = 4;
+	return m;
+}();
+
+static_assert((kMatrix * kIdentity).data()[3] == 4);
+static_assert((kMatrix * kMatrix).data()[0] == 7);
+static_assert((kMatrix + kMatrix).data()[1] == 4);
+static_assert((2 * kMatrix).data()[2] == 6);
+
+} /* namespace */
+
+class MatrixTest : public Test
+{
+protected:
+	template<typename T, unsigned int R1, unsigned int C1, unsigned int C2>
+	static Matrix<T, R1, C2> reference(const Matrix<T, R1, C1> &m1,
+					   const Matrix<T, C1, C2> &m2)
+	{
+		Matrix<T, R1, C2> result;
+
+		for (unsigned int i = 0; i < R1; i++) {
+			for (unsigned int j = 0; j < C2; j++) {
+				T sum = 0;
+				for (unsigned int k = 0; k < C1; k++)
+					sum += m1[i][k] * m2[k][j];
+				result[i][j] = sum;
+			}
+		}
+
+		return result;
+	}
+
+	template<unsigned int Rows, unsigned int Cols>
+	Matrix<float, Rows, Cols> random()
+	{
+		Matrix<float, Rows, Cols> m;
+		for (float &value : m.data())
+			value = dist_(gen_);
+		return m;
+	}
+
+	template<unsigned int R1, unsigned int C1, unsigned int C2>
+	int testMultiply()
+	{
+		Matrix<float, R1, C1> m1 = random<R1, C1>();
+		Matrix<float, C1, C2> m2 = random<C1, C2>();
+
+		Matrix<float, R1, C2> result = m1 * m2;
+		Matrix<float, R1, C2> expected = reference(m1, m2);
+
+		for (unsigned int i = 0; i < R1 * C2; i++) {
+			if (std::abs(result.data()[i] - expected.data()[i]) > 1e-5) {
+				cerr << "Matrix product " << result
+				     << " doesn't match " << expected << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testMatrixVector()
+	{
+		Matrix<float, 3, 3> m = random<3, 3>();
+		Vector<float, 3> v({ 0.25f, -0.5f, 2.0f });
+
+		Vector<float, 3> result = m * v;
+
+		for (unsigned int i = 0; i < 3; i++) {
+			float expected = m[i][0] * v[0] + m[i][1] * v[1] + m[i][2] * v[2];
+			if (std::abs(result[i] - expected) > 1e-5) {
+				cerr << "Matrix vector product " << result
+				     << " is incorrect" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testFixedPointMultiply()
+	{
+		static constexpr unsigned int kFrac = 10;
+
+		Matrix<float, 3, 3> ccm({ 1.6f, -0.4f, -0.2f,
+					  -0.3f, 1.5f, -0.2f,
+					  -0.1f, -0.6f, 1.7f });
+		Matrix<int16_t, 3, 3> fixed;
+		for (unsigned int i = 0; i < 9; i++)
+			fixed.data()[i] = std::round(ccm.data()[i] * (1 << kFrac));
+
+		for (unsigned int n = 0; n < 100; n++) {
+			Vector<int32_t, 3> pixel({ static_cast<int32_t>(gen_() % 1024),
+						   static_cast<int32_t>(gen_() % 1024),
+						   static_cast<int32_t>(gen_() % 1024) });
+			Vector<float, 3> pixelf({ static_cast<float>(pixel[0]),
+						  static_cast<float>(pixel[1]),
+						  static_cast<float>(pixel[2]) });
+
+			Vector<int32_t, 3> result = fixedPointMultiply<kFrac>(fixed, pixel);
+			Vector<float, 3> expected = ccm * pixelf;
+
+			for (unsigned int i = 0; i < 3; i++) {
+				if (std::abs(result[i] - expected[i]) > 2.0f) {
+					cerr << "Fixed-point product " << result
+					     << " doesn't match " << expected << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		/*
+		 * Products of 16-bit elements summed over the columns overflow
+		 * a 32-bit accumulator.
+		 */
+		Matrix<int16_t, 1, 3> big({ 32767, 32767, 32767 });
+		Vector<uint16_t, 3> white({ 65535, 65535, 65535 });
+
+		Vector<uint16_t, 1> product = fixedPointMultiply<17>(big, white);
+		int64_t expected = (int64_t{ 32767 } * 65535 * 3 + (1 << 16)) >> 17;
+		if (product[0] != expected) {
+			cerr << "Fixed-point product " << product[0]
+			     << " overflowed, expected " << expected << endl;
+			return TestFail;
+		}
+
+		/* Results out of the range of the vector type shall saturate. */
+		Matrix<int16_t, 2, 3> gains({ 2048, 0, 0,
+					      -1024, -1024, 0 });
+		Vector<uint16_t, 3> pixel({ 65535, 1000, 0 });
+
+		Vector<uint16_t, 2> clamped = fixedPointMultiply<10>(gains, pixel);
+		if (clamped[0] != 65535 || clamped[1] != 0) {
+			cerr << "Fixed-point product " << clamped
+			     << " isn't saturated to [0, 65535]" << endl;
+			return TestFail;
+		}
+
+		Matrix<int16_t, 2, 1> signedGains({ 4096, -4096 });
+		Vector<int8_t, 1> value({ 100 });
+
+		Vector<int8_t, 2> clampedSigned = fixedPointMultiply<10>(signedGains, value);
+		if (clampedSigned[0] != 127 || clampedSigned[1] != -128) {
+			cerr << "Fixed-point product "
+			     << static_cast<int>(clampedSigned[0]) << ", "
+			     << static_cast<int>(clampedSigned[1])
+			     << " isn't saturated to [-128, 127]" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testInterpolator()
+	{
+		std::map<unsigned int, Matrix<float, 3, 3>> matrices = {
+			{ 2000, Matrix<float, 3, 3>::identity() },
+			{ 6000, 3.0f * Matrix<float, 3, 3>::identity() },
+		};
+		MatrixInterpolator<float, 3, 3> interpolator(matrices);
+
+		Matrix<float, 3, 3> m = interpolator.get(3000);
+		if (std::abs(m[1][1] - 1.5f) > 1e-5 || m[0][1] != 0.0f) {
+			cerr << "Interpolated matrix " << m << " is incorrect" << endl;
+			return TestFail;
+		}
+
+		if (interpolator.get(6000)[2][2] != 3.0f ||
+		    interpolator.get(1000)[2][2] != 1.0f) {
+			cerr << "Matrix lookup out of range failed" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testMultiply<3, 3, 3>() != TestPass ||
+		    testMultiply<3, 3, 1>() != TestPass ||
+		    testMultiply<4, 2, 3>() != TestPass)
+			return TestFail;
+
+		if (testMatrixVector() != TestPass)
+			return TestFail;
+
+		if (testFixedPointMultiply() != TestPass)
+			return TestFail;
+
+		if (testInterpolator() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+
+private:
+	std::mt19937 gen_;
+	std::uniform_real_distribution<float> dist_{ -2.0f, 2.0f };
+};
+
+TEST_REGISTER(MatrixTest)
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Matrix and vector operations benchmark
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+
+#include "fixedpoint.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa;
+
+class MatrixBenchmark : public Test
+{
+protected:
+	static constexpr unsigned int kIterations = 1000000;
+
+	int run() override
+	{
+		std::mt19937 gen;
+		std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+
+		/* Colour correction matrix, in floating and Q10 fixed point. */
+		Matrix<float, 3, 3> m;
+		Matrix<int16_t, 3, 3> fixed;
+		for (unsigned int i = 0; i < 9; i++) {
+			m.data()[i] = dist(gen);
+			fixed.data()[i] = std::round(m.data()[i] * 1024);
+		}
+
+		/*
+		 * Modify the input vector at every iteration, and accumulate
+		 * the results, to prevent the compiler from hoisting the
+		 * products out of the loops.
+		 */
+		Vector<float, 3> v({ 0.1f, 0.2f, 0.3f });
+		Vector<int32_t, 3> vi({ 100, 200, 300 });
+		float sum = 0;
+		int64_t sumi = 0;
+
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < kIterations; i++) {
+			v[i % 3] += 1.0f;
+			sum += (m * v)[0];
+		}
+		auto mid = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < kIterations; i++) {
+			vi[i % 3] += 1;
+			sumi += fixedPointMultiply<10>(fixed, vi)[0];
+		}
+		auto end = chrono::steady_clock::now();
+
+		cout << "3x3 matrix vector product: "
+		     << chrono::duration<double, std::nano>(mid - start).count() / kIterations
+		     << "ns floating point, "
+		     << chrono::duration<double, std::nano>(end - mid).count() / kIterations
+		     << "ns fixed point (" << sum << ", " << sumi << ")" << endl;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(MatrixBenchmark)
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Piecewise linear function batch evaluation tests
+ */
+
+#include <array>
+#include <iostream>
+
+#include "pwl.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa;
+
+class PwlTest : public Test
+{
+protected:
+	int compare(const Pwl &pwl, Span<const double> x, Span<const double> y)
+	{
+		for (unsigned int i = 0; i < x.size(); i++) {
+			double expected = pwl.eval(x[i]);
+			if (y[i] != expected) {
+				cerr << "Batch evaluation at " << x[i] << " gave "
+				     << y[i] << ", expected " << expected << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		Pwl pwl({
+			Pwl::Point({ 0, 0 }),
+			Pwl::Point({ 1024, 3000 }),
+			Pwl::Point({ 4096, 12000 }),
+			Pwl::Point({ 16384, 35000 }),
+			Pwl::Point({ 65535, 65535 }),
+		});
+
+		/* Sorted input, including values outside of the domain. */
+		std::array<double, 256> x, y;
+		for (unsigned int i = 0; i < x.size(); i++)
+			x[i] = i * 300.0 - 1000.0;
+
+		pwl.eval(x, y);
+		if (compare(pwl, x, y) != TestPass)
+			return TestFail;
+
+		/* Unsorted input. */
+		std::array<double, 6> xu = { 70000, 12, 5000, 5000, -3, 1024 };
+		std::array<double, 6> yu;
+
+		pwl.eval(xu, yu);
+		if (compare(pwl, xu, yu) != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(PwlTest)
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Piecewise linear function evaluation benchmark
+ */
+
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include "pwl.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa;
+
+class PwlBenchmark : public Test
+{
+protected:
+	static constexpr unsigned int kIterations = 10000;
+
+	int run() override
+	{
+		Pwl pwl({
+			Pwl::Point({ 0, 0 }),
+			Pwl::Point({ 1024, 3000 }),
+			Pwl::Point({ 4096, 12000 }),
+			Pwl::Point({ 16384, 35000 }),
+			Pwl::Point({ 65535, 65535 }),
+		});
+
+		/* Sample a lookup table over the whole domain. */
+		std::array<double, 256> x, y;
+		for (unsigned int i = 0; i < x.size(); i++)
+			x[i] = i * 300.0 - 1000.0;
+
+		double sum = 0;
+
+		auto start = chrono::steady_clock::now();
+		for (unsigned int n = 0; n < kIterations; n++) {
+			for (unsigned int i = 0; i < x.size(); i++)
+				y[i] = pwl.eval(x[i]);
+			sum += y[n % y.size()];
+		}
+		auto mid = chrono::steady_clock::now();
+		for (unsigned int n = 0; n < kIterations; n++) {
+			pwl.eval(x, y);
+			sum += y[n % y.size()];
+		}
+		auto end = chrono::steady_clock::now();
+
+		cout << x.size() << " points LUT: "
+		     << chrono::duration<double, std::micro>(mid - start).count() / kIterations
+		     << "us with scalar eval(), "
+		     << chrono::duration<double, std::micro>(end - mid).count() / kIterations
+		     << "us with batch eval() (" << sum << ")" << endl;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(PwlBenchmark)
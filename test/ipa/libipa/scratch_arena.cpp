@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Scratch arena tests
+ */
+
+#include "scratch_arena.h"
+
+#include <iostream>
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa;
+
+namespace {
+
+struct alignas(64) Aligned {
+	uint8_t data[3];
+};
+
+template<typename T>
+bool isAligned(const T *ptr)
+{
+	return !(reinterpret_cast<uintptr_t>(ptr) % alignof(T));
+}
+
+} /* namespace */
+
+class ScratchArenaTest : public Test
+{
+protected:
+	int testReuse()
+	{
+		ScratchArena arena;
+		arena.reserve<uint32_t>(64);
+
+		if (arena.capacity() < 64 * sizeof(uint32_t) || arena.used()) {
+			cerr << "Invalid arena state after reserve()" << endl;
+			return TestFail;
+		}
+
+		const size_t capacity = arena.capacity();
+
+		Span<uint32_t> first = arena.allocate<uint32_t>(64);
+		if (first.size() != 64 || arena.used() < 64 * sizeof(uint32_t)) {
+			cerr << "Invalid allocation of " << first.size()
+			     << " elements, " << arena.used() << " bytes used"
+			     << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < first.size(); ++i)
+			first[i] = i;
+
+		/* Memory is reused after a reset, without growing the block. */
+		arena.reset();
+
+		if (arena.used()) {
+			cerr << "Memory still used after reset()" << endl;
+			return TestFail;
+		}
+
+		Span<uint32_t> second = arena.allocate<uint32_t>(64);
+		if (second.data() != first.data() || arena.capacity() != capacity) {
+			cerr << "Arena memory not reused after reset()" << endl;
+			return TestFail;
+		}
+
+		/* Release drops the memory and the reservations. */
+		arena.release();
+
+		if (arena.capacity() || arena.used()) {
+			cerr << "Arena memory not freed by release()" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testAlignment()
+	{
+		ScratchArena arena;
+		arena.reserve<uint8_t>(1);
+		arena.reserve<uint16_t>(1);
+		arena.reserve<double>(3);
+		arena.reserve<Aligned>(2);
+
+		/* Interleave types to force padding between allocations. */
+		Span<uint8_t> bytes = arena.allocate<uint8_t>(1);
+		Span<uint16_t> shorts = arena.allocate<uint16_t>(1);
+		Span<double> doubles = arena.allocate<double>(3);
+		Span<Aligned> aligned = arena.allocate<Aligned>(2);
+
+		if (!isAligned(bytes.data()) || !isAligned(shorts.data()) ||
+		    !isAligned(doubles.data()) || !isAligned(aligned.data())) {
+			cerr << "Misaligned allocation" << endl;
+			return TestFail;
+		}
+
+		if (arena.used() > arena.capacity()) {
+			cerr << "Reservations don't cover aligned allocations: "
+			     << arena.used() << " bytes used, capacity "
+			     << arena.capacity() << endl;
+			return TestFail;
+		}
+
+		/* Allocations must not overlap. */
+		const uint8_t *end = bytes.data() + 1;
+		if (reinterpret_cast<const uint8_t *>(shorts.data()) < end)
+			return TestFail;
+
+		end = reinterpret_cast<const uint8_t *>(shorts.data() + 1);
+		if (reinterpret_cast<const uint8_t *>(doubles.data()) < end)
+			return TestFail;
+
+		end = reinterpret_cast<const uint8_t *>(doubles.data() + 3);
+		if (reinterpret_cast<const uint8_t *>(aligned.data()) < end)
+			return TestFail;
+
+		return TestPass;
+	}
+
+	int testOverflow()
+	{
+		ScratchArena arena;
+		arena.reserve<uint8_t>(16);
+
+		const size_t capacity = arena.capacity();
+
+		/* Exceed the reservation, allocations must still succeed. */
+		Span<uint8_t> first = arena.allocate<uint8_t>(16);
+		Span<uint8_t> second = arena.allocate<uint8_t>(4096);
+		Span<Aligned> third = arena.allocate<Aligned>(4);
+
+		if (second.size() != 4096 || !isAligned(third.data())) {
+			cerr << "Invalid overflow allocation" << endl;
+			return TestFail;
+		}
+
+		/* Overflow allocations must be usable and distinct. */
+		memset(first.data(), 0x11, first.size());
+		memset(second.data(), 0x22, second.size());
+		memset(third.data(), 0x33, third.size_bytes());
+
+		if (first[15] != 0x11 || second[0] != 0x22 ||
+		    second[4095] != 0x22) {
+			cerr << "Overlapping overflow allocations" << endl;
+			return TestFail;
+		}
+
+		const size_t peak = arena.used();
+		if (arena.capacity() != capacity || peak < 16 + 4096 + 4 * sizeof(Aligned)) {
+			cerr << "Invalid usage " << peak << " after overflow" << endl;
+			return TestFail;
+		}
+
+		/* The block grows to the peak usage at the next reset. */
+		arena.reset();
+
+		if (arena.capacity() < peak) {
+			cerr << "Arena did not grow to the peak usage: capacity "
+			     << arena.capacity() << ", peak " << peak << endl;
+			return TestFail;
+		}
+
+		/* The same allocations now fit in the block. */
+		first = arena.allocate<uint8_t>(16);
+		second = arena.allocate<uint8_t>(4096);
+		third = arena.allocate<Aligned>(4);
+
+		const uint8_t *base = first.data();
+		const uint8_t *last = reinterpret_cast<const uint8_t *>(third.data() + 4);
+		if (arena.used() > arena.capacity() ||
+		    static_cast<size_t>(last - base) > arena.capacity() ||
+		    second.data() < base || second.data() > last) {
+			cerr << "Allocations overflowed the grown arena" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testReuse() != TestPass)
+			return TestFail;
+
+		if (testAlignment() != TestPass)
+			return TestFail;
+
+		if (testOverflow() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(ScratchArenaTest)
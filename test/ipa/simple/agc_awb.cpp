@@ -0,0 +1,260 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * Software ISP exposure and white balance convergence tests
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <libcamera/base/utils.h>
+
+#include "libcamera/internal/software_isp/swisp_stats.h"
+
+#include "agc.h"
+#include "awb.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+using namespace ipa::soft;
+
+namespace {
+
+constexpr uint8_t kBlackLevel = 16;
+constexpr int32_t kExposureMin = 4;
+constexpr int32_t kExposureMax = 2000;
+constexpr double kGainMin = 1.0;
+constexpr double kGainMax = 16.0;
+
+/* Maximum white balance gain, as in the IPA */
+constexpr double kAwbGainMax = 4.0;
+
+/* Number of frames before exposure changes apply, as in the IPA */
+constexpr unsigned int kSensorDelay = 2;
+
+/*
+ * Maximum number of frames to converge. Each exposure update shows in the
+ * frames after the sensor delay only, which the IPA skips. An update thus
+ * takes kSensorDelay + 1 frames, and up to four updates are needed to get out
+ * of a saturated image.
+ */
+constexpr unsigned int kMaxFrames = 4 * (kSensorDelay + 1);
+
+struct Colour {
+	double r;
+	double g;
+	double b;
+};
+
+/*
+ * Simulated scene, with one reflectance per zone of the AWB grid. Each zone
+ * is textured with samples of different brightness.
+ */
+class Scene
+{
+public:
+	Scene(double radiance, const Colour &illuminant)
+		: radiance_(radiance), illuminant_(illuminant),
+		  zones_(SwIspStats::kAwbGridWidth * SwIspStats::kAwbGridHeight,
+			 Colour{ 0.5, 0.5, 0.5 })
+	{
+	}
+
+	void setZone(unsigned int index, const Colour &reflectance)
+	{
+		zones_[index] = reflectance;
+	}
+
+	SwIspStats capture(int32_t exposure, double gain) const
+	{
+		static constexpr double kTexture[] = { 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 1.75 };
+		static constexpr unsigned int kSamplesPerZone = 64;
+
+		SwIspStats stats{};
+
+		/* Report the sums of a 10-bit sensor. */
+		stats.sampleDivisor = 4;
+
+		auto sample = [&](double reflectance, double light, double texture) {
+			double value = kBlackLevel + (255 - kBlackLevel) *
+				       radiance_ * reflectance * light * texture * exposure * gain;
+			return static_cast<unsigned int>(std::clamp(value, 0.0, 255.0));
+		};
+
+		for (const auto &[i, zone] : utils::enumerate(zones_)) {
+			SwIspStats::AwbZone &stat = stats.awbGrid[i];
+
+			for (unsigned int s = 0; s < kSamplesPerZone; ++s) {
+				double texture = kTexture[s % std::size(kTexture)];
+				unsigned int r = sample(zone.r, illuminant_.r, texture);
+				unsigned int g = sample(zone.g, illuminant_.g, texture);
+				unsigned int b = sample(zone.b, illuminant_.b, texture);
+
+				stat.sumR += r * stats.sampleDivisor;
+				stat.sumG += g * stats.sampleDivisor;
+				stat.sumB += b * stats.sampleDivisor;
+				stat.count++;
+
+				stats.sumR_ += r * stats.sampleDivisor;
+				stats.sumG_ += g * stats.sampleDivisor;
+				stats.sumB_ += b * stats.sampleDivisor;
+
+				unsigned int y = (r * 77 + g * 150 + b * 29) / 256;
+				stats.yHistogram[y * SwIspStats::kYHistogramSize / 256]++;
+			}
+		}
+
+		return stats;
+	}
+
+private:
+	double radiance_;
+	Colour illuminant_;
+	std::vector<Colour> zones_;
+};
+
+} /* namespace */
+
+class SoftAgcAwbTest : public Test
+{
+protected:
+	/*
+	 * Replay the frames of a scene through the AGC with the update cadence
+	 * of the IPA, and return the index of the first frame captured with
+	 * the converged exposure, or 0 if it didn't converge.
+	 */
+	unsigned int converge(const Scene &scene, int32_t exposure, double gain)
+	{
+		Agc agc;
+		agc.configure(kExposureMin, kExposureMax, kGainMin, kGainMax);
+
+		/* Exposure and gain applied to the frames, delayed by the sensor */
+		std::vector<std::pair<int32_t, double>> applied(kSensorDelay + 1,
+								{ exposure, gain });
+		unsigned int ignore = 0;
+
+		for (unsigned int frame = 0; frame < 10 * (kSensorDelay + 1); ++frame) {
+			const auto [frameExposure, frameGain] = applied.front();
+			applied.erase(applied.begin());
+
+			SwIspStats stats = scene.capture(frameExposure, frameGain);
+
+			if (ignore) {
+				ignore--;
+				applied.push_back(applied.back());
+				continue;
+			}
+
+			int32_t nextExposure = frameExposure;
+			double nextGain = frameGain;
+			if (!agc.process(stats.yHistogram, kBlackLevel,
+					 nextExposure, nextGain))
+				return frame;
+
+			ignore = kSensorDelay;
+			applied.push_back({ nextExposure, nextGain });
+		}
+
+		return 0;
+	}
+
+	int testAgc()
+	{
+		const Scene scene(0.001, { 1.0, 1.0, 1.0 });
+
+		struct {
+			const char *name;
+			int32_t exposure;
+			double gain;
+		} starts[] = {
+			{ "dark", kExposureMin, kGainMin },
+			{ "saturated", kExposureMax, kGainMax },
+		};
+
+		for (const auto &start : starts) {
+			unsigned int frames = converge(scene, start.exposure, start.gain);
+			if (!frames || frames > kMaxFrames) {
+				cerr << "AGC didn't converge from " << start.name
+				     << " in " << kMaxFrames << " frames" << endl;
+				return TestFail;
+			}
+		}
+
+		/* A very dark scene must be compensated by the analogue gain. */
+		const Scene dark(0.00005, { 1.0, 1.0, 1.0 });
+		unsigned int frames = converge(dark, kExposureMin, kGainMin);
+		if (!frames || frames > kMaxFrames) {
+			cerr << "AGC didn't converge in low light in " << kMaxFrames
+			     << " frames" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testAwb()
+	{
+		/* Warm illuminant, with a large red object in the scene. */
+		Scene scene(0.001, { 1.6, 1.0, 0.6 });
+		for (unsigned int i = 0; i < SwIspStats::kAwbGridWidth * 5; ++i)
+			scene.setZone(i, { 0.6, 0.15, 0.1 });
+
+		SwIspStats stats = scene.capture(300, 1.0);
+
+		Awb awb;
+		awb.process(stats, kBlackLevel);
+
+		const double expectedR = 1.0 / 1.6;
+		const double expectedB = 1.0 / 0.6;
+
+		if (std::abs(awb.gainR() / expectedR - 1.0) > 0.05 ||
+		    std::abs(awb.gainB() / expectedB - 1.0) > 0.05) {
+			cerr << "AWB gains " << awb.gainR() << "/" << awb.gainB()
+			     << " don't match " << expectedR << "/" << expectedB
+			     << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Without any usable zone the whole frame sums are used. Noise
+		 * can bring the red and blue sums below the black level, which
+		 * must be handled as a lack of red and blue, not wrap around.
+		 */
+		const unsigned int nPixels = 1000;
+
+		stats = {};
+		stats.sampleDivisor = 1;
+		stats.yHistogram[0] = nPixels;
+		stats.sumR_ = (kBlackLevel * nPixels) / 4 - 100;
+		stats.sumG_ = (kBlackLevel * nPixels) / 2 + 200;
+		stats.sumB_ = (kBlackLevel * nPixels) / 4 - 100;
+
+		awb.process(stats, kBlackLevel);
+
+		if (awb.gainR() != kAwbGainMax || awb.gainB() != kAwbGainMax) {
+			cerr << "AWB gains " << awb.gainR() << "/" << awb.gainB()
+			     << " invalid with sums below the black level" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testAgc() != TestPass)
+			return TestFail;
+
+		if (testAwb() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(SoftAgcAwbTest)
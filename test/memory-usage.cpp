@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * MemoryUsage tests
+ */
+
+#include <iostream>
+
+#include <libcamera/memory_usage.h>
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class MemoryUsageTest : public Test
+{
+protected:
+	int run()
+	{
+		using Purpose = MemoryUsage::Purpose;
+		using Type = MemoryUsage::Type;
+
+		MemoryUsage usage;
+
+		if (usage.total() != 0) {
+			cout << "Default memory usage is not empty" << endl;
+			return TestFail;
+		}
+
+		usage.add(Purpose::Application, Type::DmaBuf, 4096);
+		usage.add(Purpose::Raw, Type::DmaBuf, 1000);
+		usage.add(Purpose::Raw, Type::DmaBuf, 24);
+		usage.add(Purpose::Statistics, Type::SharedMemory, 512);
+
+		if (usage.size(Purpose::Raw, Type::DmaBuf) != 1024 ||
+		    usage.size(Purpose::Raw) != 1024 ||
+		    usage.size(Purpose::Parameters) != 0) {
+			cout << "Invalid per-purpose memory usage" << endl;
+			return TestFail;
+		}
+
+		if (usage.size(Type::DmaBuf) != 5120 ||
+		    usage.size(Type::SharedMemory) != 512) {
+			cout << "Invalid per-type memory usage" << endl;
+			return TestFail;
+		}
+
+		if (usage.total() != 5632) {
+			cout << "Invalid total memory usage" << endl;
+			return TestFail;
+		}
+
+		if (usage.toString() != "5632 bytes, Application/dmabuf: 4096, "
+					"Raw/dmabuf: 1024, Statistics/shmem: 512") {
+			cout << "Invalid string representation "
+			     << usage.toString() << endl;
+			return TestFail;
+		}
+
+		usage.remove(Purpose::Raw, Type::DmaBuf, 1000);
+		if (usage.size(Purpose::Raw) != 24) {
+			cout << "Failed to remove memory" << endl;
+			return TestFail;
+		}
+
+		/* Removing more memory than recorded shall clamp to zero. */
+		usage.remove(Purpose::Statistics, Type::SharedMemory, 4096);
+		if (usage.size(Purpose::Statistics) != 0 ||
+		    usage.total() != 4120) {
+			cout << "Failed to clamp removed memory" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(MemoryUsageTest)
@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Post-processing stages benchmark
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef HAVE_LIBYUV
+#include <libyuv/scale.h>
+#endif
+
+#include <libcamera/formats.h>
+#include <libcamera/stream.h>
+#include <libcamera/transform.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/post_processing.h"
+#include "libcamera/internal/post_processing/scale.h"
+#include "libcamera/internal/post_processing/transform.h"
+#include "libcamera/internal/shared_mem_object.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+namespace {
+
+class Buffer
+{
+public:
+	Buffer(const StreamConfiguration &cfg)
+		: mem_("post-processing-benchmark", cfg.frameSize)
+	{
+		const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < info.numPlanes(); ++i) {
+			unsigned int stride = PostProcessingStage::planeStride(cfg, i);
+			unsigned int size = info.planeSize(cfg.size.height, i, stride);
+
+			planes_.push_back(mem_.mem().subspan(offset, size));
+			offset += size;
+		}
+	}
+
+	const std::vector<Span<uint8_t>> &planes() const { return planes_; }
+
+private:
+	SharedMem mem_;
+	std::vector<Span<uint8_t>> planes_;
+};
+
+StreamConfiguration streamConfiguration(const PixelFormat &format, const Size &size)
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(format);
+
+	StreamConfiguration cfg;
+	cfg.pixelFormat = format;
+	cfg.size = size;
+	cfg.stride = info.stride(size.width, 0, 16);
+	cfg.frameSize = 0;
+	for (unsigned int i = 0; i < info.numPlanes(); ++i)
+		cfg.frameSize += info.planeSize(size.height, i,
+						PostProcessingStage::planeStride(cfg, i));
+
+	return cfg;
+}
+
+template<typename Func>
+double measure(Func func)
+{
+	static constexpr unsigned int kIterations = 50;
+
+	/* Warm up the caches and the worker threads. */
+	func();
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned int i = 0; i < kIterations; ++i)
+		func();
+	auto end = chrono::steady_clock::now();
+
+	return chrono::duration<double, std::milli>(end - start).count() / kIterations;
+}
+
+} /* namespace */
+
+class PostProcessingBenchmark : public Test
+{
+protected:
+	int benchmarkScale(const Size &inputSize, const Size &outputSize)
+	{
+		StreamConfiguration inputCfg = streamConfiguration(formats::NV12, inputSize);
+		StreamConfiguration outputCfg = streamConfiguration(formats::NV12, outputSize);
+
+		Buffer input(inputCfg);
+		Buffer output(outputCfg);
+
+		std::mt19937 gen;
+		for (const Span<uint8_t> &plane : input.planes()) {
+			for (uint8_t &value : plane)
+				value = gen();
+		}
+
+		cout << "NV12 " << inputSize << " to " << outputSize << ":" << endl;
+
+		for (unsigned int stripes : { 1U, 0U }) {
+			ScaleStage scale(ScaleStage::Filter::Bilinear, stripes);
+			if (scale.configure(inputCfg, outputCfg)) {
+				cerr << "Failed to configure scale stage" << endl;
+				return TestFail;
+			}
+
+			double time = measure([&]() {
+				scale.process(input.planes(), output.planes());
+			});
+
+			cout << "  ScaleStage bilinear, "
+			     << (stripes ? "single thread: " : "multiple threads: ")
+			     << time << "ms" << endl;
+		}
+
+#ifdef HAVE_LIBYUV
+		const std::vector<Span<uint8_t>> &in = input.planes();
+		const std::vector<Span<uint8_t>> &out = output.planes();
+
+		double time = measure([&]() {
+			libyuv::NV12Scale(in[0].data(), inputCfg.stride,
+					  in[1].data(), inputCfg.stride,
+					  inputSize.width, inputSize.height,
+					  out[0].data(), outputCfg.stride,
+					  out[1].data(), outputCfg.stride,
+					  outputSize.width, outputSize.height,
+					  libyuv::FilterMode::kFilterBilinear);
+		});
+
+		cout << "  libyuv NV12Scale bilinear: " << time << "ms" << endl;
+#else
+		cout << "  libyuv not available" << endl;
+#endif
+
+		return TestPass;
+	}
+
+	int benchmarkTransform(const PixelFormat &format, Transform transform)
+	{
+		const Size inputSize{ 1920, 1080 };
+		const Size outputSize = !!(transform & Transform::Transpose)
+				      ? Size(inputSize.height, inputSize.width)
+				      : inputSize;
+
+		StreamConfiguration inputCfg = streamConfiguration(format, inputSize);
+		StreamConfiguration outputCfg = streamConfiguration(format, outputSize);
+
+		Buffer input(inputCfg);
+		Buffer output(outputCfg);
+
+		cout << format << " " << inputSize << " "
+		     << transformToString(transform) << ":" << endl;
+
+		for (unsigned int stripes : { 1U, 0U }) {
+			TransformStage stage(transform, stripes);
+			if (stage.configure(inputCfg, outputCfg)) {
+				cerr << "Failed to configure transform stage" << endl;
+				return TestFail;
+			}
+
+			double time = measure([&]() {
+				stage.process(input.planes(), output.planes());
+			});
+
+			cout << "  TransformStage, "
+			     << (stripes ? "single thread: " : "multiple threads: ")
+			     << time << "ms" << endl;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (benchmarkScale({ 1920, 1080 }, { 1280, 720 }) != TestPass)
+			return TestFail;
+
+		if (benchmarkScale({ 1920, 1080 }, { 640, 480 }) != TestPass)
+			return TestFail;
+
+		for (Transform transform : { Transform::Rot90, Transform::Rot180 }) {
+			if (benchmarkTransform(formats::NV12, transform) != TestPass)
+				return TestFail;
+		}
+
+		if (benchmarkTransform(formats::XRGB8888, Transform::Rot90) != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(PostProcessingBenchmark)
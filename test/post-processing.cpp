@@ -0,0 +1,411 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Post-processing stages tests
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <libcamera/formats.h>
+#include <libcamera/stream.h>
+#include <libcamera/transform.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/post_processing.h"
+#include "libcamera/internal/post_processing/downscale.h"
+#include "libcamera/internal/post_processing/scale.h"
+#include "libcamera/internal/post_processing/transform.h"
+#include "libcamera/internal/shared_mem_object.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+namespace {
+
+class Buffer
+{
+public:
+	Buffer(const StreamConfiguration &cfg)
+		: mem_("post-processing-test", cfg.frameSize)
+	{
+		const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < info.numPlanes(); ++i) {
+			unsigned int stride = PostProcessingStage::planeStride(cfg, i);
+			unsigned int size = info.planeSize(cfg.size.height, i, stride);
+
+			planes_.push_back(mem_.mem().subspan(offset, size));
+			offset += size;
+		}
+	}
+
+	Span<uint8_t> plane(unsigned int i) const { return planes_[i]; }
+
+private:
+	SharedMem mem_;
+	std::vector<Span<uint8_t>> planes_;
+};
+
+StreamConfiguration streamConfiguration(const PixelFormat &format, const Size &size)
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(format);
+
+	StreamConfiguration cfg;
+	cfg.pixelFormat = format;
+	cfg.size = size;
+	cfg.stride = info.stride(size.width, 0, 16);
+	cfg.frameSize = 0;
+	for (unsigned int i = 0; i < info.numPlanes(); ++i)
+		cfg.frameSize += info.planeSize(size.height, i,
+						PostProcessingStage::planeStride(cfg, i));
+
+	return cfg;
+}
+
+} /* namespace */
+
+class PostProcessingTest : public Test
+{
+protected:
+	int testDownscale()
+	{
+		StreamConfiguration inputCfg = streamConfiguration(formats::RGB888, { 48, 30 });
+		StreamConfiguration outputCfg = streamConfiguration(formats::RGB888, { 16, 10 });
+
+		DownscaleStage stage;
+		if (stage.configure(inputCfg, outputCfg)) {
+			cerr << "Failed to configure downscale stage" << endl;
+			return TestFail;
+		}
+
+		Buffer input(inputCfg);
+		Buffer output(outputCfg);
+
+		std::mt19937 gen;
+		for (uint8_t &value : input.plane(0))
+			value = gen();
+
+		std::vector<Span<uint8_t>> in{ input.plane(0) };
+		std::vector<Span<uint8_t>> out{ output.plane(0) };
+		stage.process(in, out);
+
+		for (unsigned int y = 0; y < 10; ++y) {
+			for (unsigned int x = 0; x < 16 * 3; ++x) {
+				unsigned int c = x % 3;
+				unsigned int sum = 4;
+
+				for (unsigned int j = 0; j < 3; ++j) {
+					for (unsigned int i = 0; i < 3; ++i) {
+						unsigned int offset = (y * 3 + j) * inputCfg.stride
+								    + ((x / 3) * 3 + i) * 3 + c;
+						sum += input.plane(0)[offset];
+					}
+				}
+
+				uint8_t value = output.plane(0)[y * outputCfg.stride + x];
+				if (value != sum / 9) {
+					cerr << "Incorrect downscaled value " << unsigned(value)
+					     << " at (" << x << ", " << y << "), expected "
+					     << sum / 9 << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		/* Invalid configurations shall be rejected. */
+		if (!stage.configure(inputCfg, streamConfiguration(formats::RGB888, { 20, 10 })) ||
+		    !stage.configure(inputCfg, streamConfiguration(formats::BGR888, { 16, 10 })) ||
+		    !stage.configure(streamConfiguration(formats::NV12, { 64, 48 }),
+				     streamConfiguration(formats::NV12, { 32, 15 }))) {
+			cerr << "Invalid configuration accepted" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testDownscaleInPlace()
+	{
+		/*
+		 * Downscale horizontally in place, with the input and output
+		 * sharing the same memory and stride, as done by pipeline
+		 * handlers that capture frames wider than the stream. The
+		 * result must match an out-of-place downscale.
+		 */
+		const Size outputSize(40, 16);
+
+		for (const PixelFormat &format : { formats::NV12, formats::YUV420,
+						   formats::RGB888, formats::XRGB8888 }) {
+			const PixelFormatInfo &info = PixelFormatInfo::info(format);
+
+			for (unsigned int factor : { 2U, 4U }) {
+				StreamConfiguration inputCfg =
+					streamConfiguration(format, { outputSize.width * factor,
+								      outputSize.height });
+				StreamConfiguration outputCfg = streamConfiguration(format, outputSize);
+				StreamConfiguration inPlaceCfg = outputCfg;
+				inPlaceCfg.stride = inputCfg.stride;
+				inPlaceCfg.frameSize = inputCfg.frameSize;
+
+				DownscaleStage reference;
+				DownscaleStage stage;
+				if (reference.configure(inputCfg, outputCfg) ||
+				    stage.configure(inputCfg, inPlaceCfg)) {
+					cerr << "Failed to configure " << format
+					     << " downscale" << endl;
+					return TestFail;
+				}
+
+				Buffer frame(inputCfg);
+				Buffer expected(outputCfg);
+
+				std::mt19937 gen;
+				std::vector<Span<uint8_t>> planes;
+				std::vector<Span<uint8_t>> expectedPlanes;
+
+				for (unsigned int p = 0; p < info.numPlanes(); ++p) {
+					for (uint8_t &value : frame.plane(p))
+						value = gen();
+
+					planes.push_back(frame.plane(p));
+					expectedPlanes.push_back(expected.plane(p));
+				}
+
+				reference.process(planes, expectedPlanes);
+				stage.process(planes, planes);
+
+				for (unsigned int p = 0; p < info.numPlanes(); ++p) {
+					unsigned int lineSize = info.stride(outputSize.width, p, 1);
+					unsigned int lines = outputSize.height /
+							     info.planes[p].verticalSubSampling;
+					unsigned int stride = PostProcessingStage::planeStride(inPlaceCfg, p);
+					unsigned int expectedStride = PostProcessingStage::planeStride(outputCfg, p);
+
+					for (unsigned int y = 0; y < lines; ++y) {
+						const uint8_t *line = &planes[p][y * stride];
+						const uint8_t *ref = &expectedPlanes[p][y * expectedStride];
+
+						if (!std::equal(line, line + lineSize, ref)) {
+							cerr << "In place " << format
+							     << " downscale by " << factor
+							     << " differs on plane " << p
+							     << " line " << y << endl;
+							return TestFail;
+						}
+					}
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testScale()
+	{
+		const Size inputSize(96, 64);
+		StreamConfiguration inputCfg = streamConfiguration(formats::NV12, inputSize);
+		StreamConfiguration halfCfg = streamConfiguration(formats::NV12, inputSize / 2);
+		StreamConfiguration oddCfg = streamConfiguration(formats::NV12, { 64, 40 });
+
+		Buffer input(inputCfg);
+		Buffer reference(halfCfg);
+		Buffer output(halfCfg);
+		Buffer odd(oddCfg);
+
+		std::mt19937 gen;
+		for (unsigned int i = 0; i < 2; ++i) {
+			for (uint8_t &value : input.plane(i))
+				value = gen();
+		}
+
+		std::vector<Span<uint8_t>> in{ input.plane(0), input.plane(1) };
+
+		/*
+		 * Scaling by a factor of two is a box filter with both the
+		 * bilinear and area filters, and must match the downscale
+		 * stage.
+		 */
+		DownscaleStage downscale;
+		downscale.configure(inputCfg, halfCfg);
+		downscale.process(in, std::vector<Span<uint8_t>>{ reference.plane(0),
+								  reference.plane(1) });
+
+		for (ScaleStage::Filter filter : { ScaleStage::Filter::Bilinear,
+						   ScaleStage::Filter::Area }) {
+			ScaleStage scale(filter, 3);
+			if (scale.configure(inputCfg, halfCfg)) {
+				cerr << "Failed to configure scale stage" << endl;
+				return TestFail;
+			}
+
+			std::vector<Span<uint8_t>> out{ output.plane(0), output.plane(1) };
+			scale.process(in, out);
+
+			for (unsigned int i = 0; i < 2; ++i) {
+				if (!std::equal(output.plane(i).begin(), output.plane(i).end(),
+						reference.plane(i).begin())) {
+					cerr << "Scaled plane " << i << " doesn't match reference"
+					     << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		/* Compare bilinear scaling by 1.5 and 1.6 with a float reference. */
+		ScaleStage scale(ScaleStage::Filter::Bilinear, 2);
+		if (scale.configure(inputCfg, oddCfg)) {
+			cerr << "Failed to configure scale stage" << endl;
+			return TestFail;
+		}
+
+		scale.process(in, std::vector<Span<uint8_t>>{ odd.plane(0), odd.plane(1) });
+
+		const float scaleX = 96.0f / 64;
+		const float scaleY = 64.0f / 40;
+
+		for (unsigned int y = 0; y < 40; ++y) {
+			float sy = std::clamp((y + 0.5f) * scaleY - 0.5f, 0.0f, 63.0f);
+			unsigned int y0 = std::min<unsigned int>(sy, 62);
+
+			for (unsigned int x = 0; x < 64; ++x) {
+				float sx = std::clamp((x + 0.5f) * scaleX - 0.5f, 0.0f, 95.0f);
+				unsigned int x0 = std::min<unsigned int>(sx, 94);
+
+				auto pixel = [&](unsigned int px, unsigned int py) -> float {
+					return input.plane(0)[py * inputCfg.stride + px];
+				};
+
+				float fx = sx - x0;
+				float fy = sy - y0;
+				float expected = (pixel(x0, y0) * (1 - fx) + pixel(x0 + 1, y0) * fx) * (1 - fy) +
+						 (pixel(x0, y0 + 1) * (1 - fx) + pixel(x0 + 1, y0 + 1) * fx) * fy;
+				float value = odd.plane(0)[y * oddCfg.stride + x];
+
+				if (std::abs(value - expected) > 1.0f) {
+					cerr << "Bilinear value " << value << " at (" << x
+					     << ", " << y << ") doesn't match " << expected
+					     << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testTransform()
+	{
+		struct PlaneLayout {
+			unsigned int bytesPerPixel;
+			unsigned int subSampling;
+		};
+
+		const std::vector<std::pair<PixelFormat, std::vector<PlaneLayout>>> layouts = {
+			{ formats::RGB888, { { 3, 1 } } },
+			{ formats::XRGB8888, { { 4, 1 } } },
+			{ formats::NV12, { { 1, 1 }, { 2, 2 } } },
+			{ formats::YUV420, { { 1, 1 }, { 1, 2 }, { 1, 2 } } },
+		};
+
+		/* Use a size that isn't a multiple of the tile size. */
+		const Size inputSize(70, 38);
+
+		for (const auto &[format, planes] : layouts) {
+			StreamConfiguration inputCfg = streamConfiguration(format, inputSize);
+			Buffer input(inputCfg);
+
+			std::mt19937 gen;
+			std::vector<Span<uint8_t>> in;
+			for (unsigned int i = 0; i < planes.size(); ++i) {
+				for (uint8_t &value : input.plane(i))
+					value = gen();
+				in.push_back(input.plane(i));
+			}
+
+			for (unsigned int t = 0; t < 8; ++t) {
+				const Transform transform = static_cast<Transform>(t);
+				const bool transpose = !!(transform & Transform::Transpose);
+				const bool hflip = !!(transform & Transform::HFlip);
+				const bool vflip = !!(transform & Transform::VFlip);
+
+				const Size outputSize = transpose
+						      ? Size(inputSize.height, inputSize.width)
+						      : inputSize;
+				StreamConfiguration outputCfg = streamConfiguration(format, outputSize);
+				Buffer output(outputCfg);
+
+				TransformStage stage(transform, 3);
+				if (stage.configure(inputCfg, outputCfg)) {
+					cerr << "Failed to configure " << transformToString(transform)
+					     << " transform stage" << endl;
+					return TestFail;
+				}
+
+				std::vector<Span<uint8_t>> out;
+				for (unsigned int i = 0; i < planes.size(); ++i)
+					out.push_back(output.plane(i));
+
+				stage.process(in, out);
+
+				for (unsigned int i = 0; i < planes.size(); ++i) {
+					const unsigned int bpp = planes[i].bytesPerPixel;
+					const Size size = inputSize / planes[i].subSampling;
+					const Size outSize = outputSize / planes[i].subSampling;
+					const unsigned int inStride = PostProcessingStage::planeStride(inputCfg, i);
+					const unsigned int outStride = PostProcessingStage::planeStride(outputCfg, i);
+
+					for (unsigned int y = 0; y < outSize.height; ++y) {
+						for (unsigned int x = 0; x < outSize.width; ++x) {
+							unsigned int sx = transpose ? y : x;
+							unsigned int sy = transpose ? x : y;
+							if (hflip)
+								sx = size.width - 1 - sx;
+							if (vflip)
+								sy = size.height - 1 - sy;
+
+							const uint8_t *expected = &input.plane(i)[sy * inStride + sx * bpp];
+							const uint8_t *value = &output.plane(i)[y * outStride + x * bpp];
+
+							if (!std::equal(value, value + bpp, expected)) {
+								cerr << transformToString(transform)
+								     << " of " << format << " plane " << i
+								     << " doesn't match at (" << x << ", "
+								     << y << ")" << endl;
+								return TestFail;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testDownscale() != TestPass)
+			return TestFail;
+
+		if (testDownscaleInPlace() != TestPass)
+			return TestFail;
+
+		if (testScale() != TestPass)
+			return TestFail;
+
+		if (testTransform() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(PostProcessingTest)
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Software ISP debayering and filtering benchmark
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/stream.h>
+
+#include "libcamera/internal/shared_mem_object.h"
+
+#include "debayer_cpu.h"
+#include "swstats_cpu.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+namespace {
+
+class Buffer
+{
+public:
+	Buffer(unsigned int size)
+		: mem_("debayer-benchmark", size),
+		  buffer_({ { mem_.fd(), 0, size } })
+	{
+	}
+
+	FrameBuffer *buffer() { return &buffer_; }
+	Span<uint8_t> data() { return mem_.mem(); }
+
+private:
+	SharedMem mem_;
+	FrameBuffer buffer_;
+};
+
+} /* namespace */
+
+class DebayerBenchmark : public Test
+{
+protected:
+	static constexpr unsigned int kFrames = 30;
+
+	int init() override
+	{
+		inputCfg_.pixelFormat = formats::SBGGR8;
+		inputCfg_.size = { 1928, 1088 };
+		inputCfg_.stride = inputCfg_.size.width;
+
+		debayer_ = std::make_unique<DebayerCpu>(std::make_unique<SwStatsCpu>());
+
+		outputCfg_.pixelFormat = formats::RGB888;
+		outputCfg_.size = { 1920, 1080 };
+		std::tie(outputCfg_.stride, outputCfg_.frameSize) =
+			debayer_->strideAndFrameSize(outputCfg_.pixelFormat,
+						     outputCfg_.size);
+
+		std::vector<std::reference_wrapper<StreamConfiguration>> outputCfgs{ outputCfg_ };
+		if (debayer_->configure(inputCfg_, outputCfgs)) {
+			cerr << "Failed to configure the debayer" << endl;
+			return TestFail;
+		}
+
+		input_ = std::make_unique<Buffer>(inputCfg_.stride * inputCfg_.size.height);
+		output_ = std::make_unique<Buffer>(outputCfg_.frameSize);
+
+		std::mt19937 gen;
+		for (uint8_t &value : input_->data())
+			value = gen();
+
+		return TestPass;
+	}
+
+	double measure(const DebayerParams &params)
+	{
+		/* Warm up the caches and the temporal reference. */
+		debayer_->process(input_->buffer(), output_->buffer(), params);
+
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < kFrames; ++i)
+			debayer_->process(input_->buffer(), output_->buffer(), params);
+		auto end = chrono::steady_clock::now();
+
+		return chrono::duration<double, std::milli>(end - start).count() / kFrames;
+	}
+
+	int run() override
+	{
+		DebayerParams params;
+		double unfiltered = measure(params);
+
+		params.denoise = 128;
+		params.sharpen = 64;
+		params.noiseLevel = 8;
+		double filtered = measure(params);
+
+		params.temporal = 128;
+		double temporal = measure(params);
+
+		cout << "SBGGR8 to RGB888 " << outputCfg_.size << " debayering: "
+		     << unfiltered << "ms" << endl;
+		cout << "  with spatial filter: " << filtered << "ms" << endl;
+		cout << "  with spatial and temporal filters: " << temporal << "ms" << endl;
+
+		return TestPass;
+	}
+
+private:
+	StreamConfiguration inputCfg_;
+	StreamConfiguration outputCfg_;
+
+	std::unique_ptr<DebayerCpu> debayer_;
+	std::unique_ptr<Buffer> input_;
+	std::unique_ptr<Buffer> output_;
+};
+
+TEST_REGISTER(DebayerBenchmark)
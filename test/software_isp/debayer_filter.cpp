@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Software ISP denoise and sharpening filter test
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/stream.h>
+
+#include "libcamera/internal/shared_mem_object.h"
+
+#include "debayer_cpu.h"
+#include "swstats_cpu.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+namespace {
+
+class Buffer
+{
+public:
+	Buffer(unsigned int size)
+		: mem_("debayer-filter-test", size),
+		  buffer_({ { mem_.fd(), 0, size } })
+	{
+	}
+
+	FrameBuffer *buffer() { return &buffer_; }
+	Span<uint8_t> data() { return mem_.mem(); }
+
+private:
+	SharedMem mem_;
+	FrameBuffer buffer_;
+};
+
+} /* namespace */
+
+class DebayerFilterTest : public Test
+{
+protected:
+	/* Margin excluded from the measurements to ignore border effects. */
+	static constexpr unsigned int kMargin = 8;
+
+	int init() override
+	{
+		inputCfg_.pixelFormat = formats::SBGGR8;
+		/*
+		 * Lines of 130 RGB888 pixels are not a whole number of filter
+		 * blocks, to test the processing of the last partial block.
+		 */
+		inputCfg_.size = { 138, 104 };
+		inputCfg_.stride = inputCfg_.size.width;
+
+		debayer_ = std::make_unique<DebayerCpu>(std::make_unique<SwStatsCpu>());
+
+		outputCfg_.pixelFormat = formats::RGB888;
+		outputCfg_.size = { 130, 96 };
+		std::tie(outputCfg_.stride, outputCfg_.frameSize) =
+			debayer_->strideAndFrameSize(outputCfg_.pixelFormat,
+						     outputCfg_.size);
+
+		std::vector<std::reference_wrapper<StreamConfiguration>> outputCfgs{ outputCfg_ };
+		if (debayer_->configure(inputCfg_, outputCfgs)) {
+			cerr << "Failed to configure the debayer" << endl;
+			return TestFail;
+		}
+
+		input_ = std::make_unique<Buffer>(inputCfg_.stride * inputCfg_.size.height);
+		output_ = std::make_unique<Buffer>(outputCfg_.frameSize);
+
+		return TestPass;
+	}
+
+	std::vector<uint8_t> process(const DebayerParams &params)
+	{
+		debayer_->process(input_->buffer(), output_->buffer(), params);
+
+		Span<uint8_t> data = output_->data();
+		return { data.begin(), data.begin() + outputCfg_.frameSize };
+	}
+
+	/* Standard deviation of the samples of columns [\a begin, \a end[ */
+	double stddev(const std::vector<uint8_t> &image, unsigned int begin,
+		      unsigned int end)
+	{
+		double sum = 0.0;
+		double sum2 = 0.0;
+		unsigned int count = 0;
+
+		for (unsigned int y = kMargin; y < outputCfg_.size.height - kMargin; ++y) {
+			for (unsigned int x = begin * 3; x < end * 3; ++x) {
+				double value = image[y * outputCfg_.stride + x];
+				sum += value;
+				sum2 += value * value;
+				count++;
+			}
+		}
+
+		double mean = sum / count;
+		return std::sqrt(sum2 / count - mean * mean);
+	}
+
+	double stddev(const std::vector<uint8_t> &image)
+	{
+		return stddev(image, kMargin, outputCfg_.size.width - kMargin);
+	}
+
+	void fillNoise(std::mt19937 &gen)
+	{
+		/* A flat grey frame with uniform noise. */
+		std::uniform_int_distribution<int> noise(-4, 4);
+
+		for (uint8_t &value : input_->data())
+			value = 64 + noise(gen);
+	}
+
+	void fillEdge(unsigned int edge)
+	{
+		/* A vertical edge at column \a edge of the input frame. */
+		Span<uint8_t> data = input_->data();
+		for (unsigned int y = 0; y < inputCfg_.size.height; ++y) {
+			for (unsigned int x = 0; x < inputCfg_.size.width; ++x)
+				data[y * inputCfg_.stride + x] = x < edge ? 32 : 128;
+		}
+	}
+
+	int testDenoise()
+	{
+		std::mt19937 gen;
+		fillNoise(gen);
+
+		DebayerParams params;
+		double reference = stddev(process(params));
+
+		params.denoise = 255;
+		params.noiseLevel = 32;
+		double denoised = stddev(process(params));
+
+		if (denoised > reference * 0.75) {
+			cerr << "Noise not reduced: standard deviation "
+			     << denoised << ", " << reference
+			     << " without filter" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testSharpen()
+	{
+		/* A vertical edge in the middle of the frame. */
+		fillEdge(inputCfg_.size.width / 2);
+
+		DebayerParams params;
+		std::vector<uint8_t> reference = process(params);
+
+		params.sharpen = 255;
+		params.noiseLevel = 2;
+		std::vector<uint8_t> sharpened = process(params);
+
+		/*
+		 * Sharpening overshoots on both sides of the edge, on a line
+		 * crossing it.
+		 */
+		const unsigned int y = outputCfg_.size.height / 2;
+		const uint8_t *ref = &reference[y * outputCfg_.stride];
+		const uint8_t *out = &sharpened[y * outputCfg_.stride];
+
+		uint8_t refMin = 255, refMax = 0;
+		uint8_t outMin = 255, outMax = 0;
+
+		for (unsigned int x = kMargin * 3; x < (outputCfg_.size.width - kMargin) * 3; ++x) {
+			refMin = std::min(refMin, ref[x]);
+			refMax = std::max(refMax, ref[x]);
+			outMin = std::min(outMin, out[x]);
+			outMax = std::max(outMax, out[x]);
+		}
+
+		if (outMin >= refMin || outMax <= refMax) {
+			cerr << "Edge not sharpened: range [" << unsigned(outMin)
+			     << ", " << unsigned(outMax) << "], ["
+			     << unsigned(refMin) << ", " << unsigned(refMax)
+			     << "] without filter" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Flat areas away from the edge must not be modified, including
+		 * the last pixel, in the last partial block.
+		 */
+		for (unsigned int x : { kMargin, outputCfg_.size.width - kMargin - 1,
+					outputCfg_.size.width - 1 }) {
+			for (unsigned int c = 0; c < 3; ++c) {
+				if (out[x * 3 + c] != ref[x * 3 + c]) {
+					cerr << "Flat area modified at " << x << ": "
+					     << unsigned(out[x * 3 + c]) << " instead of "
+					     << unsigned(ref[x * 3 + c]) << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testTemporalStatic()
+	{
+		/* Two frames of a static scene with different noise. */
+		std::mt19937 gen;
+		fillNoise(gen);
+		std::vector<uint8_t> first = process({});
+
+		fillNoise(gen);
+		std::vector<uint8_t> second = process({});
+
+		/*
+		 * Without spatial filtering, the first frame is output
+		 * unmodified as there's no previous frame to blend it with.
+		 */
+		DebayerParams params;
+		params.temporal = 128;
+		params.noiseLevel = 32;
+
+		gen.seed();
+		fillNoise(gen);
+		if (process(params) != first) {
+			cerr << "First frame modified by the temporal filter" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Blending two frames with equal weights divides the standard
+		 * deviation of uncorrelated noise by sqrt(2). Check the last
+		 * pixels, in the last partial block, separately.
+		 */
+		fillNoise(gen);
+		std::vector<uint8_t> blended = process(params);
+
+		const unsigned int width = outputCfg_.size.width;
+
+		for (const auto &[begin, end] : { std::pair{ kMargin, width - kMargin },
+						  std::pair{ width - 2, width } }) {
+			double reference = stddev(second, begin, end);
+			double filtered = stddev(blended, begin, end);
+
+			if (filtered > reference * 0.85) {
+				cerr << "Noise not reduced in columns [" << begin
+				     << ", " << end << "[: standard deviation "
+				     << filtered << ", " << reference
+				     << " without filter" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testTemporalMotion()
+	{
+		/*
+		 * Move a vertical edge by 8 pixels between two frames. The
+		 * pixels it moved over differ by much more than the motion
+		 * threshold, and must not be blended.
+		 */
+		const unsigned int edge = inputCfg_.size.width / 2;
+
+		fillEdge(edge + 8);
+		std::vector<uint8_t> reference = process({});
+
+		DebayerParams params;
+		params.temporal = 255;
+		params.noiseLevel = 4;
+
+		fillEdge(edge);
+		process(params);
+		fillEdge(edge + 8);
+		std::vector<uint8_t> moved = process(params);
+
+		/*
+		 * Check the columns between the two edge positions in the
+		 * output, away from the transitions. The output is cropped
+		 * from the center of the input.
+		 */
+		const unsigned int offset = (inputCfg_.size.width - outputCfg_.size.width) / 2;
+		const unsigned int begin = edge - offset + 2;
+		const unsigned int end = edge + 8 - offset - 2;
+
+		for (unsigned int y = 0; y < outputCfg_.size.height; ++y) {
+			for (unsigned int x = begin * 3; x < end * 3; ++x) {
+				unsigned int index = y * outputCfg_.stride + x;
+				if (moved[index] != reference[index]) {
+					cerr << "Moved edge blended at (" << x / 3
+					     << ", " << y << "): " << unsigned(moved[index])
+					     << " instead of " << unsigned(reference[index])
+					     << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		/* The filter must be disabled by default. */
+		DebayerParams params;
+		if (params.denoise || params.sharpen || params.temporal) {
+			cerr << "Filter enabled by default" << endl;
+			return TestFail;
+		}
+
+		if (testDenoise() != TestPass)
+			return TestFail;
+
+		if (testSharpen() != TestPass)
+			return TestFail;
+
+		if (testTemporalStatic() != TestPass)
+			return TestFail;
+
+		if (testTemporalMotion() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+
+private:
+	StreamConfiguration inputCfg_;
+	StreamConfiguration outputCfg_;
+
+	std::unique_ptr<DebayerCpu> debayer_;
+	std::unique_ptr<Buffer> input_;
+	std::unique_ptr<Buffer> output_;
+};
+
+TEST_REGISTER(DebayerFilterTest)
@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * Software ISP black level, gains and gamma lookup tables test
+ */
+
+#include <array>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/stream.h>
+
+#include "libcamera/internal/shared_mem_object.h"
+
+#include "debayer_cpu.h"
+#include "swstats_cpu.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+namespace {
+
+class Buffer
+{
+public:
+	Buffer(unsigned int size)
+		: mem_("debayer-lookup-test", size),
+		  buffer_({ { mem_.fd(), 0, size } })
+	{
+	}
+
+	FrameBuffer *buffer() { return &buffer_; }
+	Span<uint8_t> data() { return mem_.mem(); }
+
+private:
+	SharedMem mem_;
+	FrameBuffer buffer_;
+};
+
+/* Output samples, in the RGB888 memory order. */
+enum Colour {
+	Blue,
+	Green,
+	Red,
+};
+
+const char *const colourNames[] = { "blue", "green", "red" };
+
+} /* namespace */
+
+class DebayerLookupTest : public Test
+{
+protected:
+	/*
+	 * Configure the debayer for unpacked BGGR input of \a bitDepth bits
+	 * per sample.
+	 */
+	int configure(unsigned int bitDepth)
+	{
+		bitDepth_ = bitDepth;
+
+		inputCfg_.pixelFormat = bitDepth == 10 ? formats::SBGGR10 : formats::SBGGR12;
+		inputCfg_.size = { 40, 24 };
+		inputCfg_.stride = inputCfg_.size.width * 2;
+
+		debayer_ = std::make_unique<DebayerCpu>(std::make_unique<SwStatsCpu>());
+
+		outputCfg_.pixelFormat = formats::RGB888;
+		outputCfg_.size = { 32, 16 };
+		std::tie(outputCfg_.stride, outputCfg_.frameSize) =
+			debayer_->strideAndFrameSize(outputCfg_.pixelFormat,
+						     outputCfg_.size);
+
+		std::vector<std::reference_wrapper<StreamConfiguration>> outputCfgs{ outputCfg_ };
+		if (debayer_->configure(inputCfg_, outputCfgs)) {
+			cerr << "Failed to configure the debayer for "
+			     << inputCfg_.pixelFormat << endl;
+			return TestFail;
+		}
+
+		input_ = std::make_unique<Buffer>(inputCfg_.stride * inputCfg_.size.height);
+		output_ = std::make_unique<Buffer>(outputCfg_.frameSize);
+
+		return TestPass;
+	}
+
+	/*
+	 * Process a flat frame of raw \a value samples, and return the output
+	 * samples of the pixel in the center of the frame. As all neighbours
+	 * are equal, the output samples are the lookup table entries of \a value.
+	 */
+	std::array<uint8_t, 3> process(uint16_t value, const DebayerParams &params)
+	{
+		Span<uint8_t> data = input_->data();
+		uint16_t *samples = reinterpret_cast<uint16_t *>(data.data());
+		for (size_t i = 0; i < data.size() / 2; ++i)
+			samples[i] = value;
+
+		debayer_->process(input_->buffer(), output_->buffer(), params);
+
+		const uint8_t *pixel = output_->data().data() +
+				       outputCfg_.size.height / 2 * outputCfg_.stride +
+				       outputCfg_.size.width / 2 * 3;
+		return { pixel[Blue], pixel[Green], pixel[Red] };
+	}
+
+	int testBlackLevel(const DebayerParams &params, unsigned int blackLevel)
+	{
+		/* Values at or below the black level are black. */
+		for (unsigned int value : { 0U, blackLevel / 2, blackLevel - 1, blackLevel }) {
+			std::array<uint8_t, 3> out = process(value, params);
+			if (out != std::array<uint8_t, 3>{}) {
+				cerr << "Value " << value << " at or below black level "
+				     << blackLevel << " not black" << endl;
+				return TestFail;
+			}
+		}
+
+		/*
+		 * Values a few codes above the black level are not black, and
+		 * are distinct.
+		 */
+		std::array<uint8_t, 3> previous = {};
+
+		for (unsigned int value = blackLevel + 1; value <= blackLevel + 4; ++value) {
+			std::array<uint8_t, 3> out = process(value, params);
+
+			for (unsigned int c = 0; c < 3; ++c) {
+				if (out[c] <= previous[c]) {
+					cerr << "Value " << value << " above black level "
+					     << blackLevel << " maps to " << colourNames[c]
+					     << " " << unsigned(out[c]) << ", previous value to "
+					     << unsigned(previous[c]) << endl;
+					return TestFail;
+				}
+			}
+
+			previous = out;
+		}
+
+		return TestPass;
+	}
+
+	int testGains(const DebayerParams &params, unsigned int blackLevel)
+	{
+		/* A quarter of the range above the black level, to avoid clipping. */
+		const unsigned int maxValue = (1U << bitDepth_) - 1;
+		const uint16_t value = blackLevel + (maxValue - blackLevel) / 4;
+		const std::array<uint8_t, 3> reference = process(value, params);
+
+		/*
+		 * Double each gain in turn, and reset it to unity. Only the
+		 * colour of the gain must be modified, and restored.
+		 */
+		for (unsigned int c = 0; c < 3; ++c) {
+			DebayerParams gainParams = params;
+			uint16_t &gain = c == Blue ? gainParams.gainB
+				       : c == Green ? gainParams.gainG
+						    : gainParams.gainR;
+			gain = 2 * DebayerParams::kGainOne;
+
+			std::array<uint8_t, 3> out = process(value, gainParams);
+
+			for (unsigned int i = 0; i < 3; ++i) {
+				if (i == c ? out[i] > reference[i] : out[i] == reference[i])
+					continue;
+
+				cerr << "Doubling the " << colourNames[c] << " gain maps "
+				     << colourNames[i] << " to " << unsigned(out[i])
+				     << (i == c ? " instead of more than " : " instead of ")
+				     << unsigned(reference[i]) << endl;
+				return TestFail;
+			}
+
+			out = process(value, params);
+			if (out != reference) {
+				cerr << "Resetting the " << colourNames[c]
+				     << " gain didn't restore the output" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		for (unsigned int bitDepth : { 10U, 12U }) {
+			if (configure(bitDepth) != TestPass)
+				return TestFail;
+
+			/* A black level of 64 at 10 bits, 256 at 12 bits. */
+			DebayerParams params;
+			params.blackLevel = 4096;
+			const unsigned int blackLevel = params.blackLevel >> (16 - bitDepth);
+
+			if (testBlackLevel(params, blackLevel) != TestPass ||
+			    testGains(params, blackLevel) != TestPass) {
+				cerr << "Lookup tables test failed for "
+				     << inputCfg_.pixelFormat << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+private:
+	StreamConfiguration inputCfg_;
+	StreamConfiguration outputCfg_;
+	unsigned int bitDepth_;
+
+	std::unique_ptr<DebayerCpu> debayer_;
+	std::unique_ptr<Buffer> input_;
+	std::unique_ptr<Buffer> output_;
+};
+
+TEST_REGISTER(DebayerLookupTest)
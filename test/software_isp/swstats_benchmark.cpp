@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Red Hat Inc.
+ *
+ * Software ISP statistics benchmark
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <libcamera/formats.h>
+#include <libcamera/stream.h>
+
+#include "swstats_cpu.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class SwStatsBenchmark : public Test
+{
+protected:
+	static constexpr unsigned int kFrames = 100;
+
+	double measure(const PixelFormat &format, unsigned int stride)
+	{
+		const Size size{ 1920, 1080 };
+
+		StreamConfiguration cfg;
+		cfg.pixelFormat = format;
+		cfg.size = size;
+		cfg.stride = stride;
+
+		SwStatsCpu stats;
+		if (!stats.isValid() || stats.configure(cfg))
+			return -1.0;
+
+		stats.setWindow(Rectangle(size));
+
+		/* Two extra lines for the lines following the last one. */
+		std::vector<uint8_t> data(stride * (size.height + 2));
+		std::mt19937 gen;
+		for (uint8_t &value : data)
+			value = gen();
+
+		/* Clamp unpacked samples to their bit depth. */
+		BayerFormat bayer = BayerFormat::fromPixelFormat(format);
+		if (bayer.packing == BayerFormat::Packing::None && bayer.bitDepth > 8) {
+			uint16_t *samples = reinterpret_cast<uint16_t *>(data.data());
+			for (size_t i = 0; i < data.size() / 2; ++i)
+				samples[i] &= (1 << bayer.bitDepth) - 1;
+		}
+
+		auto frame = [&]() {
+			stats.startFrame();
+			for (unsigned int y = 0; y < size.height; y += 2) {
+				const uint8_t *src[3] = {
+					nullptr,
+					&data[y * stride],
+					&data[(y + 1) * stride],
+				};
+				stats.processLine0(y, src);
+			}
+			stats.finishFrame();
+		};
+
+		/* Warm up the caches. */
+		frame();
+
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < kFrames; ++i)
+			frame();
+		auto end = chrono::steady_clock::now();
+
+		return chrono::duration<double, std::micro>(end - start).count() / kFrames;
+	}
+
+	int run() override
+	{
+		const struct {
+			PixelFormat format;
+			unsigned int stride;
+		} formats[] = {
+			{ formats::SBGGR8, 1920 },
+			{ formats::SBGGR10, 1920 * 2 },
+			{ formats::SBGGR12, 1920 * 2 },
+			{ formats::SBGGR10_CSI2P, 1920 * 5 / 4 },
+		};
+
+		for (const auto &[format, stride] : formats) {
+			double duration = measure(format, stride);
+			if (duration < 0) {
+				cerr << "Failed to configure statistics for "
+				     << format << endl;
+				return TestFail;
+			}
+
+			cout << format << " 1920x1080 statistics: " << duration
+			     << "us" << endl;
+		}
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(SwStatsBenchmark)
@@ -0,0 +1,209 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * TimestampMatcher tests
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "libcamera/internal/timestamp_matcher.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+/* 30fps frame period and a tolerance well below it, in nanoseconds. */
+constexpr int64_t kFramePeriod = 33333333;
+constexpr int64_t kTolerance = 2000000;
+
+class TimestampMatcherTest : public Test
+{
+protected:
+	/*
+	 * The items identify frames as stream * 1000 + frame number, to check
+	 * which frames are matched and dropped.
+	 */
+	void add(TimestampMatcher<unsigned int> &matcher, unsigned int stream,
+		 unsigned int frame, int64_t offset = 0)
+	{
+		matcher.add(stream, frame * kFramePeriod + offset, 0,
+			    stream * 1000 + frame, &dropped_, &sets_);
+	}
+
+	void clear()
+	{
+		dropped_.clear();
+		sets_.clear();
+	}
+
+	int testMatch()
+	{
+		TimestampMatcher<unsigned int> matcher(2);
+		matcher.setTolerance(kTolerance);
+
+		/* Frames within the tolerance are matched in order. */
+		for (unsigned int frame = 1; frame <= 4; ++frame) {
+			add(matcher, 0, frame);
+			add(matcher, 1, frame, 1000000);
+		}
+
+		if (!dropped_.empty() || sets_.size() != 4) {
+			cerr << "Expected 4 matched sets, got " << sets_.size()
+			     << " and " << dropped_.size() << " dropped" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < sets_.size(); ++i) {
+			const vector<unsigned int> expected = { i + 1, 1000 + i + 1 };
+			if (sets_[i] != expected) {
+				cerr << "Set " << i << " mismatched" << endl;
+				return TestFail;
+			}
+		}
+
+		/* The frame duration and phase are measured from the timestamps. */
+		if (matcher.frameDuration(0) != kFramePeriod ||
+		    matcher.frameDuration(1) != kFramePeriod) {
+			cerr << "Invalid frame duration " << matcher.frameDuration(0)
+			     << "/" << matcher.frameDuration(1) << endl;
+			return TestFail;
+		}
+
+		if (matcher.phaseError(0) != 0 || matcher.phaseError(1) != 1000000) {
+			cerr << "Invalid phase error " << matcher.phaseError(1) << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testLostFrame()
+	{
+		TimestampMatcher<unsigned int> matcher(2);
+		matcher.setTolerance(kTolerance);
+
+		/* Stream 1 loses frame 2, frame 2 of stream 0 must be dropped. */
+		add(matcher, 0, 1);
+		add(matcher, 1, 1);
+		add(matcher, 0, 2);
+		add(matcher, 0, 3);
+		add(matcher, 1, 3);
+
+		const vector<vector<unsigned int>> expected = {
+			{ 1, 1001 }, { 3, 1003 },
+		};
+
+		if (sets_ != expected || dropped_ != vector<unsigned int>{ 2 }) {
+			cerr << "Unmatched frame not dropped" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testOutOfTolerance()
+	{
+		TimestampMatcher<unsigned int> matcher(2);
+		matcher.setTolerance(kTolerance);
+
+		/*
+		 * Streams offset by more than the tolerance never match, all
+		 * frames but the last one are dropped.
+		 */
+		for (unsigned int frame = 1; frame <= 4; ++frame) {
+			add(matcher, 0, frame);
+			add(matcher, 1, frame, kTolerance + 1);
+		}
+
+		const vector<unsigned int> expected = { 1, 1001, 2, 1002, 3, 1003, 4 };
+
+		if (!sets_.empty() || dropped_ != expected) {
+			cerr << "Frames out of tolerance matched" << endl;
+			return TestFail;
+		}
+
+		if (matcher.pending(0) != 0 || matcher.pending(1) != 1) {
+			cerr << "Invalid pending frames" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testMaxPending()
+	{
+		TimestampMatcher<unsigned int> matcher(2);
+		matcher.setTolerance(kTolerance);
+		matcher.setMaxPending(3);
+
+		/* Stream 1 stalls, the oldest frames of stream 0 are dropped. */
+		for (unsigned int frame = 1; frame <= 5; ++frame)
+			add(matcher, 0, frame);
+
+		if (!sets_.empty() || dropped_ != vector<unsigned int>{ 1, 2 } ||
+		    matcher.pending(0) != 3) {
+			cerr << "Pending frames not bounded" << endl;
+			return TestFail;
+		}
+
+		/* Matching resumes when stream 1 catches up. */
+		clear();
+		add(matcher, 1, 5);
+
+		const vector<vector<unsigned int>> expected = { { 5, 1005 } };
+
+		if (sets_ != expected || dropped_ != vector<unsigned int>{ 3, 4 }) {
+			cerr << "Matching didn't resume after a stall" << endl;
+			return TestFail;
+		}
+
+		/* Flushing drops all pending frames. */
+		clear();
+		add(matcher, 0, 6);
+		add(matcher, 0, 7);
+
+		std::vector<unsigned int> flushed;
+		matcher.flush(&flushed);
+
+		if (flushed != vector<unsigned int>{ 6, 7 } || matcher.pending(0) ||
+		    matcher.frameDuration(0)) {
+			cerr << "Pending frames not flushed" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (testMatch() != TestPass)
+			return TestFail;
+
+		clear();
+		if (testLostFrame() != TestPass)
+			return TestFail;
+
+		clear();
+		if (testOutOfTolerance() != TestPass)
+			return TestFail;
+
+		clear();
+		if (testMaxPending() != TestPass)
+			return TestFail;
+
+		return TestPass;
+	}
+
+private:
+	vector<unsigned int> dropped_;
+	vector<vector<unsigned int>> sets_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(TimestampMatcherTest)
@@ -23,6 +23,85 @@ public:
 	Format()
 		: V4L2VideoDeviceTest("vimc", "Raw Capture 0") {}
 protected:
+	static bool isSameFormat(const V4L2DeviceFormat &a,
+				 const V4L2DeviceFormat &b)
+	{
+		return a.fourcc == b.fourcc && a.size == b.size &&
+		       a.planesCount == b.planesCount &&
+		       a.planes[0].bpl == b.planes[0].bpl &&
+		       a.planes[0].size == b.planes[0].size;
+	}
+
+	int testTryFormat(const V4L2DeviceFormat &active)
+	{
+		/*
+		 * Try the same format repeatedly, the results must not depend
+		 * on whether they come from the driver or from the cache, and
+		 * the active format must not change.
+		 */
+		V4L2DeviceFormat requested = active;
+		requested.size = { 640, 480 };
+
+		V4L2DeviceFormat first = requested;
+		int ret = capture_->tryFormat(&first);
+		if (ret) {
+			cerr << "Failed to try format" << endl;
+			return TestFail;
+		}
+
+		V4L2DeviceFormat second = requested;
+		ret = capture_->tryFormat(&second);
+		if (ret || !isSameFormat(first, second)) {
+			cerr << "Repeated tryFormat() returned a different format: "
+			     << first << " vs. " << second << endl;
+			return TestFail;
+		}
+
+		V4L2DeviceFormat current = {};
+		ret = capture_->getFormat(&current);
+		if (ret || !isSameFormat(current, active)) {
+			cerr << "tryFormat() changed the active format" << endl;
+			return TestFail;
+		}
+
+		/* Fill the cache past its capacity with different sizes. */
+		for (unsigned int i = 0; i < 32; ++i) {
+			V4L2DeviceFormat other = requested;
+			other.size = { 64 + i * 16, 48 + i * 16 };
+			ret = capture_->tryFormat(&other);
+			if (ret) {
+				cerr << "Failed to try format " << other << endl;
+				return TestFail;
+			}
+		}
+
+		V4L2DeviceFormat third = requested;
+		ret = capture_->tryFormat(&third);
+		if (ret || !isSameFormat(first, third)) {
+			cerr << "tryFormat() result changed after eviction: "
+			     << first << " vs. " << third << endl;
+			return TestFail;
+		}
+
+		/* Setting a format must not affect the results of tryFormat(). */
+		V4L2DeviceFormat format = first;
+		ret = capture_->setFormat(&format);
+		if (ret || !isSameFormat(format, first)) {
+			cerr << "Failed to set tried format " << first << endl;
+			return TestFail;
+		}
+
+		V4L2DeviceFormat fourth = active;
+		ret = capture_->tryFormat(&fourth);
+		if (ret || !isSameFormat(fourth, active)) {
+			cerr << "tryFormat() of the previous format returned "
+			     << fourth << " instead of " << active << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
 	int run()
 	{
 		V4L2DeviceFormat format = {};
@@ -49,6 +128,9 @@ protected:
 			return TestFail;
 		}
 
+		if (testTryFormat(format) != TestPass)
+			return TestFail;
+
 		std::vector<std::pair<uint32_t, const char *>> formats{
 			{ V4L2_PIX_FMT_YUYV, "YUYV" },
 			{ 0, "<INVALID>" },
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * InternalBufferPool tests
+ */
+
+#include <iostream>
+
+#include "libcamera/internal/internal_buffer_pool.h"
+
+#include "v4l2_videodevice_test.h"
+
+using namespace libcamera;
+using namespace std;
+
+class InternalBufferPoolTest : public V4L2VideoDeviceTest
+{
+public:
+	InternalBufferPoolTest()
+		: V4L2VideoDeviceTest("vimc", "Raw Capture 0")
+	{
+	}
+
+protected:
+	static constexpr unsigned int kMaxCount = 4;
+
+	int run()
+	{
+		InternalBufferPool pool("test-pool",
+					DmaBufAllocator::DmaBufAllocatorFlag::SystemHeap |
+					DmaBufAllocator::DmaBufAllocatorFlag::UDmaBuf);
+
+		unsigned int allocated = 0;
+		pool.bufferAllocated.connect(this, [&](FrameBuffer *) { allocated++; });
+
+		int ret = pool.allocate(capture_, 1, kMaxCount);
+		if (ret) {
+			cerr << "Failed to allocate the pool" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Without a usable dma-buf provider, the pool falls back to
+		 * allocating all the buffers up front.
+		 */
+		const unsigned int initialCount = pool.buffers().size();
+		if ((initialCount != 1 && initialCount != kMaxCount) ||
+		    pool.maxCount() != kMaxCount || allocated != initialCount) {
+			cerr << "Invalid initial pool: " << initialCount << "/"
+			     << pool.maxCount() << " buffers, " << allocated
+			     << " reported" << endl;
+			return TestFail;
+		}
+
+		ret = capture_->importBuffers(kMaxCount);
+		if (ret) {
+			cerr << "Failed to import buffers" << endl;
+			return TestFail;
+		}
+
+		/* Grow the pool to its maximum size. */
+		for (unsigned int count = initialCount; count < kMaxCount; ++count) {
+			FrameBuffer *buffer = pool.allocateBuffer();
+			if (!buffer) {
+				cerr << "Failed to grow the pool to "
+				     << count + 1 << " buffers" << endl;
+				return TestFail;
+			}
+
+			if (!pool.contains(buffer) ||
+			    pool.buffers().size() != count + 1 ||
+			    allocated != count + 1) {
+				cerr << "Buffer allocated on demand not tracked" << endl;
+				return TestFail;
+			}
+
+			/* The device must accept the heap allocated buffer. */
+			ret = capture_->queueBuffer(buffer);
+			if (ret) {
+				cerr << "Failed to queue buffer allocated on demand"
+				     << endl;
+				return TestFail;
+			}
+		}
+
+		if (pool.allocateBuffer() || allocated != kMaxCount) {
+			cerr << "Pool grew past its maximum size" << endl;
+			return TestFail;
+		}
+
+		/* Buffers of other owners don't belong to the pool. */
+		std::vector<FrameBuffer::Plane> planes;
+		FrameBuffer other(planes);
+		if (pool.contains(&other)) {
+			cerr << "Foreign buffer found in the pool" << endl;
+			return TestFail;
+		}
+
+		capture_->streamOff();
+		capture_->releaseBuffers();
+
+		pool.release();
+		if (!pool.buffers().empty() || pool.maxCount() ||
+		    pool.allocateBuffer()) {
+			cerr << "Pool not empty after release()" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(InternalBufferPoolTest)
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2024, Google Inc.
+ *
+ * libcamera V4L2 M2M video device format tests
+ */
+
+#include <errno.h>
+#include <iostream>
+#include <memory>
+
+#include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/media_device.h"
+#include "libcamera/internal/v4l2_videodevice.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+
+class V4L2M2MDeviceFormatsTest : public Test
+{
+protected:
+	int init()
+	{
+		enumerator_ = DeviceEnumerator::create();
+		if (!enumerator_) {
+			cerr << "Failed to create device enumerator" << endl;
+			return TestFail;
+		}
+
+		if (enumerator_->enumerate()) {
+			cerr << "Failed to enumerate media devices" << endl;
+			return TestFail;
+		}
+
+		DeviceMatch dm("vim2m");
+		dm.add("vim2m-source");
+		dm.add("vim2m-sink");
+
+		media_ = enumerator_->search(dm);
+		if (!media_) {
+			cerr << "No vim2m device found" << endl;
+			return TestSkip;
+		}
+
+		return TestPass;
+	}
+
+	/*
+	 * Try the capture format on a device whose input format has been set
+	 * to \a input, on a newly opened device with no tryFormat() cache.
+	 */
+	int tryUncached(const V4L2DeviceFormat &input, V4L2DeviceFormat *format)
+	{
+		MediaEntity *entity = media_->getEntityByName("vim2m-source");
+		V4L2M2MDevice m2m(entity->deviceNode());
+		if (m2m.open())
+			return -ENODEV;
+
+		V4L2DeviceFormat inputFormat = input;
+		int ret = m2m.output()->setFormat(&inputFormat);
+		if (ret)
+			return ret;
+
+		return m2m.capture()->tryFormat(format);
+	}
+
+	int run()
+	{
+		MediaEntity *entity = media_->getEntityByName("vim2m-source");
+		V4L2M2MDevice m2m(entity->deviceNode());
+		if (m2m.open()) {
+			cerr << "Failed to open VIM2M device" << endl;
+			return TestFail;
+		}
+
+		V4L2VideoDevice *output = m2m.output();
+		V4L2VideoDevice *capture = m2m.capture();
+
+		V4L2DeviceFormat request = {};
+		if (capture->getFormat(&request)) {
+			cerr << "Failed to get capture format" << endl;
+			return TestFail;
+		}
+
+		const Size inputSizes[] = { { 640, 480 }, { 320, 240 }, { 640, 480 } };
+
+		/*
+		 * Switch the input format and try the same capture format after
+		 * each switch. The capture format depends on the input format,
+		 * the results must match the ones of a device that has never
+		 * cached any result.
+		 */
+		for (const Size &size : inputSizes) {
+			V4L2DeviceFormat input = {};
+			if (output->getFormat(&input)) {
+				cerr << "Failed to get output format" << endl;
+				return TestFail;
+			}
+
+			input.size = size;
+			if (output->setFormat(&input)) {
+				cerr << "Failed to set output format" << endl;
+				return TestFail;
+			}
+
+			V4L2DeviceFormat cached = request;
+			if (capture->tryFormat(&cached)) {
+				cerr << "Failed to try capture format" << endl;
+				return TestFail;
+			}
+
+			V4L2DeviceFormat expected = request;
+			if (tryUncached(input, &expected)) {
+				cerr << "Failed to try capture format on a new device" << endl;
+				return TestFail;
+			}
+
+			if (cached.toString() != expected.toString() ||
+			    cached.planes[0].bpl != expected.planes[0].bpl ||
+			    cached.planes[0].size != expected.planes[0].size) {
+				cerr << "Stale capture format " << cached
+				     << " with input " << input << ", expected "
+				     << expected << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+private:
+	std::unique_ptr<DeviceEnumerator> enumerator_;
+	std::shared_ptr<MediaDevice> media_;
+};
+
+TEST_REGISTER(V4L2M2MDeviceFormatsTest)